@@ -0,0 +1 @@
+#include "../../src/core/debugwriter.h"
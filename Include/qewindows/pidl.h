@@ -0,0 +1 @@
+#include "../../src/windows/pidl.h"
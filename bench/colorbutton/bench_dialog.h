@@ -0,0 +1,115 @@
+/*  QExt: Extensions to Qt
+ *  Copyright (C) 2016  Jonathan Harper
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QE_BENCH_DIALOG_H
+#define QE_BENCH_DIALOG_H
+
+#include <chrono>
+#include <memory>
+#include <QtCore/QCoreApplication>
+#include <QtCore/QEvent>
+#include <QtWidgets/QColorDialog>
+#include <QtWidgets/QVBoxLayout>
+#include <QtWidgets/QWidget>
+#include "../../test/core/test.h"
+#include "colorbutton.h"
+
+//! Records when a widget is first painted.
+class FirstPaintFilter : public QObject
+{
+public:
+    bool painted = false;
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override
+    {
+        if (event->type() == QEvent::Paint)
+            painted = true;
+        return QObject::eventFilter(watched, event);
+    }
+};
+
+struct dialog_bench
+{
+    static constexpr int Opens = 20;
+
+    //! Processes events until \a filter has seen a paint event, for at most five seconds.
+    static void waitForPaint(FirstPaintFilter &filter)
+    {
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (!filter.painted && std::chrono::steady_clock::now() < deadline)
+            QCoreApplication::processEvents();
+    }
+
+    //! The previous showColorDialog(): a new dialog for every click, timed to its first paint.
+    static void cold_open(qe_test::Bench &bench)
+    {
+        QWidget window;
+        window.show();
+        QCoreApplication::processEvents();
+
+        FirstPaintFilter filter;
+        std::unique_ptr<QColorDialog> dlg;
+        bench.setSamples(Opens);
+        bench.run([&] {
+            dlg.reset();
+            filter.painted = false;
+        }, [&] {
+            dlg.reset(new QColorDialog(Qt::red, &window));
+            dlg->installEventFilter(&filter);
+            dlg->show();
+            waitForPaint(filter);
+        });
+    }
+
+    //! showColorDialog() with the window's shared, pre-warmed dialog, in live preview mode so that
+    //! it returns without blocking, timed to its first paint.
+    static void shared_open(qe_test::Bench &bench)
+    {
+        QWidget window;
+        auto layout = new QVBoxLayout(&window);
+        auto button = new QeColorButton(Qt::red);
+        button->setLivePreviewEnabled(true);
+        layout->addWidget(button);
+        window.show();
+        //lets the button pre-warm the dialog
+        QCoreApplication::processEvents();
+        QCoreApplication::processEvents();
+
+        QColorDialog *dlg = button->colorDialog();
+        FirstPaintFilter filter;
+        dlg->installEventFilter(&filter);
+        bench.setSamples(Opens);
+        bench.run([&] {
+            dlg->reject();
+            filter.painted = false;
+        }, [&] {
+            button->showColorDialog();
+            waitForPaint(filter);
+        });
+        dlg->removeEventFilter(&filter);
+        dlg->reject();
+    }
+
+    static void add()
+    {
+        qe_test::add_benchmark("color_dialog_new_per_open", &cold_open);
+        qe_test::add_benchmark("color_dialog_shared", &shared_open);
+    }
+};
+
+#endif // QE_BENCH_DIALOG_H
@@ -0,0 +1,143 @@
+/*  QExt: Extensions to Qt
+ *  Copyright (C) 2016  Jonathan Harper
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QE_BENCH_PALETTE_H
+#define QE_BENCH_PALETTE_H
+
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <QtCore/QCoreApplication>
+#include <QtGui/QImage>
+#include <QtWidgets/QGridLayout>
+#include <QtWidgets/QWidget>
+#include "../../test/core/test.h"
+#include "colorbutton.h"
+#include "colorpalette.h"
+
+struct palette_bench
+{
+    static constexpr int Columns = 64;
+
+    static QVector<QColor> makeColors(int count)
+    {
+        QVector<QColor> colors;
+        colors.reserve(count);
+        for (int i = 0; i < count; ++i)
+            colors.append(QColor::fromRgb(QRgb(0xff000000u | ((quint32(i) * 2654435761u) & 0xffffffu))));
+        return colors;
+    }
+
+    static QImage makeTarget()
+    {
+        return QImage(1280, 800, QImage::Format_ARGB32_Premultiplied);
+    }
+
+    //! Builds, lays out and renders \a colors as a grid of QeColorButton.
+    static QWidget *buildGrid(const QVector<QColor> &colors, QImage &target)
+    {
+        auto grid = new QWidget;
+        auto layout = new QGridLayout(grid);
+        for (int i = 0; i < colors.size(); ++i)
+            layout->addWidget(new QeColorButton(colors.at(i)), i / Columns, i % Columns);
+        QCoreApplication::processEvents();
+        grid->resize(target.size());
+        grid->render(&target);
+        return grid;
+    }
+
+    //! Builds and renders \a colors as one QeColorPalette.
+    static QeColorPalette *buildPalette(const QVector<QColor> &colors, QImage &target)
+    {
+        auto palette = new QeColorPalette(colors);
+        palette->resize(target.size());
+        palette->render(&target);
+        return palette;
+    }
+
+    template <int Count>
+    static void grid_build(qe_test::Bench &bench)
+    {
+        const QVector<QColor> colors = makeColors(Count);
+        QImage target = makeTarget();
+        std::unique_ptr<QWidget> grid;
+        bench.setSamples(11);
+        bench.run([&] { grid.reset(); }, [&] { grid.reset(buildGrid(colors, target)); });
+    }
+
+    template <int Count>
+    static void grid_repaint(qe_test::Bench &bench)
+    {
+        QImage target = makeTarget();
+        std::unique_ptr<QWidget> grid(buildGrid(makeColors(Count), target));
+        bench.run([&] { grid->render(&target); });
+        std::printf("       %d widgets\n", grid->findChildren<QWidget *>().size() + 1);
+    }
+
+    template <int Count>
+    static void palette_build(qe_test::Bench &bench)
+    {
+        const QVector<QColor> colors = makeColors(Count);
+        QImage target = makeTarget();
+        std::unique_ptr<QeColorPalette> palette;
+        bench.setSamples(11);
+        bench.run([&] { palette.reset(); }, [&] { palette.reset(buildPalette(colors, target)); });
+    }
+
+    template <int Count>
+    static void palette_repaint(qe_test::Bench &bench)
+    {
+        QImage target = makeTarget();
+        std::unique_ptr<QeColorPalette> palette(buildPalette(makeColors(Count), target));
+        bench.run([&] { palette->render(&target); });
+        std::printf("       %d widgets\n", palette->findChildren<QWidget *>().size() + 1);
+    }
+
+    static void hit_test(qe_test::Bench &bench)
+    {
+        QImage target = makeTarget();
+        //rendering delivers the pending resize, which lays out the grid
+        std::unique_ptr<QeColorPalette> palette(buildPalette(makeColors(10000), target));
+
+        int hits = 0;
+        std::size_t i = 0;
+        bench.run([&] {
+            hits += palette->indexAt(QPoint(int(i * 7 % 1280), int(i * 13 % 800))) >= 0;
+            ++i;
+        });
+        qe_test::keep(hits);
+    }
+
+    template <int Count>
+    static void add(const char *suffix)
+    {
+        auto name = [suffix](const char *what) { return std::string(what) + suffix; };
+        qe_test::add_benchmark(name("button_grid_build_render").c_str(), &grid_build<Count>);
+        qe_test::add_benchmark(name("button_grid_repaint").c_str(), &grid_repaint<Count>);
+        qe_test::add_benchmark(name("palette_build_render").c_str(), &palette_build<Count>);
+        qe_test::add_benchmark(name("palette_repaint").c_str(), &palette_repaint<Count>);
+    }
+
+    static void add()
+    {
+        add<1024>("_x1024");
+        add<10000>("_x10000");
+        qe_test::add_benchmark("palette_index_at", &hit_test);
+    }
+};
+
+#endif // QE_BENCH_PALETTE_H
@@ -0,0 +1,160 @@
+/*  QExt: Extensions to Qt
+ *  Copyright (C) 2016  Jonathan Harper
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QE_BENCH_SUITE_H
+#define QE_BENCH_SUITE_H
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <QtGui/QImage>
+#include <QtWidgets/QWidget>
+#include "../../test/core/test.h"
+#include "colorbutton.h"
+
+//! Measures each stage of a QeColorButton's work with 1, 100 and 10k buttons alive, reporting the
+//! time and heap allocations per operation.
+struct suite_bench
+{
+    static QColor colorAt(std::size_t i, std::size_t colors)
+    {
+        return QColor::fromRgb(QRgb(0xff000000u | ((quint32(i % colors) * 2654435761u) & 0xffffffu)));
+    }
+
+    //! Count buttons in one parent.
+    struct Buttons
+    {
+        std::unique_ptr<QWidget> parent{new QWidget};
+        std::vector<QeColorButton *> buttons;
+
+        void create(std::size_t count)
+        {
+            buttons.reserve(count);
+            for (std::size_t i = 0; i < count; ++i) {
+                auto button = new QeColorButton(colorAt(i, 16), parent.get());
+                button->flushUpdates();
+                buttons.push_back(button);
+            }
+        }
+
+        void destroy()
+        {
+            for (auto button : buttons)
+                delete button;
+            buttons.clear();
+        }
+    };
+
+    template <std::size_t Count>
+    static void construct(qe_test::Bench &bench)
+    {
+        Buttons fixture;
+        bench.setSamples(11).setBatch(Count);
+        bench.run([&] { fixture.destroy(); }, [&] { fixture.create(Count); });
+    }
+
+    template <std::size_t Count>
+    static void set_color_cached(qe_test::Bench &bench)
+    {
+        Buttons fixture;
+        fixture.create(Count);
+        std::size_t i = 0;
+        bench.run([&] {
+            auto button = fixture.buttons[i % Count];
+            button->setColor(colorAt(i + 1, 16));
+            button->flushUpdates();
+            ++i;
+        });
+    }
+
+    //! With no room in the cache, every change paints a new swatch.
+    template <std::size_t Count>
+    static void set_color_regenerated(qe_test::Bench &bench)
+    {
+        Buttons fixture;
+        fixture.create(Count);
+        const int limit = QeColorButton::swatchCacheLimit();
+        QeColorButton::setSwatchCacheLimit(0);
+        std::size_t i = 0;
+        bench.run([&] {
+            auto button = fixture.buttons[i % Count];
+            button->setColor(colorAt(i, 0xffffff));
+            button->flushUpdates();
+            ++i;
+        });
+        QeColorButton::setSwatchCacheLimit(limit);
+    }
+
+    template <std::size_t Count>
+    static void set_text_format(qe_test::Bench &bench)
+    {
+        Buttons fixture;
+        fixture.create(Count);
+        const QString formats[2] = {QStringLiteral("%r, %g, %b"), QStringLiteral("hsv(%h, %s, %v)")};
+        std::size_t i = 0;
+        bench.run([&] {
+            auto button = fixture.buttons[i % Count];
+            //the buttons start with formats[0]
+            button->setTextFormat(formats[((i / Count) + 1) & 1]);
+            button->flushUpdates();
+            ++i;
+        });
+    }
+
+    template <std::size_t Count>
+    static void paint(qe_test::Bench &bench)
+    {
+        Buttons fixture;
+        fixture.create(Count);
+        for (auto button : fixture.buttons)
+            button->resize(button->sizeHint());
+        QImage target(fixture.buttons.front()->size(), QImage::Format_ARGB32_Premultiplied);
+        std::size_t i = 0;
+        bench.run([&] {
+            fixture.buttons[i++ % Count]->render(&target);
+        });
+    }
+
+    template <std::size_t Count>
+    static void destroy(qe_test::Bench &bench)
+    {
+        Buttons fixture;
+        bench.setSamples(11).setBatch(Count);
+        bench.run([&] { fixture.create(Count); }, [&] { fixture.destroy(); });
+    }
+
+    template <std::size_t Count>
+    static void add(const char *suffix)
+    {
+        auto name = [suffix](const char *stage) { return std::string(stage) + suffix; };
+        qe_test::add_benchmark(name("colorbutton_construct").c_str(), &construct<Count>);
+        qe_test::add_benchmark(name("colorbutton_set_color_cached").c_str(), &set_color_cached<Count>);
+        qe_test::add_benchmark(name("colorbutton_set_color_regenerated").c_str(), &set_color_regenerated<Count>);
+        qe_test::add_benchmark(name("colorbutton_set_text_format").c_str(), &set_text_format<Count>);
+        qe_test::add_benchmark(name("colorbutton_paint").c_str(), &paint<Count>);
+        qe_test::add_benchmark(name("colorbutton_destroy").c_str(), &destroy<Count>);
+    }
+
+    static void add()
+    {
+        add<1>("_x1");
+        add<100>("_x100");
+        add<10000>("_x10000");
+    }
+};
+
+#endif // QE_BENCH_SUITE_H
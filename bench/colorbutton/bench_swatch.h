@@ -0,0 +1,136 @@
+/*  QExt: Extensions to Qt
+ *  Copyright (C) 2016  Jonathan Harper
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QE_BENCH_SWATCH_H
+#define QE_BENCH_SWATCH_H
+
+#include <cstdio>
+#include <memory>
+#include <vector>
+#include <QtCore/QCoreApplication>
+#include <QtCore/QSet>
+#include <QtWidgets/QWidget>
+#include "../../test/core/test.h"
+#include "colorbutton.h"
+
+struct swatch_bench
+{
+    static constexpr std::size_t Buttons = 10000;
+
+    //! Returns one of \a colors distinct, opaque colors.
+    static QColor colorAt(std::size_t i, std::size_t colors)
+    {
+        return QColor::fromRgb(QRgb(0xff000000u | ((quint32(i % colors) * 2654435761u) & 0xffffffu)));
+    }
+
+    //! Creates Buttons buttons cycling through \a Colors colors and reports the time per button,
+    //! including the deferred first update.
+    template <std::size_t Colors>
+    static void create(qe_test::Bench &bench)
+    {
+        std::unique_ptr<QWidget> parent;
+        std::vector<QeColorButton *> buttons;
+        bench.setSamples(11).setBatch(Buttons);
+        bench.run([&] {
+            parent.reset(new QWidget);
+            buttons.clear();
+            buttons.reserve(Buttons);
+        }, [&] {
+            for (std::size_t i = 0; i < Buttons; ++i)
+                buttons.push_back(new QeColorButton(colorAt(i, Colors), parent.get()));
+            QCoreApplication::processEvents();
+        });
+
+        QSet<qint64> icons;
+        for (auto button : buttons)
+            icons.insert(button->icon().cacheKey());
+        std::printf("       %d distinct icons\n", icons.size());
+    }
+
+    //! Returns 100 buttons in \a parent.
+    static std::vector<QeColorButton *> makeButtons(QWidget *parent)
+    {
+        std::vector<QeColorButton *> buttons;
+        for (std::size_t i = 0; i < 100; ++i)
+            buttons.push_back(new QeColorButton(colorAt(i, 16), parent));
+        return buttons;
+    }
+
+    static void set_color_unchanged(qe_test::Bench &bench)
+    {
+        std::unique_ptr<QWidget> parent(new QWidget);
+        const std::vector<QeColorButton *> buttons = makeButtons(parent.get());
+        std::size_t i = 0;
+        bench.run([&] {
+            auto button = buttons[i++ % buttons.size()];
+            button->setColor(button->color());
+        });
+    }
+
+    static void set_color_flush(qe_test::Bench &bench)
+    {
+        std::unique_ptr<QWidget> parent(new QWidget);
+        const std::vector<QeColorButton *> buttons = makeButtons(parent.get());
+        std::size_t i = 0;
+        bench.run([&] {
+            auto button = buttons[i % buttons.size()];
+            button->setColor(colorAt(i, 16));
+            button->flushUpdates();
+            ++i;
+        });
+    }
+
+    //! Applies a theme of three property changes to 100 buttons, as bulk palette loads do,
+    //! updating each button after every change (\a FlushEach) or once per pass of the event loop.
+    template <bool FlushEach>
+    static void theme(qe_test::Bench &bench)
+    {
+        std::unique_ptr<QWidget> parent(new QWidget);
+        const std::vector<QeColorButton *> buttons = makeButtons(parent.get());
+        QCoreApplication::processEvents();
+
+        std::size_t i = 0;
+        bench.run([&] {
+            for (std::size_t b = 0; b < buttons.size(); ++b) {
+                auto button = buttons[b];
+                button->setColor(colorAt(i + b, 16));
+                if (FlushEach)
+                    button->flushUpdates();
+                button->setFrameVisible(i & 1);
+                if (FlushEach)
+                    button->flushUpdates();
+                button->setTextFormat((i & 1) ? QStringLiteral("%h, %s, %v") : QStringLiteral("%r, %g, %b"));
+                if (FlushEach)
+                    button->flushUpdates();
+            }
+            QCoreApplication::processEvents();
+            ++i;
+        });
+    }
+
+    static void add()
+    {
+        qe_test::add_benchmark("colorbutton_create_16_colors", &create<16>);
+        qe_test::add_benchmark("colorbutton_create_distinct_colors", &create<Buttons>);
+        qe_test::add_benchmark("colorbutton_set_color_unchanged", &set_color_unchanged);
+        qe_test::add_benchmark("colorbutton_set_color_flush_16_colors", &set_color_flush);
+        qe_test::add_benchmark("colorbutton_theme_x100_update_per_change", &theme<true>);
+        qe_test::add_benchmark("colorbutton_theme_x100_coalesced", &theme<false>);
+    }
+};
+
+#endif // QE_BENCH_SWATCH_H
@@ -0,0 +1,92 @@
+/*  QExt: Extensions to Qt
+ *  Copyright (C) 2016  Jonathan Harper
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QE_BENCH_TEXTFORMAT_H
+#define QE_BENCH_TEXTFORMAT_H
+
+#include <QtGui/QColor>
+#include <qecore/debugutil.h>
+#include "../../test/core/test.h"
+#include "colorbutton_p.h"
+
+struct textformat_bench
+{
+    static const char *formatText(int index)
+    {
+        static const char *const formats[] = {"%r, %g, %b", "hsv(%h, %s, %v) hsl(%H, %S, %L)"};
+        return formats[index];
+    }
+
+    //! The previous updateText(): parses the format on every call and reads each component from
+    //! the color as given, converting color spaces once per component.
+    static void interpret(QString &out, const QString &format, const QColor &color)
+    {
+        const QChar *p = format.constData();
+        const QChar *end = p + format.size();
+        while (p != end) {
+            if (*p == QLatin1Char('%') && p + 1 != end && qe::formatInto(out, color, p[1].toLatin1(), 2)) {
+                p += 2;
+                continue;
+            }
+            out += *p++;
+        }
+    }
+
+    static QColor colorAt(std::size_t i)
+    {
+        return QColor::fromRgb(QRgb(0xff000000u | ((quint32(i) * 2654435761u) & 0xffffffu)));
+    }
+
+    template <int Format>
+    static void parse_per_render(qe_test::Bench &bench)
+    {
+        const QString text = QString::fromLatin1(formatText(Format));
+        QString out;
+        out.reserve(128);
+        std::size_t i = 0;
+        bench.run([&] {
+            out.truncate(0);
+            interpret(out, text, colorAt(i++));
+            qe_test::keep(out);
+        });
+    }
+
+    template <int Format>
+    static void compiled_program(qe_test::Bench &bench)
+    {
+        QeColorTextProgram program;
+        program.compile(QString::fromLatin1(formatText(Format)));
+        QString out;
+        out.reserve(128);
+        std::size_t i = 0;
+        bench.run([&] {
+            out.truncate(0);
+            program.render(out, colorAt(i++));
+            qe_test::keep(out);
+        });
+    }
+
+    static void add()
+    {
+        qe_test::add_benchmark("textformat_rgb_parse_per_render", &parse_per_render<0>);
+        qe_test::add_benchmark("textformat_rgb_compiled_program", &compiled_program<0>);
+        qe_test::add_benchmark("textformat_hsv_hsl_parse_per_render", &parse_per_render<1>);
+        qe_test::add_benchmark("textformat_hsv_hsl_compiled_program", &compiled_program<1>);
+    }
+};
+
+#endif // QE_BENCH_TEXTFORMAT_H
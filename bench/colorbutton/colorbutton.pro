@@ -0,0 +1,28 @@
+QT += core gui widgets
+
+TARGET = colorbutton_bench
+TEMPLATE = app
+CONFIG += console c++1z release
+
+INCLUDEPATH += ../../Include ../../example/colorbutton
+
+include(../../src/core/core.pri)
+
+SOURCES += \
+	$$PWD/main.cpp \
+	$$PWD/../../example/colorbutton/colorbutton.cpp \
+	$$PWD/../../example/colorbutton/colorpalette.cpp
+
+HEADERS += \
+    $$PWD/../../test/core/test.h \
+    $$PWD/../../test/core/baseline.h \
+    $$PWD/../../test/core/perfcounters.h \
+    $$PWD/bench_swatch.h \
+    $$PWD/bench_textformat.h \
+    $$PWD/bench_palette.h \
+    $$PWD/bench_dialog.h \
+    $$PWD/bench_suite.h \
+    $$PWD/../../example/colorbutton/colorbutton.h \
+    $$PWD/../../example/colorbutton/colorbutton_p.h \
+    $$PWD/../../example/colorbutton/colorpalette.h \
+    $$PWD/../../example/colorbutton/colorpalette_p.h
@@ -0,0 +1,28 @@
+#include <QtWidgets/QApplication>
+#include "bench_swatch.h"
+#include "bench_textformat.h"
+#include "bench_palette.h"
+#include "bench_dialog.h"
+#include "bench_suite.h"
+
+#if defined(__GLIBC__)
+QE_TEST_COUNT_MALLOC
+#else
+QE_TEST_COUNT_ALLOCATIONS
+#endif
+
+int main(int argc, char *argv[])
+{
+    //the benchmarks never show a window; run without a display unless told otherwise
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    QApplication app(argc, argv);
+
+    suite_bench::add();
+    swatch_bench::add();
+    textformat_bench::add();
+    palette_bench::add();
+    dialog_bench::add();
+
+    return qe_test::run_benchmarks(argc, argv);
+}
@@ -0,0 +1,116 @@
+/*  QExt: Extensions to Qt
+ *  Copyright (C) 2016  Jonathan Harper
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QE_BENCH_DEBUGUTIL_H
+#define QE_BENCH_DEBUGUTIL_H
+
+#include <QtCore/QPoint>
+#include <QtCore/QRect>
+#include <QtCore/QVariant>
+#include <QtCore/QVector>
+#include <qecore/debugutil.h>
+#include "../../test/core/test.h"
+
+//! The switch-based qe::toString as it was before the formatter registry, for comparison.
+//! Only the cases exercised below are reproduced.
+inline QString legacy_toString(const QVariant &var)
+{
+    QString ret;
+    switch(static_cast<QMetaType::Type>(var.type())) {
+    case QMetaType::QString:
+    case QMetaType::Double:
+    case QMetaType::Int:
+        ret = var.toString();
+        break;
+    case QMetaType::QPoint:
+    {
+        QPoint p = var.value<QPoint>();
+        ret = QString(QStringLiteral("(%1, %2)")).arg(p.x()).arg(p.y());
+        break;
+    }
+    case QMetaType::QRect:
+    {
+        QRect r = var.value<QRect>();
+        ret = QString(QStringLiteral("[(%1, %2), %3 x %4]")).arg(
+                    r.left()).arg(r.top()).arg(r.width()).arg(r.height());
+        break;
+    }
+    default:
+        break;
+    }
+    return ret;
+}
+
+struct debugutil_bench
+{
+    static constexpr int Values = 1024;
+
+    //! A mix of property values, as a trace log would see them.
+    static QVector<QVariant> makeValues()
+    {
+        QVector<QVariant> values;
+        for (int i = 0; i < Values; ++i) {
+            switch (i % 4) {
+            case 0: values.append(QVariant(i * 7919)); break;
+            case 1: values.append(QVariant(QPoint(i, -i))); break;
+            case 2: values.append(QVariant(QRect(i, i * 2, 640, 480))); break;
+            default: values.append(QVariant(QStringLiteral("property"))); break;
+            }
+        }
+        return values;
+    }
+
+    static void legacy_to_string(qe_test::Bench &bench)
+    {
+        const QVector<QVariant> values = makeValues();
+        int i = 0;
+        bench.run([&] {
+            qe_test::keep(legacy_toString(values.at(i++ & (Values - 1))));
+        });
+    }
+
+    static void to_string(qe_test::Bench &bench)
+    {
+        const QVector<QVariant> values = makeValues();
+        int i = 0;
+        bench.run([&] {
+            qe_test::keep(qe::toString(values.at(i++ & (Values - 1))));
+        });
+    }
+
+    static void format_into_reused(qe_test::Bench &bench)
+    {
+        const QVector<QVariant> values = makeValues();
+        QString buffer;
+        buffer.reserve(256);
+        int i = 0;
+        bench.run([&] {
+            buffer.truncate(0);
+            qe::formatInto(buffer, values.at(i++ & (Values - 1)));
+            qe_test::keep(buffer);
+        });
+    }
+
+    static void add()
+    {
+        qe_test::add_benchmark("legacy_to_string_qvariant", &legacy_to_string);
+        qe_test::add_benchmark("to_string_qvariant", &to_string);
+        qe_test::add_benchmark("format_into_qvariant_reused", &format_into_reused);
+    }
+};
+
+#endif // QE_BENCH_DEBUGUTIL_H
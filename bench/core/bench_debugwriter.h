@@ -0,0 +1,95 @@
+/*  QExt: Extensions to Qt
+ *  Copyright (C) 2016  Jonathan Harper
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QE_BENCH_DEBUGWRITER_H
+#define QE_BENCH_DEBUGWRITER_H
+
+#include <cstdio>
+#include <QtCore/QDebug>
+#include <QtCore/QString>
+#include <qecore/debugwriter.h>
+#include "../../test/core/test.h"
+
+namespace debugwriter_bench_detail {
+
+//! Discards messages so the benchmark measures qDebug itself rather than the console.
+inline void discardMessage(QtMsgType, const QMessageLogContext &, const QString &message)
+{
+    qe_test::keep(message);
+}
+
+} // namespace debugwriter_bench_detail
+
+struct debugwriter_bench
+{
+    static QString path()
+    {
+        return QStringLiteral("C:/Users/someone/Documents/a/path/that/does/not/exist.txt");
+    }
+
+    static void qdebug(qe_test::Bench &bench)
+    {
+        using namespace debugwriter_bench_detail;
+        const QString p = path();
+        auto previous = qInstallMessageHandler(&discardMessage);
+        bench.run([&] {
+            qDebug() << "Failed to create NodeInfo from path: " << p;
+        });
+        qInstallMessageHandler(previous);
+    }
+
+    //! Runs \a fn with a DebugWriter that discards its messages, and prints how many it dropped.
+    template <class Fn>
+    static void write(qe_test::Bench &bench, Fn &&fn)
+    {
+        auto &writer = qe::DebugWriter::instance();
+        //large enough that the producer is not just counting drops
+        writer.setBufferSize(64 * 1024 * 1024);
+        writer.setSink([](const QString &message) { qe_test::keep(message); });
+        const quint64 droppedBefore = writer.droppedCount();
+        bench.run(fn);
+        writer.flush();
+        std::printf("       %llu dropped\n", static_cast<unsigned long long>(writer.droppedCount() - droppedBefore));
+        writer.setSink(nullptr);
+    }
+
+    static void write_qstring(qe_test::Bench &bench)
+    {
+        const QString p = path();
+        write(bench, [&] {
+            QE_DEBUG_WRITE("Failed to create NodeInfo from path: %1", p);
+        });
+    }
+
+    static void write_int_int(qe_test::Bench &bench)
+    {
+        int i = 0;
+        write(bench, [&] {
+            QE_DEBUG_WRITE("Item %1 of %2", i, i + 1);
+            ++i;
+        });
+    }
+
+    static void add()
+    {
+        qe_test::add_benchmark("qdebug_literal_qstring", &qdebug);
+        qe_test::add_benchmark("debug_write_qstring", &write_qstring);
+        qe_test::add_benchmark("debug_write_int_int", &write_int_int);
+    }
+};
+
+#endif // QE_BENCH_DEBUGWRITER_H
@@ -0,0 +1,98 @@
+/*  QExt: Extensions to Qt
+ *  Copyright (C) 2016  Jonathan Harper
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QE_BENCH_FORMATINTO_H
+#define QE_BENCH_FORMATINTO_H
+
+#include <QtCore/QLocale>
+#include <QtCore/QString>
+#include <qecore/debugutil.h>
+#include "../../test/core/test.h"
+
+//! Formats values into a reused buffer with QString::number and with qe::formatInto.
+struct formatinto_bench
+{
+    //! Runs \a fn(buffer, i) for i = 0, 1, 2 and so on, flushing the buffer periodically, as a
+    //! log or table writer would.
+    template <class Fn>
+    static void append(qe_test::Bench &bench, Fn &&fn)
+    {
+        QString buffer;
+        buffer.reserve(4096);
+        std::size_t i = 0;
+        bench.run([&] {
+            fn(buffer, i++);
+            if (buffer.size() > 4000)
+                buffer.truncate(0);
+        });
+        qe_test::keep(buffer);
+    }
+
+    static void number_int(qe_test::Bench &bench)
+    {
+        append(bench, [](QString &buffer, std::size_t i) {
+            buffer += QString::number(int(i * 2654435761u));
+        });
+    }
+
+    static void format_int(qe_test::Bench &bench)
+    {
+        append(bench, [](QString &buffer, std::size_t i) {
+            qe::formatInto(buffer, int(i * 2654435761u));
+        });
+    }
+
+    static void number_double_shortest(qe_test::Bench &bench)
+    {
+        append(bench, [](QString &buffer, std::size_t i) {
+            buffer += QString::number(double(i) * 0.001, 'g', QLocale::FloatingPointShortest);
+        });
+    }
+
+    static void format_double(qe_test::Bench &bench)
+    {
+        append(bench, [](QString &buffer, std::size_t i) {
+            qe::formatInto(buffer, double(i) * 0.001);
+        });
+    }
+
+    static void number_double_fixed(qe_test::Bench &bench)
+    {
+        append(bench, [](QString &buffer, std::size_t i) {
+            buffer += QString::number(double(i) * 0.001, 'f', 2);
+        });
+    }
+
+    static void format_double_fixed(qe_test::Bench &bench)
+    {
+        append(bench, [](QString &buffer, std::size_t i) {
+            qe::formatInto(buffer, double(i) * 0.001, 'f', 2);
+        });
+    }
+
+    static void add()
+    {
+        qe_test::add_benchmark("qstring_number_int", &number_int);
+        qe_test::add_benchmark("format_into_int", &format_int);
+        qe_test::add_benchmark("qstring_number_double_shortest", &number_double_shortest);
+        qe_test::add_benchmark("format_into_double", &format_double);
+        qe_test::add_benchmark("qstring_number_double_fixed", &number_double_fixed);
+        qe_test::add_benchmark("format_into_double_fixed", &format_double_fixed);
+    }
+};
+
+#endif // QE_BENCH_FORMATINTO_H
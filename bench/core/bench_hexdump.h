@@ -0,0 +1,123 @@
+/*  QExt: Extensions to Qt
+ *  Copyright (C) 2016  Jonathan Harper
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QE_BENCH_HEXDUMP_H
+#define QE_BENCH_HEXDUMP_H
+
+#include <vector>
+#include <QtCore/QByteArray>
+#include <qecore/debugutil.h>
+#include "../../src/core/debugutil_p.h"
+#include "../../test/core/test.h"
+
+//! Hex encoding one byte at a time through QString::number, as callers of toHexString did.
+inline QString legacy_hexString(const QByteArray &bytes)
+{
+    QString ret;
+    for (char c : bytes) {
+        const auto b = static_cast<uchar>(c);
+        if (b < 0x10)
+            ret += QLatin1Char('0');
+        ret += QString::number(b, 16);
+    }
+    return ret;
+}
+
+struct hexdump_bench
+{
+    static constexpr int Size = 1 << 20;
+
+    static QByteArray makeBytes()
+    {
+        QByteArray bytes(Size, Qt::Uninitialized);
+        unsigned seed = 1;
+        for (int i = 0; i < Size; ++i) {
+            seed = seed * 1103515245u + 12345u;
+            bytes[i] = static_cast<char>(seed >> 16);
+        }
+        return bytes;
+    }
+
+    template <qe::detail::SimdLevel Level>
+    static void encode(qe_test::Bench &bench)
+    {
+        const QByteArray bytes = makeBytes();
+        auto in = reinterpret_cast<const unsigned char *>(bytes.constData());
+        std::vector<char> out(std::size_t(Size) * 2);
+        bench.setBytes(Size);
+        bench.run([&] {
+            qe::detail::hexEncode(in, std::size_t(Size), out.data(), false, Level);
+            qe_test::keep(out[0]);
+        });
+    }
+
+    static void legacy_per_byte(qe_test::Bench &bench)
+    {
+        const QByteArray bytes = makeBytes();
+        bench.setSamples(11).setBytes(Size);
+        bench.run([&] {
+            qe_test::keep(legacy_hexString(bytes));
+        });
+    }
+
+    static void to_hex(qe_test::Bench &bench)
+    {
+        const QByteArray bytes = makeBytes();
+        bench.setBytes(Size);
+        bench.run([&] {
+            qe_test::keep(bytes.toHex());
+        });
+    }
+
+    static void hex_into_reused(qe_test::Bench &bench)
+    {
+        const QByteArray bytes = makeBytes();
+        QString buffer;
+        bench.setBytes(Size);
+        bench.run([&] {
+            buffer.truncate(0);
+            qe::hexInto(buffer, bytes);
+            qe_test::keep(buffer);
+        });
+    }
+
+    static void hex_dump(qe_test::Bench &bench)
+    {
+        const QByteArray bytes = makeBytes();
+        bench.setSamples(11).setBytes(Size);
+        bench.run([&] {
+            qe_test::keep(qe::hexDump(bytes));
+        });
+    }
+
+    static void add()
+    {
+        using qe::detail::SimdLevel;
+        qe_test::add_benchmark("hex_encode_scalar", &encode<SimdLevel::Scalar>);
+#ifdef QE_SIMD_X86
+        qe_test::add_benchmark("hex_encode_sse2", &encode<SimdLevel::SSE2>);
+        if (qe::detail::simdLevel() == SimdLevel::AVX2)
+            qe_test::add_benchmark("hex_encode_avx2", &encode<SimdLevel::AVX2>);
+#endif
+        qe_test::add_benchmark("legacy_hex_per_byte_qstring_number", &legacy_per_byte);
+        qe_test::add_benchmark("qbytearray_to_hex", &to_hex);
+        qe_test::add_benchmark("hex_into_qbytearray_reused", &hex_into_reused);
+        qe_test::add_benchmark("hex_dump_qbytearray", &hex_dump);
+    }
+};
+
+#endif // QE_BENCH_HEXDUMP_H
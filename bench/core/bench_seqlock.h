@@ -0,0 +1,148 @@
+/*  QExt: Extensions to Qt
+ *  Copyright (C) 2016  Jonathan Harper
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QE_BENCH_SEQLOCK_H
+#define QE_BENCH_SEQLOCK_H
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <QtCore/QReadWriteLock>
+#include <qecore/seqlock.h>
+#include "../../test/core/test.h"
+
+class SeqValuePrivate;
+class SeqValue : public qe::PublicBase
+{
+public:
+    SeqValue();
+    int value() const;
+    void setValue(int v);
+private:
+    QE_DECLARE_PRIVATE(SeqValue)
+};
+
+class SeqValuePrivate : public qe::SeqLockedPrivate
+{
+    QE_DECLARE_PUBLIC(SeqValue)
+public:
+    SeqValuePrivate(qe::PublicBase *qq) : qe::SeqLockedPrivate(qq) {}
+    int value = 0;
+};
+
+SeqValue::SeqValue() : qe::PublicBase(*new SeqValuePrivate(this)) {}
+
+int SeqValue::value() const
+{
+    return QE_CD_READ(d->value);
+}
+
+void SeqValue::setValue(int v)
+{
+    QE_D;
+    qe::SeqWriteLocker lock(d);
+    d->value = v;
+}
+
+class LockedValuePrivate;
+class LockedValue : public qe::PublicBase
+{
+public:
+    LockedValue();
+    int value() const;
+    void setValue(int v);
+private:
+    QE_DECLARE_PRIVATE(LockedValue)
+};
+
+class LockedValuePrivate : public qe::PrivateBase
+{
+    QE_DECLARE_PUBLIC(LockedValue)
+public:
+    LockedValuePrivate(qe::PublicBase *qq) : qe::PrivateBase(qq) {}
+    mutable QReadWriteLock lock;
+    int value = 0;
+};
+
+LockedValue::LockedValue() : qe::PublicBase(*new LockedValuePrivate(this)) {}
+
+int LockedValue::value() const
+{
+    QE_CD;
+    QReadLocker locker(&d->lock);
+    return d->value;
+}
+
+void LockedValue::setValue(int v)
+{
+    QE_D;
+    QWriteLocker locker(&d->lock);
+    d->value = v;
+}
+
+struct seqlock_bench
+{
+    static constexpr std::size_t ReadsPerThread = 2000000;
+
+    //! Times \a Readers threads reading a \a Value while one thread writes it every 50
+    //! microseconds, as wall time per read.
+    template <class Value, int Readers>
+    static void read(qe_test::Bench &bench)
+    {
+        Value value;
+        std::atomic<bool> done{false};
+        std::thread writer([&] {
+            int i = 0;
+            while (!done.load(std::memory_order_relaxed)) {
+                value.setValue(++i);
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+            }
+        });
+
+        bench.setSamples(11).setBatch(ReadsPerThread * Readers);
+        bench.run([&] {
+            std::vector<std::thread> threads;
+            for (int t = 0; t < Readers; ++t) {
+                threads.emplace_back([&] {
+                    long long sum = 0;
+                    for (std::size_t i = 0; i < ReadsPerThread; ++i)
+                        sum += value.value();
+                    qe_test::keep(sum);
+                });
+            }
+            for (auto &t : threads)
+                t.join();
+        });
+        done = true;
+        writer.join();
+    }
+
+    static void add()
+    {
+        qe_test::add_benchmark("seqlocked_read_1_reader", &read<SeqValue, 1>);
+        qe_test::add_benchmark("rwlock_read_1_reader", &read<LockedValue, 1>);
+        qe_test::add_benchmark("seqlocked_read_2_readers", &read<SeqValue, 2>);
+        qe_test::add_benchmark("rwlock_read_2_readers", &read<LockedValue, 2>);
+        qe_test::add_benchmark("seqlocked_read_4_readers", &read<SeqValue, 4>);
+        qe_test::add_benchmark("rwlock_read_4_readers", &read<LockedValue, 4>);
+        qe_test::add_benchmark("seqlocked_read_8_readers", &read<SeqValue, 8>);
+        qe_test::add_benchmark("rwlock_read_8_readers", &read<LockedValue, 8>);
+    }
+};
+
+#endif // QE_BENCH_SEQLOCK_H
@@ -0,0 +1,22 @@
+QT += core gui
+
+TARGET = core_bench
+TEMPLATE = app
+CONFIG += console c++1z release
+
+INCLUDEPATH += ../../Include
+
+include(../../src/core/core.pri)
+
+SOURCES += \
+	$$PWD/main.cpp
+
+HEADERS += \
+    $$PWD/../../test/core/test.h \
+    $$PWD/../../test/core/baseline.h \
+    $$PWD/../../test/core/perfcounters.h \
+    $$PWD/bench_seqlock.h \
+    $$PWD/bench_debugutil.h \
+    $$PWD/bench_hexdump.h \
+    $$PWD/bench_debugwriter.h \
+    $$PWD/bench_formatinto.h
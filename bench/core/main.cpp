@@ -0,0 +1,16 @@
+#include "bench_seqlock.h"
+#include "bench_debugutil.h"
+#include "bench_hexdump.h"
+#include "bench_debugwriter.h"
+#include "bench_formatinto.h"
+
+int main(int argc, char *argv[])
+{
+    seqlock_bench::add();
+    debugutil_bench::add();
+    hexdump_bench::add();
+    debugwriter_bench::add();
+    formatinto_bench::add();
+
+    return qe_test::run_benchmarks(argc, argv);
+}
@@ -17,6 +17,10 @@
 *******************************************************************************/
 
 #include "colorbutton_p.h"
+#include <qecore/debugutil.h>
+#include <QtCore/QCache>
+#include <QtCore/QCoreApplication>
+#include <QtCore/QTimer>
 #include <QtGui/QPainter>
 #include <QtWidgets/QColorDialog>
 
@@ -29,50 +33,301 @@ void QeColorButtonPrivate::init()
     QE_QPTR;
     q->setToolButtonStyle(Qt::ToolButtonTextBesideIcon);
     QObject::connect(q, &QAbstractButton::clicked, q, &QeColorButton::showColorDialog);
-    updateIcon();
-    updateText();
+    textProgram.compile(format);
+    //a new button has its icon and text at once; only later changes are queued
+    dirty = IconDirty | TextDirty;
+    flush();
 }
 
-//! Updates the icon after a change in the color
-void QeColorButtonPrivate::updateIcon()
+//! \brief Marks the parts of the button in \a flags as out of date.
+//! The first call after a flush queues a single update for the next pass of the event loop;
+//! further calls before then only add to the flags.
+void QeColorButtonPrivate::markDirty(int flags)
 {
+    dirty |= flags;
+    if (updateQueued)
+        return;
+    updateQueued = true;
     QE_QPTR;
-    QPixmap pixmap(q->iconSize());
+    QMetaObject::invokeMethod(q, "flushUpdates", Qt::QueuedConnection);
+}
+
+//! Applies the updates marked by markDirty(), if any.
+void QeColorButtonPrivate::flush()
+{
+    const int flags = dirty;
+    dirty = 0;
+    updateQueued = false;
+    if (flags & IconDirty)
+        updateIcon();
+    if (flags & TextDirty)
+        updateText();
+}
+
+namespace {
+
+//! Swatches are small; 1 MiB holds about a thousand 16x16 swatches at a device pixel ratio of 1.
+int swatchCacheKilobytes = 1024;
+
+void clearSwatchCache();
+
+//! \internal
+//! Returns the process-wide swatch cache. The cost of an entry is its size in KiB.
+QCache<QeColorSwatchKey, QIcon> &swatchCache()
+{
+    static QCache<QeColorSwatchKey, QIcon> cache(swatchCacheKilobytes);
+    static bool registered = false;
+    if (!registered) {
+        //pixmaps must not outlive the application object
+        qAddPostRoutine(clearSwatchCache);
+        registered = true;
+    }
+    return cache;
+}
+
+void clearSwatchCache()
+{
+    swatchCache().clear();
+}
+
+//! \internal
+//! Paints the swatch described by \a key.
+QPixmap renderSwatch(const QeColorSwatchKey &key)
+{
+    QPixmap pixmap(key.size * key.devicePixelRatio);
+    pixmap.setDevicePixelRatio(key.devicePixelRatio);
     pixmap.fill(Qt::transparent);
     QPainter painter(&pixmap);
+    QeColorButtonPrivate::paintSwatch(&painter, QRect(QPoint(), key.size),
+                                      QColor::fromRgba64(QRgba64::fromRgba64(key.color)),
+                                      key.drawFrame, QColor::fromRgba(key.shadow));
+    painter.end();
+    return pixmap;
+}
+
+} // namespace
 
-    QRect rect = pixmap.rect().adjusted(0,0,-1,-1);
+//! \brief Paints a swatch of \a color filling \a rect, framed in \a frameColor if \a drawFrame is true.
+//! This is the drawing shared by the button icons and QeColorPalette.
+void QeColorButtonPrivate::paintSwatch(QPainter *painter, const QRect &rect, const QColor &color,
+                                       bool drawFrame, const QColor &frameColor)
+{
+    QRect fill = rect.adjusted(0,0,-1,-1);
     if (drawFrame) {
-        painter.setPen(QPen(q->palette().shadow(), 1));
-        painter.drawRect(rect);
-        rect.adjust(2, 2, -1, -1);
+        painter->setPen(QPen(frameColor, 1));
+        painter->drawRect(fill);
+        fill.adjust(2, 2, -1, -1);
     }
+    painter->fillRect(fill, color);
+}
 
-    painter.fillRect(rect, color);
-    painter.end();
-    q->setIcon(QIcon(pixmap));
+//! Returns the key of the swatch for the current state of the button.
+QeColorSwatchKey QeColorButtonPrivate::swatchKey() const
+{
+    QE_CONST_QPTR;
+    QeColorSwatchKey key;
+    key.color = color.rgba64();
+    key.size = q->iconSize();
+    key.shadow = q->palette().shadow().color().rgba();
+    key.devicePixelRatio = q->devicePixelRatioF();
+    key.drawFrame = drawFrame;
+    return key;
 }
 
+//! \brief Returns the swatch icon for \a key, painting it only if it is not already cached.
+//! Every button showing the same swatch shares the returned icon.
+QIcon QeColorButtonPrivate::swatchIcon(const QeColorSwatchKey &key)
+{
+    auto &cache = swatchCache();
+    if (QIcon *icon = cache.object(key))
+        return *icon;
+
+    const QSize pixels = key.size * key.devicePixelRatio;
+    const int cost = qMax(1, pixels.width() * pixels.height() * 4 / 1024);
+    QIcon icon(renderSwatch(key));
+    cache.insert(key, new QIcon(icon), cost);
+    return icon;
+}
+
+//! Updates the icon after a change in the color
+void QeColorButtonPrivate::updateIcon()
+{
+    const QeColorSwatchKey key = swatchKey();
+    if (key == iconKey)
+        return;
+    iconKey = key;
+
+    QE_QPTR;
+    q->setIcon(swatchIcon(key));
+}
+
+namespace {
+
+const char SharedDialogName[] = "qe_colorbutton_dialog";
+
+//! Live previews update the button at most once per frame at 60 Hz.
+constexpr int PreviewInterval = 16;
+
+} // namespace
+
+//! \brief Returns the color dialog shared by the buttons in \a window, creating it if necessary.
+//! The dialog is a child of \a window, so it is destroyed with it.
+QColorDialog *QeColorButtonPrivate::sharedDialog(QWidget *window)
+{
+    const QString name = QLatin1String(SharedDialogName);
+    auto dlg = window->findChild<QColorDialog *>(name, Qt::FindDirectChildrenOnly);
+    if (dlg)
+        return dlg;
+
+    dlg = new QColorDialog(window);
+    dlg->setObjectName(name);
+    //polish and lay out now rather than when the dialog is first shown
+    dlg->ensurePolished();
+    dlg->adjustSize();
+    return dlg;
+}
+
+//! Shows \a dialog without blocking and previews its current color on the button.
+void QeColorButtonPrivate::beginPreview(QColorDialog *dialog)
+{
+    QE_QPTR;
+    previewOrigin = color;
+    if (!previewTimer) {
+        previewTimer = new QTimer(q);
+        previewTimer->setSingleShot(true);
+        previewTimer->setInterval(PreviewInterval);
+        QObject::connect(previewTimer, &QTimer::timeout, q, [this] {
+            if (!previewDeferred)
+                return;
+            previewDeferred = false;
+            QE_QPTR;
+            q->setColor(previewPending);
+            previewTimer->start();
+        });
+    }
+
+    previewConnections[0] = QObject::connect(dialog, &QColorDialog::currentColorChanged, q,
+                                             [this](const QColor &c) { previewColor(c); });
+    previewConnections[1] = QObject::connect(dialog, &QDialog::finished, q,
+                                             [this, dialog](int result) { endPreview(dialog, result); });
+    dialog->setModal(false);
+    dialog->show();
+    dialog->raise();
+    dialog->activateWindow();
+}
+
+//! \brief Applies \a c to the button, throttled to one change per PreviewInterval.
+//! The first change is applied at once; the latest of any that follow within the interval is
+//! applied when it ends.
+void QeColorButtonPrivate::previewColor(const QColor &c)
+{
+    previewPending = c;
+    if (previewTimer->isActive()) {
+        previewDeferred = true;
+        return;
+    }
+    QE_QPTR;
+    q->setColor(c);
+    previewTimer->start();
+}
+
+//! Ends a live preview: keeps the selected color if \a dialog was accepted and restores the original otherwise.
+void QeColorButtonPrivate::endPreview(QColorDialog *dialog, int result)
+{
+    QObject::disconnect(previewConnections[0]);
+    QObject::disconnect(previewConnections[1]);
+    previewTimer->stop();
+    previewDeferred = false;
+
+    QE_QPTR;
+    const QColor chosen = result == QDialog::Accepted ? dialog->selectedColor() : previewOrigin;
+    q->setColor(chosen);
+    if (chosen != previewOrigin)
+        emit q->colorChanged(chosen);
+}
+
+//! Renders the text format and updates the button text if it changed.
 void QeColorButtonPrivate::updateText()
 {
-    QString txt = format;
-    txt.replace(QStrLit("%r"), QString::number(color.red()));
-    txt.replace(QStrLit("%R"), QString::number(color.redF(), 'g', 2));
-    txt.replace(QStrLit("%g"), QString::number(color.green()));
-    txt.replace(QStrLit("%G"), QString::number(color.greenF(), 'g', 2));
-    txt.replace(QStrLit("%b"), QString::number(color.blue()));
-    txt.replace(QStrLit("%B"), QString::number(color.blueF(), 'g', 2));
-    txt.replace(QStrLit("%h"), QString::number(color.hue()));
-    txt.replace(QStrLit("%H"), QString::number(color.hueF(), 'g', 2));
-    txt.replace(QStrLit("%s"), QString::number(color.saturation()));
-    txt.replace(QStrLit("%S"), QString::number(color.saturationF(), 'g', 2));
-    txt.replace(QStrLit("%v"), QString::number(color.value()));
-    txt.replace(QStrLit("%V"), QString::number(color.valueF(), 'g', 2));
-    txt.replace(QStrLit("%l"), QString::number(color.lightness()));
-    txt.replace(QStrLit("%L"), QString::number(color.lightnessF(), 'g', 2));
+    text.truncate(0);
+    textProgram.render(text, color);
 
     QE_QPTR;
-    q->setText(txt);
+    if (text != q->text())
+        q->setText(text);
+}
+
+namespace {
+
+//! \internal
+//! Returns the color space read by \a component, or 0 if it is not a component.
+int componentSpace(char component)
+{
+    switch (component) {
+    case 'r': case 'R': case 'g': case 'G': case 'b': case 'B':
+        return QeColorTextProgram::Rgb;
+    case 'h': case 'H': case 's': case 'S': case 'v': case 'V':
+        return QeColorTextProgram::Hsv;
+    case 'l': case 'L':
+        return QeColorTextProgram::Hsl;
+    default:
+        return 0;
+    }
+}
+
+} // namespace
+
+//! \brief Parses \a format, replacing the current program.
+//! `%` followed by one of `rgbhsvl` (integer) or `RGBHSVL` (floating point) is a placeholder;
+//! everything else is copied as-is.
+void QeColorTextProgram::compile(const QString &format)
+{
+    m_format = format;
+    m_tokens.clear();
+    m_spaces = 0;
+
+    const QChar *begin = m_format.constData();
+    const QChar *end = begin + m_format.size();
+    const QChar *literal = begin;
+    for (const QChar *p = begin; p + 1 < end; ++p) {
+        if (*p != QLatin1Char('%'))
+            continue;
+        const char component = p[1].toLatin1();
+        const int space = componentSpace(component);
+        if (!space)
+            continue;
+        if (p != literal)
+            m_tokens.append({int(literal - begin), int(p - literal), 0});
+        m_tokens.append({0, 0, component});
+        m_spaces |= space;
+        ++p;
+        literal = p + 1;
+    }
+    if (literal != end)
+        m_tokens.append({int(literal - begin), int(end - literal), 0});
+}
+
+//! Appends the text for \a color to \a out.
+void QeColorTextProgram::render(QString &out, const QColor &color) const
+{
+    //QColor converts on every call to a component outside its own spec, so convert up front
+    QColor rgb, hsv, hsl;
+    if (m_spaces & Rgb)
+        rgb = color.spec() == QColor::Rgb ? color : color.toRgb();
+    if (m_spaces & Hsv)
+        hsv = color.spec() == QColor::Hsv ? color : color.toHsv();
+    if (m_spaces & Hsl)
+        hsl = color.spec() == QColor::Hsl ? color : color.toHsl();
+
+    const QChar *format = m_format.constData();
+    for (const Token &token : m_tokens) {
+        switch (componentSpace(token.component)) {
+        case Rgb: qe::formatInto(out, rgb, token.component, 2); break;
+        case Hsv: qe::formatInto(out, hsv, token.component, 2); break;
+        case Hsl: qe::formatInto(out, hsl, token.component, 2); break;
+        default:  out.append(format + token.offset, token.length); break;
+        }
+    }
 }
 
 //! Constructs a new QeColorButton with the color \a col, text format, \a txt and \a parent.
@@ -81,6 +336,7 @@ QeColorButton::QeColorButton(const QColor &color, QString textFormat, QWidget *p
 {
     setTextFormat(textFormat);
     setColor(color);
+    flushUpdates();
 }
 
 //! Constructs a new QeColorButton with the given color and parent.
@@ -88,6 +344,7 @@ QeColorButton::QeColorButton(const QColor &color, QWidget *parent)
     : QeColorButton(*new QeColorButtonPrivate(this), parent)
 {
     setColor(color);
+    flushUpdates();
 }
 
 //! The default constructor, with \arg parent as the parent widget.
@@ -137,17 +394,18 @@ void QeColorButton::setTextFormat(QString format)
     if (d->format == format)
         return;
     d->format = format;
-    d->updateText();
+    d->textProgram.compile(d->format);
+    d->markDirty(QeColorButtonPrivate::TextDirty);
 }
 
 //! \brief Setter for the `color` property.
 void QeColorButton::setColor(const QColor &c)
 {
     QE_DPTR;
-    if (c != d->color)
-        d->color = c;
-    d->updateIcon();
-    d->updateText();
+    if (c == d->color)
+        return;
+    d->color = c;
+    d->markDirty(QeColorButtonPrivate::IconDirty | QeColorButtonPrivate::TextDirty);
 }
 
 /*!
@@ -156,27 +414,104 @@ void QeColorButton::setColor(const QColor &c)
 void QeColorButton::setFrameVisible(bool b)
 {
     QE_DPTR;
-    if (b != d->drawFrame)
-        d->drawFrame = b;
-    d->updateIcon();
+    if (b == d->drawFrame)
+        return;
+    d->drawFrame = b;
+    d->markDirty(QeColorButtonPrivate::IconDirty);
+}
+
+/*!
+   \brief Applies pending changes to the icon and text immediately.
+
+   Property setters do not repaint the swatch or rebuild the text themselves. Instead, changes
+   made during one pass of the event loop are applied together at the start of the next. Call
+   this when the icon or text must be current before returning to the event loop, e.g. before
+   grabbing the widget or reading `text()`. A new button is already up to date when its
+   constructor returns.
+ */
+void QeColorButton::flushUpdates()
+{
+    QE_DPTR;
+    d->flush();
 }
 
+//! \brief Sets the size of the swatch cache shared by all color buttons to \a kilobytes.
+//! Least recently used swatches are evicted once the limit is exceeded. The default is 1024 KiB.
+void QeColorButton::setSwatchCacheLimit(int kilobytes)
+{
+    swatchCacheKilobytes = qMax(kilobytes, 0);
+    swatchCache().setMaxCost(swatchCacheKilobytes);
+}
 
+//! Returns the size, in KiB, of the swatch cache shared by all color buttons.
+int QeColorButton::swatchCacheLimit()
+{
+    return swatchCacheKilobytes;
+}
 
-//! Shows a color selection dialog and changes the current `color` property, if appropriate.
+//! \brief Shows a color selection dialog and changes the current `color` property, if appropriate.
 //! This will emit the `colorChanged(QColor)` signal.
+//!
+//! The dialog is shared by all of the buttons in a window and is created while the event loop
+//! is idle after the first button is shown, so opening it only needs to show it. If `livePreview`
+//! is enabled, the dialog is not modal: the button follows the dialog's current color as it
+//! changes, and `colorChanged(QColor)` is emitted once the dialog is accepted.
 void QeColorButton::showColorDialog()
 {
-    QColorDialog dlg(color());
-    dlg.exec();
+    QE_DPTR;
+    QColorDialog *dlg = d->sharedDialog(window());
+    //a live preview for another button ends (and reverts) when the dialog is reused
+    if (dlg->isVisible())
+        dlg->reject();
+    dlg->setCurrentColor(color());
+
+    if (d->livePreview) {
+        d->beginPreview(dlg);
+        return;
+    }
 
-    auto newColor = dlg.currentColor();
+    dlg->exec();
+    auto newColor = dlg->currentColor();
     if (newColor != color()) {
         setColor(newColor);
         emit colorChanged(newColor);
     }
 }
 
+//! \brief Returns whether the button follows the color dialog's current color while it is open.
+//! The default is false, which shows the dialog modally.
+bool QeColorButton::isLivePreviewEnabled() const
+{
+    QE_CD;
+    return d->livePreview;
+}
+
+//! \brief Sets whether showColorDialog() shows a non-modal dialog whose current color is previewed
+//! on the button while it is open.
+void QeColorButton::setLivePreviewEnabled(bool b)
+{
+    QE_D;
+    d->livePreview = b;
+}
+
+//! Returns the color dialog shared by the buttons in this button's window, creating it if necessary.
+QColorDialog *QeColorButton::colorDialog() const
+{
+    return QeColorButtonPrivate::sharedDialog(window());
+}
+
+//! Creates the shared color dialog for the window once the event loop is idle.
+void QeColorButton::showEvent(QShowEvent *event)
+{
+    QToolButton::showEvent(event);
+
+    QE_D;
+    if (d->dialogPrewarmed)
+        return;
+    d->dialogPrewarmed = true;
+    QTimer::singleShot(0, this, [this] { QeColorButtonPrivate::sharedDialog(window()); });
+}
+
 /*!
   \class QeColorButton
   \brief The QeColorButton class displays a user-selected color.
@@ -24,6 +24,8 @@
 
 #include <qecore/dptr.h>
 
+class QColorDialog;
+
 class QeColorButtonPrivate;
 class QeColorButton : public QToolButton, public qe::PublicBase
 {
@@ -32,6 +34,7 @@ class QeColorButton : public QToolButton, public qe::PublicBase
     Q_PROPERTY(QColor color READ color WRITE setColor NOTIFY colorChanged)
     Q_PROPERTY(bool isFrameVisible READ isFrameVisible WRITE setFrameVisible)
     Q_PROPERTY(QString textFormat READ textFormat WRITE setTextFormat)
+    Q_PROPERTY(bool livePreview READ isLivePreviewEnabled WRITE setLivePreviewEnabled)
 
 public:
     QeColorButton(const QColor &color, QString textFormat, QWidget *parent = nullptr);
@@ -43,10 +46,18 @@ public:
     bool isFrameVisible() const;
     QString textFormat() const;
     void setTextFormat(QString format);
+    bool isLivePreviewEnabled() const;
+    void setLivePreviewEnabled(bool b);
+
+    QColorDialog *colorDialog() const;
+
+    static void setSwatchCacheLimit(int kilobytes);
+    static int swatchCacheLimit();
 
 public Q_SLOTS:
     void setColor(const QColor &c);
     void setFrameVisible(bool b);
+    void flushUpdates();
     void showColorDialog();
 
 Q_SIGNALS:
@@ -55,6 +66,8 @@ Q_SIGNALS:
 protected:
     QeColorButton(QeColorButtonPrivate &dd, QWidget *parent = nullptr);
 
+    void showEvent(QShowEvent *event) override;
+
 private:
     Q_DISABLE_COPY(QeColorButton)
     QE_DECLARE_PRIVATE(QeColorButton)
@@ -3,16 +3,19 @@ QT += core gui widgets
 
 TARGET = colorbutton_example
 TEMPLATE = app
-CONFIG += C++14
+CONFIG += c++1z
 
 INCLUDEPATH += "../../Include"
 
 HEADERS += \ 
 	$$PWD/colorbutton.h \
-	$$PWD/colorbutton_p.h
+	$$PWD/colorbutton_p.h \
+	$$PWD/colorpalette.h \
+	$$PWD/colorpalette_p.h
 
 SOURCES += \ 
 	$$PWD/colorbutton.cpp \ 
+	$$PWD/colorpalette.cpp \
     $$PWD/main.cpp
 	
 win32 {
@@ -26,5 +29,8 @@ win32 {
 	}
 }
 
+#qe::formatInto and the other out-of-line qecore functions; there is no qecore library to link here
+!win32: include(../../src/core/core.pri)
+
 DISTFILES += \
     readme.md
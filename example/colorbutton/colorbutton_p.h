@@ -20,9 +20,76 @@
 #define QE_EXAMPLE_COLORBUTTON_P_H
 
 #include <QIcon>
+#include <QtCore/QHash>
+#include <QtCore/QSize>
+#include <QtCore/QVector>
 #include <qecore/dptr.h>
 #include "colorbutton.h"
 
+class QColorDialog;
+class QPainter;
+class QTimer;
+
+//! \brief Identifies a rendered color swatch.
+//! Buttons whose swatches have equal keys share a single cached QIcon.
+struct QeColorSwatchKey
+{
+    quint64 color = 0;              //QColor::rgba64()
+    QSize size;                     //logical icon size
+    QRgb shadow = 0;                //frame color, taken from the palette
+    qreal devicePixelRatio = 1.0;
+    bool drawFrame = true;
+};
+
+inline bool operator==(const QeColorSwatchKey &lhs, const QeColorSwatchKey &rhs)
+{
+    return lhs.color == rhs.color && lhs.size == rhs.size && lhs.shadow == rhs.shadow
+            && lhs.devicePixelRatio == rhs.devicePixelRatio && lhs.drawFrame == rhs.drawFrame;
+}
+
+inline bool operator!=(const QeColorSwatchKey &lhs, const QeColorSwatchKey &rhs)
+{
+    return !(lhs == rhs);
+}
+
+inline uint qHash(const QeColorSwatchKey &key, uint seed = 0)
+{
+    seed = qHash(key.color, seed);
+    seed = qHash(key.size.width(), qHash(key.size.height(), seed));
+    seed = qHash(key.shadow, seed);
+    seed = qHash(key.devicePixelRatio, seed);
+    return seed ^ uint(key.drawFrame);
+}
+
+//! \brief A text format parsed into literal runs and color components.
+//! The format is parsed once when it is set; render() then expands it in a single pass,
+//! converting the color to each color space it needs at most once.
+class QeColorTextProgram
+{
+public:
+    //! The color spaces read by a program.
+    enum Space { Rgb = 0x1, Hsv = 0x2, Hsl = 0x4 };
+
+    void compile(const QString &format);
+    void render(QString &out, const QColor &color) const;
+
+    //! Returns the color spaces read by the program, as a combination of Space values.
+    int spaces() const { return m_spaces; }
+
+private:
+    //! A component placeholder if `component` is non-zero; otherwise a run of literal text.
+    struct Token
+    {
+        int offset;
+        int length;
+        char component;
+    };
+
+    QString m_format;
+    QVector<Token> m_tokens;
+    int m_spaces = 0;
+};
+
 class QeColorButtonPrivate : public qe::PrivateBase
 {
     QE_DECLARE_PUBLIC(QeColorButton)
@@ -31,13 +98,46 @@ public:
     ~QeColorButtonPrivate() {}
     void init();
 
+    //! The parts of the button that markDirty() can schedule for an update.
+    enum DirtyFlag { IconDirty = 0x1, TextDirty = 0x2 };
+
+    void markDirty(int flags);
+    void flush();
+
     virtual void updateIcon();
     virtual void updateText();
 
+    static QColorDialog *sharedDialog(QWidget *window);
+    void beginPreview(QColorDialog *dialog);
+    void previewColor(const QColor &c);
+    void endPreview(QColorDialog *dialog, int result);
+
+    QeColorSwatchKey swatchKey() const;
+    static QIcon swatchIcon(const QeColorSwatchKey &key);
+    static void paintSwatch(QPainter *painter, const QRect &rect, const QColor &color,
+                            bool drawFrame, const QColor &frameColor);
+
     QColor color = Qt::white;
     QColor frameColor = Qt::black;
     bool drawFrame = true;
     QString format = QStringLiteral("%r, %g, %b");
+    QeColorTextProgram textProgram;
+    //reused by updateText() for every render
+    QString text;
+    //the key of the swatch currently shown; empty until the first updateIcon()
+    QeColorSwatchKey iconKey;
+    //DirtyFlag values waiting for flush()
+    int dirty = 0;
+    bool updateQueued = false;
+
+    bool livePreview = false;
+    bool dialogPrewarmed = false;
+    //the color before a live preview started; restored if the dialog is cancelled
+    QColor previewOrigin;
+    QColor previewPending;
+    bool previewDeferred = false;
+    QTimer *previewTimer = nullptr;
+    QMetaObject::Connection previewConnections[2];
 };
 
 #endif //QE_EXAMPLE_COLORBUTTON_P_H
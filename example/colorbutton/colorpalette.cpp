@@ -0,0 +1,409 @@
+/*******************************************************************************
+*  QExt: Extensions to Qt                                                      *
+*  Copyright (C) 2016  Jonathan Harper                                         *
+*                                                                              *
+*  This program is free software: you can redistribute it and/or modify        *
+*  it under the terms of the GNU General Public License as published by *
+*  the Free Software Foundation, either version 3 of the License, or           *
+*  (at your option) any later version.                                         *
+*                                                                              *
+*  This program is distributed in the hope that it will be useful,             *
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of              *
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the               *
+*  GNU General Public License for more details.                         *
+*                                                                              *
+*  You should have received a copy of the GNU General Public License    *
+*  along with this program.  If not, see <http://www.gnu.org/licenses/>.       *
+*******************************************************************************/
+
+#include "colorpalette_p.h"
+#include <QtGui/QKeyEvent>
+#include <QtGui/QMouseEvent>
+#include <QtGui/QPainter>
+#include <QtWidgets/QScrollBar>
+#include <QtWidgets/QToolTip>
+
+//! \brief Initializes the object.
+//! \note Called from the public class's constructor; see QeColorButtonPrivate::init().
+void QeColorPalettePrivate::init()
+{
+    QE_QPTR;
+    q->setFocusPolicy(Qt::StrongFocus);
+    q->setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
+    q->setVerticalScrollBarPolicy(Qt::ScrollBarAsNeeded);
+    q->viewport()->setBackgroundRole(QPalette::Base);
+    textProgram.compile(format);
+    updateGeometries();
+}
+
+//! Recalculates the grid from the viewport width and updates the scroll bar.
+void QeColorPalettePrivate::updateGeometries()
+{
+    QE_QPTR;
+    const QSize cell = cellSize();
+    const int width = q->viewport()->width();
+    columnCount = qMax(1, (width - spacing) / cell.width());
+    rowCount = (colors.size() + columnCount - 1) / columnCount;
+
+    const int height = spacing + rowCount * cell.height();
+    QScrollBar *bar = q->verticalScrollBar();
+    bar->setRange(0, qMax(0, height - q->viewport()->height()));
+    bar->setPageStep(q->viewport()->height());
+    bar->setSingleStep(cell.height());
+}
+
+//! Schedules a repaint of the swatch at \a index and its selection outline.
+void QeColorPalettePrivate::updateSwatch(int index)
+{
+    QE_QPTR;
+    if (index >= 0 && index < colors.size())
+        q->viewport()->update(q->swatchRect(index).adjusted(-3, -3, 3, 3));
+}
+
+//! Constructs a palette showing \a colors, with \a parent as the parent widget.
+QeColorPalette::QeColorPalette(const QVector<QColor> &colors, QWidget *parent)
+    : QeColorPalette(*new QeColorPalettePrivate(this), parent)
+{
+    setColors(colors);
+}
+
+//! Constructs an empty palette, with \a parent as the parent widget.
+QeColorPalette::QeColorPalette(QWidget *parent)
+    : QeColorPalette(*new QeColorPalettePrivate(this), parent)
+{
+}
+
+QeColorPalette::QeColorPalette(QeColorPalettePrivate &dd, QWidget *parent)
+    : QAbstractScrollArea(parent), qe::PublicBase(dd)
+{
+    QE_DPTR;
+    d->init();
+}
+
+//! The destructor.
+QeColorPalette::~QeColorPalette()
+{
+}
+
+//! Returns the colors shown by the palette.
+QVector<QColor> QeColorPalette::colors() const
+{
+    QE_CD;
+    return d->colors;
+}
+
+//! \brief Replaces the colors shown by the palette.
+//! The current index is reset to -1 if it is past the end of \a colors.
+void QeColorPalette::setColors(const QVector<QColor> &colors)
+{
+    QE_D;
+    d->colors = colors;
+    d->updateGeometries();
+    updateGeometry();
+    viewport()->update();
+    if (d->current >= d->colors.size()) {
+        d->current = -1;
+        emit currentIndexChanged(-1);
+    }
+}
+
+//! Returns the number of colors in the palette.
+int QeColorPalette::count() const
+{
+    QE_CD;
+    return d->colors.size();
+}
+
+//! Returns the color at \a index, or an invalid color if \a index is out of range.
+QColor QeColorPalette::color(int index) const
+{
+    QE_CD;
+    return d->colors.value(index);
+}
+
+//! Returns the color at the current index, or an invalid color if there is none.
+QColor QeColorPalette::currentColor() const
+{
+    QE_CD;
+    return d->colors.value(d->current);
+}
+
+//! Returns the index of the selected color, or -1 if no color is selected.
+int QeColorPalette::currentIndex() const
+{
+    QE_CD;
+    return d->current;
+}
+
+//! Returns the size of each swatch. The default is 16x16.
+QSize QeColorPalette::swatchSize() const
+{
+    QE_CD;
+    return d->swatchSize;
+}
+
+//! Sets the size of each swatch.
+void QeColorPalette::setSwatchSize(const QSize &size)
+{
+    QE_D;
+    if (d->swatchSize == size || size.isEmpty())
+        return;
+    d->swatchSize = size;
+    d->updateGeometries();
+    updateGeometry();
+    viewport()->update();
+}
+
+//! Returns the space between swatches, in pixels. The default is 4.
+int QeColorPalette::spacing() const
+{
+    QE_CD;
+    return d->spacing;
+}
+
+//! Sets the space between swatches. It is also used as the margin around the grid.
+void QeColorPalette::setSpacing(int spacing)
+{
+    QE_D;
+    spacing = qMax(spacing, 0);
+    if (d->spacing == spacing)
+        return;
+    d->spacing = spacing;
+    d->updateGeometries();
+    updateGeometry();
+    viewport()->update();
+}
+
+//! \brief Returns whether or not a frame is drawn around each swatch.
+bool QeColorPalette::isFrameVisible() const
+{
+    QE_CD;
+    return d->drawFrame;
+}
+
+//! \brief Sets whether or not a frame is drawn around each swatch.
+void QeColorPalette::setFrameVisible(bool b)
+{
+    QE_D;
+    if (d->drawFrame == b)
+        return;
+    d->drawFrame = b;
+    viewport()->update();
+}
+
+//! \brief Returns the format of the tooltip shown for each swatch. See QeColorButton::textFormat.
+QString QeColorPalette::textFormat() const
+{
+    QE_CD;
+    return d->format;
+}
+
+//! \brief Sets the format of the tooltip shown for each swatch.
+void QeColorPalette::setTextFormat(QString format)
+{
+    QE_D;
+    if (d->format == format)
+        return;
+    d->format = format;
+    d->textProgram.compile(d->format);
+}
+
+//! Returns the index of the swatch at \a pos, in viewport coordinates, or -1 if there is none.
+int QeColorPalette::indexAt(const QPoint &pos) const
+{
+    QE_CD;
+    const QSize cell = d->cellSize();
+    const int x = pos.x() - d->spacing;
+    const int y = pos.y() + verticalScrollBar()->value() - d->spacing;
+    if (x < 0 || y < 0)
+        return -1;
+    //points in the spacing between swatches don't hit anything
+    if (x % cell.width() >= d->swatchSize.width() || y % cell.height() >= d->swatchSize.height())
+        return -1;
+
+    const int column = x / cell.width();
+    if (column >= d->columnCount)
+        return -1;
+    const int index = (y / cell.height()) * d->columnCount + column;
+    return index < d->colors.size() ? index : -1;
+}
+
+//! Returns the rectangle of the swatch at \a index, in viewport coordinates.
+QRect QeColorPalette::swatchRect(int index) const
+{
+    QE_CD;
+    if (index < 0 || index >= d->colors.size())
+        return QRect();
+    const QSize cell = d->cellSize();
+    const int x = d->spacing + (index % d->columnCount) * cell.width();
+    const int y = d->spacing + (index / d->columnCount) * cell.height() - verticalScrollBar()->value();
+    return QRect(QPoint(x, y), d->swatchSize);
+}
+
+//! Returns room for 16 columns and up to 8 rows of swatches.
+QSize QeColorPalette::sizeHint() const
+{
+    QE_CD;
+    const QSize cell = d->cellSize();
+    const int rows = qBound(1, (d->colors.size() + 15) / 16, 8);
+    QSize ret(d->spacing + 16 * cell.width(), d->spacing + rows * cell.height());
+    if (d->colors.size() > 16 * 8)
+        ret.rwidth() += verticalScrollBar()->sizeHint().width();
+    return ret + QSize(2 * frameWidth(), 2 * frameWidth());
+}
+
+//! \brief Selects the color at \a index and scrolls to it. Pass -1 to clear the selection.
+//! Emits `currentIndexChanged(int)` if the index changed.
+void QeColorPalette::setCurrentIndex(int index)
+{
+    QE_D;
+    if (index < -1 || index >= d->colors.size())
+        index = -1;
+    if (index == d->current)
+        return;
+    d->updateSwatch(d->current);
+    d->current = index;
+    scrollToIndex(index);
+    d->updateSwatch(index);
+    emit currentIndexChanged(index);
+}
+
+//! Scrolls the viewport so that the swatch at \a index is visible.
+void QeColorPalette::scrollToIndex(int index)
+{
+    QE_D;
+    const QRect rect = swatchRect(index);
+    if (rect.isNull())
+        return;
+    QScrollBar *bar = verticalScrollBar();
+    if (rect.top() < d->spacing)
+        bar->setValue(bar->value() + rect.top() - d->spacing);
+    else if (rect.bottom() + d->spacing >= viewport()->height())
+        bar->setValue(bar->value() + rect.bottom() + d->spacing + 1 - viewport()->height());
+}
+
+//! Shows the text format, expanded for the swatch under the cursor, as a tooltip.
+bool QeColorPalette::viewportEvent(QEvent *event)
+{
+    if (event->type() != QEvent::ToolTip)
+        return QAbstractScrollArea::viewportEvent(event);
+
+    QE_D;
+    auto help = static_cast<QHelpEvent *>(event);
+    const int index = indexAt(help->pos());
+    if (index < 0) {
+        QToolTip::hideText();
+        event->ignore();
+        return true;
+    }
+    d->text.truncate(0);
+    d->textProgram.render(d->text, d->colors.at(index));
+    QToolTip::showText(help->globalPos(), d->text, viewport(), swatchRect(index));
+    return true;
+}
+
+//! Paints the swatches in the rows that intersect the exposed area.
+void QeColorPalette::paintEvent(QPaintEvent *event)
+{
+    QE_D;
+    if (d->colors.isEmpty())
+        return;
+
+    const QSize cell = d->cellSize();
+    const QRect exposed = event->rect();
+    const int offset = verticalScrollBar()->value() - d->spacing;
+    const int firstRow = qMax(0, (exposed.top() + offset) / cell.height());
+    const int lastRow = qMin(d->rowCount - 1, (exposed.bottom() + offset) / cell.height());
+    const int first = firstRow * d->columnCount;
+    const int last = qMin(d->colors.size(), (lastRow + 1) * d->columnCount);
+
+    QPainter painter(viewport());
+    const QColor frameColor = palette().shadow().color();
+    for (int i = first; i < last; ++i) {
+        const QRect rect = swatchRect(i);
+        if (rect.intersects(exposed))
+            QeColorButtonPrivate::paintSwatch(&painter, rect, d->colors.at(i), d->drawFrame, frameColor);
+    }
+
+    if (d->current >= first && d->current < last) {
+        painter.setPen(QPen(hasFocus() ? palette().highlight() : palette().mid(), 2));
+        painter.setBrush(Qt::NoBrush);
+        painter.drawRect(swatchRect(d->current).adjusted(-2, -2, 1, 1));
+    }
+}
+
+void QeColorPalette::resizeEvent(QResizeEvent *event)
+{
+    QE_D;
+    QAbstractScrollArea::resizeEvent(event);
+    d->updateGeometries();
+}
+
+//! Scrolls the painted swatches instead of repainting the whole viewport.
+void QeColorPalette::scrollContentsBy(int dx, int dy)
+{
+    viewport()->scroll(dx, dy);
+}
+
+void QeColorPalette::mousePressEvent(QMouseEvent *event)
+{
+    if (event->button() != Qt::LeftButton)
+        return QAbstractScrollArea::mousePressEvent(event);
+    const int index = indexAt(event->pos());
+    if (index >= 0)
+        setCurrentIndex(index);
+}
+
+//! Double-clicking a swatch emits `colorActivated(QColor)`.
+void QeColorPalette::mouseDoubleClickEvent(QMouseEvent *event)
+{
+    const int index = indexAt(event->pos());
+    if (event->button() != Qt::LeftButton || index < 0)
+        return QAbstractScrollArea::mouseDoubleClickEvent(event);
+    setCurrentIndex(index);
+    emit colorActivated(currentColor());
+}
+
+//! \brief Moves the selection with the arrow, Home, End and page keys.
+//! Enter and Space emit `colorActivated(QColor)` for the current color.
+void QeColorPalette::keyPressEvent(QKeyEvent *event)
+{
+    QE_D;
+    const int count = d->colors.size();
+    const int pageRows = qMax(1, viewport()->height() / d->cellSize().height());
+    const int current = d->current;
+    int index = current;
+    switch (event->key()) {
+    case Qt::Key_Left:      index = current - 1; break;
+    case Qt::Key_Right:     index = current + 1; break;
+    case Qt::Key_Up:        index = current - d->columnCount; break;
+    case Qt::Key_Down:      index = current + d->columnCount; break;
+    case Qt::Key_PageUp:    index = current - pageRows * d->columnCount; break;
+    case Qt::Key_PageDown:  index = current + pageRows * d->columnCount; break;
+    case Qt::Key_Home:      index = 0; break;
+    case Qt::Key_End:       index = count - 1; break;
+    case Qt::Key_Enter:
+    case Qt::Key_Return:
+    case Qt::Key_Space:
+        if (current < 0)
+            return QAbstractScrollArea::keyPressEvent(event);
+        emit colorActivated(currentColor());
+        return;
+    default:
+        return QAbstractScrollArea::keyPressEvent(event);
+    }
+    if (count == 0)
+        return;
+    //the first key press selects the first color
+    setCurrentIndex(current < 0 ? 0 : qBound(0, index, count - 1));
+}
+
+/*!
+  \class QeColorPalette
+  \brief The QeColorPalette class displays a grid of colors for the user to pick from.
+
+  Unlike a grid of QeColorButton, the palette is a single widget: it paints every visible swatch
+  from its array of colors in one paint event and finds the swatch under the cursor by
+  arithmetic, so palettes of thousands of colors cost one widget. Swatches are drawn the same way
+  as QeColorButton's icons, and tooltips use the same text format.
+*/
@@ -0,0 +1,89 @@
+/*******************************************************************************
+*  QExt: Extensions to Qt                                                      *
+*  Copyright (C) 2016  Jonathan Harper                                         *
+*                                                                              *
+*  This program is free software: you can redistribute it and/or modify        *
+*  it under the terms of the GNU General Public License as published by *
+*  the Free Software Foundation, either version 3 of the License, or           *
+*  (at your option) any later version.                                         *
+*                                                                              *
+*  This program is distributed in the hope that it will be useful,             *
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of              *
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the               *
+*  GNU General Public License for more details.                         *
+*                                                                              *
+*  You should have received a copy of the GNU General Public License    *
+*  along with this program.  If not, see <http://www.gnu.org/licenses/>.       *
+*******************************************************************************/
+
+#ifndef QE_EXAMPLE_COLORPALETTE_H
+#define QE_EXAMPLE_COLORPALETTE_H
+
+#include <QAbstractScrollArea>
+#include <QColor>
+#include <QVector>
+
+#include <qecore/dptr.h>
+
+class QeColorPalettePrivate;
+class QeColorPalette : public QAbstractScrollArea, public qe::PublicBase
+{
+    Q_OBJECT
+
+    Q_PROPERTY(int currentIndex READ currentIndex WRITE setCurrentIndex NOTIFY currentIndexChanged)
+    Q_PROPERTY(QSize swatchSize READ swatchSize WRITE setSwatchSize)
+    Q_PROPERTY(int spacing READ spacing WRITE setSpacing)
+    Q_PROPERTY(bool isFrameVisible READ isFrameVisible WRITE setFrameVisible)
+    Q_PROPERTY(QString textFormat READ textFormat WRITE setTextFormat)
+
+public:
+    QeColorPalette(const QVector<QColor> &colors, QWidget *parent = nullptr);
+    explicit QeColorPalette(QWidget *parent = nullptr);
+    ~QeColorPalette();
+
+    QVector<QColor> colors() const;
+    void setColors(const QVector<QColor> &colors);
+    int count() const;
+    QColor color(int index) const;
+    QColor currentColor() const;
+    int currentIndex() const;
+
+    QSize swatchSize() const;
+    void setSwatchSize(const QSize &size);
+    int spacing() const;
+    void setSpacing(int spacing);
+    bool isFrameVisible() const;
+    void setFrameVisible(bool b);
+    QString textFormat() const;
+    void setTextFormat(QString format);
+
+    int indexAt(const QPoint &pos) const;
+    QRect swatchRect(int index) const;
+
+    QSize sizeHint() const override;
+
+public Q_SLOTS:
+    void setCurrentIndex(int index);
+    void scrollToIndex(int index);
+
+Q_SIGNALS:
+    void currentIndexChanged(int index);
+    void colorActivated(QColor color);
+
+protected:
+    QeColorPalette(QeColorPalettePrivate &dd, QWidget *parent = nullptr);
+
+    bool viewportEvent(QEvent *event) override;
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+    void scrollContentsBy(int dx, int dy) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void mouseDoubleClickEvent(QMouseEvent *event) override;
+    void keyPressEvent(QKeyEvent *event) override;
+
+private:
+    Q_DISABLE_COPY(QeColorPalette)
+    QE_DECLARE_PRIVATE(QeColorPalette)
+};
+
+#endif // QE_EXAMPLE_COLORPALETTE_H
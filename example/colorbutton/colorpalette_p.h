@@ -0,0 +1,55 @@
+/*******************************************************************************
+*  QExt: Extensions to Qt                                                      *
+*  Copyright (C) 2016  Jonathan Harper                                         *
+*                                                                              *
+*  This program is free software: you can redistribute it and/or modify        *
+*  it under the terms of the GNU General Public License as published by *
+*  the Free Software Foundation, either version 3 of the License, or           *
+*  (at your option) any later version.                                         *
+*                                                                              *
+*  This program is distributed in the hope that it will be useful,             *
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of              *
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the               *
+*  GNU General Public License for more details.                         *
+*                                                                              *
+*  You should have received a copy of the GNU General Public License    *
+*  along with this program.  If not, see <http://www.gnu.org/licenses/>.       *
+*******************************************************************************/
+
+#ifndef QE_EXAMPLE_COLORPALETTE_P_H
+#define QE_EXAMPLE_COLORPALETTE_P_H
+
+#include <qecore/dptr.h>
+#include "colorbutton_p.h"
+#include "colorpalette.h"
+
+class QeColorPalettePrivate : public qe::PrivateBase
+{
+    QE_DECLARE_PUBLIC(QeColorPalette)
+public:
+    QeColorPalettePrivate(QePublicBase *qq) : qe::PrivateBase(qq) {}
+    ~QeColorPalettePrivate() {}
+    void init();
+
+    void updateGeometries();
+    void updateSwatch(int index);
+
+    //! Returns the size of one grid cell: a swatch and the spacing after it.
+    QSize cellSize() const { return swatchSize + QSize(spacing, spacing); }
+
+    QVector<QColor> colors;
+    int current = -1;
+    QSize swatchSize = QSize(16, 16);
+    int spacing = 4;
+    bool drawFrame = true;
+    QString format = QStringLiteral("%r, %g, %b");
+    QeColorTextProgram textProgram;
+    //reused for each tooltip
+    QString text;
+
+    //the grid, recalculated by updateGeometries()
+    int columnCount = 1;
+    int rowCount = 0;
+};
+
+#endif //QE_EXAMPLE_COLORPALETTE_P_H
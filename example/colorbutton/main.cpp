@@ -21,6 +21,7 @@
 #include <QtWidgets/QHBoxLayout>
 #include <QtWidgets/QPushButton>
 #include "colorbutton.h"
+#include "colorpalette.h"
 
 int main(int argc, char **argv)
 {
@@ -34,6 +35,13 @@ int main(int argc, char **argv)
     QeColorButton colorButton(Qt::red);
     layout.addWidget(&colorButton);
 
+    QVector<QColor> colors;
+    for (int hue = 0; hue < 360; hue += 5)
+        colors.append(QColor::fromHsv(hue, 255, 255));
+    QeColorPalette palette(colors);
+    layout.addWidget(&palette);
+    QObject::connect(&palette, &QeColorPalette::colorActivated, &colorButton, &QeColorButton::setColor);
+
     QPushButton closeButton(QStrLit("&Close"));
     layout.addWidget(&closeButton);
 
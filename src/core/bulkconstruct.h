@@ -0,0 +1,244 @@
+/*  QExt: Extensions to Qt
+ *  Copyright (C) 2016  Jonathan Harper
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*!
+ \headerfile bulkconstruct.h <qecore/bulkconstruct.h>
+ \brief Constructs many d-ptr objects in a single contiguous allocation.
+*/
+
+#ifndef QE_CORE_BULKCONSTRUCT_H
+#define QE_CORE_BULKCONSTRUCT_H
+
+#include <cstddef>
+#include <new>
+#include <utility>
+#include <type_traits>
+#include "dptr.h"
+
+namespace qe {
+
+//! Selects what qe::constructBulk places in its slab.
+enum class BulkLayout {
+    PrivateOnly,        //!< Only the private classes share the slab; public classes use `new`.
+    PublicAndPrivate    //!< Both the public and the private classes share the slab.
+};
+
+/*!
+    \brief Owns a set of d-ptr objects created by qe::constructBulk.
+
+    All private classes are laid out back to back in one allocation, so iterating over
+    `privateAt(0)` .. `privateAt(size() - 1)` is a linear walk through memory. With
+    BulkLayout::PublicAndPrivate the public classes follow in the same allocation.
+
+    BulkStorage is move-only. Destroying it destroys every object in reverse order of construction
+    and frees the slab with a single deallocation.
+
+    \warning Objects owned by a BulkStorage must not be deleted individually. For `QObject`-derived
+    public classes this includes deletion by a parent object.
+
+    \warning Moving a public object out of the storage moves only the d-ptr; the private class stays
+    in the slab, and `privateAt()` still returns it. The object moved to must be destroyed before the
+    storage.
+*/
+template <class Public>
+class BulkStorage
+{
+public:
+    using public_type = Public;
+    using private_type = typename Public::qe_private_type;
+
+    //! Constructs an empty instance.
+    BulkStorage() noexcept = default;
+    //! Move constructs from \a other, leaving it empty.
+    BulkStorage(BulkStorage &&other) noexcept { swap(other); }
+    //! Move assigns from \a other.
+    BulkStorage &operator=(BulkStorage &&other) noexcept { BulkStorage tmp(std::move(other)); swap(tmp); return *this; }
+    //! Deleted copy constructor.
+    BulkStorage(const BulkStorage &) = delete;
+    //! Deleted copy assignment operator.
+    BulkStorage &operator=(const BulkStorage &) = delete;
+    //! Destroys all owned objects and frees the slab.
+    ~BulkStorage()                                  { clear(); }
+
+    //! Swaps two instances.
+    void swap(BulkStorage &other) noexcept
+    {
+        std::swap(m_slab, other.m_slab);
+        std::swap(m_privates, other.m_privates);
+        std::swap(m_publics, other.m_publics);
+        std::swap(m_table, other.m_table);
+        std::swap(m_size, other.m_size);
+    }
+
+    //! Returns the number of owned objects.
+    std::size_t size() const noexcept               { return m_size; }
+    //! Returns true if no objects are owned.
+    bool isEmpty() const noexcept                   { return !m_size; }
+    //! Returns true if the public classes share the slab with the private classes.
+    bool isPublicInSlab() const noexcept            { return m_publics; }
+
+    //! Returns the public object at \a i.
+    Public &at(std::size_t i) noexcept              { return m_publics ? m_publics[i] : *m_table[i]; }
+    //! \overload
+    const Public &at(std::size_t i) const noexcept  { return m_publics ? m_publics[i] : *m_table[i]; }
+    //! Equivalent to \ref at.
+    Public &operator[](std::size_t i) noexcept      { return at(i); }
+    //! \overload
+    const Public &operator[](std::size_t i) const noexcept { return at(i); }
+
+    //! Returns the private object at \a i.
+    private_type &privateAt(std::size_t i) noexcept { return m_privates[i]; }
+    //! \overload
+    const private_type &privateAt(std::size_t i) const noexcept { return m_privates[i]; }
+    //! Returns a pointer to the first element of the contiguous private class array.
+    private_type *privateData() noexcept            { return m_privates; }
+    //! \overload
+    const private_type *privateData() const noexcept{ return m_privates; }
+
+    //! Destroys all owned objects and frees the slab.
+    void clear() noexcept                           { destroy(m_size); }
+
+private:
+    template <class P, BulkLayout L, class InitFn, class... Args>
+    friend BulkStorage<P> constructBulk(std::size_t n, InitFn &&init, Args &&...args);
+
+    static constexpr std::size_t alignUp(std::size_t value, std::size_t alignment) noexcept
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    template <BulkLayout Layout, class InitFn, class... Args>
+    void construct(std::size_t n, InitFn &init, Args &...args);
+    void destroy(std::size_t constructed) noexcept;
+
+    void *m_slab = nullptr;
+    private_type *m_privates = nullptr;
+    Public *m_publics = nullptr;    //set with BulkLayout::PublicAndPrivate
+    Public **m_table = nullptr;     //set with BulkLayout::PrivateOnly
+    std::size_t m_size = 0;
+};
+
+/*!
+    \brief Constructs \a n d-ptr objects of type `Public` in a single slab.
+
+    Every private class is constructed in place with a null q-ptr, which `qe::PublicBase` binds when
+    the public class is constructed from it. `Public` must therefore have a constructor accepting
+    `Public##Private &` followed by \a args, as the protected constructor of a d-ptr class usually
+    does. Once object `i` is constructed, `init(object, i)` is called.
+
+    If a constructor throws, the objects constructed so far are destroyed and the exception is
+    rethrown.
+
+    \code
+        auto buttons = qe::constructBulk<MyClass>(10000, [](MyClass &obj, std::size_t i) {
+            obj.setIndex(int(i));
+        });
+    \endcode
+
+    \relates qe::BulkStorage
+*/
+template <class Public, BulkLayout Layout = BulkLayout::PublicAndPrivate, class InitFn, class... Args>
+BulkStorage<Public> constructBulk(std::size_t n, InitFn &&init, Args &&...args)
+{
+    BulkStorage<Public> ret;
+    if (n)
+        ret.template construct<Layout>(n, init, args...);
+    return ret;
+}
+
+////////
+// Implementation below
+
+//! \internal
+template <class Public>
+template <BulkLayout Layout, class InitFn, class... Args>
+void BulkStorage<Public>::construct(std::size_t n, InitFn &init, Args &...args)
+{
+    static_assert(std::is_base_of<PublicBase, Public>::value, "Public must inherit from qe::PublicBase.");
+    static_assert(std::is_base_of<PrivateBase, private_type>::value, "Public##Private must inherit from qe::PrivateBase.");
+    static_assert(alignof(private_type) <= alignof(std::max_align_t)
+                  && alignof(Public) <= alignof(std::max_align_t), "Over-aligned types are not supported.");
+
+    //[private_type x n][Public x n] or [private_type x n][Public * x n]
+    const std::size_t tailOffset = Layout == BulkLayout::PublicAndPrivate
+            ? alignUp(sizeof(private_type) * n, alignof(Public))
+            : alignUp(sizeof(private_type) * n, alignof(Public *));
+    const std::size_t bytes = tailOffset + (Layout == BulkLayout::PublicAndPrivate ? sizeof(Public) : sizeof(Public *)) * n;
+
+    auto base = static_cast<unsigned char *>(::operator new(bytes));
+    m_slab = base;
+    m_privates = reinterpret_cast<private_type *>(base);
+    if (Layout == BulkLayout::PublicAndPrivate)
+        m_publics = reinterpret_cast<Public *>(base + tailOffset);
+    else
+        m_table = reinterpret_cast<Public **>(base + tailOffset);
+
+    std::size_t i = 0;
+    try {
+        for (; i < n; ++i) {
+            auto dd = ::new (static_cast<void *>(m_privates + i)) private_type(nullptr);
+            //the public class owns the private class only once its constructor returns, so a
+            //throwing constructor leaves it to be destroyed here, whether or not PublicBase was built
+            dd->qe_storage = PrivateBase::Storage::SlabPending;
+            try {
+                if (Layout == BulkLayout::PublicAndPrivate)
+                    ::new (static_cast<void *>(m_publics + i)) Public(*dd, args...);
+                else
+                    m_table[i] = new Public(*dd, args...);
+            } catch (...) {
+                dd->~private_type();
+                throw;
+            }
+            dd->qe_storage = PrivateBase::Storage::Slab;
+            m_size = i + 1;
+            init(at(i), i);
+        }
+    } catch (...) {
+        destroy(m_size);
+        throw;
+    }
+}
+
+//! \internal
+//! Destroys the first \a constructed objects in reverse order and frees the slab.
+template <class Public>
+void BulkStorage<Public>::destroy(std::size_t constructed) noexcept
+{
+    //the public destructor cleans up the private class in place via PrivateDeleter
+    while (constructed--) {
+        if (m_publics)
+            m_publics[constructed].~Public();
+        else
+            delete m_table[constructed];
+    }
+    ::operator delete(m_slab);
+    m_slab = nullptr;
+    m_privates = nullptr;
+    m_publics = nullptr;
+    m_table = nullptr;
+    m_size = 0;
+}
+
+} // namespace qe
+
+#ifndef QEXT_NO_CLUTTER
+//! \relates qe::BulkStorage
+template <class Public>
+using QeBulkStorage = qe::BulkStorage<Public>;
+#endif
+
+#endif // QE_CORE_BULKCONSTRUCT_H
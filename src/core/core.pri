@@ -6,12 +6,19 @@ CONFIG += c++1z
 HEADERS += \
 	$$PWD/global.h \
 	$$PWD/debugutil.h \
+    $$PWD/debugutil_p.h \
+    $$PWD/simd_p.h \
+    $$PWD/debugwriter.h \
+    $$PWD/debugwriter_p.h \
 	$$PWD/uniquepointer.h \
     $$PWD/type_util.h \
 	$$PWD/dptr.h \
+    $$PWD/bulkconstruct.h \
+    $$PWD/seqlock.h \
     $$PWD/managedpointer.h \
     $$PWD/pointer_deleters.h
 
 SOURCES += \
     $$PWD/dptr.cpp \
-	$$PWD/debugutil.cpp
+	$$PWD/debugutil.cpp \
+    $$PWD/debugwriter.cpp
@@ -1,3 +1,457 @@
 #include "debugutil.h"
+#include "debugutil_p.h"
+#include <cstring>
+#include <QtCore/QVector>
+#include <QtCore/QStringList>
+#include <QtCore/QDateTime>
+#include <QtCore/QUuid>
+#include <QtCore/QPoint>
+#include <QtCore/QSize>
+#include <QtCore/QRect>
+#include <QtCore/QLocale>
+#include <QtGui/QColor>
+#include <QtGui/QFont>
 
+namespace qe {
 
+namespace {
+
+template <class T>
+void formatInteger(const void *value, QString &out)
+{
+    formatInto(out, *static_cast<const T *>(value));
+}
+
+void formatBool(const void *value, QString &out)
+{
+    out += *static_cast<const bool *>(value) ? QLatin1String("true") : QLatin1String("false");
+}
+
+void formatString(const void *value, QString &out)
+{
+    out += *static_cast<const QString *>(value);
+}
+
+void formatChar(const void *value, QString &out)
+{
+    out += *static_cast<const QChar *>(value);
+}
+
+void formatByteArray(const void *value, QString &out)
+{
+    out += QString::fromUtf8(*static_cast<const QByteArray *>(value));
+}
+
+void formatStringList(const void *value, QString &out)
+{
+    //matches QVariant::toString(), which only converts single-element lists
+    auto list = static_cast<const QStringList *>(value);
+    if (list->size() == 1)
+        out += list->first();
+}
+
+void formatDouble(const void *value, QString &out)
+{
+    formatInto(out, *static_cast<const double *>(value));
+}
+
+void formatFloat(const void *value, QString &out)
+{
+    formatInto(out, double(*static_cast<const float *>(value)), 'g', 6);
+}
+
+void formatDate(const void *value, QString &out)
+{
+    out += static_cast<const QDate *>(value)->toString(Qt::ISODate);
+}
+
+void formatTime(const void *value, QString &out)
+{
+    out += static_cast<const QTime *>(value)->toString(Qt::ISODateWithMs);
+}
+
+void formatDateTime(const void *value, QString &out)
+{
+    out += static_cast<const QDateTime *>(value)->toString(Qt::ISODateWithMs);
+}
+
+void formatPoint(const void *value, QString &out)
+{
+    auto p = static_cast<const QPoint *>(value);
+    out += QLatin1Char('(');
+    formatInto(out, p->x());
+    out += QLatin1String(", ");
+    formatInto(out, p->y());
+    out += QLatin1Char(')');
+}
+
+void formatSize(const void *value, QString &out)
+{
+    auto sz = static_cast<const QSize *>(value);
+    formatInto(out, sz->width());
+    out += QLatin1String(" x ");
+    formatInto(out, sz->height());
+}
+
+void formatRect(const void *value, QString &out)
+{
+    auto r = static_cast<const QRect *>(value);
+    out += QLatin1String("[(");
+    formatInto(out, r->left());
+    out += QLatin1String(", ");
+    formatInto(out, r->top());
+    out += QLatin1String("), ");
+    formatInto(out, r->width());
+    out += QLatin1String(" x ");
+    formatInto(out, r->height());
+    out += QLatin1Char(']');
+}
+
+void formatFont(const void *value, QString &out)
+{
+    auto f = static_cast<const QFont *>(value);
+    out += QLatin1Char('[');
+    out += f->family();
+    out += QLatin1String(", ");
+    formatInto(out, f->pointSize());
+    out += QLatin1Char(']');
+}
+
+void formatUuid(const void *value, QString &out)
+{
+    out += static_cast<const QUuid *>(value)->toString();
+}
+
+//! \internal
+//! Formatters indexed by metatype id. Built-in types are registered on first use.
+struct FormatterTable
+{
+    FormatterTable()
+    {
+        formatters.fill(nullptr, QMetaType::User);
+        set(QMetaType::QString,     &formatString);
+        set(QMetaType::Bool,        &formatBool);
+        set(QMetaType::QByteArray,  &formatByteArray);
+        set(QMetaType::QChar,       &formatChar);
+        set(QMetaType::QDate,       &formatDate);
+        set(QMetaType::QDateTime,   &formatDateTime);
+        set(QMetaType::QStringList, &formatStringList);
+        set(QMetaType::QTime,       &formatTime);
+        set(QMetaType::Double,      &formatDouble);
+        set(QMetaType::Int,         &formatInteger<int>);
+        set(QMetaType::UInt,        &formatInteger<uint>);
+        set(QMetaType::LongLong,    &formatInteger<qlonglong>);
+        set(QMetaType::ULongLong,   &formatInteger<qulonglong>);
+        set(QMetaType::Float,       &formatFloat);
+        set(QMetaType::Short,       &formatInteger<short>);
+        set(QMetaType::UShort,      &formatInteger<ushort>);
+        set(QMetaType::SChar,       &formatInteger<signed char>);
+        set(QMetaType::QPoint,      &formatPoint);
+        set(QMetaType::QSize,       &formatSize);
+        set(QMetaType::QRect,       &formatRect);
+        set(QMetaType::QFont,       &formatFont);
+        set(QMetaType::QUuid,       &formatUuid);
+    }
+
+    void set(int typeId, Formatter f)
+    {
+        if (typeId >= formatters.size())
+            formatters.resize(typeId + 1);
+        formatters[typeId] = f;
+    }
+
+    QVector<Formatter> formatters;
+};
+
+FormatterTable &formatterTable()
+{
+    static FormatterTable table;
+    return table;
+}
+
+} // namespace
+
+//! \brief Registers \a formatter for the metatype \a typeId, replacing any existing formatter.
+//! Passing `nullptr` removes the formatter.
+//!
+//! \warning Registration is not thread-safe. Register formatters during start-up, before any
+//! thread calls formatInto or toString.
+void registerFormatter(int typeId, Formatter formatter)
+{
+    if (typeId <= QMetaType::UnknownType)
+        return;
+    formatterTable().set(typeId, formatter);
+}
+
+//! Returns the formatter registered for \a typeId, or `nullptr` if there is none.
+Formatter formatter(int typeId) noexcept
+{
+    const auto &formatters = formatterTable().formatters;
+    if (typeId <= QMetaType::UnknownType || typeId >= formatters.size())
+        return nullptr;
+    return formatters.at(typeId);
+}
+
+//! \brief Appends a textual representation of \a var to \a out.
+//! Returns false, leaving \a out unchanged, if no formatter is registered for the type of \a var.
+//!
+//! Reusing \a out across calls avoids allocating a string per value.
+bool formatInto(QString &out, const QVariant &var)
+{
+    auto f = formatter(var.userType());
+    if (!f)
+        return false;
+    f(var.constData(), out);
+    return true;
+}
+
+namespace {
+
+//! \internal
+//! Returns \a base, or 10 with a warning if it is outside 2-36, as `QString::number` does with
+//! range checks enabled.
+int checkedBase(int base)
+{
+    if (Q_LIKELY(detail::isValidBase(base)))
+        return base;
+    qWarning("qe::formatInto: Invalid base (%d)", base);
+    return 10;
+}
+
+} // namespace
+
+namespace detail {
+
+//! \internal
+//! The body of the integer overloads of qe::formatInto, kept out of line so that debugutil.h does
+//! not need the number formatting kernels.
+void formatIntegerInto(QString &out, qlonglong value, int base)
+{
+    char buffer[NumberChars];
+    const char *end = formatInteger(buffer, buffer + sizeof(buffer), value, checkedBase(base));
+    out.append(QLatin1String(buffer, int(end - buffer)));
+}
+
+//! \internal
+//! \overload
+void formatIntegerInto(QString &out, qulonglong value, int base)
+{
+    char buffer[NumberChars];
+    const char *end = formatInteger(buffer, buffer + sizeof(buffer), value, checkedBase(base));
+    out.append(QLatin1String(buffer, int(end - buffer)));
+}
+
+} // namespace detail
+
+//! \brief Appends \a value to \a out in the shortest form that reads back exactly.
+//! The output matches `QString::number(value, 'g', QLocale::FloatingPointShortest)` in Qt 5.15.
+void formatInto(QString &out, double value)
+{
+#ifdef QE_HAS_FLOAT_TO_CHARS
+    char buffer[detail::NumberChars];
+    const char *end = detail::formatShortest(buffer, buffer + sizeof(buffer), value);
+    out.append(QLatin1String(buffer, int(end - buffer)));
+#else
+    out += QString::number(value, 'g', QLocale::FloatingPointShortest);
+#endif
+}
+
+//! \brief Appends \a value to \a out as `QString::number(value, format, precision)` would.
+//! \a format is one of `'e'`, `'E'`, `'f'`, `'g'` or `'G'`. Values longer than a stack buffer,
+//! such as large numbers in `'f'` format, fall back to `QString::number`.
+void formatInto(QString &out, double value, char format, int precision)
+{
+#ifdef QE_HAS_FLOAT_TO_CHARS
+    char buffer[128];
+    if (const char *end = detail::formatDouble(buffer, buffer + sizeof(buffer), value, format, precision)) {
+        out.append(QLatin1String(buffer, int(end - buffer)));
+        return;
+    }
+#endif
+    out += QString::number(value, format, precision);
+}
+
+/*!
+    \brief Appends a single component of \a color to \a out.
+
+    Lower case components are integers: `r`, `g`, `b` (RGB), `h`, `s`, `v` (HSV) and `l` (HSL
+    lightness). Upper case components are the floating point equivalents, written with
+    `'g'` format and \a precision significant digits.
+
+    Returns false, leaving \a out unchanged, if \a component is not one of these.
+*/
+bool formatInto(QString &out, const QColor &color, char component, int precision)
+{
+    switch (component) {
+    case 'r': formatInto(out, color.red()); break;
+    case 'R': formatInto(out, color.redF(), 'g', precision); break;
+    case 'g': formatInto(out, color.green()); break;
+    case 'G': formatInto(out, color.greenF(), 'g', precision); break;
+    case 'b': formatInto(out, color.blue()); break;
+    case 'B': formatInto(out, color.blueF(), 'g', precision); break;
+    case 'h': formatInto(out, color.hue()); break;
+    case 'H': formatInto(out, color.hueF(), 'g', precision); break;
+    case 's': formatInto(out, color.saturation()); break;
+    case 'S': formatInto(out, color.saturationF(), 'g', precision); break;
+    case 'v': formatInto(out, color.value()); break;
+    case 'V': formatInto(out, color.valueF(), 'g', precision); break;
+    case 'l': formatInto(out, color.lightness()); break;
+    case 'L': formatInto(out, color.lightnessF(), 'g', precision); break;
+    default:
+        return false;
+    }
+    return true;
+}
+
+//! \brief Returns a textual representation of \a var, or an empty string if its type has no
+//! registered formatter.
+//! \sa formatInto, registerFormatter
+QString toString(const QVariant &var)
+{
+    QString ret;
+    formatInto(ret, var);
+    return ret;
+}
+
+//! Appends \a pointer to \a out as a `0x`-prefixed hexadecimal address.
+void appendPointer(QString &out, const void *pointer)
+{
+    static const char digits[] = "0123456789abcdef";
+    auto value = reinterpret_cast<quintptr>(pointer);
+    QChar buffer[2 + sizeof(quintptr) * 2];
+    int pos = int(sizeof(buffer) / sizeof(QChar));
+    do {
+        buffer[--pos] = QLatin1Char(digits[value & 0xF]);
+        value >>= 4;
+    } while (value);
+    buffer[--pos] = QLatin1Char('x');
+    buffer[--pos] = QLatin1Char('0');
+    out.append(buffer + pos, int(sizeof(buffer) / sizeof(QChar)) - pos);
+}
+
+namespace {
+
+//! \internal
+//! Bytes encoded per pass. Keeps the staging buffers on the stack and in L1.
+constexpr int HexChunk = 1024;
+constexpr int HexDumpWidth = 16;
+//! \internal
+//! Offset (8) + gap (2) + hex bytes and centre gap (49) + " |" + ASCII (16) + "|\n".
+constexpr int HexDumpLineMax = 8 + 2 + HexDumpWidth * 3 + 1 + 2 + HexDumpWidth + 2;
+
+} // namespace
+
+//! \brief Appends the \a size bytes at \a data to \a out as contiguous hexadecimal, two digits per
+//! byte. This is the string equivalent of `QByteArray::toHex()`.
+//!
+//! The bytes are encoded with SSE2 or AVX2 when the running CPU supports them.
+void hexInto(QString &out, const void *data, int size, bool upperCase)
+{
+    if (!data || size <= 0)
+        return;
+    auto in = static_cast<const unsigned char *>(data);
+    out.reserve(out.size() + size * 2);
+
+    char staging[HexChunk * 2];
+    for (int pos = 0; pos < size; pos += HexChunk) {
+        const int n = qMin(HexChunk, size - pos);
+        detail::hexEncode(in + pos, std::size_t(n), staging, upperCase);
+        out.append(QLatin1String(staging, n * 2));
+    }
+}
+
+//! \overload
+void hexInto(QString &out, const QByteArray &bytes, bool upperCase)
+{
+    hexInto(out, bytes.constData(), bytes.size(), upperCase);
+}
+
+/*!
+    \brief Appends a hex dump of the \a size bytes at \a data to \a out.
+
+    Each line holds 16 bytes, laid out as `hexdump -C` does:
+    \code
+        00000000  48 65 6c 6c 6f 2c 20 77  6f 72 6c 64 21 0a 00 ff  |Hello, world!...|
+    \endcode
+    \a options controls the offset column, the ASCII column and the case of the digits. Every line,
+    including the last, ends with `\n`.
+*/
+void hexDumpInto(QString &out, const void *data, int size, HexDumpOptions options)
+{
+    if (!data || size <= 0)
+        return;
+    auto in = static_cast<const unsigned char *>(data);
+    const bool showOffset = options.testFlag(HexDumpOption::ShowOffset);
+    const bool showAscii = options.testFlag(HexDumpOption::ShowAscii);
+    const bool upper = options.testFlag(HexDumpOption::UpperCase);
+    const char *digits = detail::hexDigits(upper);
+
+    const int lines = (size + HexDumpWidth - 1) / HexDumpWidth;
+    out.reserve(out.size() + lines * HexDumpLineMax);
+
+    char hex[HexChunk * 2];
+    char ascii[HexChunk];
+    char text[HexChunk / HexDumpWidth * HexDumpLineMax];
+    for (int chunk = 0; chunk < size; chunk += HexChunk) {
+        const int n = qMin(HexChunk, size - chunk);
+        detail::hexEncode(in + chunk, std::size_t(n), hex, upper);
+        if (showAscii)
+            detail::printable(in + chunk, std::size_t(n), ascii);
+
+        char *p = text;
+        for (int line = 0; line < n; line += HexDumpWidth) {
+            const int count = qMin(HexDumpWidth, n - line);
+            if (showOffset) {
+                quint32 offset = quint32(chunk + line);
+                for (int i = 7; i >= 0; --i, offset >>= 4)
+                    p[i] = digits[offset & 0xF];
+                p[8] = ' ';
+                p[9] = ' ';
+                p += 10;
+            }
+            char *lineStart = p;
+            for (int i = 0; i < HexDumpWidth; ++i) {
+                if (i == HexDumpWidth / 2)
+                    *p++ = ' ';
+                if (i < count) {
+                    p[0] = hex[2 * (line + i)];
+                    p[1] = hex[2 * (line + i) + 1];
+                } else {
+                    p[0] = ' ';
+                    p[1] = ' ';
+                }
+                p[2] = ' ';
+                p += 3;
+            }
+            if (showAscii) {
+                *p++ = ' ';
+                *p++ = '|';
+                std::memcpy(p, ascii + line, std::size_t(count));
+                p += count;
+                *p++ = '|';
+            } else {
+                //no column follows, so drop the padding of a short last line
+                while (p > lineStart && p[-1] == ' ')
+                    --p;
+            }
+            *p++ = '\n';
+        }
+        out.append(QLatin1String(text, int(p - text)));
+    }
+}
+
+//! Returns a hex dump of the \a size bytes at \a data. \sa hexDumpInto
+QString hexDump(const void *data, int size, HexDumpOptions options)
+{
+    QString ret;
+    hexDumpInto(ret, data, size, options);
+    return ret;
+}
+
+//! \overload
+QString hexDump(const QByteArray &bytes, HexDumpOptions options)
+{
+    return hexDump(bytes.constData(), bytes.size(), options);
+}
+
+} // namespace qe
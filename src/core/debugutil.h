@@ -24,95 +24,127 @@
 #define QE_CORE_DEBUGUTIL_H
 
 #ifndef QEXT_CORE_NO_QT
+#include <type_traits>
 #include <qecore/global.h>
+#include <qecore/type_util.h>
 
+#include <QtCore/QByteArray>
 #include <QtCore/QString>
 #include <QtCore/QVariant>
+#include <QtCore/QMetaType>
+
+QT_BEGIN_NAMESPACE
+class QColor;
+QT_END_NAMESPACE
 
 namespace qe
 {
-    QString toString(const QVariant &var);
+    //! \brief Appends a textual representation of the value at \a value to \a out.
+    //! \a value points to an instance of the type the formatter was registered for.
+    using Formatter = void (*)(const void *value, QString &out);
 
-    inline QString toHexString(const quint64 value) { return QString::number(value, 16); }
-    inline QString toHexString(const qint64 value)  { return QString::number(value, 16); }
-    inline QString toHexString(const quint32 value) { return QString::number(value, 16); }
-    inline QString toHexString(const qint32 value)  { return QString::number(value, 16); }
-    inline QString toHexString(const quint16 value) { return QString::number(uint(value), 16); }
-    inline QString toHexString(const qint16 value)  { return QString::number(int(value), 16); }
-    inline QString toHexString(const quint8 value)  { return QString::number(uint(value), 16); }
-    inline QString toHexString(const qint8 value)   { return QString::number(int(value), 16); }
-};
+    void registerFormatter(int typeId, Formatter formatter);
+    Formatter formatter(int typeId) noexcept;
 
-#include <QMetaType>
-#include <QBrush>
-#include <QFont>
-#include <QUuid>
-#include <QRegion>
-#include <QRect>
+    bool formatInto(QString &out, const QVariant &var);
+    QString toString(const QVariant &var);
 
-QString qe::toString(const QVariant &var)
-{
-    QString ret;
-    switch(static_cast<QMetaType::Type>(var.type())) {
-    case QMetaType::QString:
-    case QMetaType::Bool:
-    case QMetaType::QByteArray:
-    case QMetaType::QChar:
-    case QMetaType::QDate:
-    case QMetaType::QDateTime:
-    case QMetaType::QStringList:
-    case QMetaType::QTime:
-    case QMetaType::Double:
-    case QMetaType::Int:
-    case QMetaType::UInt:
-    case QMetaType::LongLong:
-    case QMetaType::ULongLong:
-        ret = var.toString();
-        break;
-    case QMetaType::Float:
-        ret = QString::number(var.value<qreal>());
-        break;
-    case QMetaType::Short:
-        ret = QString::number(var.value<short>());
-        break;
-    case QMetaType::UShort:
-        ret = QString::number(var.value<ushort>());
-        break;
-    case QMetaType::SChar:
-        ret = QString::number(var.value<signed char>());
-        break;
-    case QMetaType::QPoint:
+    namespace detail {
+    void formatIntegerInto(QString &out, qlonglong value, int base);
+    void formatIntegerInto(QString &out, qulonglong value, int base);
+    } // namespace detail
+
+    //! \brief Appends \a value in \a base to \a out without allocating a temporary string.
+    //! The output matches `QString::number(value, base)`. A \a base outside 2-36 is reported
+    //! with `qWarning()` and replaced with 10.
+    template <class T, class = std::enable_if_t<detail::is_formattable_integer<T>::value>>
+    inline void formatInto(QString &out, T value, int base = 10)
     {
-        QPoint p = var.value<QPoint>();
-        ret = QString(QStringLiteral("(%1, %2)")).arg(p.x()).arg(p.y());
-        break;
+        using Wide = std::conditional_t<std::is_signed<T>::value, qlonglong, qulonglong>;
+        detail::formatIntegerInto(out, Wide(value), base);
     }
-    case QMetaType::QSize:
+
+    void formatInto(QString &out, double value);
+    void formatInto(QString &out, double value, char format, int precision);
+    bool formatInto(QString &out, const QColor &color, char component, int precision = 2);
+
+    void appendPointer(QString &out, const void *pointer);
+
+    //! \brief Registers \a Fn as the formatter for `T`.
+    //!
+    //! \code
+    //!     void formatVector(const QVector2D &v, QString &out) { ... }
+    //!     qe::registerFormatter<QVector2D, &formatVector>();
+    //! \endcode
+    template <class T, void (*Fn)(const T &, QString &)>
+    inline void registerFormatter()
     {
-        QSize sz = var.value<QSize>();
-        ret = QString(QStringLiteral("%1 x %2")).arg(sz.width()).arg(sz.height());
-        break;
+        registerFormatter(qMetaTypeId<T>(), [](const void *value, QString &out) {
+            Fn(*static_cast<const T *>(value), out);
+        });
     }
-    case QMetaType::QRect:
+
+    //! \brief Registers a formatter for the smart pointer type `Pointer`, such as qe::UniquePointer
+    //! or qe::ManagedPointer. The stored address is formatted as hexadecimal.
+    template <class Pointer>
+    inline void registerPointerFormatter()
     {
-        QRect r = var.value<QRect>();
-        ret = QString(QStringLiteral("[(%1, %2), %3 x %4]")).arg(
-                    r.left()).arg(r.top()).arg(r.width()).arg(r.height());
-        break;
+        registerFormatter(qMetaTypeId<Pointer>(), [](const void *value, QString &out) {
+            appendPointer(out, static_cast<const Pointer *>(value)->data());
+        });
     }
-    case QMetaType::QFont:
+
+    //! Options for qe::hexDump.
+    enum class HexDumpOption {
+        NoOptions       = 0x0,  //!< Only the hex bytes are written.
+        ShowOffset      = 0x1,  //!< Each line starts with the offset of its first byte.
+        ShowAscii       = 0x2,  //!< Each line ends with the printable ASCII of its bytes.
+        UpperCase       = 0x4,  //!< Hex digits are upper case.
+        DefaultOptions  = ShowOffset | ShowAscii
+    };
+    Q_DECLARE_FLAGS(HexDumpOptions, HexDumpOption)
+
+    //! \brief Appends \a value to \a out as lower case hexadecimal without a prefix or padding.
+    //! Negative values are written as a `-` followed by their magnitude, as `QString::number` does.
+    template <class T, class = std::enable_if_t<std::is_integral<T>::value>>
+    inline void hexInto(QString &out, T value)
     {
-        QFont f = var.value<QFont>();
-        ret = QString(QStringLiteral("[%1, %2]")).arg(f.family()).arg(f.pointSize());
-        break;
-    }
-    case QMetaType::QUuid:
-        ret = var.value<QUuid>().toString();
-        break;
-    default:
-        break;
+        using U = std::make_unsigned_t<T>;
+        const bool negative = std::is_signed<T>::value && value < T(0);
+        U magnitude = negative ? U(U(0) - U(value)) : U(value);
+        QChar buffer[sizeof(T) * 2 + 1];
+        int pos = int(sizeof(buffer) / sizeof(QChar));
+        do {
+            buffer[--pos] = QLatin1Char("0123456789abcdef"[magnitude & 0xF]);
+            magnitude = U(magnitude >> 4);
+        } while (magnitude);
+        if (negative)
+            buffer[--pos] = QLatin1Char('-');
+        out.append(buffer + pos, int(sizeof(buffer) / sizeof(QChar)) - pos);
     }
-    return ret;
-}
+
+    void hexInto(QString &out, const void *data, int size, bool upperCase = false);
+    void hexInto(QString &out, const QByteArray &bytes, bool upperCase = false);
+
+    void hexDumpInto(QString &out, const void *data, int size,
+                     HexDumpOptions options = HexDumpOption::DefaultOptions);
+    QString hexDump(const void *data, int size, HexDumpOptions options = HexDumpOption::DefaultOptions);
+    QString hexDump(const QByteArray &bytes, HexDumpOptions options = HexDumpOption::DefaultOptions);
+
+    template <class T>
+    inline QString toHexStringHelper(T value) { QString ret; hexInto(ret, value); return ret; }
+
+    inline QString toHexString(const quint64 value) { return toHexStringHelper(value); }
+    inline QString toHexString(const qint64 value)  { return toHexStringHelper(value); }
+    inline QString toHexString(const quint32 value) { return toHexStringHelper(value); }
+    inline QString toHexString(const qint32 value)  { return toHexStringHelper(value); }
+    inline QString toHexString(const quint16 value) { return toHexStringHelper(value); }
+    inline QString toHexString(const qint16 value)  { return toHexStringHelper(value); }
+    inline QString toHexString(const quint8 value)  { return toHexStringHelper(value); }
+    inline QString toHexString(const qint8 value)   { return toHexStringHelper(value); }
+};
+
+Q_DECLARE_OPERATORS_FOR_FLAGS(qe::HexDumpOptions)
+
 #endif // QEXT_CORE_NO_QT
 #endif // QE_CORE_DEBUGUTIL_H
@@ -0,0 +1,315 @@
+/*  QExt: Extensions to Qt
+ *  Copyright (C) 2016  Jonathan Harper
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+//  W A R N I N G
+//  -------------
+//  This file is not part of the QExt API. It holds the byte kernels behind
+//  qe::hexInto, qe::hexDump and qe::formatInto and may change without notice.
+
+#ifndef QE_CORE_DEBUGUTIL_P_H
+#define QE_CORE_DEBUGUTIL_P_H
+
+#include <charconv>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include "simd_p.h"
+
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+#  define QE_HAS_FLOAT_TO_CHARS 1
+#endif
+
+namespace qe {
+namespace detail {
+
+//! Returns the ASCII digits for a nibble.
+inline const char *hexDigits(bool upper) noexcept
+{
+    return upper ? "0123456789ABCDEF" : "0123456789abcdef";
+}
+
+//! Writes two hex digits per byte of \a in to \a out, which must hold `2 * n` chars.
+inline void hexEncodeScalar(const unsigned char *in, std::size_t n, char *out, bool upper) noexcept
+{
+    const char *digits = hexDigits(upper);
+    for (std::size_t i = 0; i < n; ++i) {
+        out[2 * i]     = digits[in[i] >> 4];
+        out[2 * i + 1] = digits[in[i] & 0xF];
+    }
+}
+
+//! Replaces bytes outside of printable ASCII with '.'.
+inline void printableScalar(const unsigned char *in, std::size_t n, char *out) noexcept
+{
+    for (std::size_t i = 0; i < n; ++i)
+        out[i] = (in[i] >= 0x20 && in[i] < 0x7F) ? char(in[i]) : '.';
+}
+
+#ifdef QE_SIMD_X86
+//! \internal
+//! Maps the nibbles in \a v (0-15 per byte) to ASCII hex digits.
+inline __m128i nibblesToAscii(__m128i v, __m128i letterOffset) noexcept
+{
+    const __m128i nine = _mm_set1_epi8(9);
+    const __m128i isLetter = _mm_cmpgt_epi8(v, nine);
+    return _mm_add_epi8(_mm_add_epi8(v, _mm_set1_epi8('0')), _mm_and_si128(isLetter, letterOffset));
+}
+
+//! SSE2 version of hexEncodeScalar; 16 bytes per iteration.
+inline void hexEncodeSse2(const unsigned char *in, std::size_t n, char *out, bool upper) noexcept
+{
+    const __m128i mask = _mm_set1_epi8(0x0F);
+    const __m128i letterOffset = _mm_set1_epi8(upper ? 'A' - '0' - 10 : 'a' - '0' - 10);
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i));
+        const __m128i hi = nibblesToAscii(_mm_and_si128(_mm_srli_epi16(v, 4), mask), letterOffset);
+        const __m128i lo = nibblesToAscii(_mm_and_si128(v, mask), letterOffset);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 2 * i), _mm_unpacklo_epi8(hi, lo));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 2 * i + 16), _mm_unpackhi_epi8(hi, lo));
+    }
+    hexEncodeScalar(in + i, n - i, out + 2 * i, upper);
+}
+
+//! SSE2 version of printableScalar.
+inline void printableSse2(const unsigned char *in, std::size_t n, char *out) noexcept
+{
+    //bias by 0x80 so signed compares give an unsigned range check
+    const __m128i bias = _mm_set1_epi8(char(0x80));
+    const __m128i low = _mm_set1_epi8(char(0x20 ^ 0x80) - 1);
+    const __m128i high = _mm_set1_epi8(char(0x7F ^ 0x80));
+    const __m128i dot = _mm_set1_epi8('.');
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i));
+        const __m128i b = _mm_xor_si128(v, bias);
+        const __m128i ok = _mm_and_si128(_mm_cmpgt_epi8(b, low), _mm_cmplt_epi8(b, high));
+        const __m128i r = _mm_or_si128(_mm_and_si128(ok, v), _mm_andnot_si128(ok, dot));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), r);
+    }
+    printableScalar(in + i, n - i, out + i);
+}
+
+//! AVX2 version of hexEncodeScalar; 32 bytes per iteration.
+QE_SIMD_TARGET_AVX2 inline void hexEncodeAvx2(const unsigned char *in, std::size_t n, char *out, bool upper) noexcept
+{
+    const __m256i mask = _mm256_set1_epi8(0x0F);
+    const __m256i nine = _mm256_set1_epi8(9);
+    const __m256i zero = _mm256_set1_epi8('0');
+    const __m256i letterOffset = _mm256_set1_epi8(upper ? 'A' - '0' - 10 : 'a' - '0' - 10);
+    std::size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(in + i));
+        __m256i hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), mask);
+        __m256i lo = _mm256_and_si256(v, mask);
+        hi = _mm256_add_epi8(_mm256_add_epi8(hi, zero), _mm256_and_si256(_mm256_cmpgt_epi8(hi, nine), letterOffset));
+        lo = _mm256_add_epi8(_mm256_add_epi8(lo, zero), _mm256_and_si256(_mm256_cmpgt_epi8(lo, nine), letterOffset));
+        //unpack works per 128-bit lane; permute the lanes back into byte order
+        const __m256i a = _mm256_unpacklo_epi8(hi, lo);
+        const __m256i b = _mm256_unpackhi_epi8(hi, lo);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + 2 * i), _mm256_permute2x128_si256(a, b, 0x20));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + 2 * i + 32), _mm256_permute2x128_si256(a, b, 0x31));
+    }
+    hexEncodeSse2(in + i, n - i, out + 2 * i, upper);
+}
+#endif // QE_SIMD_X86
+
+//! Writes two hex digits per byte of \a in to \a out using the given \a level.
+inline void hexEncode(const unsigned char *in, std::size_t n, char *out, bool upper,
+                      SimdLevel level = simdLevel()) noexcept
+{
+#ifdef QE_SIMD_X86
+    if (level == SimdLevel::AVX2)
+        return hexEncodeAvx2(in, n, out, upper);
+    if (level == SimdLevel::SSE2)
+        return hexEncodeSse2(in, n, out, upper);
+#else
+    (void)level;
+#endif
+    hexEncodeScalar(in, n, out, upper);
+}
+
+//! Copies \a in to \a out, replacing unprintable bytes with '.', using the given \a level.
+inline void printable(const unsigned char *in, std::size_t n, char *out,
+                      SimdLevel level = simdLevel()) noexcept
+{
+#ifdef QE_SIMD_X86
+    if (level != SimdLevel::Scalar)
+        return printableSse2(in, n, out);
+#else
+    (void)level;
+#endif
+    printableScalar(in, n, out);
+}
+
+//! Enough chars for any integer in any base, and for formatShortest.
+constexpr std::size_t NumberChars = 72;
+
+//! Returns true if \a base is one that `QString::number` and std::to_chars accept, 2 to 36.
+constexpr bool isValidBase(int base) noexcept
+{
+    return base >= 2 && base <= 36;
+}
+
+//! \brief Writes \a value in \a base (2-36) to [\a first, \a last), as `QString::number` does.
+//! Any other base is replaced with 10. Returns the end of the written range.
+template <class T>
+inline char *formatInteger(char *first, char *last, T value, int base = 10) noexcept
+{
+    return std::to_chars(first, last, value, isValidBase(base) ? base : 10).ptr;
+}
+
+#ifdef QE_HAS_FLOAT_TO_CHARS
+//! \internal
+//! Writes "inf", "-inf" or "nan" for non-finite values and returns true.
+inline bool formatNonFinite(char *&out, double value) noexcept
+{
+    if (std::isnan(value)) {
+        std::memcpy(out, "nan", 3);
+        out += 3;
+        return true;
+    }
+    if (std::isinf(value)) {
+        if (value < 0)
+            *out++ = '-';
+        std::memcpy(out, "inf", 3);
+        out += 3;
+        return true;
+    }
+    return false;
+}
+
+/*!
+    \brief Writes the shortest representation of \a value that reads back exactly.
+
+    The choice between decimal and exponent form follows
+    `QString::number(value, 'g', QLocale::FloatingPointShortest)` in Qt 5.15: the shorter form wins,
+    and the decimal form wins a tie. Returns `nullptr` if [\a first, \a last) holds fewer than
+    NumberChars chars.
+*/
+inline char *formatShortest(char *first, char *last, double value) noexcept
+{
+    if (last - first < std::ptrdiff_t(NumberChars))
+        return nullptr;
+    char *out = first;
+    if (formatNonFinite(out, value))
+        return out;
+
+    char sci[NumberChars];
+    char *sciEnd = std::to_chars(sci, sci + sizeof(sci), value, std::chars_format::scientific).ptr;
+
+    //split "-d.ddde+XX" into sign, digits and exponent
+    const char *p = sci;
+    const bool negative = *p == '-';
+    if (negative)
+        ++p;
+    char digits[24];
+    int digitCount = 0;
+    for (; *p != 'e'; ++p) {
+        if (*p != '.')
+            digits[digitCount++] = *p;
+    }
+    int exponent = 0;
+    std::from_chars(p[1] == '+' ? p + 2 : p + 1, sciEnd, exponent);
+    const int decpt = exponent + 1;
+
+    //Qt: bias is the length of "e+XX" less adjustments for a decimal point shown in only one form
+    int bias = 4;
+    if (digitCount <= decpt && digitCount > 1)
+        ++bias;
+    else if (digitCount == 1 && decpt <= 0)
+        --bias;
+    const bool useDecimal = decpt <= 0 ? 1 - decpt <= bias
+                          : decpt <= digitCount ? true
+                          : decpt <= digitCount + bias;
+    if (!useDecimal) {
+        const std::size_t n = std::size_t(sciEnd - sci);
+        std::memcpy(out, sci, n);
+        return out + n;
+    }
+
+    if (negative)
+        *out++ = '-';
+    if (decpt <= 0) {
+        *out++ = '0';
+        *out++ = '.';
+        for (int i = decpt; i < 0; ++i)
+            *out++ = '0';
+        std::memcpy(out, digits, std::size_t(digitCount));
+        out += digitCount;
+    } else if (decpt >= digitCount) {
+        std::memcpy(out, digits, std::size_t(digitCount));
+        out += digitCount;
+        for (int i = digitCount; i < decpt; ++i)
+            *out++ = '0';
+    } else {
+        std::memcpy(out, digits, std::size_t(decpt));
+        out += decpt;
+        *out++ = '.';
+        std::memcpy(out, digits + decpt, std::size_t(digitCount - decpt));
+        out += digitCount - decpt;
+    }
+    return out;
+}
+
+/*!
+    \brief Writes \a value as `QString::number(value, format, precision)` does for the formats
+    `'e'`, `'E'`, `'f'`, `'g'` and `'G'`.
+
+    Returns `nullptr` if [\a first, \a last) is too small or \a format is not recognised.
+*/
+inline char *formatDouble(char *first, char *last, double value, char format, int precision) noexcept
+{
+    const bool upper = format == 'E' || format == 'G';
+    std::chars_format fmt;
+    switch (format) {
+    case 'e': case 'E': fmt = std::chars_format::scientific; break;
+    case 'f':           fmt = std::chars_format::fixed; break;
+    case 'g': case 'G': fmt = std::chars_format::general; break;
+    default:            return nullptr;
+    }
+    char *out = first;
+    if (last - first >= 4 && formatNonFinite(out, value)) {
+        //Qt writes non-finite values in the case of the format
+        if (upper) {
+            for (char *c = first; c != out; ++c) {
+                if (*c >= 'a' && *c <= 'z')
+                    *c = char(*c - 'a' + 'A');
+            }
+        }
+        return out;
+    }
+    const auto result = std::to_chars(first, last, value, fmt, precision < 0 ? 6 : precision);
+    if (result.ec != std::errc())
+        return nullptr;
+    if (upper) {
+        for (char *c = first; c != result.ptr; ++c) {
+            if (*c == 'e')
+                *c = 'E';
+        }
+    }
+    return result.ptr;
+}
+#endif // QE_HAS_FLOAT_TO_CHARS
+
+} // namespace detail
+} // namespace qe
+
+#endif // QE_CORE_DEBUGUTIL_P_H
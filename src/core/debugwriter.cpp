@@ -0,0 +1,400 @@
+#include "debugwriter.h"
+#include "debugutil.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <QtCore/QDebug>
+#include <QtCore/QLocale>
+#include <QtCore/QVector>
+
+namespace qe {
+
+namespace {
+
+thread_local detail::LogRing *t_ring = nullptr;
+//set once the thread's ring is closed; trivially destructible, so it outlives t_releaser
+thread_local bool t_exited = false;
+
+//! \internal
+//! Closes the calling thread's ring when the thread exits, so the flusher can free it. Messages
+//! written by thread-local destructors that run later are dropped.
+struct RingReleaser
+{
+    detail::LogRing *ring = nullptr;
+    ~RingReleaser()
+    {
+        t_exited = true;
+        t_ring = nullptr;
+        if (ring)
+            ring->close();
+        ring = nullptr;
+    }
+};
+
+thread_local RingReleaser t_releaser;
+
+//! \internal
+//! The lifetime of the writer returned by DebugWriter::instance(). Both variables are constant
+//! initialised and never destroyed, so they may be read during static destruction.
+enum WriterState { WriterUnborn, WriterRunning, WriterStopped };
+std::atomic<int> s_state{WriterUnborn};
+//messages refused because their thread had exited or the writer was stopped
+std::atomic<quint64> s_lateDrops{0};
+
+bool isStopped() noexcept
+{
+    return s_state.load(std::memory_order_acquire) == WriterStopped;
+}
+
+//! \internal
+//! Counts a message that was refused without reaching a ring.
+bool refuse() noexcept
+{
+    s_lateDrops.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+std::int64_t timestampNow() noexcept
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void defaultSink(const QString &message)
+{
+    qDebug().noquote() << message;
+}
+
+//! \internal
+//! Appends \a arg to \a out.
+void appendArg(QString &out, const detail::LogArg &arg)
+{
+    switch (arg.type) {
+    case detail::LogArg::Int:
+        out += QString::number(qint64(arg.i));
+        break;
+    case detail::LogArg::UInt:
+        out += QString::number(quint64(arg.u));
+        break;
+    case detail::LogArg::Double:
+        out += QString::number(arg.d, 'g', QLocale::FloatingPointShortest);
+        break;
+    case detail::LogArg::Bool:
+        out += arg.u ? QLatin1String("true") : QLatin1String("false");
+        break;
+    case detail::LogArg::Pointer:
+        appendPointer(out, arg.data);
+        break;
+    case detail::LogArg::Utf8:
+        out += QString::fromUtf8(static_cast<const char *>(arg.data), int(arg.length));
+        break;
+    case detail::LogArg::Utf16:
+        out.append(static_cast<const QChar *>(arg.data), int(arg.length));
+        break;
+    default:
+        break;
+    }
+}
+
+//! \internal
+//! Substitutes `%1` to `%9` in \a format in a single pass. Unused or missing arguments are left as-is.
+void formatRecord(QString &out, const QString &format, const detail::LogArg *args, int count)
+{
+    const QChar *begin = format.constData();
+    const QChar *end = begin + format.size();
+    const QChar *literal = begin;
+    for (const QChar *p = begin; p + 1 < end; ++p) {
+        if (*p != QLatin1Char('%'))
+            continue;
+        const int index = p[1].unicode() - '1';
+        if (index < 0 || index >= count || index > 8)
+            continue;
+        out.append(literal, int(p - literal));
+        appendArg(out, args[index]);
+        ++p;
+        literal = p + 1;
+    }
+    out.append(literal, int(end - literal));
+}
+
+struct PendingMessage
+{
+    std::int64_t timestamp;
+    QString text;
+};
+
+} // namespace
+
+class DebugWriterPrivate : public PrivateBase
+{
+    QE_DECLARE_PUBLIC(DebugWriter)
+public:
+    explicit DebugWriterPrivate(DebugWriter *qq) : PrivateBase(qq) {}
+    ~DebugWriterPrivate();
+
+    detail::LogRing *createRing();
+    void run();
+    void drain();
+
+    //guards formats; drain formats from a copy, so it is never held while formatting
+    std::mutex formatMutex;
+    QVector<QString> formats;
+
+    //guards rings, sink, bufferSize, flushInterval and the thread state
+    mutable std::mutex mutex;
+    std::condition_variable wake;
+    std::vector<std::unique_ptr<detail::LogRing>> rings;
+    DebugWriter::Sink sink = &defaultSink;
+    int bufferSize = 64 * 1024;
+    int flushInterval = 20;
+    std::thread thread;
+    bool stopping = false;
+
+    //serialises consumers; held for the whole of a drain
+    std::mutex drainMutex;
+    quint64 droppedReported = 0;
+    //drops counted by rings that have since been freed
+    std::atomic<quint64> droppedRetired{0};
+};
+
+DebugWriterPrivate::~DebugWriterPrivate()
+{
+    //refuse messages and formats from here on; they would outlive the writer
+    s_state.store(WriterStopped, std::memory_order_release);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    if (thread.joinable())
+        thread.join();
+    drain();
+
+    //rings of threads that are still running are leaked rather than freed under them
+    for (auto &ring : rings) {
+        if (!ring->isClosed())
+            (void)ring.release();
+    }
+}
+
+//! \internal
+//! Creates and registers the ring for the calling thread. Returns `nullptr` once the writer is
+//! stopping.
+detail::LogRing *DebugWriterPrivate::createRing()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (stopping)
+        return nullptr;
+    rings.emplace_back(new detail::LogRing(std::size_t(bufferSize)));
+    if (!thread.joinable())
+        thread = std::thread([this] { run(); });
+    return rings.back().get();
+}
+
+//! \internal
+void DebugWriterPrivate::run()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!stopping) {
+        wake.wait_for(lock, std::chrono::milliseconds(flushInterval));
+        lock.unlock();
+        drain();
+        lock.lock();
+    }
+}
+
+//! \internal
+//! Formats and emits every committed record, then frees the rings of threads that have exited.
+void DebugWriterPrivate::drain()
+{
+    std::lock_guard<std::mutex> drainLock(drainMutex);
+
+    std::vector<detail::LogRing *> snapshot;
+    DebugWriter::Sink currentSink;
+    QVector<QString> formatTable;
+    {
+        //a shallow copy; registerFormat detaches it if it appends while this drain formats
+        std::lock_guard<std::mutex> formatLock(formatMutex);
+        formatTable = formats;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        snapshot.reserve(rings.size());
+        for (auto &ring : rings)
+            snapshot.push_back(ring.get());
+        currentSink = sink;
+    }
+
+    std::vector<PendingMessage> messages;
+    std::vector<detail::LogRing *> finished;
+    quint64 dropped = droppedRetired.load(std::memory_order_relaxed);
+    detail::LogArg args[9];
+    for (auto ring : snapshot) {
+        //a ring closed before the drain holds no records written after it
+        const bool closed = ring->isClosed();
+        ring->consume([&](const detail::LogRecordHeader &header, const char *payload) {
+            const int count = std::min<int>(header.argCount, 9);
+            for (int i = 0; i < count; ++i)
+                payload = detail::decodeArg(payload, args[i]);
+            PendingMessage message{header.timestamp, QString()};
+            //formats are registered before any record uses them
+            if (header.formatId < formatTable.size())
+                formatRecord(message.text, formatTable.at(header.formatId), args, count);
+            messages.push_back(std::move(message));
+        });
+        dropped += ring->dropped();
+        if (closed)
+            finished.push_back(ring);
+    }
+    dropped += s_lateDrops.load(std::memory_order_relaxed);
+
+    //each ring is already in order; merge the threads by timestamp
+    std::stable_sort(messages.begin(), messages.end(), [](const PendingMessage &a, const PendingMessage &b) {
+        return a.timestamp < b.timestamp;
+    });
+    if (currentSink) {
+        for (const auto &message : messages)
+            currentSink(message.text);
+        if (dropped > droppedReported) {
+            currentSink(QStringLiteral("qe::DebugWriter: %1 messages dropped").arg(dropped - droppedReported));
+        }
+    }
+    droppedReported = dropped;
+
+    if (!finished.empty()) {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto ring : finished) {
+            droppedRetired.fetch_add(ring->dropped(), std::memory_order_relaxed);
+            rings.erase(std::remove_if(rings.begin(), rings.end(), [ring](const std::unique_ptr<detail::LogRing> &r) {
+                return r.get() == ring;
+            }), rings.end());
+        }
+    }
+}
+
+DebugWriter::DebugWriter()
+    : PublicBase(*new DebugWriterPrivate(this))
+{
+    s_state.store(WriterRunning, std::memory_order_release);
+}
+
+DebugWriter::~DebugWriter()
+{
+}
+
+//! \brief Returns the process-wide writer.
+//! The writer is destroyed with other static objects. Messages and formats written after that
+//! are refused rather than reaching it, but the instance itself must not be used.
+DebugWriter &DebugWriter::instance()
+{
+    static DebugWriter writer;
+    return writer;
+}
+
+//! \brief Registers \a format, a UTF-8 string using `%1` to `%9`, and returns its id.
+//! Used by \ref QE_DEBUG_WRITE, which registers each call site's format once.
+//! Returns -1, which \ref write refuses, once the writer has been destroyed.
+int DebugWriter::registerFormat(const char *format)
+{
+    if (isStopped())
+        return -1;
+    auto d = instance().qe_d_func();
+    std::lock_guard<std::mutex> lock(d->formatMutex);
+    d->formats.append(QString::fromUtf8(format));
+    return d->formats.size() - 1;
+}
+
+//! \internal
+bool DebugWriter::writeRecord(int formatId, const detail::LogArg *args, std::size_t count) noexcept
+{
+    //the thread's ring may already be freed, and a stopped writer's rings are no longer drained
+    if (t_exited || isStopped())
+        return refuse();
+    detail::LogRing *ring = t_ring;
+    if (!ring) {
+        try {
+            ring = instance().qe_d_func()->createRing();
+        } catch (...) {
+            return refuse();
+        }
+        if (!ring)
+            return refuse();
+        t_ring = ring;
+        t_releaser.ring = ring;
+    }
+    if (formatId < 0 || formatId >= int(detail::LogPaddingFormat)) {
+        ring->countDrop();
+        return false;
+    }
+    return detail::writeLogRecord(*ring, std::uint16_t(formatId), timestampNow(), args, count);
+}
+
+//! \brief Formats and emits every message written before the call, on the calling thread.
+//! The sink may be called from this thread and from the background thread, but never from both at once.
+void DebugWriter::flush()
+{
+    QE_D;
+    d->drain();
+}
+
+//! Returns the number of messages dropped because a thread's buffer was full.
+quint64 DebugWriter::droppedCount() const
+{
+    QE_CD;
+    std::lock_guard<std::mutex> lock(d->mutex);
+    quint64 ret = d->droppedRetired.load(std::memory_order_relaxed) + s_lateDrops.load(std::memory_order_relaxed);
+    for (const auto &ring : d->rings)
+        ret += ring->dropped();
+    return ret;
+}
+
+//! Sets the function that receives formatted messages. The default writes them with `qDebug()`.
+void DebugWriter::setSink(Sink sink)
+{
+    QE_D;
+    std::lock_guard<std::mutex> lock(d->mutex);
+    d->sink = std::move(sink);
+}
+
+//! \brief Sets the size of the buffer of each writing thread to \a bytes.
+//! Only threads that have not yet written a message are affected. The default is 64 KiB.
+void DebugWriter::setBufferSize(int bytes)
+{
+    QE_D;
+    std::lock_guard<std::mutex> lock(d->mutex);
+    d->bufferSize = qMax(bytes, 4096);
+}
+
+//! Returns the size of the buffer created for each writing thread.
+int DebugWriter::bufferSize() const
+{
+    QE_CD;
+    std::lock_guard<std::mutex> lock(d->mutex);
+    return d->bufferSize;
+}
+
+//! Sets how often, in milliseconds, the background thread drains the buffers. The default is 20.
+void DebugWriter::setFlushInterval(int msecs)
+{
+    QE_D;
+    {
+        std::lock_guard<std::mutex> lock(d->mutex);
+        d->flushInterval = qMax(msecs, 1);
+    }
+    d->wake.notify_all();
+}
+
+//! Returns how often, in milliseconds, the background thread drains the buffers.
+int DebugWriter::flushInterval() const
+{
+    QE_CD;
+    std::lock_guard<std::mutex> lock(d->mutex);
+    return d->flushInterval;
+}
+
+} // namespace qe
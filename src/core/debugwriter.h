@@ -0,0 +1,146 @@
+/*  QExt: Extensions to Qt
+ *  Copyright (C) 2016  Jonathan Harper
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*!
+ \headerfile debugwriter.h <qecore/debugwriter.h>
+ \brief Provides an asynchronous writer for diagnostics on hot paths.
+*/
+
+#ifndef QE_CORE_DEBUGWRITER_H
+#define QE_CORE_DEBUGWRITER_H
+
+#ifndef QEXT_CORE_NO_QT
+#include <functional>
+#include <QtCore/QByteArray>
+#include <QtCore/QString>
+#include "dptr.h"
+#include "debugwriter_p.h"
+
+/*!
+    \brief Queues a diagnostic message on qe::DebugWriter without formatting it or blocking.
+
+    \a format is a string literal using `%1` to `%9` for the arguments that follow, as QString::arg
+    does. The format is registered once per call site. Arguments may be integers, floating point
+    values, `bool`, pointers, `const char *`, QString, QLatin1String or QByteArray.
+
+    \code
+        QE_DEBUG_WRITE("Failed to create NodeInfo from path: %1", filepath);
+    \endcode
+*/
+#define QE_DEBUG_WRITE(format, ...) \
+    do { \
+        static const int qe_debug_format = ::qe::DebugWriter::registerFormat(format); \
+        ::qe::DebugWriter::write(qe_debug_format, ##__VA_ARGS__); \
+    } while (false)
+
+namespace qe {
+
+namespace detail {
+
+inline LogArg makeLogArg(const QString &value) noexcept
+{
+    return makeLogArg(reinterpret_cast<const char16_t *>(value.utf16()), std::size_t(value.size()));
+}
+
+inline LogArg makeLogArg(QLatin1String value) noexcept
+{
+    LogArg ret;
+    ret.type = LogArg::Utf8;
+    ret.data = value.data() ? value.data() : "";
+    ret.length = static_cast<std::uint32_t>(value.size());
+    return ret;
+}
+
+inline LogArg makeLogArg(const QByteArray &value) noexcept
+{
+    LogArg ret;
+    ret.type = LogArg::Utf8;
+    ret.data = value.constData();
+    ret.length = static_cast<std::uint32_t>(value.size());
+    return ret;
+}
+
+} // namespace detail
+
+class DebugWriterPrivate;
+
+/*!
+    \brief Formats and emits diagnostics on a background thread.
+
+    Writing a message copies its format id and raw arguments into a lock-free ring buffer owned by
+    the calling thread. A background thread drains the buffers of all threads, formats the messages
+    in timestamp order and passes them to the sink, which defaults to `qDebug()`.
+
+    Writers never block. When a thread's buffer is full, further messages from that thread are
+    dropped and counted until the background thread catches up; the number dropped is reported
+    through the sink and by droppedCount(). Messages written from thread-local destructors that run
+    after the thread's buffer is closed, or after the writer itself is destroyed at exit, are
+    dropped the same way.
+
+    Messages are normally written with \ref QE_DEBUG_WRITE.
+*/
+class DebugWriter : public PublicBase
+{
+public:
+    //! Receives one formatted message. Called from the flushing thread.
+    using Sink = std::function<void(const QString &message)>;
+
+    static DebugWriter &instance();
+
+    static int registerFormat(const char *format);
+
+    template <class... Args>
+    static inline bool write(int formatId, const Args &...args) noexcept;
+
+    void flush();
+
+    quint64 droppedCount() const;
+
+    void setSink(Sink sink);
+    void setBufferSize(int bytes);
+    int bufferSize() const;
+    void setFlushInterval(int msecs);
+    int flushInterval() const;
+
+private:
+    DebugWriter();
+    ~DebugWriter();
+
+    static bool writeRecord(int formatId, const detail::LogArg *args, std::size_t count) noexcept;
+
+    QE_DECLARE_PRIVATE(DebugWriter)
+};
+
+//! \brief Queues a message using the format registered as \a formatId and the given \a args.
+//! Returns false if the message was dropped because the calling thread's buffer is full.
+template <class... Args>
+bool DebugWriter::write(int formatId, const Args &...args) noexcept
+{
+    using detail::makeLogArg;
+    const detail::LogArg list[] = { makeLogArg(args)..., detail::LogArg() };
+    return writeRecord(formatId, list, sizeof...(Args));
+}
+
+} // namespace qe
+
+#ifndef QEXT_NO_CLUTTER
+using QeDebugWriter = qe::DebugWriter;
+#endif
+
+#endif // QEXT_CORE_NO_QT
+
+#endif // QE_CORE_DEBUGWRITER_H
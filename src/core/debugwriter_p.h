@@ -0,0 +1,339 @@
+/*  QExt: Extensions to Qt
+ *  Copyright (C) 2016  Jonathan Harper
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+//  W A R N I N G
+//  -------------
+//  This file is not part of the QExt API. It holds the record format and the ring buffer behind
+//  qe::DebugWriter and may change without notice.
+
+#ifndef QE_CORE_DEBUGWRITER_P_H
+#define QE_CORE_DEBUGWRITER_P_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <type_traits>
+
+namespace qe {
+namespace detail {
+
+//! \brief One argument of a log record, as passed to the writer and as decoded by the consumer.
+//! String arguments point at the caller's data until encoded, and into the ring after decoding.
+struct LogArg
+{
+    enum Type : std::uint32_t { None, Int, UInt, Double, Bool, Pointer, Utf8, Utf16 };
+
+    Type type = None;
+    std::uint32_t length = 0;   //!< Code units in `data` for Utf8 and Utf16.
+    union {
+        std::int64_t i;
+        std::uint64_t u;
+        double d;
+        const void *data;
+    };
+
+    LogArg() noexcept : u(0) {}
+};
+
+//! Longest string argument, in code units, that is copied into a record. Longer strings are cut.
+constexpr std::uint32_t MaxLogStringLength = 1024;
+
+//! Record format id used for the filler written when a record would wrap the end of the ring.
+constexpr std::uint16_t LogPaddingFormat = 0xFFFF;
+
+//! \brief The fixed part of a record. Records and arguments are 8-byte aligned.
+//! Padding records only use `size` and `formatId`, which fit in the smallest possible gap.
+struct LogRecordHeader
+{
+    std::uint32_t size;         //!< Total size including the header.
+    std::uint16_t formatId;
+    std::uint16_t argCount;
+    std::int64_t timestamp;
+};
+
+//! \internal
+struct LogArgHeader
+{
+    std::uint32_t type;
+    std::uint32_t length;
+};
+
+constexpr std::size_t logAlign(std::size_t n) noexcept { return (n + 7) & ~std::size_t(7); }
+
+template <class T, std::enable_if_t<std::is_integral<T>::value && !std::is_same<T, bool>::value, int> = 0>
+inline LogArg makeLogArg(T value) noexcept
+{
+    LogArg ret;
+    if (std::is_signed<T>::value) {
+        ret.type = LogArg::Int;
+        ret.i = static_cast<std::int64_t>(value);
+    } else {
+        ret.type = LogArg::UInt;
+        ret.u = static_cast<std::uint64_t>(value);
+    }
+    return ret;
+}
+
+template <class T, std::enable_if_t<std::is_floating_point<T>::value, int> = 0>
+inline LogArg makeLogArg(T value) noexcept
+{
+    LogArg ret;
+    ret.type = LogArg::Double;
+    ret.d = static_cast<double>(value);
+    return ret;
+}
+
+inline LogArg makeLogArg(bool value) noexcept
+{
+    LogArg ret;
+    ret.type = LogArg::Bool;
+    ret.u = value ? 1 : 0;
+    return ret;
+}
+
+//! Pointers are logged as addresses; the pointee is never read.
+inline LogArg makeLogArg(const void *value) noexcept
+{
+    LogArg ret;
+    ret.type = LogArg::Pointer;
+    ret.data = value;
+    return ret;
+}
+
+inline LogArg makeLogArg(std::nullptr_t) noexcept
+{
+    return makeLogArg(static_cast<const void *>(nullptr));
+}
+
+//! Strings are copied into the record, so \a value only needs to live for the duration of the call.
+inline LogArg makeLogArg(const char *value) noexcept
+{
+    LogArg ret;
+    ret.type = LogArg::Utf8;
+    ret.data = value ? value : "";
+    ret.length = value ? static_cast<std::uint32_t>(std::strlen(value)) : 0;
+    return ret;
+}
+
+inline LogArg makeLogArg(const char16_t *value, std::size_t length) noexcept
+{
+    LogArg ret;
+    ret.type = LogArg::Utf16;
+    ret.data = value;
+    ret.length = static_cast<std::uint32_t>(length);
+    return ret;
+}
+
+//! Returns the number of bytes \a arg takes in a record.
+inline std::size_t encodedSize(const LogArg &arg) noexcept
+{
+    switch (arg.type) {
+    case LogArg::Utf8:
+        return sizeof(LogArgHeader) + logAlign(arg.length < MaxLogStringLength ? arg.length : MaxLogStringLength);
+    case LogArg::Utf16:
+        return sizeof(LogArgHeader) + logAlign(2 * (arg.length < MaxLogStringLength ? arg.length : MaxLogStringLength));
+    default:
+        return sizeof(LogArgHeader) + 8;
+    }
+}
+
+//! Writes \a arg to \a out and returns the position after it.
+inline char *encodeArg(char *out, const LogArg &arg) noexcept
+{
+    LogArgHeader header{arg.type, arg.length < MaxLogStringLength ? arg.length : MaxLogStringLength};
+    std::memcpy(out, &header, sizeof(header));
+    out += sizeof(header);
+    switch (arg.type) {
+    case LogArg::Utf8:
+        std::memcpy(out, arg.data, header.length);
+        return out + logAlign(header.length);
+    case LogArg::Utf16:
+        std::memcpy(out, arg.data, 2 * std::size_t(header.length));
+        return out + logAlign(2 * std::size_t(header.length));
+    default:
+        std::memcpy(out, &arg.u, 8);
+        return out + 8;
+    }
+}
+
+//! Reads the argument at \a in into \a arg and returns the position after it.
+inline const char *decodeArg(const char *in, LogArg &arg) noexcept
+{
+    LogArgHeader header;
+    std::memcpy(&header, in, sizeof(header));
+    in += sizeof(header);
+    arg.type = static_cast<LogArg::Type>(header.type);
+    arg.length = header.length;
+    switch (arg.type) {
+    case LogArg::Utf8:
+        arg.data = in;
+        return in + logAlign(header.length);
+    case LogArg::Utf16:
+        arg.data = in;
+        return in + logAlign(2 * std::size_t(header.length));
+    default:
+        std::memcpy(&arg.u, in, 8);
+        return in + 8;
+    }
+}
+
+/*!
+    \brief A single-producer, single-consumer byte ring holding log records.
+
+    The owning thread reserves, fills and commits records; one consumer at a time drains them.
+    Neither side blocks: when a record does not fit, the producer drops it and counts the drop.
+    Records are never split across the end of the ring; a padding record fills the gap instead.
+*/
+class LogRing
+{
+public:
+    //! Constructs a ring of at least \a capacity bytes, rounded up to a power of two.
+    explicit LogRing(std::size_t capacity)
+    {
+        std::size_t size = 4096;
+        while (size < capacity)
+            size <<= 1;
+        m_mask = size - 1;
+        m_data = static_cast<char *>(::operator new(size));
+    }
+    ~LogRing() { ::operator delete(m_data); }
+
+    LogRing(const LogRing &) = delete;
+    LogRing &operator=(const LogRing &) = delete;
+
+    std::size_t capacity() const noexcept { return m_mask + 1; }
+
+    //! \brief Reserves \a size bytes, a multiple of 8, for a record. Producer only.
+    //! Returns `nullptr` and counts a drop if the ring does not have room.
+    char *reserve(std::size_t size) noexcept
+    {
+        std::size_t head = m_head.load(std::memory_order_relaxed);
+        const std::size_t tail = m_tail.load(std::memory_order_acquire);
+        const std::size_t pos = head & m_mask;
+        const std::size_t contiguous = capacity() - pos;
+        const std::size_t needed = size <= contiguous ? size : size + contiguous;
+        if (needed > capacity() - (head - tail)) {
+            countDrop();
+            return nullptr;
+        }
+        if (size > contiguous) {
+            writePadding(pos, contiguous);
+            head += contiguous;
+        }
+        m_reserved = head;
+        return m_data + (head & m_mask);
+    }
+
+    //! Publishes the record returned by the last reserve call. Producer only.
+    void commit(std::size_t size) noexcept
+    {
+        m_head.store(m_reserved + size, std::memory_order_release);
+    }
+
+    //! \brief Calls `fn(header, payload)` for each committed record and releases them. Consumer only.
+    //! Returns the number of records consumed.
+    template <class Fn>
+    std::size_t consume(Fn &&fn)
+    {
+        const std::size_t head = m_head.load(std::memory_order_acquire);
+        std::size_t tail = m_tail.load(std::memory_order_relaxed);
+        std::size_t count = 0;
+        while (tail != head) {
+            const char *at = m_data + (tail & m_mask);
+            LogRecordHeader header;
+            std::memcpy(&header, at, 8);
+            if (header.formatId != LogPaddingFormat) {
+                std::memcpy(&header.timestamp, at + 8, sizeof(header.timestamp));
+                fn(static_cast<const LogRecordHeader &>(header), at + sizeof(LogRecordHeader));
+                ++count;
+            }
+            tail += header.size;
+        }
+        m_tail.store(tail, std::memory_order_release);
+        return count;
+    }
+
+    //! Returns true if no committed records are waiting.
+    bool isEmpty() const noexcept
+    {
+        return m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_acquire);
+    }
+
+    //! Counts a record the producer could not write. Producer only.
+    void countDrop() noexcept
+    {
+        m_dropped.store(m_dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    //! Returns the number of records dropped because the ring was full.
+    std::uint64_t dropped() const noexcept { return m_dropped.load(std::memory_order_relaxed); }
+
+    //! Marks the ring as abandoned by its producer. The consumer frees it once drained.
+    void close() noexcept { m_closed.store(true, std::memory_order_release); }
+    bool isClosed() const noexcept { return m_closed.load(std::memory_order_acquire); }
+
+private:
+    void writePadding(std::size_t pos, std::size_t size) noexcept
+    {
+        const std::uint32_t size32 = static_cast<std::uint32_t>(size);
+        const std::uint16_t format = LogPaddingFormat;
+        std::memcpy(m_data + pos, &size32, sizeof(size32));
+        std::memcpy(m_data + pos + sizeof(size32), &format, sizeof(format));
+    }
+
+    alignas(64) std::atomic<std::size_t> m_head{0};
+    std::size_t m_reserved = 0;
+    std::atomic<std::uint64_t> m_dropped{0};
+    alignas(64) std::atomic<std::size_t> m_tail{0};
+    std::atomic<bool> m_closed{false};
+    std::size_t m_mask = 0;
+    char *m_data = nullptr;
+};
+
+//! \brief Encodes a record for \a formatId with the \a count arguments at \a args into \a ring.
+//! Returns false if the record was dropped.
+inline bool writeLogRecord(LogRing &ring, std::uint16_t formatId, std::int64_t timestamp,
+                           const LogArg *args, std::size_t count) noexcept
+{
+    std::size_t size = sizeof(LogRecordHeader);
+    for (std::size_t i = 0; i < count; ++i)
+        size += encodedSize(args[i]);
+    //a record larger than a quarter of the ring would starve everything else
+    if (size > ring.capacity() / 4 || count > 0xFFFF) {
+        ring.countDrop();
+        return false;
+    }
+    char *out = ring.reserve(size);
+    if (!out)
+        return false;
+
+    const LogRecordHeader header{static_cast<std::uint32_t>(size), formatId,
+                                 static_cast<std::uint16_t>(count), timestamp};
+    std::memcpy(out, &header, sizeof(header));
+    char *p = out + sizeof(header);
+    for (std::size_t i = 0; i < count; ++i)
+        p = encodeArg(p, args[i]);
+    ring.commit(size);
+    return true;
+}
+
+} // namespace detail
+} // namespace qe
+
+#endif // QE_CORE_DEBUGWRITER_P_H
@@ -38,8 +38,18 @@
     inline Classname##Private* qe_d_func() noexcept { return reinterpret_cast<Classname##Private *>(qed_ptr.data()); } \
     inline const Classname##Private* qe_d_func() const noexcept { return reinterpret_cast<const Classname##Private *>(qed_ptr.data()); } \
     inline const Classname##Private* qe_cd_func() const noexcept { return reinterpret_cast<const Classname##Private *>(qed_ptr.data()); } \
+    using qe_private_type = Classname##Private; \
+    template <class> friend class ::qe::BulkStorage; \
     friend class Classname##Private;
 
+//! Declares `noexcept` move operations for a class deriving from qe::PublicBase.
+//! A class that declares a destructor has no implicit move operations; with these, `std::vector`
+//! moves its elements when it reallocates. Qt 5 containers such as `QVector` require copyable
+//! types and cannot hold these classes by value.
+#define QE_DECLARE_MOVABLE(Classname) \
+    Classname(Classname &&) noexcept = default; \
+    Classname &operator=(Classname &&) noexcept = default;
+
 #define QE_DPTR         auto d = qe_d_func()  //! Retrieves the d-ptr for a non-`const` object.
 #define QE_CONST_DPTR   auto d = qe_cd_func() //! Retrieves a `const` d-ptr; used in `const` functions.
 #define QE_QPTR         auto q = qe_q_func()  //! Used in a PrivateBase-derived class to retrieve the back-pointer.
@@ -61,6 +71,8 @@
 //! \endcond
 namespace qe {
 
+template <class Public> class BulkStorage;
+
 /*!
     \class PrivateBase
     \brief The PrivateBase enables a class to behave as a d-ptr data class.
@@ -69,6 +81,8 @@ namespace qe {
 */
 
 class PublicBase;
+class PrivateBase;
+
 class PrivateBase
 {
 public:
@@ -93,6 +107,44 @@ public:
     void operator =(PrivateBase &&) = delete;
 protected:
     PublicBase *qe_ptr;
+
+private:
+    friend class PublicBase;
+    friend struct PrivateDeleter;
+    template <class> friend class BulkStorage;
+
+    //! Where the instance lives, which decides how PrivateDeleter cleans it up.
+    enum class Storage : unsigned char {
+        Heap,           //!< Allocated with `new`; deleted.
+        SlabPending,    //!< In a BulkStorage slab whose public class is still being constructed; left to the BulkStorage.
+        Slab            //!< In a BulkStorage slab; destroyed in place.
+    };
+    Storage qe_storage = Storage::Heap;
+};
+
+/*!
+    \brief The deleter used by PublicBase for its d-ptr.
+
+    Heap-allocated private classes are deleted normally. Private classes constructed in place by
+    qe::constructBulk are only destroyed; their memory belongs to the owning qe::BulkStorage.
+*/
+struct PrivateDeleter
+{
+    static void cleanup(PrivateBase *ptr)
+    {
+        if (!ptr)
+            return;
+        switch (ptr->qe_storage) {
+        case PrivateBase::Storage::Heap:
+            delete ptr;
+            break;
+        case PrivateBase::Storage::Slab:
+            ptr->~PrivateBase();
+            break;
+        case PrivateBase::Storage::SlabPending:
+            break;
+        }
+    }
 };
 
 /*!
@@ -110,6 +162,14 @@ protected:
     \endcode
 
     You must also use the \ref QE_DECLARE_PUBLIC macro in the private section of your class.
+
+    PublicBase can be moved. Moving transfers the d-ptr and rebinds its back-pointer to the new
+    instance; the moved-from instance is left with a null d-ptr and may only be destroyed or
+    assigned to. See \ref QE_DECLARE_MOVABLE.
+
+    \warning A private class constructed by qe::constructBulk is not relocated by a move; it stays
+    in the slab of its qe::BulkStorage. An object that takes it must be destroyed before that
+    storage.
 */
 class PublicBase
 {
@@ -117,8 +177,16 @@ public:
     //! The only functional constructor. Note that this takes a \em reference, i.e. it cannot be null.
     explicit PublicBase(PrivateBase &dd);
 
+    inline PublicBase(PublicBase &&other) noexcept;
+    inline PublicBase &operator=(PublicBase &&other) noexcept;
+
+    //! Deleted copy constructor.
+    PublicBase(const PublicBase &) = delete;
+    //! Deleted copy assignment operator.
+    PublicBase &operator=(const PublicBase &) = delete;
+
 protected:
-    UniquePointer<PrivateBase> qed_ptr;
+    UniquePointer<PrivateBase, PrivateDeleter> qed_ptr;
 };
 
 //! Constructs a new object with \a qq as the back pointer (q-ptr).
@@ -129,11 +197,32 @@ inline PrivateBase::PrivateBase(PublicBase *qq)
 
 
 //! Constructs a new object with \a dd as the source for the d-ptr.
+//! The back-pointer of \a dd is bound to this instance, so the private class may be constructed
+//! with a null q-ptr.
 inline PublicBase::PublicBase(PrivateBase &dd)
     : qed_ptr(&dd)
 {
+    dd.qe_ptr = this;
 }
 
+//! Move constructs from \a other, taking its d-ptr and rebinding the d-ptr's back-pointer.
+inline PublicBase::PublicBase(PublicBase &&other) noexcept
+    : qed_ptr(other.qed_ptr.release())
+{
+    if (qed_ptr)
+        qed_ptr->qe_ptr = this;
+}
+
+//! Move assigns from \a other. The current d-ptr is destroyed and replaced with that of \a other.
+inline PublicBase &PublicBase::operator=(PublicBase &&other) noexcept
+{
+    if (this != &other) {
+        qed_ptr.reset(other.qed_ptr.release());
+        if (qed_ptr)
+            qed_ptr->qe_ptr = this;
+    }
+    return *this;
+}
 
 } // namespace qe
 
@@ -0,0 +1,172 @@
+/*  QExt: Extensions to Qt
+ *  Copyright (C) 2016  Jonathan Harper
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*!
+ \headerfile seqlock.h <qecore/seqlock.h>
+ \brief Provides a sequence-locked d-ptr base class for lock-free readers.
+*/
+
+#ifndef QE_CORE_SEQLOCK_H
+#define QE_CORE_SEQLOCK_H
+
+#include <atomic>
+#include <thread>
+#include <type_traits>
+#include "dptr.h"
+
+//! Reads \a expr from the d-ptr of a class whose private class derives from qe::SeqLockedPrivate.
+#define QE_CD_READ(expr) (::qe::seqRead(qe_cd_func(), [&](auto d) { return (expr); }))
+
+namespace qe {
+
+/*!
+    \brief A PrivateBase that lets readers copy fields without taking a lock.
+
+    SeqLockedPrivate guards the fields of a private class with a sequence counter. Writers make the
+    counter odd for the duration of a change (see SeqWriteLocker); readers copy the fields they need
+    and retry if the counter was odd or changed while they were copying. Readers never block each
+    other and never block a writer.
+
+    This suits objects that are read frequently from many threads and written rarely. Reads should
+    be limited to copying small, trivially copyable fields, because a read may observe a torn value
+    before it is discarded and retried. Do not follow pointers or copy implicitly shared Qt types
+    inside a read.
+
+    \code
+        int MyClass::count() const
+        {
+            return QE_CD_READ(d->count);
+        }
+
+        void MyClass::setCount(int count)
+        {
+            QE_D;
+            qe::SeqWriteLocker lock(d);
+            d->count = count;
+        }
+    \endcode
+*/
+class SeqLockedPrivate : public PrivateBase
+{
+public:
+    //! Constructs a new instance with \a qq as the back-pointer.
+    explicit SeqLockedPrivate(PublicBase *qq) : PrivateBase(qq) {}
+
+    template <class Fn>
+    inline auto seqRead(Fn &&fn) const -> std::decay_t<decltype(fn())>;
+
+    inline void beginWrite() noexcept;
+    inline void endWrite() noexcept;
+
+    //! Returns the current value of the sequence counter. It is odd while a write is in progress.
+    unsigned sequence() const noexcept { return qe_seq.load(std::memory_order_acquire); }
+
+private:
+    static inline void relax(unsigned &spins) noexcept;
+
+    mutable std::atomic<unsigned> qe_seq{0};
+};
+
+//! \brief Holds a SeqLockedPrivate in the write state for the lifetime of the locker.
+//! Writers are serialised against each other; readers retry until the locker is destroyed.
+class SeqWriteLocker
+{
+public:
+    //! Begins a write on \a d.
+    explicit SeqWriteLocker(SeqLockedPrivate *d) noexcept : m_d(d) { m_d->beginWrite(); }
+    //! Ends the write.
+    ~SeqWriteLocker()                           { m_d->endWrite(); }
+
+    SeqWriteLocker(const SeqWriteLocker &) = delete;
+    SeqWriteLocker &operator=(const SeqWriteLocker &) = delete;
+
+private:
+    SeqLockedPrivate *m_d;
+};
+
+//! Calls `fn(d)` under the sequence lock of \a d and returns the result. Used by \ref QE_CD_READ.
+//! \relates qe::SeqLockedPrivate
+template <class Private, class Fn>
+inline auto seqRead(const Private *d, Fn &&fn)
+{
+    static_assert(std::is_base_of<SeqLockedPrivate, Private>::value,
+                  "QE_CD_READ requires a private class deriving from qe::SeqLockedPrivate.");
+    return d->seqRead([&] { return fn(d); });
+}
+
+////////
+// Implementation below
+
+//! Calls \a fn until it completes without a concurrent write and returns a copy of its result.
+template <class Fn>
+auto SeqLockedPrivate::seqRead(Fn &&fn) const -> std::decay_t<decltype(fn())>
+{
+    unsigned spins = 0;
+    for (;;) {
+        const unsigned before = qe_seq.load(std::memory_order_acquire);
+        if (before & 1u) {
+            relax(spins);
+            continue;
+        }
+        std::decay_t<decltype(fn())> ret = fn();
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (qe_seq.load(std::memory_order_relaxed) == before)
+            return ret;
+        relax(spins);
+    }
+}
+
+//! Marks the start of a write. Concurrent writers wait for each other.
+void SeqLockedPrivate::beginWrite() noexcept
+{
+    unsigned spins = 0;
+    unsigned seq = qe_seq.load(std::memory_order_relaxed);
+    for (;;) {
+        if (!(seq & 1u) && qe_seq.compare_exchange_weak(seq, seq + 1, std::memory_order_acquire,
+                                                        std::memory_order_relaxed))
+            break;
+        relax(spins);
+        seq = qe_seq.load(std::memory_order_relaxed);
+    }
+    //keep the writes that follow from becoming visible before the odd counter
+    std::atomic_thread_fence(std::memory_order_release);
+}
+
+//! Marks the end of a write started with beginWrite.
+void SeqLockedPrivate::endWrite() noexcept
+{
+    qe_seq.fetch_add(1, std::memory_order_release);
+}
+
+//! \internal
+//! Spins briefly, then yields to the scheduler.
+void SeqLockedPrivate::relax(unsigned &spins) noexcept
+{
+    if (++spins > 64) {
+        spins = 0;
+        std::this_thread::yield();
+    }
+}
+
+} // namespace qe
+
+#ifndef QEXT_NO_CLUTTER
+using QeSeqLockedPrivate = qe::SeqLockedPrivate;
+using QeSeqWriteLocker = qe::SeqWriteLocker;
+#endif
+
+#endif // QE_CORE_SEQLOCK_H
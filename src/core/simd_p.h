@@ -0,0 +1,92 @@
+/*  QExt: Extensions to Qt
+ *  Copyright (C) 2016  Jonathan Harper
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+//  W A R N I N G
+//  -------------
+//  This file is not part of the QExt API. It holds the CPU feature detection shared by the SIMD
+//  kernels in qecore and qewindows and may change without notice.
+
+#ifndef QE_CORE_SIMD_P_H
+#define QE_CORE_SIMD_P_H
+
+#if defined(__x86_64__) || defined(_M_X64) || (defined(__i386__) && defined(__SSE2__)) \
+    || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  define QE_SIMD_X86 1
+#  include <emmintrin.h>
+#  include <immintrin.h>
+#  if defined(_MSC_VER) && !defined(__clang__)
+#    include <intrin.h>
+#    define QE_SIMD_TARGET_AVX2
+#  else
+#    include <cpuid.h>
+#    define QE_SIMD_TARGET_AVX2 __attribute__((target("avx2")))
+#  endif
+#endif
+
+namespace qe {
+namespace detail {
+
+//! The instruction sets the SIMD kernels can use, from least to most capable.
+enum class SimdLevel { Scalar, SSE2, AVX2 };
+
+//! Returns the best SimdLevel supported by the running CPU.
+inline SimdLevel detectSimdLevel() noexcept
+{
+#ifdef QE_SIMD_X86
+#  if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] >= 7) {
+        __cpuid(info, 1);
+        const bool osxsave = info[2] & (1 << 27);
+        const bool avx = info[2] & (1 << 28);
+        __cpuidex(info, 7, 0);
+        if (osxsave && avx && (info[1] & (1 << 5)) && (_xgetbv(0) & 0x6) == 0x6)
+            return SimdLevel::AVX2;
+    }
+#  else
+    unsigned a = 0, b = 0, c = 0, d = 0;
+    if (__get_cpuid_max(0, nullptr) >= 7) {
+        __cpuid(1, a, b, c, d);
+        const bool osxsave = c & (1u << 27);
+        const bool avx = c & (1u << 28);
+        __cpuid_count(7, 0, a, b, c, d);
+        if (osxsave && avx && (b & (1u << 5))) {
+            unsigned lo, hi;
+            __asm__("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+            if ((lo & 0x6) == 0x6)
+                return SimdLevel::AVX2;
+        }
+    }
+#  endif
+    return SimdLevel::SSE2;
+#else
+    return SimdLevel::Scalar;
+#endif
+}
+
+//! Returns the SimdLevel used by the SIMD kernels. It is detected once per process.
+inline SimdLevel simdLevel() noexcept
+{
+    static const SimdLevel level = detectSimdLevel();
+    return level;
+}
+
+} // namespace detail
+} // namespace qe
+
+#endif // QE_CORE_SIMD_P_H
@@ -23,6 +23,8 @@
 #ifndef QE_CORE_TYPE_UTIL_H
 #define QE_CORE_TYPE_UTIL_H
 
+#include <cstdint>
+#include <string_view>
 #include <type_traits>
 #include <utility>
 
@@ -52,6 +54,109 @@ struct is_pointer_static_castable<From, To,
     static constexpr bool value = true;
 };
 
+//! \cond
+namespace detail {
+
+template <class T>
+constexpr ::std::string_view raw_type_name() noexcept
+{
+#if defined(__clang__) || defined(__GNUC__)
+    return __PRETTY_FUNCTION__;
+#elif defined(_MSC_VER)
+    return __FUNCSIG__;
+#else
+#   error "qe::type_name requires __PRETTY_FUNCTION__ or __FUNCSIG__"
+#endif
+}
+
+//the decoration around the type name is the same for every T; measure it using a known type
+constexpr ::std::string_view type_name_probe = raw_type_name<void>();
+constexpr ::std::size_t type_name_prefix = type_name_probe.find("void");
+constexpr ::std::size_t type_name_suffix = type_name_probe.size() - type_name_prefix - 4;
+
+//the probe must find the type between the decoration each compiler is known to write
+static_assert(type_name_prefix != ::std::string_view::npos, "qe::type_name: the probe type was not found");
+#if defined(__clang__)
+//"... raw_type_name() [T = void]"
+static_assert(type_name_probe.substr(type_name_prefix - 5, 5) == "[T = "
+              && type_name_probe.substr(type_name_prefix + 4) == "]",
+              "qe::type_name: unexpected __PRETTY_FUNCTION__ format");
+#elif defined(__GNUC__)
+//"... raw_type_name() [with T = void; std::string_view = ...]"
+static_assert(type_name_probe.substr(type_name_prefix - 10, 10) == "[with T = "
+              && (type_name_probe[type_name_prefix + 4] == ';' || type_name_probe[type_name_prefix + 4] == ']'),
+              "qe::type_name: unexpected __PRETTY_FUNCTION__ format");
+#elif defined(_MSC_VER)
+//"... __cdecl qe::detail::raw_type_name<void>(void) noexcept"
+static_assert(type_name_probe.substr(type_name_prefix - 14, 14) == "raw_type_name<"
+              && type_name_probe.substr(type_name_prefix + 4, 7) == ">(void)",
+              "qe::type_name: unexpected __FUNCSIG__ format");
+#endif
+
+//! Integer types accepted by qe::formatInto. Character types are excluded so they are not printed as numbers.
+template <class T>
+struct is_formattable_integer
+    : ::std::integral_constant<bool, ::std::is_integral<T>::value && !::std::is_same<T, bool>::value
+                                     && !::std::is_same<T, char>::value && !::std::is_same<T, wchar_t>::value
+                                     && !::std::is_same<T, char16_t>::value && !::std::is_same<T, char32_t>::value>
+{
+};
+
+constexpr ::std::uint64_t fnv1a(::std::string_view text) noexcept
+{
+    ::std::uint64_t hash = 14695981039346656037ull;
+    for (char c : text) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+} // namespace detail
+//! \endcond
+
+/*!
+    \brief Returns the name of \a T as spelled by the compiler, without using RTTI.
+
+    The result is a constant expression that refers to static storage. Spelling differs between
+    compilers (MSVC writes `class Foo` where GCC and Clang write `Foo`), so names are only
+    comparable within one build.
+*/
+template <class T>
+constexpr ::std::string_view type_name() noexcept
+{
+    constexpr ::std::string_view raw = detail::raw_type_name<T>();
+    return raw.substr(detail::type_name_prefix, raw.size() - detail::type_name_prefix - detail::type_name_suffix);
+}
+
+//! \cond
+//trimming with the measured affixes must give back a name whose spelling does not vary
+static_assert(type_name<int>() == "int" && type_name<void>() == "void",
+              "qe::type_name: the decoration differs between types");
+//! \endcond
+
+//! A compile-time key for a type. \sa qe::type_id
+using type_id_t = ::std::uint64_t;
+
+/*!
+    \brief Returns a compile-time key for \a T: the 64-bit FNV-1a hash of qe::type_name<T>().
+
+    The key is stable across runs of the same build and is usable as a `case` label or a key in
+    flat hash tables. cv-qualifiers and references are part of the type, so `type_id<int>()` and
+    `type_id<const int>()` differ.
+
+    \code
+        switch (key) {
+        case qe::type_id<QPoint>(): ...
+        }
+    \endcode
+*/
+template <class T>
+constexpr type_id_t type_id() noexcept
+{
+    return detail::fnv1a(type_name<T>());
+}
+
 } //namespace qe
 
 #endif //QE_CORE_TYPE_UTIL_H
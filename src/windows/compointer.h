@@ -48,8 +48,11 @@ struct WCharManager : ComDeleter<wchar_t>
             return nullptr;
         std::size_t len = 0;
         ::StringCbLengthW(pointer, STRSAFE_MAX_CCH * sizeof(wchar_t), &len);
+        //the length excludes the terminator
+        len += sizeof(wchar_t);
         auto ret = static_cast<wchar_t *>(CoTaskMemAlloc(len));
-        ::StringCchCopyW(ret, STRSAFE_MAX_CCH, pointer);
+        if (ret)
+            ::StringCchCopyW(ret, len / sizeof(wchar_t), pointer);
         return ret;
     }
 };
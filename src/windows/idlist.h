@@ -17,16 +17,77 @@
 #ifndef QE_WINDOWS_SHELL_IDLIST_H
 #define QE_WINDOWS_SHELL_IDLIST_H
 
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <functional>
 #include <iterator>
+#include <stdexcept>
+#include <type_traits>
 #include <ShlObj_core.h>
 #include <qewindows/global.h>
+#include <qewindows/pidl.h>
 #include <qewindows/unaligned.h>
 
 namespace qe {
 namespace windows {
 namespace shell {
 
-#include "idlist_impl.h"
+static_assert(sizeof(pidl::ShItemId) == sizeof(SHITEMID)
+              && offsetof(pidl::ShItemId, cb) == offsetof(SHITEMID, cb)
+              && offsetof(pidl::ShItemId, abID) == offsetof(SHITEMID, abID),
+              "qe::pidl::ShItemId must match the layout of SHITEMID");
+static_assert(sizeof(pidl::ItemIdList) == sizeof(ITEMIDLIST), "qe::pidl::ItemIdList must match the layout of ITEMIDLIST");
+
+using pidl::abIDType;
+
+//! Returns \a id as the equivalent qe::pidl type.
+inline const pidl::ItemIdList *toPidl(const ITEMIDLIST *id) noexcept
+{
+    return reinterpret_cast<const pidl::ItemIdList *>(id);
+}
+
+//! Returns \a id as the equivalent SDK type.
+inline const ITEMIDLIST *fromPidl(const pidl::ItemIdList *id) noexcept
+{
+    return reinterpret_cast<const ITEMIDLIST *>(id);
+}
+
+//! Compares two items; see qe::pidl::compareId. Results are undefined if left or right is nullptr.
+inline int compareId(const ITEMIDLIST *left, const ITEMIDLIST *right) noexcept
+{
+    return pidl::compareId(toPidl(left), toPidl(right));
+}
+
+//! Compares two id lists; see qe::pidl::compareIdList. Results are undefined if left or right is nullptr.
+inline int compareIdList(const ITEMIDLIST *left, const ITEMIDLIST *right) noexcept
+{
+    return pidl::compareIdList(toPidl(left), toPidl(right));
+}
+
+template <class T>
+using isCastablePtr = std::bool_constant
+<
+       std::is_same_v<T, PITEMID_CHILD>
+    || std::is_same_v<T, PUITEMID_CHILD>
+    || std::is_same_v<T, PIDLIST_ABSOLUTE>
+    || std::is_same_v<T, PUIDLIST_RELATIVE>
+    || std::is_same_v<T, PIDLIST_RELATIVE>
+>;
+
+template <class T>
+using isCastableConstPtr = std::bool_constant
+<
+       std::is_same_v<T, PCIDLIST_ABSOLUTE>
+    || std::is_same_v<T, PCUIDLIST_ABSOLUTE>
+    || std::is_same_v<T, PCIDLIST_RELATIVE>
+    || std::is_same_v<T, PCUIDLIST_RELATIVE>
+    || std::is_same_v<T, PCITEMID_CHILD>
+    || std::is_same_v<T, PCUITEMID_CHILD>
+>;
+
+template <class T>
+using isCastablePtrPtr = isCastablePtr<std::remove_pointer_t<T>>;
 
 //! \brief An enum for type data computed from the final abID[0] element in an `ITEMIDLIST` array.
 enum class InferredType {
@@ -61,6 +122,13 @@ enum class InferredType {
 //! underlying data via IdList::const_iterator, and direct access via the castTo and castAddress
 //! functions. The `ITEMIDLIST` pointer is copied using `ILCLone` when an IdList is copied, so each
 //! instance is unique if the same pointer is not assigned to two IdLists.
+//!
+//! IdLists hash by content; see hash(). The hash, and an index of where each item starts, are
+//! computed on first use and kept until the stored pointer changes, so the list must not be
+//! modified in place through data(). With the index, elementCount, byteCount, lastId, at, rawType
+//! and the parent's size take constant time. The caches are filled atomically, so like any other
+//! `const` object, an IdList can be read from several threads at once; a thread that finds the
+//! index being built by another walks the list instead of waiting.
 class IdList
 {
 public:
@@ -87,20 +155,32 @@ public:
     inline bool isRoot() const noexcept;
 
     //! Swaps with other.
-    void swap(IdList &other) noexcept               { std::swap(m_id, other.m_id); }
+    void swap(IdList &other) noexcept
+    {
+        std::swap(m_id, other.m_id);
+        m_hash.store(other.m_hash.exchange(m_hash.load(std::memory_order_relaxed), std::memory_order_relaxed),
+                     std::memory_order_relaxed);
+        std::swap(m_index, other.m_index);
+        m_indexState.store(other.m_indexState.exchange(m_indexState.load(std::memory_order_relaxed),
+                                                       std::memory_order_relaxed),
+                           std::memory_order_relaxed);
+    }
     inline void reset(pointer id = nullptr);
 
     //! Returns the stored pointer.
     pointer data() const noexcept                   { return m_id; }
     //! Returns a pointer to the stored pointer.
-    ITEMIDLIST ** address() noexcept                { return &m_id; }
+    ITEMIDLIST ** address() noexcept                { invalidate(); return &m_id; }
     inline const ITEMIDLIST *lastId() const noexcept;
+    inline const ITEMIDLIST *at(unsigned int index) const;
 
     inline std::uint8_t rawType() const noexcept;
     inline InferredType inferredType() const noexcept;
     inline unsigned int elementCount() const noexcept;
     inline unsigned int byteCount() const noexcept;
+    inline unsigned int parentByteCount() const noexcept;
     inline IdList parent() const;
+    inline std::uint64_t hash() const noexcept;
 
     //! This function casts the stored pointer to a given `ITEMIDLIST` typedef.
     //!
@@ -124,7 +204,7 @@ public:
     //! castAddress is used to gain direct access to the stored pointer to set its value via
     //! shell functions.
     template <class T, class = std::enable_if<isCastablePtrPtr<T>::value>>
-    T castAddress() noexcept                        { return reinterpret_cast<T>(&m_id); }
+    T castAddress() noexcept                        { invalidate(); return reinterpret_cast<T>(&m_id); }
 
 public:
     struct const_iterator
@@ -161,10 +241,27 @@ public:
     const_iterator begin() const noexcept           { return cbegin(); }
     const_iterator cbegin() const noexcept          { return const_iterator(m_id); }
     const_iterator end() const noexcept             { return cend(); }
-    const_iterator cend() const noexcept            { return const_iterator(&static_null_id); }
+    const_iterator cend() const noexcept            { return const_iterator(fromPidl(&pidl::terminator)); }
 
 private:
+    //! The states of m_index; only the thread that moves it to Building may write the index.
+    enum IndexState : std::uint8_t { IndexEmpty, IndexBuilding, IndexReady };
+
+    inline const pidl::ItemOffsets *index() const noexcept;
+    //! Drops the caches after the stored pointer changes.
+    void invalidate() noexcept
+    {
+        m_hash.store(0, std::memory_order_relaxed);
+        m_index.clear();
+        m_indexState.store(IndexEmpty, std::memory_order_relaxed);
+    }
+
     ITEMIDLIST *m_id;
+    //the content hash, or 0 if not yet computed
+    mutable std::atomic<std::uint64_t> m_hash{0};
+    //built by index() and published through m_indexState
+    mutable pidl::ItemOffsets m_index;
+    mutable std::atomic<std::uint8_t> m_indexState{IndexEmpty};
 };
 
 //! Equality operator for IdList.
@@ -187,13 +284,7 @@ inline bool operator!=(const IdList &lhs, const IdList &rhs)
 //! Checks if it is safe for the iterator to advance.
 bool IdList::const_iterator::hasNext() const noexcept
 {
-    if (isNull())
-        return false;
-    const_iterator nxt = *this;
-    ++nxt;
-    if (!nxt || nxt->mkid.cb == 0) //double null termination
-        return false;
-    return true;
+    return pidl::hasNext(toPidl(p));
 }
 
 //! Advances the iterator. Synonymous with operator++.
@@ -201,7 +292,7 @@ IdList::const_iterator &IdList::const_iterator::next()
 {
     if (!p || p->mkid.cb == 0)
         throw std::out_of_range("iterator out of range");
-    p = constPointerFromOffset(p, p->mkid.cb);
+    p = fromPidl(pidl::nextId(toPidl(p)));
     return *this;
 }
 
@@ -211,6 +302,17 @@ IdList::IdList(const IdList &other)
 {
     auto tmp = ILCloneFull(aligned_cast<PCUIDLIST_ABSOLUTE>(other.m_id));
     m_id = aligned_cast<ITEMIDLIST *>(tmp);
+    //the clone has the same bytes, so it can share the caches; a failed clone has none
+    if (!m_id) {
+        invalidate();
+        return;
+    }
+    m_hash.store(other.m_hash.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    if (other.m_indexState.load(std::memory_order_acquire) == IndexReady) {
+        m_index = other.m_index;
+        if (m_index.isBuilt())
+            m_indexState.store(IndexReady, std::memory_order_relaxed);
+    }
 }
 
 //! Returns true if the stored pointer is a single null-initialized element.
@@ -229,18 +331,57 @@ void IdList::reset(pointer id)
     if (m_id)
         ILFree(aligned_cast<PIDLIST_RELATIVE>(m_id));
     m_id = id;
+    invalidate();
+}
+
+//! \internal
+//! Returns the index of the stored list, building it if needed, or nullptr if there is none.
+//! One thread builds the index in place; the others do not wait for it and get nullptr until it is
+//! published, so the callers walk the list instead.
+const pidl::ItemOffsets *IdList::index() const noexcept
+{
+    if (!m_id)
+        return nullptr;
+    std::uint8_t state = m_indexState.load(std::memory_order_acquire);
+    if (state == IndexReady)
+        return &m_index;
+    if (state != IndexEmpty
+            || !m_indexState.compare_exchange_strong(state, IndexBuilding, std::memory_order_acquire,
+                                                     std::memory_order_relaxed))
+        return nullptr;
+    m_index.build(toPidl(m_id));
+    //a large list that could not allocate is left empty, to try again on the next call
+    const bool built = m_index.isBuilt();
+    m_indexState.store(built ? IndexReady : IndexEmpty, std::memory_order_release);
+    return built ? &m_index : nullptr;
 }
 
 //! Returns a const pointer to the last id in the array.
-//! \note Returns nullptr if the (only) element is the root id or if the id is invalid.
+//! \note Returns the root id itself if the list is empty, and nullptr if the id is invalid.
 const ITEMIDLIST *IdList::lastId() const noexcept
 {
-    auto iter = cbegin();
-    if (iter.isNull())
-        return iter;
-    while (iter.hasNext())
-        ++iter;
-    return iter;
+    auto idx = index();
+    if (!idx)
+        return fromPidl(pidl::lastId(toPidl(m_id)));
+    if (!idx->count())
+        return m_id;
+    return fromPidl(pidl::constPointerFromOffset(toPidl(m_id), idx->offset(idx->count() - 1)));
+}
+
+//! Returns a const pointer to the id at \a index, counting from 0.
+//! Throws `std::out_of_range` if \a index is not less than elementCount().
+const ITEMIDLIST *IdList::at(unsigned int index) const
+{
+    if (index >= elementCount())
+        throw std::out_of_range("index out of range");
+    auto idx = this->index();
+    if (!idx) {
+        auto ret = toPidl(m_id);
+        for (; index; --index)
+            ret = pidl::nextId(ret);
+        return fromPidl(ret);
+    }
+    return fromPidl(pidl::constPointerFromOffset(toPidl(m_id), idx->offset(index)));
 }
 
 //! Gets the value of `mkid.abID[0]` of the final element in the array.
@@ -249,22 +390,17 @@ const ITEMIDLIST *IdList::lastId() const noexcept
 //! `mkid.cb` values. It returns `0xFF` for an invalid id list and `0xFE` for the root node.
 uint8_t IdList::rawType() const noexcept
 {
-    //make sure it's not nullptr or the desktop id.
-    if (!m_id)
-        return static_cast<uint8_t>(abIDType::Invalid);
-    if(m_id->mkid.cb == 0) //
+    auto idx = index();
+    if (!idx)
+        return pidl::rawType(toPidl(m_id));
+    if (!idx->count())
         return static_cast<uint8_t>(abIDType::Root);
-    if (m_id->mkid.cb < 3) //we've already checked for the desktop; anything else is invalid
+    if (idx->hasShortItem())
         return static_cast<uint8_t>(abIDType::Invalid);
-    unsigned char ret = 0; //caches the next-to-last value
-    auto iter = cbegin();
-    while (iter.hasNext()) {
-        ++iter;
-        if (iter->mkid.cb < 3) //check for invalid child ids
-            return static_cast<uint8_t>(abIDType::Invalid);
-        ret = iter->mkid.abID[0];
-    }
-    return ret;
+    //only items after the first are examined; see qe::pidl::rawType
+    if (idx->count() == 1)
+        return 0;
+    return pidl::bytes(toPidl(m_id))[idx->offset(idx->count() - 1) + offsetof(SHITEMID, abID)];
 }
 
 //! Returns the type of the final `ITEMIDLIST`, if known or abIDType::Unknown otherwise.
@@ -313,42 +449,89 @@ InferredType IdList::inferredType() const noexcept
 //! Returns the number of elements in the `ITEMIDLIST` array.
 unsigned int IdList::elementCount() const noexcept
 {
-    unsigned int ret = 0;
-    for (const auto &iter : *this) {
-        (void)iter;
-        ++ret;
-    }
-    return ret;
+    auto idx = index();
+    return idx ? idx->count() : pidl::elementCount(toPidl(m_id));
 }
 
 //! Returns the total byte count of the `ITEMIDLIST` array.
 //! This is functionally equivalent to `ILGetSize` except that it is noexcept.
 unsigned int IdList::byteCount() const noexcept
 {
-    unsigned int ret = 0;
-    for(const auto &iter : *this) {
-        ret += iter.mkid.cb;
-    }
-    return ret + 2; //add the null terminating bytes
+    auto idx = index();
+    return idx ? unsigned(idx->byteCount()) : pidl::byteCount(toPidl(m_id));
 }
 
-//! Gets a pidl's parent id. This calls `ILRemoveLastID`.
+//! Returns the byte count of parent(), or 0 if there is no parent.
+unsigned int IdList::parentByteCount() const noexcept
+{
+    const unsigned count = elementCount();
+    if (!count)
+        return 0;
+    auto idx = index();
+    if (!idx)
+        return byteCount() - pidl::itemSize(pidl::lastId(toPidl(m_id)));
+    return unsigned(idx->offset(count - 1)) + 2;
+}
+
+//! Gets a pidl's parent id, copying all but the last item into a new `ITEMIDLIST` allocated with
+//! `CoTaskMemAlloc`, as `ILClone` does. Like any new IdList, the parent computes its hash on first use.
 //! This function returns a default-constructed id list if the called id list instance is invalid or
 //! is the root node (desktop).
 IdList IdList::parent() const
 {
-    if (!m_id || isRoot())
+    const unsigned size = parentByteCount();
+    if (!size)
         return {};
-    PIDLIST_ABSOLUTE ret = ILCloneFull(castTo<PCUIDLIST_ABSOLUTE>());
-    if (!ILRemoveLastID(aligned_cast<PUIDLIST_RELATIVE>(ret)))
+    auto ret = static_cast<unsigned char *>(CoTaskMemAlloc(size));
+    if (!ret)
         return {};
-    return {aligned_cast<ITEMIDLIST *>(ret)};
+    std::memcpy(ret, m_id, size - 2);
+    ret[size - 2] = ret[size - 1] = 0;
+    return {reinterpret_cast<ITEMIDLIST *>(ret)};
+}
+
+//! \brief Returns a 64-bit hash of the contents of the id list, or 0 if it is `nullptr`.
+//! Equal lists have equal hashes. The hash is computed once and cached; see qe::pidl::hashIdList.
+std::uint64_t IdList::hash() const noexcept
+{
+    std::uint64_t h = m_hash.load(std::memory_order_relaxed);
+    if (!h) {
+        //threads that race here compute and store the same value
+        h = pidl::hashIdList(toPidl(m_id));
+        m_hash.store(h, std::memory_order_relaxed);
+    }
+    return h;
+}
+
+//! Returns the hash of \a key for `QHash` and `QSet`.
+//! \relates IdList
+inline unsigned int qHash(const IdList &key, unsigned int seed = 0) noexcept
+{
+    const std::uint64_t h = key.hash();
+    return static_cast<unsigned int>(h ^ (h >> 32)) ^ seed;
 }
 
 } // namespace shell
 } // namespace windows
 } // namespace qe
 
+namespace std {
+
+/*! \relates qe::windows::shell::IdList
+    Specialization of `std::hash` for \ref qe::windows::shell::IdList, which hashes its contents.
+ */
+template <>
+struct hash<qe::windows::shell::IdList>
+{
+    using argument_type = qe::windows::shell::IdList;
+    using result_type = std::size_t;
+    result_type operator()(const argument_type &id) const noexcept
+    {
+        return static_cast<std::size_t>(id.hash());
+    }
+};
+} //namespace std
+
 #ifndef QEXT_NO_CLUTTER
 using QeShellIdList = qe::windows::shell::IdList;
 #endif
@@ -0,0 +1,593 @@
+/*  QExt: Extensions to Qt
+ *  Copyright (C) 2016  Jonathan Harper
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*!
+ \headerfile pidl.h <qewindows/pidl.h>
+ \brief Provides the byte-level routines behind qe::windows::shell::IdList without the Windows SDK.
+*/
+
+#ifndef QE_WINDOWS_PIDL_H
+#define QE_WINDOWS_PIDL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+
+#include "../core/simd_p.h"
+
+namespace qe {
+
+//! \namespace qe::pidl
+//!
+//! \brief Platform-neutral routines for shell ID lists (PIDLs) held as raw bytes.
+//!
+//! An ID list is a sequence of `SHITEMID` items, each a little-endian 16-bit size `cb` that
+//! includes itself followed by `cb - 2` bytes, ended by an item whose `cb` is zero. ShItemId and
+//! ItemIdList have the layout of the SDK's `SHITEMID` and `ITEMIDLIST`, so a pidl from the shell can
+//! be passed here with a `reinterpret_cast`, as IdList does. The routines read `cb` a byte at a time,
+//! so items may be unaligned, and they build and behave the same on any platform.
+//!
+//! Apart from checkedByteCount, the routines trust the list to be terminated; use checkedByteCount
+//! first on data read from disk or the registry.
+namespace pidl {
+
+#pragma pack(push, 1)
+//! The layout of `SHITEMID`.
+struct ShItemId
+{
+    std::uint16_t cb;
+    std::uint8_t abID[1];
+};
+
+//! The layout of `ITEMIDLIST`.
+struct ItemIdList
+{
+    ShItemId mkid;
+};
+#pragma pack(pop)
+
+static_assert(sizeof(ShItemId) == 3 && offsetof(ShItemId, abID) == 2, "ShItemId must be packed");
+
+//! Known values of `abID[0]`, the first byte of an item after `cb`.
+enum class abIDType : std::uint8_t {
+    CplApplet   = 0x00, //virtual
+    GUID        = 0x1F, //guid, virtual
+    Drive       = 0x23, //drive
+    Drive2      = 0x25, //drive     lnk/persistent
+    Drive3      = 0x29, //drive
+    ShellExt    = 0x2E, //guid, virtual
+    Drive1      = 0x2F, //drive
+    Folder1     = 0x30, //localfs   lnk/persistent
+    FolderA     = 0x31, //localfs
+    ValueA      = 0x32, //localfs
+    ValueW      = 0x34, //localfs
+    FolderW     = 0x35, //localfs
+    Workgroup   = 0x41, //remote?, virtual
+    Computer    = 0x42, //remote, virtual
+    NetProvider = 0x46, //remote, virtual?
+    Network     = 0x47, //virtual
+    IESPECIAL1  = 0x61, //htmlhelp, possibly local, virtual
+    Printer     = 0x70, //guid, virtual
+    IESPECIAL2  = 0xb1, //localfs, virtual?
+    Share       = 0xc3, //remote, filesystem
+    Root        = 0xFE, //guessing (hoping?) these are unused
+    Invalid     = 0xFF
+};
+
+//! The empty list: a lone terminator, which is also the id of the desktop.
+inline constexpr ItemIdList terminator = {{0x0000, {0x00}}};
+
+//! Returns \a ptr advanced by \a distance bytes, or nullptr if \a ptr is nullptr.
+template <class T>
+inline const T *constPointerFromOffset(const T *ptr, std::size_t distance) noexcept
+{
+    if (!ptr)
+        return nullptr;
+    return reinterpret_cast<const T *>(reinterpret_cast<const unsigned char *>(ptr) + distance);
+}
+
+//! Returns \a data as an id list. \a data must hold a well-formed list; see checkedByteCount.
+inline const ItemIdList *fromBytes(const void *data) noexcept
+{
+    return static_cast<const ItemIdList *>(data);
+}
+
+//! Returns \a id as bytes.
+inline const std::uint8_t *bytes(const ItemIdList *id) noexcept
+{
+    return reinterpret_cast<const std::uint8_t *>(id);
+}
+
+//! Returns the `cb` of the item at \a id, reading it byte by byte.
+inline unsigned itemSize(const ItemIdList *id) noexcept
+{
+    const std::uint8_t *p = bytes(id);
+    return unsigned(p[0]) | unsigned(p[1]) << 8;
+}
+
+//! Returns true if \a id is the terminator, i.e. its `cb` is zero.
+inline bool isTerminator(const ItemIdList *id) noexcept
+{
+    return !itemSize(id);
+}
+
+//! Returns the item after \a id. \a id must not be the terminator.
+inline const ItemIdList *nextId(const ItemIdList *id) noexcept
+{
+    return constPointerFromOffset(id, itemSize(id));
+}
+
+//! Returns true if there is an item after \a id, i.e. \a id and its successor are not terminators.
+inline bool hasNext(const ItemIdList *id) noexcept
+{
+    if (!id || isTerminator(id))
+        return false;
+    return !isTerminator(nextId(id));
+}
+
+using detail::SimdLevel;
+
+//! Returns the index of the first byte that differs between \a a and \a b, or \a n if none do.
+inline std::size_t mismatchScalar(const std::uint8_t *a, const std::uint8_t *b, std::size_t n) noexcept
+{
+    std::size_t i = 0;
+    //skip equal words; the differing byte is found below whatever the byte order
+    for (; i + 8 <= n; i += 8) {
+        std::uint64_t x, y;
+        std::memcpy(&x, a + i, 8);
+        std::memcpy(&y, b + i, 8);
+        if (x != y)
+            break;
+    }
+    for (; i < n; ++i) {
+        if (a[i] != b[i])
+            return i;
+    }
+    return n;
+}
+
+#ifdef QE_SIMD_X86
+//! Returns the index of the lowest set bit of \a mask, which must not be zero.
+inline unsigned lowestSetBit(std::uint32_t mask) noexcept
+{
+#  if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return unsigned(index);
+#  else
+    return unsigned(__builtin_ctz(mask));
+#  endif
+}
+
+//! mismatchScalar using 16-byte SSE2 compares. Nothing past \a n is read.
+inline std::size_t mismatchSse2(const std::uint8_t *a, const std::uint8_t *b, std::size_t n) noexcept
+{
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i));
+        const __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i));
+        const std::uint32_t equal = std::uint32_t(_mm_movemask_epi8(_mm_cmpeq_epi8(x, y)));
+        if (equal != 0xFFFF)
+            return i + lowestSetBit(~equal);
+    }
+    return i + mismatchScalar(a + i, b + i, n - i);
+}
+
+//! mismatchScalar using 32-byte AVX2 compares. Nothing past \a n is read.
+QE_SIMD_TARGET_AVX2 inline std::size_t mismatchAvx2(const std::uint8_t *a, const std::uint8_t *b, std::size_t n) noexcept
+{
+    std::size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+        const __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i));
+        const std::uint32_t equal = std::uint32_t(_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, y)));
+        if (equal != 0xFFFFFFFFu)
+            return i + lowestSetBit(~equal);
+    }
+    return i + mismatchSse2(a + i, b + i, n - i);
+}
+#endif // QE_SIMD_X86
+
+//! Returns the index of the first byte that differs between \a a and \a b, or \a n if none do,
+//! using the given \a level.
+inline std::size_t mismatch(const std::uint8_t *a, const std::uint8_t *b, std::size_t n,
+                            SimdLevel level = detail::simdLevel()) noexcept
+{
+#ifdef QE_SIMD_X86
+    if (level == SimdLevel::AVX2)
+        return mismatchAvx2(a, b, n);
+    if (level == SimdLevel::SSE2)
+        return mismatchSse2(a, b, n);
+#else
+    (void)level;
+#endif
+    return mismatchScalar(a, b, n);
+}
+
+//! \brief Compares the items at \a left and \a right byte by byte, returning -1, 0 or 1.
+//! The terminator sorts first. Only the `cb` bytes of each item are read. Results are undefined if
+//! either is nullptr.
+inline int compareId(const ItemIdList *left, const ItemIdList *right,
+                     SimdLevel level = detail::simdLevel()) noexcept
+{
+    const unsigned left_cb = itemSize(left);
+    const unsigned right_cb = itemSize(right);
+    //check for the terminator/root node
+    if (left_cb == 0) {
+        if (right_cb == 0)
+            return 0; //terminator, equal
+        return -1; //left is terminator
+    } else if (right_cb == 0)
+        return 1; //right is terminator
+
+    //compare the payloads up to the shorter of the two
+    const unsigned shorter = left_cb < right_cb ? left_cb : right_cb;
+    const std::size_t n = shorter > offsetof(ShItemId, abID) ? shorter - offsetof(ShItemId, abID) : 0;
+    const auto left_abID = bytes(left) + offsetof(ShItemId, abID);
+    const auto right_abID = bytes(right) + offsetof(ShItemId, abID);
+    const std::size_t i = mismatch(left_abID, right_abID, n, level);
+    if (i < n)
+        return left_abID[i] < right_abID[i] ? -1 : 1;
+    //equal up to this point, so we just see which is longer.
+    if (left_cb < right_cb)
+        return -1;
+    if (left_cb > right_cb)
+        return 1;
+    return 0;
+}
+
+//! \brief Compares the lists at \a left and \a right item by item, returning -1, 0 or 1.
+//! A list sorts after its prefixes. Results are undefined if either is nullptr.
+//!
+//! Items of equal size are compared whole, `cb` included, in a single pass over both lists; only
+//! the first pair of items that differ in size goes through compareId.
+inline int compareIdList(const ItemIdList *left, const ItemIdList *right,
+                         SimdLevel level = detail::simdLevel()) noexcept
+{
+    auto left_pos = bytes(left);
+    auto right_pos = bytes(right);
+    for (;;) {
+        const unsigned left_cb = unsigned(left_pos[0]) | unsigned(left_pos[1]) << 8;
+        const unsigned right_cb = unsigned(right_pos[0]) | unsigned(right_pos[1]) << 8;
+        if (!left_cb || !right_cb) {
+            if (!left_cb && !right_cb)
+                return 0; //identical
+            return left_cb ? 1 : -1; //the shorter list sorts first
+        }
+        if (left_cb != right_cb) //the items differ, so they decide
+            return compareId(fromBytes(left_pos), fromBytes(right_pos), level);
+
+        const std::size_t i = mismatch(left_pos, right_pos, left_cb, level);
+        if (i < left_cb)
+            return left_pos[i] < right_pos[i] ? -1 : 1;
+        //advance if equal so far
+        left_pos += left_cb;
+        right_pos += left_cb;
+    }
+}
+
+//! Returns the number of items in \a id, not counting the terminator, or 0 if \a id is nullptr.
+inline unsigned elementCount(const ItemIdList *id) noexcept
+{
+    unsigned ret = 0;
+    for (; id && !isTerminator(id); id = nextId(id))
+        ++ret;
+    return ret;
+}
+
+//! \brief Returns the size of \a id in bytes, including the terminator, or 0 if \a id is nullptr.
+//! This is equivalent to `ILGetSize`.
+inline unsigned byteCount(const ItemIdList *id) noexcept
+{
+    if (!id)
+        return 0;
+    unsigned ret = 0;
+    for (; !isTerminator(id); id = nextId(id))
+        ret += itemSize(id);
+    return ret + 2; //add the null terminating bytes
+}
+
+//! \brief Returns the last item of \a id.
+//! Returns \a id itself if it is nullptr or the root (an empty list).
+inline const ItemIdList *lastId(const ItemIdList *id) noexcept
+{
+    if (!id || isTerminator(id))
+        return id;
+    while (hasNext(id))
+        id = nextId(id);
+    return id;
+}
+
+//! \brief Returns `abID[0]` of the last item of \a id.
+//!
+//! Returns abIDType::Invalid for nullptr or an item too small to hold `abID[0]`, and
+//! abIDType::Root for the root. Only items after the first are examined, so the value for a
+//! single-item list is zero.
+inline std::uint8_t rawType(const ItemIdList *id) noexcept
+{
+    //make sure it's not nullptr or the desktop id.
+    if (!id)
+        return static_cast<std::uint8_t>(abIDType::Invalid);
+    if (itemSize(id) == 0)
+        return static_cast<std::uint8_t>(abIDType::Root);
+    if (itemSize(id) < 3) //we've already checked for the desktop; anything else is invalid
+        return static_cast<std::uint8_t>(abIDType::Invalid);
+    std::uint8_t ret = 0; //caches the next-to-last value
+    while (hasNext(id)) {
+        id = nextId(id);
+        if (itemSize(id) < 3) //check for invalid child ids
+            return static_cast<std::uint8_t>(abIDType::Invalid);
+        ret = bytes(id)[offsetof(ShItemId, abID)];
+    }
+    return ret;
+}
+
+//! Mixes the bits of \a h; a bijection.
+inline std::uint64_t hashMix(std::uint64_t h) noexcept
+{
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDull;
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ull;
+    h ^= h >> 33;
+    return h;
+}
+
+//! Returns \a x rotated left by \a r bits, 0 < \a r < 64.
+inline std::uint64_t rotl64(std::uint64_t x, unsigned r) noexcept
+{
+    return (x << r) | (x >> (64 - r));
+}
+
+//! \brief Returns a 64-bit hash of the \a n bytes at \a p.
+//! Two independent lanes each take eight bytes per step, so the loop runs at the multiplier's
+//! throughput rather than its latency. Nothing outside the \a n bytes is read. Not for
+//! cryptographic use.
+inline std::uint64_t hashBytes(const std::uint8_t *p, std::size_t n, std::uint64_t seed = 0) noexcept
+{
+    const std::uint64_t k0 = 0x9E3779B97F4A7C15ull;
+    const std::uint64_t k1 = 0xC2B2AE3D27D4EB4Full;
+    std::uint64_t a = seed ^ (n * k0);
+    std::uint64_t b = ~seed;
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        std::uint64_t x, y;
+        std::memcpy(&x, p + i, 8);
+        std::memcpy(&y, p + i + 8, 8);
+        a = rotl64((a ^ x) * k1, 31) * k0;
+        b = rotl64((b ^ y) * k0, 29) * k1;
+    }
+    if (i < n) {
+        //the last 1-15 bytes, read with fixed-size loads that may overlap bytes already hashed;
+        //n is part of the initial state, so lists that differ only in length still differ
+        const std::size_t rest = n - i;
+        std::uint64_t x = 0, y = 0;
+        if (n >= 16) {
+            std::memcpy(&x, p + n - 16, 8);
+            std::memcpy(&y, p + n - 8, 8);
+        } else if (rest >= 8) {
+            std::memcpy(&x, p, 8);
+            std::memcpy(&y, p + n - 8, 8);
+        } else if (rest >= 4) {
+            std::uint32_t lo, hi;
+            std::memcpy(&lo, p, 4);
+            std::memcpy(&hi, p + n - 4, 4);
+            x = lo;
+            y = hi;
+        } else {
+            x = std::uint64_t(p[0]) | std::uint64_t(p[rest / 2]) << 8 | std::uint64_t(p[rest - 1]) << 16;
+        }
+        a = rotl64((a ^ x) * k1, 31) * k0;
+        b = rotl64((b ^ y) * k0, 29) * k1;
+    }
+    return hashMix(a ^ rotl64(b, 32));
+}
+
+//! The hash of the empty list; see hashIdList.
+inline constexpr std::uint64_t emptyListHash = 0x243F6A8885A308D3ull;
+
+//! Returns the hash of the item at \a id, `cb` included. \a id must not be the terminator.
+inline std::uint64_t hashItem(const ItemIdList *id) noexcept
+{
+    return hashBytes(bytes(id), itemSize(id));
+}
+
+//! \brief Extends \a listHash, the hash of a list, by an item with hash \a itemHash.
+//! The result is the hash of the list with the item appended, so hashes can be built one item at
+//! a time; see hashIdList.
+inline std::uint64_t hashAppend(std::uint64_t listHash, std::uint64_t itemHash) noexcept
+{
+    return hashMix(listHash * 0x9E3779B97F4A7C15ull + itemHash);
+}
+
+//! \brief Returns the hash of the first \a count items of \a id, or of all of them if there are fewer.
+//! The hash is a fold of hashAppend over the items from emptyListHash, so the hash of a list's
+//! parent is its hash before the last item. Returns 0 if \a id is nullptr.
+inline std::uint64_t hashPrefix(const ItemIdList *id, unsigned count) noexcept
+{
+    if (!id)
+        return 0;
+    std::uint64_t ret = emptyListHash;
+    for (; count && !isTerminator(id); --count, id = nextId(id))
+        ret = hashAppend(ret, hashItem(id));
+    return ret;
+}
+
+//! \brief Returns a 64-bit hash of the contents of \a id, or 0 if \a id is nullptr.
+//! Lists for which compareIdList returns 0 have the same hash.
+inline std::uint64_t hashIdList(const ItemIdList *id) noexcept
+{
+    return hashPrefix(id, ~0u);
+}
+
+//! \brief The offsets of the items of an id list, for constant-time access to them.
+//!
+//! build() walks the list once and records where each item and the terminator start. Lists of up
+//! to InlineItems items that are smaller than 64 KiB are indexed in place with 16-bit offsets;
+//! others use a heap array of 32-bit offsets. The index does not own or track the list, so it
+//! must be rebuilt or cleared when the list changes.
+class ItemOffsets
+{
+public:
+    //! The number of items indexed without allocating.
+    static constexpr unsigned InlineItems = 11;
+
+    ItemOffsets() noexcept {}
+    ItemOffsets(const ItemOffsets &other) noexcept  { copy(other); }
+    ItemOffsets(ItemOffsets &&other) noexcept       { steal(other); }
+    ~ItemOffsets() noexcept                         { clear(); }
+
+    ItemOffsets &operator=(const ItemOffsets &other) noexcept
+    {
+        if (this != &other) {
+            clear();
+            copy(other);
+        }
+        return *this;
+    }
+    ItemOffsets &operator=(ItemOffsets &&other) noexcept
+    {
+        if (this != &other) {
+            clear();
+            steal(other);
+        }
+        return *this;
+    }
+
+    inline void build(const ItemIdList *id) noexcept;
+    //! Forgets the index, freeing any memory it uses.
+    void clear() noexcept
+    {
+        if (m_state == Large)
+            delete[] m_large;
+        m_state = Empty;
+        m_count = 0;
+        m_shortItem = false;
+    }
+
+    //! Returns true if the index was built. An index for `nullptr`, or one that could not allocate, is not.
+    bool isBuilt() const noexcept                   { return m_state != Empty; }
+    //! Returns true if the index is held in place.
+    bool isInline() const noexcept                  { return m_state == Small; }
+    //! Returns the number of items, not counting the terminator.
+    unsigned count() const noexcept                 { return m_count; }
+    //! Returns the byte offset of item \a i; `offset(count())` is the offset of the terminator.
+    std::size_t offset(unsigned i) const noexcept   { return m_state == Large ? m_large[i] : m_small[i]; }
+    //! Returns the size of the list in bytes, including the terminator.
+    std::size_t byteCount() const noexcept          { return offset(m_count) + 2; }
+    //! Returns true if an item has a `cb` too small to hold `abID[0]`; see rawType.
+    bool hasShortItem() const noexcept              { return m_shortItem; }
+
+private:
+    enum State : std::uint8_t { Empty, Small, Large };
+
+    void copy(const ItemOffsets &other) noexcept
+    {
+        if (other.m_state == Large) {
+            m_large = new (std::nothrow) std::uint32_t[other.m_count + 1];
+            if (!m_large)
+                return;
+            std::memcpy(m_large, other.m_large, (other.m_count + 1) * sizeof(std::uint32_t));
+        } else {
+            std::memcpy(m_small, other.m_small, sizeof(m_small));
+        }
+        m_state = other.m_state;
+        m_count = other.m_count;
+        m_shortItem = other.m_shortItem;
+    }
+    template <class T>
+    static void fill(T *offsets, const ItemIdList *id, unsigned count) noexcept
+    {
+        std::size_t offset = 0;
+        for (unsigned i = 0; i < count; ++i) {
+            offsets[i] = T(offset);
+            offset += itemSize(constPointerFromOffset(id, offset));
+        }
+        offsets[count] = T(offset);
+    }
+    void steal(ItemOffsets &other) noexcept
+    {
+        std::memcpy(static_cast<void *>(this), &other, sizeof(ItemOffsets));
+        other.m_state = Empty;
+        other.m_count = 0;
+    }
+
+    union {
+        std::uint16_t m_small[InlineItems + 1];
+        std::uint32_t *m_large;
+    };
+    std::uint32_t m_count = 0;
+    State m_state = Empty;
+    bool m_shortItem = false;
+};
+
+//! \brief Indexes the list at \a id, replacing any previous index.
+//! Leaves the index empty if \a id is nullptr or a large list cannot be allocated.
+void ItemOffsets::build(const ItemIdList *id) noexcept
+{
+    clear();
+    if (!id)
+        return;
+    //count first, to know which representation fits
+    unsigned count = 0;
+    std::size_t end = 0;
+    bool shortItem = false;
+    for (auto pos = id; !isTerminator(pos); pos = nextId(pos)) {
+        shortItem |= itemSize(pos) < 3;
+        end += itemSize(pos);
+        ++count;
+    }
+    if (count <= InlineItems && end <= 0xFFFF) {
+        fill(m_small, id, count);
+        m_state = Small;
+    } else {
+        m_large = new (std::nothrow) std::uint32_t[count + 1];
+        if (!m_large)
+            return;
+        fill(m_large, id, count);
+        m_state = Large;
+    }
+    m_count = count;
+    m_shortItem = shortItem;
+}
+
+//! \brief Returns the size of the list at \a data, including the terminator, if it is well formed
+//! within \a size bytes, or 0 otherwise.
+//! A list is well formed if every item has room for its `cb` and lies within \a size bytes, and
+//! the terminator does too. Use this before any other routine on untrusted data.
+inline std::size_t checkedByteCount(const void *data, std::size_t size) noexcept
+{
+    if (!data)
+        return 0;
+    auto p = static_cast<const std::uint8_t *>(data);
+    std::size_t pos = 0;
+    while (size - pos >= 2) {
+        const std::size_t cb = std::size_t(p[pos]) | std::size_t(p[pos + 1]) << 8;
+        if (!cb)
+            return pos + 2;
+        if (cb < 2 || cb > size - pos)
+            return 0;
+        pos += cb;
+    }
+    return 0;
+}
+
+} // namespace pidl
+} // namespace qe
+
+#endif // QE_WINDOWS_PIDL_H
@@ -1,5 +1,8 @@
 #include "shell.h"
 #include <propkey.h>
+#include <QtCore/QCoreApplication>
+#include <qecore/debugutil.h>
+#include "shellflags_p.h"
 
 namespace qe {
 namespace windows {
@@ -157,73 +160,144 @@ UnknownPointer<IBindCtx> createBindContext()
     return ctx;
 }
 
+//the translation tables use numeric constants so they build without the SDK; keep them honest
+static_assert(detail::sfgao::CanCopy == SFGAO_CANCOPY && detail::sfgao::CanMove == SFGAO_CANMOVE
+              && detail::sfgao::Storage == SFGAO_STORAGE && detail::sfgao::CanRename == SFGAO_CANRENAME
+              && detail::sfgao::CanDelete == SFGAO_CANDELETE && detail::sfgao::System == SFGAO_SYSTEM
+              && detail::sfgao::Encrypted == SFGAO_ENCRYPTED && detail::sfgao::IsSlow == SFGAO_ISSLOW
+              && detail::sfgao::Ghosted == SFGAO_GHOSTED && detail::sfgao::Link == SFGAO_LINK
+              && detail::sfgao::ReadOnly == SFGAO_READONLY && detail::sfgao::Hidden == SFGAO_HIDDEN
+              && detail::sfgao::Stream == SFGAO_STREAM && detail::sfgao::Removable == SFGAO_REMOVABLE
+              && detail::sfgao::Compressed == SFGAO_COMPRESSED && detail::sfgao::Folder == SFGAO_FOLDER
+              && detail::sfgao::FileSystem == SFGAO_FILESYSTEM
+              && detail::sfgao::HasSubfolder == SFGAO_HASSUBFOLDER,
+              "detail::sfgao does not match the Windows SDK");
+static_assert(detail::attribute::ReadOnly == FILE_ATTRIBUTE_READONLY
+              && detail::attribute::Hidden == FILE_ATTRIBUTE_HIDDEN
+              && detail::attribute::System == FILE_ATTRIBUTE_SYSTEM
+              && detail::attribute::Directory == FILE_ATTRIBUTE_DIRECTORY
+              && detail::attribute::Compressed == FILE_ATTRIBUTE_COMPRESSED
+              && detail::attribute::Encrypted == FILE_ATTRIBUTE_ENCRYPTED,
+              "detail::attribute does not match the Windows SDK");
+static_assert(detail::node::Folder == quint32(NodeFlag::Folder)
+              && detail::node::FileSystem == quint32(NodeFlag::FileSystem)
+              && detail::node::StorageObject == quint32(NodeFlag::StorageObject)
+              && detail::node::Stream == quint32(NodeFlag::Stream)
+              && detail::node::ShellLink == quint32(NodeFlag::ShellLink)
+              && detail::node::CanCopy == quint32(NodeFlag::CanCopy)
+              && detail::node::CanMove == quint32(NodeFlag::CanMove)
+              && detail::node::CanRename == quint32(NodeFlag::CanRename)
+              && detail::node::CanDelete == quint32(NodeFlag::CanDelete)
+              && detail::node::ReadOnly == quint32(NodeFlag::ReadOnly)
+              && detail::node::Hidden == quint32(NodeFlag::Hidden)
+              && detail::node::System == quint32(NodeFlag::System)
+              && detail::node::Ghosted == quint32(NodeFlag::Ghosted)
+              && detail::node::Remote == quint32(NodeFlag::Remote)
+              && detail::node::Removable == quint32(NodeFlag::Removable)
+              && detail::node::Compressed == quint32(NodeFlag::Compressed)
+              && detail::node::Encrypted == quint32(NodeFlag::Encrypted)
+              && detail::node::MayHaveChildren == quint32(NodeFlag::MayHaveChildren),
+              "detail::node does not match NodeFlag");
+
+//! \internal
+inline NodeFlags toNodeFlags(quint32 bits)
+{
+    return NodeFlags(QFlag(bits));
+}
+
 //! Helper function to translate to native format.
 SFGAOF nodeFlagsToSfgao(NodeFlags flags)
 {
-    SFGAOF ret = 0x0;
-    if (flags & NodeFlag::Folder)           ret |= SFGAO_FOLDER;
-    if (flags & NodeFlag::FileSystem)       ret |= SFGAO_FILESYSTEM;
-    if (flags & NodeFlag::StorageObject)    ret |= SFGAO_STORAGE;
-    if (flags & NodeFlag::Stream)           ret |= SFGAO_STREAM;
-
-    if (flags & NodeFlag::CanCopy)          ret |= SFGAO_CANCOPY;
-    if (flags & NodeFlag::CanMove)          ret |= SFGAO_CANMOVE;
-    if (flags & NodeFlag::CanRename)        ret |= SFGAO_CANRENAME;
-    if (flags & NodeFlag::CanDelete)        ret |= SFGAO_CANDELETE;
-
-    if (flags & NodeFlag::ReadOnly)         ret |= SFGAO_READONLY;
-    if (flags & NodeFlag::Hidden)           ret |= SFGAO_HIDDEN;
-    if (flags & NodeFlag::System)           ret |= SFGAO_SYSTEM;
-    if (flags & NodeFlag::Ghosted)          ret |= SFGAO_GHOSTED;
-    if (flags & NodeFlag::ShellLink)        ret |= SFGAO_LINK;
-    if (flags & NodeFlag::Remote)           ret |= SFGAO_ISSLOW;
-    if (flags & NodeFlag::Removable)        ret |= SFGAO_REMOVABLE;
-    if (flags & NodeFlag::Compressed)       ret |= SFGAO_COMPRESSED;
-    if (flags & NodeFlag::Encrypted)        ret |= SFGAO_ENCRYPTED;
-    if (flags & NodeFlag::MayHaveChildren)  ret |= SFGAO_HASSUBFOLDER;
-    return ret;
+    return SFGAOF(detail::nodeToSfgao(quint32(flags)));
 }
 
 //! Helper function to translate native flags to NodeFlags.
 NodeFlags sfgaoFlagsToNodeFlags(SFGAOF flags)
 {
-    NodeFlags ret = NodeFlag::NoFlags;
-    if (flags & SFGAO_FOLDER)       ret |= NodeFlag::Folder;
-    if (flags & SFGAO_FILESYSTEM)   ret |= NodeFlag::FileSystem;
-    if (flags & SFGAO_STORAGE)      ret |= NodeFlag::StorageObject;
-    if (flags & SFGAO_STREAM)       ret |= NodeFlag::Stream;
-
-    if (flags & SFGAO_CANCOPY)      ret |= NodeFlag::CanCopy;
-    if (flags & SFGAO_CANMOVE)      ret |= NodeFlag::CanMove;
-    if (flags & SFGAO_CANRENAME)    ret |= NodeFlag::CanRename;
-    if (flags & SFGAO_CANDELETE)    ret |= NodeFlag::CanDelete;
-
-    if (flags & SFGAO_READONLY)     ret |= NodeFlag::ReadOnly;
-    if (flags & SFGAO_HIDDEN)       ret |= NodeFlag::Hidden;
-    if (flags & SFGAO_SYSTEM)       ret |= NodeFlag::System;
-    if (flags & SFGAO_GHOSTED)      ret |= NodeFlag::Ghosted;
-    if (flags & SFGAO_LINK)         ret |= NodeFlag::ShellLink;
-    if (flags & SFGAO_ISSLOW)       ret |= NodeFlag::Remote;
-    if (flags & SFGAO_REMOVABLE)    ret |= NodeFlag::Removable;
-    if (flags & SFGAO_COMPRESSED)   ret |= NodeFlag::Compressed;
-    if (flags & SFGAO_ENCRYPTED)    ret |= NodeFlag::Encrypted;
-    if (flags & SFGAO_HASSUBFOLDER) ret |= NodeFlag::MayHaveChildren;
-    return ret;
+    return toNodeFlags(detail::sfgaoToNode(quint32(flags)));
 }
 
 //! Helper function to translate FILE_ATTRIBUTE_* flags to NodeFlags.
 NodeFlags fileAttributeToNodeFlags(DWORD flags)
 {
-    NodeFlags ret = NodeFlag::NoFlags;
-    if (flags & FILE_ATTRIBUTE_READONLY)    ret |= NodeFlag::ReadOnly;
-    if (flags & FILE_ATTRIBUTE_HIDDEN)      ret |= NodeFlag::Hidden;
-    if (flags & FILE_ATTRIBUTE_SYSTEM)      ret |= NodeFlag::System;
-    if (flags & FILE_ATTRIBUTE_DIRECTORY)   ret |= NodeFlag::Folder;
-    if (flags & FILE_ATTRIBUTE_COMPRESSED)  ret |= NodeFlag::Compressed;
-    if (flags & FILE_ATTRIBUTE_ENCRYPTED)   ret |= NodeFlag::Encrypted;
-    return ret;
+    return toNodeFlags(detail::attributeToNode(quint32(flags)));
+}
+
+//! Translates \a count NodeFlags values from \a in to \a out, e.g. for all children of a folder.
+void nodeFlagsToSfgao(const NodeFlags *in, SFGAOF *out, std::size_t count)
+{
+    for (std::size_t i = 0; i < count; ++i)
+        out[i] = SFGAOF(detail::nodeToSfgao(quint32(in[i])));
+}
+
+//! Translates \a count `SFGAOF` values from \a in to \a out.
+void sfgaoFlagsToNodeFlags(const SFGAOF *in, NodeFlags *out, std::size_t count)
+{
+    for (std::size_t i = 0; i < count; ++i)
+        out[i] = toNodeFlags(detail::sfgaoToNode(quint32(in[i])));
+}
+
+//! Translates \a count `FILE_ATTRIBUTE_*` values from \a in to \a out.
+void fileAttributeToNodeFlags(const DWORD *in, NodeFlags *out, std::size_t count)
+{
+    for (std::size_t i = 0; i < count; ++i)
+        out[i] = toNodeFlags(detail::attributeToNode(quint32(in[i])));
+}
+
+//! \internal
+//! Appends the names of the set flags in \a value, separated by `|`.
+void formatNodeFlags(const NodeFlags &value, QString &out)
+{
+    static const struct { NodeFlag flag; const char *name; } names[] = {
+        {NodeFlag::Folder, "Folder"},               {NodeFlag::FileSystem, "FileSystem"},
+        {NodeFlag::Library, "Library"},             {NodeFlag::StorageObject, "StorageObject"},
+        {NodeFlag::Stream, "Stream"},               {NodeFlag::ReparsePoint, "ReparsePoint"},
+        {NodeFlag::Virtual, "Virtual"},             {NodeFlag::MountPoint, "MountPoint"},
+        {NodeFlag::Junction, "Junction"},           {NodeFlag::SymLink, "SymLink"},
+        {NodeFlag::ShellLink, "ShellLink"},         {NodeFlag::CanCopy, "CanCopy"},
+        {NodeFlag::CanMove, "CanMove"},             {NodeFlag::CanRename, "CanRename"},
+        {NodeFlag::CanDelete, "CanDelete"},         {NodeFlag::ReadOnly, "ReadOnly"},
+        {NodeFlag::Hidden, "Hidden"},               {NodeFlag::System, "System"},
+        {NodeFlag::Ghosted, "Ghosted"},             {NodeFlag::Remote, "Remote"},
+        {NodeFlag::Removable, "Removable"},         {NodeFlag::Compressed, "Compressed"},
+        {NodeFlag::Encrypted, "Encrypted"},         {NodeFlag::MayHaveChildren, "MayHaveChildren"}
+    };
+    if (!value) {
+        out += QLatin1String("NoFlags");
+        return;
+    }
+    bool first = true;
+    for (const auto &entry : names) {
+        if (!(value & entry.flag))
+            continue;
+        if (!first)
+            out += QLatin1Char('|');
+        out += QLatin1String(entry.name);
+        first = false;
+    }
+}
+
+//! \brief Registers formatters for `NodeFlags` and the shell interface pointer types with
+//! qe::registerFormatter, so they can be passed to qe::toString and qe::formatInto.
+//!
+//! This runs automatically when the QCoreApplication is created, or at once if one already
+//! exists when the module is loaded. Calling it again is harmless.
+void registerFormatters()
+{
+    qe::registerFormatter<NodeFlags, &formatNodeFlags>();
+    qe::registerPointerFormatter<UnknownBasePointer>();
+    qe::registerPointerFormatter<DispatchPointer>();
+    qe::registerPointerFormatter<ShellItemPointer>();
+    qe::registerPointerFormatter<ShellItem2Pointer>();
+    qe::registerPointerFormatter<ShellFolderPointer>();
+    qe::registerPointerFormatter<ShellFolder2Pointer>();
+    qe::registerPointerFormatter<StreamPointer>();
+    qe::registerPointerFormatter<StoragePointer>();
+    qe::registerPointerFormatter<BStrPointer>();
+    qe::registerPointerFormatter<WCharPointer>();
 }
 
+Q_COREAPP_STARTUP_FUNCTION(registerFormatters)
 
 } // namespace shell
 } // namespace windows
@@ -1,6 +1,7 @@
 #ifndef QE_WINDOWS_SHELL_H
 #define QE_WINDOWS_SHELL_H
 
+#include <cstddef>
 #include <QtCore/QtGlobal>
 #include <QtCore/QObject>
 #include <qewindows/types.h>
@@ -176,6 +177,11 @@ Q_FLAG_NS(NodeFlag);
 QE_WINDOWS_EXPORT NodeFlags fileAttributeToNodeFlags(DWORD flags);
 QE_WINDOWS_EXPORT SFGAOF nodeFlagsToSfgao(NodeFlags flags);
 QE_WINDOWS_EXPORT NodeFlags sfgaoFlagsToNodeFlags(SFGAOF flags);
+QE_WINDOWS_EXPORT void fileAttributeToNodeFlags(const DWORD *in, NodeFlags *out, std::size_t count);
+QE_WINDOWS_EXPORT void nodeFlagsToSfgao(const NodeFlags *in, SFGAOF *out, std::size_t count);
+QE_WINDOWS_EXPORT void sfgaoFlagsToNodeFlags(const SFGAOF *in, NodeFlags *out, std::size_t count);
+
+QE_WINDOWS_EXPORT void registerFormatters();
 
 } // namespace shell
 } // namespace windows
@@ -0,0 +1,185 @@
+/*  QExt: Extensions to Qt
+ *  Copyright (C) 2016  Jonathan Harper
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+//  W A R N I N G
+//  -------------
+//  This file is not part of the QExt API. It holds the translation tables behind
+//  shell::sfgaoFlagsToNodeFlags and friends and may change without notice. It
+//  includes neither Qt nor the Windows SDK so it can be built and tested anywhere.
+
+#ifndef QE_WINDOWS_SHELLFLAGS_P_H
+#define QE_WINDOWS_SHELLFLAGS_P_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace qe {
+namespace windows {
+namespace shell {
+namespace detail {
+
+//! Values of shell::NodeFlag. shell.cpp checks that they match.
+namespace node {
+constexpr std::uint32_t Folder          = 0x00000001;
+constexpr std::uint32_t FileSystem      = 0x00000002;
+constexpr std::uint32_t StorageObject   = 0x00000008;
+constexpr std::uint32_t Stream          = 0x00000010;
+constexpr std::uint32_t ShellLink       = 0x00000800;
+constexpr std::uint32_t CanCopy         = 0x00001000;
+constexpr std::uint32_t CanMove         = 0x00002000;
+constexpr std::uint32_t CanRename       = 0x00004000;
+constexpr std::uint32_t CanDelete       = 0x00008000;
+constexpr std::uint32_t ReadOnly        = 0x00010000;
+constexpr std::uint32_t Hidden          = 0x00020000;
+constexpr std::uint32_t System          = 0x00040000;
+constexpr std::uint32_t Ghosted         = 0x00080000;
+constexpr std::uint32_t Remote          = 0x00100000;
+constexpr std::uint32_t Removable       = 0x00200000;
+constexpr std::uint32_t Compressed      = 0x00400000;
+constexpr std::uint32_t Encrypted       = 0x00800000;
+constexpr std::uint32_t MayHaveChildren = 0x10000000;
+} // namespace node
+
+//! Values of the `SFGAO_*` macros. shell.cpp checks that they match.
+namespace sfgao {
+constexpr std::uint32_t CanCopy         = 0x00000001;
+constexpr std::uint32_t CanMove         = 0x00000002;
+constexpr std::uint32_t Storage         = 0x00000008;
+constexpr std::uint32_t CanRename       = 0x00000010;
+constexpr std::uint32_t CanDelete       = 0x00000020;
+constexpr std::uint32_t System          = 0x00001000;
+constexpr std::uint32_t Encrypted       = 0x00002000;
+constexpr std::uint32_t IsSlow          = 0x00004000;
+constexpr std::uint32_t Ghosted         = 0x00008000;
+constexpr std::uint32_t Link            = 0x00010000;
+constexpr std::uint32_t ReadOnly        = 0x00040000;
+constexpr std::uint32_t Hidden          = 0x00080000;
+constexpr std::uint32_t Stream          = 0x00400000;
+constexpr std::uint32_t Removable       = 0x02000000;
+constexpr std::uint32_t Compressed      = 0x04000000;
+constexpr std::uint32_t Folder          = 0x20000000;
+constexpr std::uint32_t FileSystem      = 0x40000000;
+constexpr std::uint32_t HasSubfolder    = 0x80000000;
+} // namespace sfgao
+
+//! Values of the `FILE_ATTRIBUTE_*` macros. shell.cpp checks that they match.
+namespace attribute {
+constexpr std::uint32_t ReadOnly        = 0x00000001;
+constexpr std::uint32_t Hidden          = 0x00000002;
+constexpr std::uint32_t System          = 0x00000004;
+constexpr std::uint32_t Directory       = 0x00000010;
+constexpr std::uint32_t Compressed      = 0x00000800;
+constexpr std::uint32_t Encrypted       = 0x00004000;
+} // namespace attribute
+
+//! One bit of a NodeFlag and the native bit it corresponds to.
+struct FlagMapping
+{
+    std::uint32_t node;
+    std::uint32_t native;
+};
+
+//! NodeFlag <-> SFGAO bits. Both directions are generated from this table.
+constexpr FlagMapping sfgaoMapping[] = {
+    {node::Folder,          sfgao::Folder},
+    {node::FileSystem,      sfgao::FileSystem},
+    {node::StorageObject,   sfgao::Storage},
+    {node::Stream,          sfgao::Stream},
+    {node::CanCopy,         sfgao::CanCopy},
+    {node::CanMove,         sfgao::CanMove},
+    {node::CanRename,       sfgao::CanRename},
+    {node::CanDelete,       sfgao::CanDelete},
+    {node::ReadOnly,        sfgao::ReadOnly},
+    {node::Hidden,          sfgao::Hidden},
+    {node::System,          sfgao::System},
+    {node::Ghosted,         sfgao::Ghosted},
+    {node::ShellLink,       sfgao::Link},
+    {node::Remote,          sfgao::IsSlow},
+    {node::Removable,       sfgao::Removable},
+    {node::Compressed,      sfgao::Compressed},
+    {node::Encrypted,       sfgao::Encrypted},
+    {node::MayHaveChildren, sfgao::HasSubfolder}
+};
+
+//! FILE_ATTRIBUTE -> NodeFlag bits.
+constexpr FlagMapping attributeMapping[] = {
+    {node::ReadOnly,        attribute::ReadOnly},
+    {node::Hidden,          attribute::Hidden},
+    {node::System,          attribute::System},
+    {node::Folder,          attribute::Directory},
+    {node::Compressed,      attribute::Compressed},
+    {node::Encrypted,       attribute::Encrypted}
+};
+
+/*!
+    \brief Translates a 32-bit flag word with one 256-entry table per input byte.
+
+    Each table entry is the OR of the output bits for the input bits set in that byte, so a
+    translation is four loads and three ORs with no branches, whatever the mapping.
+*/
+struct BitTranslator
+{
+    std::array<std::array<std::uint32_t, 256>, 4> tables{};
+
+    constexpr std::uint32_t operator()(std::uint32_t in) const noexcept
+    {
+        return tables[0][in & 0xFF] | tables[1][(in >> 8) & 0xFF]
+             | tables[2][(in >> 16) & 0xFF] | tables[3][in >> 24];
+    }
+
+    //! Translates \a count words from \a in to \a out. \a in and \a out may be the same array.
+    void operator()(const std::uint32_t *in, std::uint32_t *out, std::size_t count) const noexcept
+    {
+        for (std::size_t i = 0; i < count; ++i)
+            out[i] = (*this)(in[i]);
+    }
+};
+
+//! Builds a BitTranslator from \a mapping, reading `native` bits if \a fromNative and `node` bits otherwise.
+template <std::size_t N>
+constexpr BitTranslator makeTranslator(const FlagMapping (&mapping)[N], bool fromNative) noexcept
+{
+    BitTranslator ret;
+    for (std::size_t byte = 0; byte < 4; ++byte) {
+        for (std::uint32_t value = 0; value < 256; ++value) {
+            const std::uint32_t in = value << (8 * byte);
+            std::uint32_t out = 0;
+            for (const auto &entry : mapping) {
+                if (in & (fromNative ? entry.native : entry.node))
+                    out |= fromNative ? entry.node : entry.native;
+            }
+            ret.tables[byte][value] = out;
+        }
+    }
+    return ret;
+}
+
+inline constexpr BitTranslator nodeToSfgao = makeTranslator(sfgaoMapping, false);
+inline constexpr BitTranslator sfgaoToNode = makeTranslator(sfgaoMapping, true);
+inline constexpr BitTranslator attributeToNode = makeTranslator(attributeMapping, true);
+
+static_assert(sfgaoToNode(sfgao::Folder | sfgao::HasSubfolder) == (node::Folder | node::MayHaveChildren),
+              "SFGAO translation table is inconsistent");
+static_assert(nodeToSfgao(node::ShellLink) == sfgao::Link, "SFGAO translation table is inconsistent");
+
+} // namespace detail
+} // namespace shell
+} // namespace windows
+} // namespace qe
+
+#endif // QE_WINDOWS_SHELLFLAGS_P_H
@@ -1,10 +1,26 @@
 #include "shellnode.h"
+#include <QtCore/QHash>
 #include <qewindows/shell.h>
 #include <qewindows/shellnodedata.h>
 
 namespace qe {
 namespace windows {
 
+//! Returns true if the shell reports \a item as part of the file system.
+//! \internal
+inline bool isFileSystemItem(IShellItem *item)
+{
+    SFGAOF attributes = 0;
+    return SUCCEEDED(item->GetAttributes(SFGAO_FILESYSTEM, &attributes)) && (attributes & SFGAO_FILESYSTEM);
+}
+
+//! Returns true if \a node is a valid node that is not on the file system.
+//! \internal
+inline bool isVirtual(const ShellNode *node)
+{
+    return node && node->isValid() && !(node->data()->flags & shell::NodeFlag::FileSystem);
+}
+
 //! Helper function that initializes the root node.
 //! \internal
 ShellNode *ShellNode::get_rootNode()
@@ -48,7 +64,10 @@ QVector<ShellNodePointer> ShellNode::children()
     return d.children;
 }
 
-//! Forces the node to enumerate its children. If the data is remote, this may be costly.
+//! \brief Forces the node to enumerate its children. If the data is remote, this may be costly.
+//! Items that are already children are not added again. A file system item is matched by its id
+//! list. Other items without a match are compared by the shell with each child that is not on the
+//! file system, as their folders may hand out a different id list for the same item.
 void ShellNode::enumerate()
 {
     if (!isValid())
@@ -60,30 +79,61 @@ void ShellNode::enumerate()
 
     auto items = bindTo<IEnumShellItems>();
     Q_ASSERT(items);
-    IShellItem *ptr = nullptr;
-    auto hr = S_OK;
-    while (hr == S_OK) {
-        //iterate over an individual item
-        hr = items->Next(1, &ptr, nullptr);
-        if (!SUCCEEDED(hr))
+    //index the known children by the hash of their id, so that each item is only compared with
+    //the children that share its hash
+    QMultiHash<uint, const ShellNode *> known;
+    known.reserve(d.children.count());
+    //the children that an item missing from known may still be equal to
+    int virtualChildren = 0;
+    for (int i = 0; i < d.children.count(); ++i) {
+        const ShellNode *node = d.children.at(i).data();
+        if (node && node->isValid() && node->d.cachedData->id)
+            known.insert(qHash(node->d.cachedData->id), node);
+        virtualChildren += isVirtual(node);
+    }
+    for (;;) {
+        //iterate over an individual item; S_FALSE means none was returned
+        ShellItemPointer item;
+        if (items->Next(1, item.addressOf(), nullptr) != S_OK)
             break;
+        IShellItem *ptr = item.get();
+        if (!ptr)
+            continue;
+        const shell::IdList id = shell::idListFromUnknown(ptr);
         bool found = false;
-        if (d.children.count()) {
-            auto iter = d.children.cbegin();
-            auto iter_end = d.children.cend();
-            //search and see if this node exists already
-            for(; iter != iter_end; ++iter) {
-                auto node = *iter;
-                if (node && !shell::compareItems(node->itemPointer().data(), ptr)) {
+        if (id) {
+            //search and see if this node exists already; the shell decides for ids that share a
+            //hash but not their bytes
+            const uint key = qHash(id);
+            for (auto iter = known.constFind(key); iter != known.cend() && iter.key() == key; ++iter) {
+                const ShellNode *node = iter.value();
+                if (node->d.cachedData->id == id || !shell::compareItems(node->itemPointer().data(), ptr)) {
                     found = true;
                     break;
                 }
             }
         }
-        if (!found && ptr) {
+        if (!found && !id) {
+            //without an id, ask the shell to compare the item with each child
+            for (int i = 0; i < d.children.count() && !found; ++i) {
+                auto node = d.children.at(i);
+                found = node && !shell::compareItems(node->itemPointer().data(), ptr);
+            }
+        } else if (!found && virtualChildren && !isFileSystemItem(ptr)) {
+            //ask the shell to compare the item with each child that may have another id for it
+            for (int i = 0; i < d.children.count() && !found; ++i) {
+                auto node = d.children.at(i);
+                found = isVirtual(node.data()) && !shell::compareItems(node->itemPointer().data(), ptr);
+            }
+        }
+        if (!found) {
             auto child = createChild(ptr);
-            if (child)
+            if (child) {
                 d.children.append(child);
+                virtualChildren += isVirtual(child.data());
+                if (child->isValid() && child->d.cachedData->id)
+                    known.insert(qHash(child->d.cachedData->id), child.data());
+            }
         }
     }
     d.enumerated = true;
@@ -117,6 +167,7 @@ ShellNode::ShellNode(ShellNodeDataPointer data, ShellNodePointer parent) /*noexc
 {
     d.cachedData = data;
     d.parent = parent;
+    d.root = !parent;
 }
 
 } // namespace windows
@@ -66,12 +66,13 @@ public:
     //! Returns true if the node was successfully constructed and has valid data.
     bool isValid() const noexcept                       { return d.cachedData; }
     //! Returns true if this is the root, i.e. desktop node.
-    bool isRoot() const noexcept                        { return !d.parent; }
+    bool isRoot() const noexcept                        { return d.root; }
     //! Returns true if the children of this node are enumerated.
     bool isEnumerated() const noexcept                  { return d.enumerated; }
 
-    //! Returns a pointer to the parent node, or an invalid pointer if this is the root node.
-    PointerType parent() const noexcept                 { return d.parent ? d.parent : nullptr; }
+    //! Returns a pointer to the parent node, or an invalid pointer if this is the root node or the
+    //! parent has been destroyed. Nodes do not keep their parent alive.
+    PointerType parent() const noexcept                 { return d.parent.toStrongRef(); }
     bool hasChildren() const noexcept;
     //! Returns the number of known children of this node. Call enumerate to ensure that this value is correct.
     int childCount() const noexcept                     { return d.children.count(); }
@@ -111,7 +112,9 @@ private:
 
     //! \internal
     struct LocalData {
-        PointerType parent;
+        //weak, as the parent owns its children
+        QWeakPointer<ShellNode> parent;
+        bool root = true;
         ShellItem2Pointer item;
         ShellNodeDataPointer cachedData;
         QVector<PointerType> children;
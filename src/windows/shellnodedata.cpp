@@ -83,6 +83,7 @@ void ShellNodeData::refresh()
                     flags |= shell::NodeFlag::Junction;
             }
         }
+        PropVariantClear(&var);
     }
 
     invalid = false;
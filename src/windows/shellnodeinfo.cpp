@@ -1,6 +1,6 @@
 #include "shellnodeinfo.h"
 #include <QVarLengthArray>
-#include <QtCore/QDebug>
+#include <qecore/debugwriter.h>
 #include <qewindows/shell.h>
 #include <qewindows/winutil.h>
 
@@ -41,18 +41,20 @@ bool ShellNodeInfo::setNode(QString filepath)
         converted.reserve(filepath.length());
     }*/
     if (filepath.length() > MAX_PATH - 1) {
-        qDebug() << "Can't add paths longer than 260 literals to the shell.";
+        QE_DEBUG_WRITE("Can't add paths longer than 260 literals to the shell.");
         d.reset();
         return false;
     }
 
     //Actually copy the string
-    Q_ASSERT(filepath.toWCharArray(converted) > 0);
+    const int length = filepath.toWCharArray(converted);
+    Q_ASSERT(length > 0);
+    Q_UNUSED(length);
 
     auto item = ShellItem2Pointer();
     SHCreateItemFromParsingName(converted, nullptr, IID_PPV_ARGS(item.addressOf()));
     if (!item) {
-        qDebug() << "Failed to create NodeInfo from path: " << filepath;
+        QE_DEBUG_WRITE("Failed to create NodeInfo from path: %1", filepath);
         return false;
     }
     d = ShellNodeData::create(item);
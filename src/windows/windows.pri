@@ -12,12 +12,13 @@ HEADERS += \
     $$PWD/unknownpointer.h \
     $$PWD/winutil.h \
     $$PWD/shell.h \
+    $$PWD/shellflags_p.h \
     $$PWD/shellnode.h \
     $$PWD/shellnodedata.h \
     $$PWD/shellnodeinfo.h \
     $$PWD/shell_impl.h \
-    $$PWD/idlist.h \
-    $$PWD/idlist_impl.h
+    $$PWD/pidl.h \
+    $$PWD/idlist.h
 
 SOURCES += \
     $$PWD/winutil.cpp \
@@ -0,0 +1,327 @@
+/*  QExt: Extensions to Qt
+ *  Copyright (C) 2016  Jonathan Harper
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QE_TEST_BASELINE_H
+#define QE_TEST_BASELINE_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <ctime>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace qe_test {
+
+//! The sample times of one benchmark case in a baseline run, in nanoseconds per operation.
+struct BaselineEntry
+{
+    std::string name;
+    std::size_t iterations = 0;
+    std::vector<double> times;
+};
+
+//! One saved run of a benchmark program.
+struct BaselineRun
+{
+    unsigned id = 0;
+    long long time = 0;         //seconds since the epoch
+    std::string label;
+    std::vector<BaselineEntry> entries;
+
+    //! Returns the entry for the case \a name, or nullptr.
+    const BaselineEntry *find(const std::string &name) const
+    {
+        for (const auto &entry : entries) {
+            if (entry.name == name)
+                return &entry;
+        }
+        return nullptr;
+    }
+};
+
+/*!
+    \brief A file of saved benchmark runs, oldest first.
+
+    The file is plain text so that it can be kept next to the code, diffed and trimmed by hand:
+
+        # qe_test baseline
+        version 1
+        run <id> <time> <label>
+        <case> <iterations> <time per operation of each sample...>
+        end
+
+    New runs are appended, so the file doubles as a history of each case. Give each run a label,
+    such as a commit id, to find where a change happened.
+*/
+class Baseline
+{
+public:
+    static const int Version = 1;
+
+    //! Reads \a path. Returns false and sets \a error if it can't be read or parsed.
+    bool load(const std::string &path, std::string *error = nullptr);
+    //! Appends \a run to \a path, creating the file if needed, and to this object.
+    bool append(const std::string &path, BaselineRun run);
+
+    const std::vector<BaselineRun> &runs() const    { return m_runs; }
+    //! Returns the most recent run with \a label, or the most recent run if \a label is empty.
+    const BaselineRun *latest(const std::string &label = std::string()) const;
+
+private:
+    std::vector<BaselineRun> m_runs;
+};
+
+//! The result of comparing a case against its baseline.
+struct Comparison
+{
+    enum Verdict { Unchanged, Improvement, Regression };
+
+    double ratio = 1.0;     //median of the new samples over the median of the baseline samples
+    double low = 1.0;       //confidence interval of ratio
+    double high = 1.0;
+    double p = 1.0;         //two-sided Mann-Whitney U test
+    Verdict verdict = Unchanged;
+
+    const char *verdictName() const
+    {
+        return verdict == Regression ? "regression" : verdict == Improvement ? "improvement" : "unchanged";
+    }
+};
+
+namespace detail {
+
+inline double median_of(std::vector<double> values)
+{
+    if (values.empty())
+        return 0.0;
+    const std::size_t mid = values.size() / 2;
+    std::nth_element(values.begin(), values.begin() + std::ptrdiff_t(mid), values.end());
+    return values[mid];
+}
+
+//! Returns the two-sided p-value of the Mann-Whitney U test, using the normal approximation.
+inline double mann_whitney_p(const std::vector<double> &a, const std::vector<double> &b)
+{
+    const double n1 = double(a.size());
+    const double n2 = double(b.size());
+    if (a.empty() || b.empty())
+        return 1.0;
+
+    std::vector<std::pair<double, int>> all;
+    all.reserve(a.size() + b.size());
+    for (double v : a)
+        all.emplace_back(v, 0);
+    for (double v : b)
+        all.emplace_back(v, 1);
+    std::sort(all.begin(), all.end());
+
+    //ranks start at 1 and ties share their average rank
+    double rankSum = 0.0;
+    double tieTerm = 0.0;
+    for (std::size_t i = 0; i < all.size();) {
+        std::size_t j = i;
+        while (j < all.size() && all[j].first == all[i].first)
+            ++j;
+        const double rank = (double(i + 1) + double(j)) / 2.0;
+        for (std::size_t k = i; k < j; ++k) {
+            if (all[k].second == 0)
+                rankSum += rank;
+        }
+        const double t = double(j - i);
+        tieTerm += t * t * t - t;
+        i = j;
+    }
+
+    const double n = n1 + n2;
+    const double u = rankSum - n1 * (n1 + 1.0) / 2.0;
+    const double mean = n1 * n2 / 2.0;
+    const double variance = n1 * n2 / 12.0 * ((n + 1.0) - tieTerm / (n * (n - 1.0)));
+    if (variance <= 0.0)
+        return 1.0;
+    const double z = std::max(std::fabs(u - mean) - 0.5, 0.0) / std::sqrt(variance);
+    return std::erfc(z / std::sqrt(2.0));
+}
+
+//! Returns a 95% percentile bootstrap interval of median(after) / median(before).
+inline std::pair<double, double> bootstrap_ratio(const std::vector<double> &before,
+                                                 const std::vector<double> &after,
+                                                 int resamples = 2000)
+{
+    std::uint64_t state = 0x5EEDull;
+    auto next = [&state] {
+        std::uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    };
+    auto resample = [&next](const std::vector<double> &from, std::vector<double> &to) {
+        for (auto &v : to)
+            v = from[next() % from.size()];
+        return median_of(to);
+    };
+
+    std::vector<double> ratios(static_cast<std::size_t>(resamples));
+    std::vector<double> a(before.size());
+    std::vector<double> b(after.size());
+    for (auto &ratio : ratios) {
+        const double base = resample(before, a);
+        ratio = base > 0.0 ? resample(after, b) / base : 1.0;
+    }
+    std::sort(ratios.begin(), ratios.end());
+    const std::size_t lo = std::size_t(double(resamples) * 0.025);
+    const std::size_t hi = std::min(ratios.size() - 1, std::size_t(double(resamples) * 0.975));
+    return {ratios[lo], ratios[hi]};
+}
+
+} // namespace detail
+
+/*!
+    \brief Compares the sample times \a after against \a before.
+
+    A case is a regression only if the samples differ significantly at level \a alpha and the
+    whole confidence interval of the median ratio is above `1 + threshold`, so that small but
+    consistent differences and noisy cases are both reported as unchanged. Improvements are
+    judged the same way against `1 / (1 + threshold)`.
+*/
+inline Comparison compare(const std::vector<double> &before, const std::vector<double> &after,
+                          double threshold = 0.05, double alpha = 0.01)
+{
+    Comparison ret;
+    if (before.empty() || after.empty())
+        return ret;
+    const double base = detail::median_of(before);
+    ret.ratio = base > 0.0 ? detail::median_of(after) / base : 1.0;
+    const auto interval = detail::bootstrap_ratio(before, after);
+    ret.low = interval.first;
+    ret.high = interval.second;
+    ret.p = detail::mann_whitney_p(before, after);
+    if (ret.p < alpha && ret.low > 1.0 + threshold)
+        ret.verdict = Comparison::Regression;
+    else if (ret.p < alpha && ret.high < 1.0 / (1.0 + threshold))
+        ret.verdict = Comparison::Improvement;
+    return ret;
+}
+
+////////
+// Implementation below
+
+inline bool Baseline::load(const std::string &path, std::string *error)
+{
+    auto failed = [error, &path](int line, const std::string &message) {
+        if (error)
+            *error = path + ":" + std::to_string(line) + ": " + message;
+        return false;
+    };
+
+    std::ifstream in(path);
+    if (!in)
+        return failed(0, "cannot be read");
+
+    std::vector<BaselineRun> runs;
+    BaselineRun *run = nullptr;
+    bool versioned = false;
+    std::string text;
+    int lineNumber = 0;
+    while (std::getline(in, text)) {
+        ++lineNumber;
+        if (text.empty() || text[0] == '#')
+            continue;
+        std::istringstream line(text);
+        std::string word;
+        line >> word;
+        if (!versioned) {
+            int version = 0;
+            if (word != "version" || !(line >> version))
+                return failed(lineNumber, "expected a version line");
+            if (version != Version)
+                return failed(lineNumber, "unsupported version " + std::to_string(version));
+            versioned = true;
+        } else if (!run) {
+            if (word != "run")
+                return failed(lineNumber, "expected a run line");
+            runs.emplace_back();
+            run = &runs.back();
+            if (!(line >> run->id >> run->time))
+                return failed(lineNumber, "malformed run line");
+            std::getline(line >> std::ws, run->label);
+        } else if (word == "end") {
+            run = nullptr;
+        } else {
+            BaselineEntry entry;
+            entry.name = word;
+            if (!(line >> entry.iterations))
+                return failed(lineNumber, "malformed case line");
+            double value;
+            while (line >> value)
+                entry.times.push_back(value);
+            if (!line.eof() || entry.times.empty())
+                return failed(lineNumber, "malformed sample times");
+            run->entries.push_back(std::move(entry));
+        }
+    }
+    if (run)
+        return failed(lineNumber, "unterminated run");
+    m_runs = std::move(runs);
+    return true;
+}
+
+inline bool Baseline::append(const std::string &path, BaselineRun run)
+{
+    const bool exists = std::ifstream(path).good();
+    std::ofstream out(path, std::ios::app);
+    if (!out)
+        return false;
+    if (!exists)
+        out << "# qe_test baseline\nversion " << Version << "\n";
+
+    run.id = m_runs.empty() ? 1 : m_runs.back().id + 1;
+    if (!run.time)
+        run.time = static_cast<long long>(std::time(nullptr));
+    out << "run " << run.id << ' ' << run.time;
+    if (!run.label.empty())
+        out << ' ' << run.label;
+    out << '\n';
+    out.precision(9);
+    for (const auto &entry : run.entries) {
+        out << entry.name << ' ' << entry.iterations;
+        for (double t : entry.times)
+            out << ' ' << t;
+        out << '\n';
+    }
+    out << "end\n";
+    out.flush();
+    if (!out)
+        return false;
+    m_runs.push_back(std::move(run));
+    return true;
+}
+
+inline const BaselineRun *Baseline::latest(const std::string &label) const
+{
+    for (auto it = m_runs.rbegin(); it != m_runs.rend(); ++it) {
+        if (label.empty() || it->label == label)
+            return &*it;
+    }
+    return nullptr;
+}
+
+} // namespace qe_test
+
+#endif // QE_TEST_BASELINE_H
@@ -0,0 +1,91 @@
+/*  QExt: Extensions to Qt
+ *  Copyright (C) 2016  Jonathan Harper
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QE_TEST_BENCH_POINTER_H
+#define QE_TEST_BENCH_POINTER_H
+
+#include <utility>
+#include <qecore/managedpointer.h>
+#include <qecore/uniquepointer.h>
+#include "test.h"
+
+//! Benchmarks for the core smart pointers. Run with `core_test --bench`.
+struct pointer_bench
+{
+    using Unique = qe::UniquePointer<int>;
+    using Managed = qe::ManagedPointer<int, qe::DefaultManager<int>>;
+
+    static void unique_create(qe_test::Bench &bench)
+    {
+        bench.run([] {
+            Unique p(new int(1));
+            qe_test::keep(p);
+        });
+    }
+
+    static void unique_move(qe_test::Bench &bench)
+    {
+        Unique a(new int(1));
+        Unique b;
+        bench.run([&] {
+            b = std::move(a);
+            a = std::move(b);
+            qe_test::keep(a);
+        });
+    }
+
+    static void unique_swap(qe_test::Bench &bench)
+    {
+        Unique a(new int(1));
+        Unique b(new int(2));
+        bench.run([&] {
+            a.swap(b);
+            qe_test::keep(a);
+        });
+    }
+
+    static void managed_copy(qe_test::Bench &bench)
+    {
+        const Managed a(new int(1));
+        bench.run([&] {
+            Managed b(a);
+            qe_test::keep(b);
+        });
+    }
+
+    static void managed_move(qe_test::Bench &bench)
+    {
+        Managed a(new int(1));
+        Managed b;
+        bench.run([&] {
+            b = std::move(a);
+            a = std::move(b);
+            qe_test::keep(a);
+        });
+    }
+
+    static void add()
+    {
+        qe_test::add_benchmark("unique_pointer_create", &unique_create);
+        qe_test::add_benchmark("unique_pointer_move", &unique_move);
+        qe_test::add_benchmark("unique_pointer_swap", &unique_swap);
+        qe_test::add_benchmark("managed_pointer_copy", &managed_copy);
+        qe_test::add_benchmark("managed_pointer_move", &managed_move);
+    }
+};
+
+#endif // QE_TEST_BENCH_POINTER_H
@@ -13,4 +13,15 @@ SOURCES += \
 HEADERS += \
     $$PWD/test_uniquepointer.h \
     $$PWD/test.h \
-    $$PWD/test_managedpointer.h
+    $$PWD/perfcounters.h \
+    $$PWD/baseline.h \
+    $$PWD/test_managedpointer.h \
+    $$PWD/test_dptr.h \
+    $$PWD/test_bulkconstruct.h \
+    $$PWD/test_seqlock.h \
+    $$PWD/test_hexencode.h \
+    $$PWD/test_logring.h \
+    $$PWD/test_typeutil.h \
+    $$PWD/test_numberformat.h \
+    $$PWD/test_baseline.h \
+    $$PWD/bench_pointer.h
@@ -1,13 +1,30 @@
 #include "test_uniquepointer.h"
 #include "test_managedpointer.h"
+#include "test_dptr.h"
+#include "test_bulkconstruct.h"
+#include "test_seqlock.h"
+#include "test_hexencode.h"
+#include "test_logring.h"
+#include "test_typeutil.h"
+#include "test_numberformat.h"
+#include "test_baseline.h"
+#include "bench_pointer.h"
+
+QE_TEST_COUNT_ALLOCATIONS
 
 int main(int argc, char *argv[])
 {
-    (void)(argc);
-    (void)(argv);
-
-    unique_pointer_test::run();
-    managed_pointer_test::run();
+    qe_test::add_test("unique_pointer", &unique_pointer_test::run);
+    qe_test::add_test("managed_pointer", &managed_pointer_test::run);
+    qe_test::add_test("dptr", &dptr_test::run);
+    qe_test::add_test("bulk_construct", &bulk_construct_test::run);
+    qe_test::add_test("seqlock", &seqlock_test::run);
+    qe_test::add_test("hex_encode", &hex_encode_test::run);
+    qe_test::add_test("log_ring", &log_ring_test::run);
+    qe_test::add_test("type_util", &type_util_test::run);
+    qe_test::add_test("number_format", &number_format_test::run);
+    qe_test::add_test("baseline", &baseline_test::run);
+    pointer_bench::add();
 
-    return 0;
+    return qe_test::run(argc, argv);
 }
@@ -0,0 +1,196 @@
+/*  QExt: Extensions to Qt
+ *  Copyright (C) 2016  Jonathan Harper
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+    Hardware performance counters for benchmark cases, read with perf_event_open(2) on Linux.
+    Each counter is opened on its own, for the calling thread and for user space only, so it works
+    without root whenever /proc/sys/kernel/perf_event_paranoid is 2 or lower, and any counter the
+    CPU or kernel doesn't provide is simply reported as unavailable. On other platforms no
+    counters are available.
+*/
+
+#ifndef QE_TEST_PERFCOUNTERS_H
+#define QE_TEST_PERFCOUNTERS_H
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace qe_test {
+
+class PerfCounters
+{
+public:
+    //! The counters, in the order they are reported.
+    enum Counter {
+        Cycles,
+        Instructions,
+        L1dMisses,
+        LlcMisses,
+        BranchMisses,
+        DtlbMisses,
+        CounterCount
+    };
+
+    //! Returns the name of \a counter as used in reports.
+    static const char *name(int counter)
+    {
+        static const char *const names[CounterCount] = {
+            "cycles", "instructions", "l1d_misses", "llc_misses", "branch_misses", "dtlb_misses"
+        };
+        return names[counter];
+    }
+
+    PerfCounters()
+    {
+#if defined(__linux__)
+        auto cache = [](std::uint64_t cache) {
+            return cache | (std::uint64_t(PERF_COUNT_HW_CACHE_OP_READ) << 8)
+                    | (std::uint64_t(PERF_COUNT_HW_CACHE_RESULT_MISS) << 16);
+        };
+        const std::uint32_t types[CounterCount] = {
+            PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HW_CACHE,
+            PERF_TYPE_HW_CACHE, PERF_TYPE_HARDWARE, PERF_TYPE_HW_CACHE
+        };
+        const std::uint64_t configs[CounterCount] = {
+            PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, cache(PERF_COUNT_HW_CACHE_L1D),
+            cache(PERF_COUNT_HW_CACHE_LL), PERF_COUNT_HW_BRANCH_MISSES, cache(PERF_COUNT_HW_CACHE_DTLB)
+        };
+        for (int i = 0; i < CounterCount; ++i) {
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = types[i];
+            attr.config = configs[i];
+            attr.disabled = 1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            //scaled if the kernel has to multiplex more counters than the PMU has
+            attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+            m_fds[i] = int(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+            if (m_fds[i] < 0 && !m_error)
+                m_error = errno;
+        }
+#else
+        m_error = ENOSYS;
+#endif
+    }
+
+    ~PerfCounters()
+    {
+#if defined(__linux__)
+        for (int fd : m_fds) {
+            if (fd >= 0)
+                close(fd);
+        }
+#endif
+    }
+
+    PerfCounters(const PerfCounters &) = delete;
+    PerfCounters &operator=(const PerfCounters &) = delete;
+
+    //! Returns true if at least one counter could be opened.
+    bool isAvailable() const
+    {
+        for (int fd : m_fds) {
+            if (fd >= 0)
+                return true;
+        }
+        return false;
+    }
+
+    //! Resets and starts the counters.
+    void start()
+    {
+#if defined(__linux__)
+        for (int fd : m_fds) {
+            if (fd >= 0) {
+                ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+                ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+            }
+        }
+#endif
+    }
+
+    //! Starts the counters again without resetting them, after stop().
+    void resume()
+    {
+#if defined(__linux__)
+        for (int fd : m_fds) {
+            if (fd >= 0)
+                ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+
+    //! Stops the counters.
+    void stop()
+    {
+#if defined(__linux__)
+        for (int fd : m_fds) {
+            if (fd >= 0)
+                ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        }
+#endif
+    }
+
+    //! Returns the value of \a counter since start(), or -1 if it is unavailable.
+    double value(int counter) const
+    {
+#if defined(__linux__)
+        const int fd = m_fds[counter];
+        std::uint64_t data[3];
+        if (fd < 0 || read(fd, data, sizeof(data)) != ssize_t(sizeof(data)) || data[2] == 0)
+            return -1.0;
+        return double(data[0]) * (double(data[1]) / double(data[2]));
+#else
+        (void)counter;
+        return -1.0;
+#endif
+    }
+
+    //! Returns the errno of the first counter that could not be opened, or 0 if all of them were.
+    int error() const { return m_error; }
+
+    //! Returns the value of /proc/sys/kernel/perf_event_paranoid, or -100 if it can't be read.
+    static int paranoidLevel()
+    {
+        int level = -100;
+        if (std::FILE *file = std::fopen("/proc/sys/kernel/perf_event_paranoid", "r")) {
+            if (std::fscanf(file, "%d", &level) != 1)
+                level = -100;
+            std::fclose(file);
+        }
+        return level;
+    }
+
+private:
+    int m_fds[CounterCount] = {-1, -1, -1, -1, -1, -1};
+    int m_error = 0;
+};
+
+} // namespace qe_test
+
+#endif // QE_TEST_PERFCOUNTERS_H
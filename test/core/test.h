@@ -1,7 +1,74 @@
+/*  QExt: Extensions to Qt
+ *  Copyright (C) 2016  Jonathan Harper
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+    A small test and benchmark runner. The EXPECT_* checks are never compiled out, so tests can
+    run in release builds; a failed check is recorded against the running case and the case
+    continues. Outside of qe_test::run(), a failed check aborts, like the assert it replaced.
+
+    Cases are registered with qe_test::add_test()/add_benchmark() or QE_TEST_CASE/QE_BENCHMARK,
+    then run from main() with `return qe_test::run(argc, argv);`, or qe_test::run_benchmarks() in a
+    program that only benchmarks. Options:
+
+        --list              print the registered cases and exit
+        --filter <text>     run only cases whose name contains <text>
+        --bench             run benchmark cases as well as tests
+        --bench-only        run only benchmark cases
+        --perf              also read hardware performance counters in benchmark cases (Linux)
+        --json <file>       write the results as JSON to <file>, or to stdout for "-"
+
+    Benchmark baselines (see qe_test::Baseline):
+
+        --save-baseline <file>  append the benchmark results to <file>
+        --label <text>          label the saved run, e.g. with a commit id
+        --baseline <file>       compare each benchmark with the latest run in <file>; significant
+                                regressions fail the run
+        --baseline-label <text> compare with the latest run labelled <text> instead
+        --threshold <percent>   the smallest change that is reported (default 5)
+        --alpha <p>             the significance level of the comparison (default 0.01)
+        --history <file>        print the saved medians of the selected cases and exit
+
+    QE_EXPECT_NO_ALLOC { ... } and QE_EXPECT_ALLOCS(n) { ... } check the number of heap
+    allocations made by the calling thread inside the braces. They need QE_TEST_COUNT_ALLOCATIONS
+    (or QE_TEST_COUNT_MALLOC) once, at namespace scope, in the file that defines main().
+*/
+
 #ifndef QE_TEST_TEST_H
 #define QE_TEST_TEST_H
 
 #include <assert.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "baseline.h"
+#include "perfcounters.h"
 
 auto equal_check = [](auto && lhs, auto && rhs) -> bool
 {
@@ -49,14 +116,877 @@ auto flag_check = [](auto && lhs, auto && rhs) -> bool
     return static_cast<T>(lhs) & static_cast<T>(rhs) ? true : false;
 };
 
-#define EXPECT_EQ(x, y) assert(equal_check(x, y))
-#define EXPECT_NE(x, y) assert(not_equal_check(x, y))
-#define EXPECT_LT(x, y) assert(less_than_check(x, y))
-#define EXPECT_LE(x, y) assert(less_than_or_equal_check(x, y))
-#define EXPECT_GT(x, y) assert(greater_than_check(x, y))
-#define EXPECT_GE(x, y) assert(greater_than_or_equal_check(x, y))
-#define EXPECT_TRUE(x)  assert(implicit_true_check(x))
-#define EXPECT_FALSE(x) assert(implicit_false_check(x))
-#define EXPECT_FLAG(type, x, y) assert(flag_check<type>(x, y))
+namespace qe_test {
+
+//! A failed check.
+struct Failure
+{
+    std::string file;
+    int line;
+    std::string check;
+    std::string values;
+};
+
+//! The timings of a benchmark case, in nanoseconds per operation.
+struct BenchStats
+{
+    std::size_t iterations = 0;     //per sample
+    std::size_t samples = 0;
+    std::size_t batch = 1;          //operations per iteration
+    std::size_t bytes = 0;          //per operation; 0 if no throughput is reported
+    double min = 0.0;
+    double median = 0.0;
+    double p99 = 0.0;
+    double mean = 0.0;
+    //per operation, indexed by PerfCounters::Counter; negative if not measured
+    double counters[PerfCounters::CounterCount] = {-1.0, -1.0, -1.0, -1.0, -1.0, -1.0};
+    //heap allocations per operation; negative if allocations are not counted
+    double allocations = -1.0;
+    //per operation, of each sample in the order they were taken
+    std::vector<double> times;
+};
+
+//! The outcome of one case.
+struct CaseResult
+{
+    std::string name;
+    bool benchmark = false;
+    std::size_t checks = 0;
+    std::vector<Failure> failures;
+    double seconds = 0.0;
+    BenchStats stats;
+    bool compared = false;      //whether comparison holds a comparison with a baseline
+    Comparison comparison;
+
+    bool passed() const { return failures.empty(); }
+};
+
+class Bench;
+
+//! A registered case: either a test or a benchmark.
+struct Case
+{
+    std::string name;
+    void (*test)();
+    void (*bench)(Bench &);
+};
+
+//! \internal
+struct State
+{
+    std::mutex mutex;
+    CaseResult *current = nullptr;
+    std::atomic<std::size_t> checks{0};
+    bool perf = false;
+};
+
+//! \internal
+inline State &state()
+{
+    static State s;
+    return s;
+}
+
+//! Returns the registered cases, in registration order.
+inline std::vector<Case> &registry()
+{
+    static std::vector<Case> cases;
+    return cases;
+}
+
+//! Registers \a fn as the test case \a name.
+inline void add_test(const char *name, void (*fn)())
+{
+    registry().push_back({name, fn, nullptr});
+}
+
+//! Registers \a fn as the benchmark case \a name.
+inline void add_benchmark(const char *name, void (*fn)(Bench &))
+{
+    registry().push_back({name, nullptr, fn});
+}
+
+//! Registers a case during static initialization. Used by \ref QE_TEST_CASE and \ref QE_BENCHMARK.
+struct Registrar
+{
+    Registrar(const char *name, void (*fn)())        { add_test(name, fn); }
+    Registrar(const char *name, void (*fn)(Bench &)) { add_benchmark(name, fn); }
+};
+
+namespace detail {
+
+template <class T, class = void>
+struct is_printable : std::false_type {};
+
+template <class T>
+struct is_printable<T, std::void_t<decltype(std::declval<std::ostream &>() << std::declval<const T &>())>>
+    : std::true_type {};
+
+//! Returns \a value as text for a failure message, or "?" if it can't be printed.
+template <class T>
+std::string describe(const T &value)
+{
+    if constexpr (std::is_same<T, bool>::value) {
+        return value ? "true" : "false";
+    } else if constexpr (std::is_enum<T>::value) {
+        return std::to_string(static_cast<long long>(value));
+    } else if constexpr (is_printable<T>::value) {
+        std::ostringstream out;
+        out << value;
+        return out.str();
+    } else {
+        return "?";
+    }
+}
+
+//! Records a failed check against the running case, or aborts if there is none.
+inline void fail(const char *file, int line, const char *check, std::string values)
+{
+    State &s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    std::fprintf(stderr, "%s:%d: FAILED %s%s%s\n", file, line, check,
+                 values.empty() ? "" : " with ", values.c_str());
+    std::fflush(stderr);
+    if (!s.current)
+        std::abort();
+    s.current->failures.push_back({file, line, check, std::move(values)});
+}
+
+template <class Predicate, class Value>
+inline bool check(const char *file, int line, const char *text, Predicate &&predicate, Value &&value)
+{
+    state().checks.fetch_add(1, std::memory_order_relaxed);
+    if (predicate(value))
+        return true;
+    fail(file, line, text, describe(value));
+    return false;
+}
+
+template <class Predicate, class Lhs, class Rhs>
+inline bool check(const char *file, int line, const char *text, Predicate &&predicate, Lhs &&lhs, Rhs &&rhs)
+{
+    state().checks.fetch_add(1, std::memory_order_relaxed);
+    if (predicate(lhs, rhs))
+        return true;
+    fail(file, line, text, describe(lhs) + ", " + describe(rhs));
+    return false;
+}
+
+inline std::string json_escape(const std::string &text)
+{
+    std::string ret;
+    ret.reserve(text.size());
+    for (char c : text) {
+        switch (c) {
+        case '"':  ret += "\\\""; break;
+        case '\\': ret += "\\\\"; break;
+        case '\n': ret += "\\n"; break;
+        case '\t': ret += "\\t"; break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20) {
+                char buffer[8];
+                std::snprintf(buffer, sizeof(buffer), "\\u%04x", c);
+                ret += buffer;
+            } else {
+                ret += c;
+            }
+        }
+    }
+    return ret;
+}
+
+//! Per-thread allocation counters, maintained by QE_TEST_COUNT_ALLOCATIONS or QE_TEST_COUNT_MALLOC.
+struct AllocationCounters
+{
+    std::size_t allocations = 0;
+    std::size_t deallocations = 0;
+};
+
+inline thread_local AllocationCounters t_allocations;
+
+//! Returns whether a counting allocator has been installed.
+inline bool &allocation_counting()
+{
+    static bool counting = false;
+    return counting;
+}
+
+inline void *counted_alloc(std::size_t size) noexcept
+{
+    ++t_allocations.allocations;
+    return std::malloc(size ? size : 1);
+}
+
+// The replacement operator delete hands counted_free() the memory that the replacement operator
+// new got from counted_alloc(), so the two always pair through malloc() and free(). Once both are
+// inlined, GCC only sees a pointer from operator new reaching free() and warns.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+inline void counted_free(void *ptr) noexcept
+{
+    if (ptr)
+        ++t_allocations.deallocations;
+    std::free(ptr);
+}
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+} // namespace detail
+
+//! Returns the number of allocations made so far by the calling thread.
+inline std::size_t thread_allocations()
+{
+    return detail::t_allocations.allocations;
+}
+
+//! \brief Checks the number of allocations made by the calling thread during its lifetime.
+//! Used by \ref QE_EXPECT_NO_ALLOC and \ref QE_EXPECT_ALLOCS.
+class AllocationScope
+{
+public:
+    AllocationScope(const char *file, int line, const char *text, std::size_t expected) noexcept
+        : m_file(file), m_line(line), m_text(text), m_expected(expected), m_start(thread_allocations())
+    {
+    }
+
+    ~AllocationScope()
+    {
+        const std::size_t count = thread_allocations() - m_start;
+        state().checks.fetch_add(1, std::memory_order_relaxed);
+        if (!detail::allocation_counting())
+            detail::fail(m_file, m_line, m_text, "allocation counting is not enabled");
+        else if (count != m_expected)
+            detail::fail(m_file, m_line, m_text, "expected " + std::to_string(m_expected) + " allocations, got "
+                         + std::to_string(count));
+    }
+
+    //! Returns true the first time it is called, so that a `for` loop runs its body once.
+    bool once() noexcept
+    {
+        const bool first = !m_entered;
+        m_entered = true;
+        return first;
+    }
+
+    AllocationScope(const AllocationScope &) = delete;
+    AllocationScope &operator=(const AllocationScope &) = delete;
+
+private:
+    const char *m_file;
+    int m_line;
+    const char *m_text;
+    std::size_t m_expected;
+    std::size_t m_start;
+    bool m_entered = false;
+};
+
+//! Prevents the optimizer from discarding \a value.
+template <class T>
+inline void keep(const T &value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "m"(value) : "memory");
+#else
+    static volatile const T *sink;
+    sink = &value;
+#endif
+}
+
+/*!
+    \brief Times a benchmark case.
+
+    run() calls its function repeatedly to warm up and to find an iteration count that makes one
+    sample last at least sampleTime(), then times samples() samples and records the per-operation
+    minimum, median, 99th percentile and mean. An iteration is one call of the function, and
+    performs batch() operations. With `--perf`, hardware counters are read across all of the
+    samples, and with QE_TEST_COUNT_ALLOCATIONS or QE_TEST_COUNT_MALLOC, heap allocations are
+    counted; both are reported per operation.
+
+    For an operation that consumes its fixture, such as destroying widgets, run(setup, fn) calls
+    setup() before each call of fn() and leaves it out of the time, the counters and the
+    allocations. Each call of fn() is then timed on its own, so it should take well over a
+    microsecond.
+*/
+class Bench
+{
+public:
+    //! Sets the number of timed samples. The default is 31.
+    Bench &setSamples(std::size_t samples)  { m_samples = std::max<std::size_t>(samples, 1); return *this; }
+    std::size_t samples() const             { return m_samples; }
+    //! Sets the minimum duration of a sample in nanoseconds. The default is 2 ms.
+    Bench &setSampleTime(double ns)         { m_sampleTime = ns; return *this; }
+    double sampleTime() const               { return m_sampleTime; }
+    //! Sets the number of operations one call of the function performs. The default is 1.
+    Bench &setBatch(std::size_t ops)        { m_batch = std::max<std::size_t>(ops, 1); return *this; }
+    std::size_t batch() const               { return m_batch; }
+    //! Sets the number of bytes one operation processes, to report throughput. The default is 0.
+    Bench &setBytes(std::size_t bytes)      { m_bytes = bytes; return *this; }
+    std::size_t bytes() const               { return m_bytes; }
+
+    template <class Fn>
+    void run(Fn &&fn);
+    template <class Setup, class Fn>
+    void run(Setup &&setup, Fn &&fn);
+
+    //! Returns the timings of the last call to run().
+    const BenchStats &stats() const         { return m_stats; }
+
+private:
+    template <class Time>
+    void measure(Time &&time);
+
+    std::size_t m_samples = 31;
+    double m_sampleTime = 2e6;
+    std::size_t m_batch = 1;
+    std::size_t m_bytes = 0;
+    BenchStats m_stats;
+};
+
+template <class Fn>
+void Bench::run(Fn &&fn)
+{
+    using clock = std::chrono::steady_clock;
+    measure([&fn](std::size_t iterations, PerfCounters *, std::size_t &allocations) {
+        const std::size_t allocationsBefore = thread_allocations();
+        const auto start = clock::now();
+        for (std::size_t i = 0; i < iterations; ++i)
+            fn();
+        const std::chrono::duration<double, std::nano> elapsed = clock::now() - start;
+        allocations += thread_allocations() - allocationsBefore;
+        return elapsed.count();
+    });
+}
+
+template <class Setup, class Fn>
+void Bench::run(Setup &&setup, Fn &&fn)
+{
+    using clock = std::chrono::steady_clock;
+    measure([&setup, &fn](std::size_t iterations, PerfCounters *counters, std::size_t &allocations) {
+        double total = 0.0;
+        for (std::size_t i = 0; i < iterations; ++i) {
+            if (counters)
+                counters->stop();
+            setup();
+            if (counters)
+                counters->resume();
+            const std::size_t allocationsBefore = thread_allocations();
+            const auto start = clock::now();
+            fn();
+            const std::chrono::duration<double, std::nano> elapsed = clock::now() - start;
+            allocations += thread_allocations() - allocationsBefore;
+            total += elapsed.count();
+        }
+        return total;
+    });
+}
+
+//! \internal
+//! Calibrates and takes the samples; \a time runs the given number of iterations and returns the
+//! time they took in nanoseconds.
+template <class Time>
+void Bench::measure(Time &&time)
+{
+    //calibrate, which also warms up caches and branch predictors
+    std::size_t ignored = 0;
+    std::size_t iterations = 1;
+    double elapsed = time(iterations, nullptr, ignored);
+    while (elapsed < m_sampleTime / 4 && iterations < (std::size_t(1) << 32)) {
+        iterations *= 2;
+        elapsed = time(iterations, nullptr, ignored);
+    }
+    if (elapsed < m_sampleTime)
+        iterations = std::size_t(double(iterations) * m_sampleTime / std::max(elapsed, 1.0)) + 1;
+
+    std::unique_ptr<PerfCounters> counters;
+    if (state().perf)
+        counters.reset(new PerfCounters);
+
+    const double opsPerSample = double(iterations) * double(m_batch);
+    std::vector<double> perOp(m_samples);
+    double total = 0.0;
+    std::size_t allocations = 0;
+    if (counters)
+        counters->start();
+    for (auto &sample : perOp) {
+        sample = time(iterations, counters.get(), allocations) / opsPerSample;
+        total += sample;
+    }
+    if (counters)
+        counters->stop();
+    m_stats.times = perOp;
+    std::sort(perOp.begin(), perOp.end());
+
+    const double ops = opsPerSample * double(m_samples);
+    for (int i = 0; i < PerfCounters::CounterCount; ++i) {
+        const double value = counters ? counters->value(i) : -1.0;
+        m_stats.counters[i] = value < 0.0 ? -1.0 : value / ops;
+    }
+    m_stats.allocations = detail::allocation_counting() ? double(allocations) / ops : -1.0;
+
+    m_stats.iterations = iterations;
+    m_stats.samples = m_samples;
+    m_stats.batch = m_batch;
+    m_stats.bytes = m_bytes;
+    m_stats.min = perOp.front();
+    m_stats.median = perOp[perOp.size() / 2];
+    m_stats.p99 = perOp[std::min(perOp.size() - 1, (perOp.size() * 99 + 99) / 100 - 1)];
+    m_stats.mean = total / double(m_samples);
+}
+
+//! Writes \a results as JSON to \a out.
+inline void write_json(std::FILE *out, const std::vector<CaseResult> &results)
+{
+    std::size_t failed = 0;
+    for (const auto &result : results)
+        failed += result.passed() ? 0 : 1;
+
+    std::fprintf(out, "{\n  \"passed\": %zu,\n  \"failed\": %zu,\n  \"cases\": [", results.size() - failed, failed);
+    const char *separator = "\n";
+    for (const auto &result : results) {
+        std::fprintf(out, "%s    {\"name\": \"%s\", \"kind\": \"%s\", \"passed\": %s, \"seconds\": %.6f",
+                     separator, detail::json_escape(result.name).c_str(),
+                     result.benchmark ? "benchmark" : "test", result.passed() ? "true" : "false",
+                     result.seconds);
+        if (result.benchmark) {
+            const BenchStats &s = result.stats;
+            std::fprintf(out, ", \"iterations\": %zu, \"samples\": %zu, \"batch\": %zu, \"min_ns\": %.3f"
+                              ", \"median_ns\": %.3f, \"p99_ns\": %.3f, \"mean_ns\": %.3f",
+                         s.iterations, s.samples, s.batch, s.min, s.median, s.p99, s.mean);
+            if (s.bytes != 0)
+                std::fprintf(out, ", \"bytes\": %zu", s.bytes);
+            if (s.allocations >= 0.0)
+                std::fprintf(out, ", \"allocations\": %.3f", s.allocations);
+            if (state().perf) {
+                std::fprintf(out, ", \"counters\": {");
+                for (int i = 0; i < PerfCounters::CounterCount; ++i) {
+                    std::fprintf(out, i ? ", " : "");
+                    if (s.counters[i] < 0.0)
+                        std::fprintf(out, "\"%s\": null", PerfCounters::name(i));
+                    else
+                        std::fprintf(out, "\"%s\": %.3f", PerfCounters::name(i), s.counters[i]);
+                }
+                std::fprintf(out, "}");
+            }
+            if (result.compared) {
+                const Comparison &c = result.comparison;
+                std::fprintf(out, ", \"baseline\": {\"ratio\": %.4f, \"low\": %.4f, \"high\": %.4f"
+                                  ", \"p\": %.3g, \"verdict\": \"%s\"}",
+                             c.ratio, c.low, c.high, c.p, c.verdictName());
+            }
+        } else {
+            std::fprintf(out, ", \"checks\": %zu", result.checks);
+        }
+        std::fprintf(out, ", \"failures\": [");
+        const char *failureSeparator = "";
+        for (const auto &failure : result.failures) {
+            std::fprintf(out, "%s{\"file\": \"%s\", \"line\": %d, \"check\": \"%s\", \"values\": \"%s\"}",
+                         failureSeparator, detail::json_escape(failure.file).c_str(), failure.line,
+                         detail::json_escape(failure.check).c_str(), detail::json_escape(failure.values).c_str());
+            failureSeparator = ", ";
+        }
+        std::fprintf(out, "]}");
+        separator = ",\n";
+    }
+    std::fprintf(out, "\n  ]\n}\n");
+}
+
+//! Prints the hardware counters in \a stats, if any were measured.
+inline void print_counters(const BenchStats &stats)
+{
+    bool any = false;
+    for (double value : stats.counters)
+        any = any || value >= 0.0;
+    if (!any)
+        return;
+
+    std::printf("      ");
+    for (int i = 0; i < PerfCounters::CounterCount; ++i) {
+        if (stats.counters[i] >= 0.0)
+            std::printf(" %s %.2f", PerfCounters::name(i), stats.counters[i]);
+        else
+            std::printf(" %s -", PerfCounters::name(i));
+    }
+    const double cycles = stats.counters[PerfCounters::Cycles];
+    const double instructions = stats.counters[PerfCounters::Instructions];
+    if (cycles > 0.0 && instructions >= 0.0)
+        std::printf(" ipc %.2f", instructions / cycles);
+    std::printf(" per op\n");
+}
+
+//! Prints the throughput and the heap allocations in \a stats, if either was measured.
+inline void print_rates(const BenchStats &stats)
+{
+    if (stats.bytes == 0 && stats.allocations < 0.0)
+        return;
+
+    std::printf("      ");
+    if (stats.bytes != 0 && stats.median > 0.0)
+        std::printf(" %.1f MiB/s", (double(stats.bytes) / (1024.0 * 1024.0)) / (stats.median * 1e-9));
+    if (stats.allocations >= 0.0)
+        std::printf(" %.2f allocs/op", stats.allocations);
+    std::printf("\n");
+}
+
+//! Prints \a c, a comparison with a baseline.
+inline void print_comparison(const Comparison &c)
+{
+    std::printf("      %+.1f%% [%+.1f%%, %+.1f%%] p=%.2g %s\n", (c.ratio - 1.0) * 100.0,
+                (c.low - 1.0) * 100.0, (c.high - 1.0) * 100.0, c.p,
+                c.verdict == Comparison::Regression ? "REGRESSION" : c.verdictName());
+}
+
+//! Prints the saved medians of the cases accepted by \a selected, with the change from each run to the next.
+template <class Selected>
+inline void print_history(const Baseline &baseline, Selected &&selected, double threshold, double alpha)
+{
+    std::vector<std::string> names;
+    for (const auto &run : baseline.runs()) {
+        for (const auto &entry : run.entries) {
+            if (selected(entry.name) && std::find(names.begin(), names.end(), entry.name) == names.end())
+                names.push_back(entry.name);
+        }
+    }
+    for (const auto &name : names) {
+        std::printf("%s\n", name.c_str());
+        const BaselineEntry *previous = nullptr;
+        for (const auto &run : baseline.runs()) {
+            const BaselineEntry *entry = run.find(name);
+            if (!entry)
+                continue;
+            char date[32] = "";
+            const std::time_t when = std::time_t(run.time);
+            if (const std::tm *tm = std::localtime(&when))
+                std::strftime(date, sizeof(date), "%Y-%m-%d %H:%M", tm);
+            std::printf("  %4u %s %-24s %10.2f ns/op", run.id, date, run.label.c_str(),
+                        detail::median_of(entry->times));
+            if (previous) {
+                const Comparison c = compare(previous->times, entry->times, threshold, alpha);
+                std::printf("  %+6.1f%%%s", (c.ratio - 1.0) * 100.0,
+                            c.verdict == Comparison::Regression ? "  REGRESSION"
+                            : c.verdict == Comparison::Improvement ? "  improvement" : "");
+            }
+            std::printf("\n");
+            previous = entry;
+        }
+    }
+}
+
+//! Runs \a c and returns its result.
+inline CaseResult run_case(const Case &c)
+{
+    State &s = state();
+    CaseResult result;
+    result.name = c.name;
+    result.benchmark = c.bench != nullptr;
+    {
+        std::lock_guard<std::mutex> lock(s.mutex);
+        s.current = &result;
+    }
+    const std::size_t checksBefore = s.checks.load(std::memory_order_relaxed);
+    const auto start = std::chrono::steady_clock::now();
+    try {
+        if (c.bench) {
+            Bench bench;
+            c.bench(bench);
+            result.stats = bench.stats();
+        } else {
+            c.test();
+        }
+    } catch (const std::exception &e) {
+        detail::fail("<exception>", 0, "uncaught exception", e.what());
+    } catch (...) {
+        detail::fail("<exception>", 0, "uncaught exception", std::string());
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    result.seconds = elapsed.count();
+    result.checks = s.checks.load(std::memory_order_relaxed) - checksBefore;
+    {
+        std::lock_guard<std::mutex> lock(s.mutex);
+        s.current = nullptr;
+    }
+    return result;
+}
+
+//! Runs the registered cases selected by the command line. Returns 0 if every case passed.
+inline int run(int argc, char *argv[])
+{
+    bool list = false;
+    bool tests = true;
+    bool benchmarks = false;
+    std::string filter;
+    const char *json = nullptr;
+    const char *baselinePath = nullptr;
+    const char *savePath = nullptr;
+    const char *historyPath = nullptr;
+    std::string baselineLabel;
+    std::string label;
+    double threshold = 0.05;
+    double alpha = 0.01;
+    for (int i = 1; i < argc; ++i) {
+        const char *arg = argv[i];
+        if (!std::strcmp(arg, "--list")) {
+            list = true;
+        } else if (!std::strcmp(arg, "--bench")) {
+            benchmarks = true;
+        } else if (!std::strcmp(arg, "--perf")) {
+            state().perf = true;
+        } else if (!std::strcmp(arg, "--bench-only")) {
+            benchmarks = true;
+            tests = false;
+        } else if (!std::strcmp(arg, "--filter") && i + 1 < argc) {
+            filter = argv[++i];
+        } else if (!std::strcmp(arg, "--json") && i + 1 < argc) {
+            json = argv[++i];
+        } else if (!std::strcmp(arg, "--baseline") && i + 1 < argc) {
+            baselinePath = argv[++i];
+        } else if (!std::strcmp(arg, "--baseline-label") && i + 1 < argc) {
+            baselineLabel = argv[++i];
+        } else if (!std::strcmp(arg, "--save-baseline") && i + 1 < argc) {
+            savePath = argv[++i];
+        } else if (!std::strcmp(arg, "--label") && i + 1 < argc) {
+            label = argv[++i];
+        } else if (!std::strcmp(arg, "--history") && i + 1 < argc) {
+            historyPath = argv[++i];
+        } else if (!std::strcmp(arg, "--threshold") && i + 1 < argc) {
+            threshold = std::atof(argv[++i]) / 100.0;
+        } else if (!std::strcmp(arg, "--alpha") && i + 1 < argc) {
+            alpha = std::atof(argv[++i]);
+        } else {
+            std::fprintf(stderr, "unknown option: %s\n", arg);
+            return 2;
+        }
+    }
+
+    auto selected = [&filter](const std::string &name) {
+        return filter.empty() || name.find(filter) != std::string::npos;
+    };
+
+    if (historyPath) {
+        Baseline history;
+        std::string error;
+        if (!history.load(historyPath, &error)) {
+            std::fprintf(stderr, "%s\n", error.c_str());
+            return 2;
+        }
+        print_history(history, selected, threshold, alpha);
+        return 0;
+    }
+
+    Baseline baseline;
+    const BaselineRun *reference = nullptr;
+    if (baselinePath) {
+        std::string error;
+        if (!baseline.load(baselinePath, &error)) {
+            std::fprintf(stderr, "%s\n", error.c_str());
+            return 2;
+        }
+        reference = baseline.latest(baselineLabel);
+        if (!reference) {
+            std::fprintf(stderr, "%s: no run labelled \"%s\"\n", baselinePath, baselineLabel.c_str());
+            return 2;
+        }
+    }
+
+    if (state().perf && benchmarks && !list) {
+        PerfCounters probe;
+        if (!probe.isAvailable()) {
+            std::printf("hardware counters unavailable: %s (perf_event_paranoid is %d)\n",
+                        std::strerror(probe.error()), PerfCounters::paranoidLevel());
+        }
+    }
+
+    std::vector<CaseResult> results;
+    for (const Case &c : registry()) {
+        if (!selected(c.name))
+            continue;
+        if (c.bench ? !benchmarks : !tests)
+            continue;
+        if (list) {
+            std::printf("%s %s\n", c.bench ? "bench" : "test ", c.name.c_str());
+            continue;
+        }
+
+        results.push_back(run_case(c));
+        CaseResult &result = results.back();
+        if (result.benchmark) {
+            const BenchStats &s = result.stats;
+            std::printf("%-5s %-40s %10.2f min %10.2f median %10.2f p99 ns/op (%zu x %zu)\n",
+                        result.passed() ? "BENCH" : "FAIL", result.name.c_str(),
+                        s.min, s.median, s.p99, s.samples, s.iterations);
+            print_counters(s);
+            print_rates(s);
+            const BaselineEntry *entry = reference ? reference->find(result.name) : nullptr;
+            if (entry && result.passed()) {
+                result.compared = true;
+                result.comparison = compare(entry->times, s.times, threshold, alpha);
+                print_comparison(result.comparison);
+            }
+        } else {
+            std::printf("%-5s %-40s %6zu checks %10.3f ms\n", result.passed() ? "PASS" : "FAIL",
+                        result.name.c_str(), result.checks, result.seconds * 1e3);
+        }
+        std::fflush(stdout);
+    }
+    if (list)
+        return 0;
+
+    std::size_t failed = 0;
+    std::size_t regressions = 0;
+    for (const auto &result : results) {
+        failed += result.passed() ? 0 : 1;
+        regressions += result.compared && result.comparison.verdict == Comparison::Regression ? 1 : 0;
+    }
+    if (reference) {
+        std::printf("%zu passed, %zu failed, %zu regressed against run %u %s\n", results.size() - failed,
+                    failed, regressions, reference->id, reference->label.c_str());
+    } else {
+        std::printf("%zu passed, %zu failed\n", results.size() - failed, failed);
+    }
+
+    if (savePath) {
+        BaselineRun run;
+        run.label = label;
+        for (const auto &result : results) {
+            if (result.benchmark && result.passed())
+                run.entries.push_back({result.name, result.stats.iterations, result.stats.times});
+        }
+        Baseline saved;
+        if (std::ifstream(savePath).good() && !saved.load(savePath)) {
+            std::fprintf(stderr, "%s: not a baseline file, not overwriting it\n", savePath);
+            return 2;
+        }
+        if (run.entries.empty()) {
+            std::fprintf(stderr, "no benchmark results to save\n");
+        } else if (!saved.append(savePath, std::move(run))) {
+            std::fprintf(stderr, "cannot write %s\n", savePath);
+            return 2;
+        }
+    }
+
+    if (json) {
+        const bool toStdout = !std::strcmp(json, "-");
+        std::FILE *out = toStdout ? stdout : std::fopen(json, "w");
+        if (!out) {
+            std::fprintf(stderr, "cannot write %s\n", json);
+            return 2;
+        }
+        write_json(out, results);
+        if (!toStdout)
+            std::fclose(out);
+    }
+    return failed || regressions ? 1 : 0;
+}
+
+//! Runs the registered benchmark cases, as run() does with `--bench-only`. For programs that only
+//! benchmark.
+inline int run_benchmarks(int argc, char *argv[])
+{
+    std::vector<char *> args(argv, argv + argc);
+    static char benchOnly[] = "--bench-only";
+    args.insert(args.begin() + (argc > 0 ? 1 : 0), benchOnly);
+    return run(int(args.size()), args.data());
+}
+
+} // namespace qe_test
+
+//! Defines and registers a test case called \a name.
+#define QE_TEST_CASE(name) \
+    static void name(); \
+    static const ::qe_test::Registrar name##_registrar(#name, &name); \
+    static void name()
+
+//! Defines and registers a benchmark case called \a name. The body receives `qe_test::Bench &bench`.
+#define QE_BENCHMARK(name) \
+    static void name(::qe_test::Bench &); \
+    static const ::qe_test::Registrar name##_registrar(#name, &name); \
+    static void name(::qe_test::Bench &bench)
+
+/*!
+    \brief Replaces the global `operator new` and `operator delete` with versions that count calls
+    per thread. Use once, at namespace scope, in the file that defines main().
+
+    The over-aligned forms are not replaced, and their allocations are not counted.
+*/
+#define QE_TEST_COUNT_ALLOCATIONS \
+    void *operator new(std::size_t size) \
+    { \
+        if (void *ptr = ::qe_test::detail::counted_alloc(size)) \
+            return ptr; \
+        throw std::bad_alloc(); \
+    } \
+    void *operator new[](std::size_t size) { return ::operator new(size); } \
+    void *operator new(std::size_t size, const std::nothrow_t &) noexcept \
+    { \
+        return ::qe_test::detail::counted_alloc(size); \
+    } \
+    void *operator new[](std::size_t size, const std::nothrow_t &) noexcept \
+    { \
+        return ::qe_test::detail::counted_alloc(size); \
+    } \
+    void operator delete(void *ptr) noexcept { ::qe_test::detail::counted_free(ptr); } \
+    void operator delete[](void *ptr) noexcept { ::qe_test::detail::counted_free(ptr); } \
+    void operator delete(void *ptr, std::size_t) noexcept { ::qe_test::detail::counted_free(ptr); } \
+    void operator delete[](void *ptr, std::size_t) noexcept { ::qe_test::detail::counted_free(ptr); } \
+    static const bool qe_test_allocations_counted = (::qe_test::detail::allocation_counting() = true);
+
+#if defined(__GLIBC__)
+extern "C" void *__libc_malloc(std::size_t size);
+extern "C" void *__libc_calloc(std::size_t count, std::size_t size);
+extern "C" void *__libc_realloc(void *ptr, std::size_t size);
+extern "C" void __libc_free(void *ptr);
+
+/*!
+    \brief Counts `malloc`, `calloc` and `realloc` per thread instead of `operator new`, which also
+    counts allocations made by C code, Qt's containers and shared libraries. glibc only; use instead
+    of QE_TEST_COUNT_ALLOCATIONS, not with it.
+*/
+#define QE_TEST_COUNT_MALLOC \
+    extern "C" void *malloc(std::size_t size) \
+    { \
+        ++::qe_test::detail::t_allocations.allocations; \
+        return __libc_malloc(size); \
+    } \
+    extern "C" void *calloc(std::size_t count, std::size_t size) \
+    { \
+        ++::qe_test::detail::t_allocations.allocations; \
+        return __libc_calloc(count, size); \
+    } \
+    extern "C" void *realloc(void *ptr, std::size_t size) \
+    { \
+        ++::qe_test::detail::t_allocations.allocations; \
+        return __libc_realloc(ptr, size); \
+    } \
+    extern "C" void free(void *ptr) \
+    { \
+        if (ptr) \
+            ++::qe_test::detail::t_allocations.deallocations; \
+        __libc_free(ptr); \
+    } \
+    static const bool qe_test_allocations_counted = (::qe_test::detail::allocation_counting() = true);
+#endif
+
+#define QE_TEST_ALLOCATION_SCOPE(text, n) \
+    for (::qe_test::AllocationScope qe_allocation_scope(__FILE__, __LINE__, text, n); qe_allocation_scope.once(); )
+
+//! Checks that the statement or block that follows makes no heap allocations on the calling thread.
+#define QE_EXPECT_NO_ALLOC QE_TEST_ALLOCATION_SCOPE("QE_EXPECT_NO_ALLOC", 0)
+//! Checks that the statement or block that follows makes exactly \a n heap allocations on the calling thread.
+#define QE_EXPECT_ALLOCS(n) QE_TEST_ALLOCATION_SCOPE("QE_EXPECT_ALLOCS(" #n ")", n)
+
+#define QE_TEST_CHECK(predicate, text, ...) \
+    ::qe_test::detail::check(__FILE__, __LINE__, text, predicate, __VA_ARGS__)
+
+#define EXPECT_EQ(x, y) QE_TEST_CHECK(equal_check, "EXPECT_EQ(" #x ", " #y ")", x, y)
+#define EXPECT_NE(x, y) QE_TEST_CHECK(not_equal_check, "EXPECT_NE(" #x ", " #y ")", x, y)
+#define EXPECT_LT(x, y) QE_TEST_CHECK(less_than_check, "EXPECT_LT(" #x ", " #y ")", x, y)
+#define EXPECT_LE(x, y) QE_TEST_CHECK(less_than_or_equal_check, "EXPECT_LE(" #x ", " #y ")", x, y)
+#define EXPECT_GT(x, y) QE_TEST_CHECK(greater_than_check, "EXPECT_GT(" #x ", " #y ")", x, y)
+#define EXPECT_GE(x, y) QE_TEST_CHECK(greater_than_or_equal_check, "EXPECT_GE(" #x ", " #y ")", x, y)
+#define EXPECT_TRUE(x)  QE_TEST_CHECK(implicit_true_check, "EXPECT_TRUE(" #x ")", x)
+#define EXPECT_FALSE(x) QE_TEST_CHECK(implicit_false_check, "EXPECT_FALSE(" #x ")", x)
+#define EXPECT_FLAG(type, x, y) QE_TEST_CHECK(flag_check<type>, "EXPECT_FLAG(" #type ", " #x ", " #y ")", x, y)
 
 #endif // QE_TEST_TEST_H
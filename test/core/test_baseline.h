@@ -0,0 +1,145 @@
+/*  QExt: Extensions to Qt
+ *  Copyright (C) 2016  Jonathan Harper
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QE_TEST_BASELINE_TEST_H
+#define QE_TEST_BASELINE_TEST_H
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "baseline.h"
+#include "test.h"
+
+//! Checks the benchmark baseline file and the regression test used by `--baseline`.
+struct baseline_test
+{
+    static void run()
+    {
+        compare_test();
+        file_test();
+        malformed_test();
+    }
+
+    //! Returns \a count samples around \a centre with a few percent of deterministic noise.
+    static std::vector<double> samples(double centre, std::size_t count, std::uint32_t seed)
+    {
+        std::vector<double> ret;
+        for (std::size_t i = 0; i < count; ++i) {
+            seed = seed * 1664525u + 1013904223u;
+            ret.push_back(centre * (1.0 + double(seed >> 8) / double(1u << 24) * 0.04));
+        }
+        return ret;
+    }
+
+    static void compare_test()
+    {
+        using qe_test::Comparison;
+        const auto base = samples(100.0, 31, 1);
+
+        const Comparison same = qe_test::compare(base, samples(100.0, 31, 2));
+        EXPECT_EQ(same.verdict, Comparison::Unchanged);
+        EXPECT_GT(same.p, 0.01);
+        EXPECT_LE(same.low, 1.0);
+        EXPECT_GE(same.high, 1.0);
+
+        const Comparison slower = qe_test::compare(base, samples(130.0, 31, 3));
+        EXPECT_EQ(slower.verdict, Comparison::Regression);
+        EXPECT_LT(slower.p, 1e-6);
+        EXPECT_GT(slower.low, 1.2);
+        EXPECT_LT(slower.high, 1.4);
+
+        const Comparison faster = qe_test::compare(base, samples(70.0, 31, 4));
+        EXPECT_EQ(faster.verdict, Comparison::Improvement);
+
+        //significant, but smaller than the threshold
+        const Comparison small = qe_test::compare(base, samples(102.0, 31, 5), 0.05);
+        EXPECT_EQ(small.verdict, Comparison::Unchanged);
+        EXPECT_EQ(qe_test::compare(base, samples(102.0, 31, 5), 0.0, 0.5).verdict, Comparison::Regression);
+
+        //too few samples to be significant
+        EXPECT_EQ(qe_test::compare({100.0}, {200.0}).verdict, Comparison::Unchanged);
+        EXPECT_EQ(qe_test::compare({}, base).verdict, Comparison::Unchanged);
+    }
+
+    static void file_test()
+    {
+        const std::string path = "baseline_test.txt";
+        std::remove(path.c_str());
+
+        qe_test::Baseline baseline;
+        EXPECT_FALSE(baseline.load(path));
+
+        qe_test::BaselineRun first;
+        first.label = "abc123";
+        first.entries.push_back({"one", 100, {1.5, 2.25, 3.125}});
+        first.entries.push_back({"two", 7, {1e-3, 12345.678}});
+        EXPECT_TRUE(baseline.append(path, first));
+        qe_test::BaselineRun second;
+        second.entries.push_back({"one", 200, {4.0}});
+        EXPECT_TRUE(baseline.append(path, second));
+
+        qe_test::Baseline loaded;
+        std::string error;
+        EXPECT_TRUE(loaded.load(path, &error));
+        EXPECT_TRUE(error.empty());
+        EXPECT_EQ(loaded.runs().size(), 2u);
+        EXPECT_EQ(loaded.runs()[0].id, 1u);
+        EXPECT_EQ(loaded.runs()[1].id, 2u);
+        EXPECT_EQ(loaded.runs()[0].label, "abc123");
+        EXPECT_TRUE(loaded.runs()[1].label.empty());
+
+        const qe_test::BaselineEntry *two = loaded.runs()[0].find("two");
+        EXPECT_TRUE(two);
+        if (two) {
+            EXPECT_EQ(two->iterations, 7u);
+            EXPECT_TRUE(two->times == std::vector<double>({1e-3, 12345.678}));
+        }
+        EXPECT_FALSE(loaded.runs()[1].find("two"));
+
+        EXPECT_EQ(loaded.latest(), &loaded.runs()[1]);
+        EXPECT_EQ(loaded.latest("abc123"), &loaded.runs()[0]);
+        EXPECT_FALSE(loaded.latest("missing"));
+        std::remove(path.c_str());
+    }
+
+    static bool load_text(const char *text, std::string *error)
+    {
+        const std::string path = "baseline_test_malformed.txt";
+        std::ofstream(path) << text;
+        qe_test::Baseline baseline;
+        const bool ret = baseline.load(path, error);
+        std::remove(path.c_str());
+        return ret;
+    }
+
+    static void malformed_test()
+    {
+        std::string error;
+        EXPECT_TRUE(load_text("# comment\nversion 1\n", &error));
+        EXPECT_FALSE(load_text("version 2\n", &error));
+        EXPECT_NE(error.find("version 2"), std::string::npos);
+        EXPECT_FALSE(load_text("run 1 0\n", &error));
+        EXPECT_FALSE(load_text("version 1\nrun 1 0\none 10 1.0\n", &error));
+        EXPECT_FALSE(load_text("version 1\nrun 1 0\none 10 1.0 x\nend\n", &error));
+        EXPECT_FALSE(load_text("version 1\nrun 1 0\none 10\nend\n", &error));
+        EXPECT_TRUE(load_text("version 1\nrun 1 0 a label with spaces\none 10 1.0\nend\n", &error));
+    }
+};
+
+#endif // QE_TEST_BASELINE_TEST_H
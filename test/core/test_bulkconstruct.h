@@ -0,0 +1,272 @@
+/*  QExt: Extensions to Qt
+ *  Copyright (C) 2016  Jonathan Harper
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QE_TEST_BULKCONSTRUCT_H
+#define QE_TEST_BULKCONSTRUCT_H
+
+#include <stdexcept>
+#include <utility>
+#include <qecore/bulkconstruct.h>
+#include "test.h"
+
+class BulkItemPrivate;
+class BulkItem : public qe::PublicBase
+{
+public:
+    explicit BulkItem(int value);
+    BulkItem(BulkItem &&other) noexcept : qe::PublicBase(std::move(other)) { ++instances; }
+    BulkItem &operator=(BulkItem &&other) noexcept = default;
+    ~BulkItem();
+
+    int value() const;
+    BulkItemPrivate *privatePointer() { return qe_d_func(); }
+
+    static int instances;
+
+protected:
+    BulkItem(BulkItemPrivate &dd, int scale = 1);
+
+private:
+    QE_DECLARE_PRIVATE(BulkItem)
+};
+
+class BulkItemPrivate : public qe::PrivateBase
+{
+    QE_DECLARE_PUBLIC(BulkItem)
+public:
+    BulkItemPrivate(qe::PublicBase *qq) : qe::PrivateBase(qq) { ++instances; }
+    ~BulkItemPrivate() { --instances; }
+
+    BulkItem *publicPointer() { return qe_q_func(); }
+
+    int value = 0;
+    int scale = 1;
+    static int instances;
+};
+
+int BulkItem::instances = 0;
+int BulkItemPrivate::instances = 0;
+
+BulkItem::BulkItem(int value)
+    : BulkItem(*new BulkItemPrivate(this))
+{
+    QE_D;
+    d->value = value;
+}
+
+BulkItem::BulkItem(BulkItemPrivate &dd, int scale)
+    : qe::PublicBase(dd)
+{
+    QE_D;
+    d->scale = scale;
+    ++instances;
+}
+
+BulkItem::~BulkItem()
+{
+    --instances;
+}
+
+int BulkItem::value() const
+{
+    QE_CD;
+    return d->value * d->scale;
+}
+
+//! Throws from the constructor of the \a throwAt-th instance, either from a base constructed
+//! before qe::PublicBase (\a early) or after it.
+class ThrowingItemPrivate;
+class ThrowingItem : private std::pair<int, int>, public qe::PublicBase
+{
+public:
+    ~ThrowingItem() = default;
+
+    static int constructed;
+
+protected:
+    ThrowingItem(ThrowingItemPrivate &dd, int throwAt, bool early);
+
+private:
+    static std::pair<int, int> checkEarly(int throwAt, bool early)
+    {
+        if (early && constructed == throwAt)
+            throw std::runtime_error("early");
+        return {};
+    }
+
+    QE_DECLARE_PRIVATE(ThrowingItem)
+};
+
+class ThrowingItemPrivate : public qe::PrivateBase
+{
+    QE_DECLARE_PUBLIC(ThrowingItem)
+public:
+    ThrowingItemPrivate(qe::PublicBase *qq) : qe::PrivateBase(qq) { ++created; }
+    ~ThrowingItemPrivate() { ++destroyed; }
+
+    static int created;
+    static int destroyed;
+};
+
+int ThrowingItem::constructed = 0;
+int ThrowingItemPrivate::created = 0;
+int ThrowingItemPrivate::destroyed = 0;
+
+ThrowingItem::ThrowingItem(ThrowingItemPrivate &dd, int throwAt, bool early)
+    : std::pair<int, int>(checkEarly(throwAt, early)), qe::PublicBase(dd)
+{
+    if (!early && constructed == throwAt)
+        throw std::runtime_error("late");
+    ++constructed;
+}
+
+struct bulk_construct_test
+{
+    static void run()
+    {
+        heap_construct_test();
+        slab_construct_test();
+        private_only_test();
+        move_test();
+        slab_move_test();
+        throwing_test();
+    }
+
+    //! The regular, one-allocation-per-object path must be unchanged.
+    static void heap_construct_test()
+    {
+        {
+            BulkItem item(5);
+            EXPECT_EQ(5, item.value());
+            EXPECT_EQ(1, BulkItem::instances);
+            EXPECT_EQ(1, BulkItemPrivate::instances);
+        }
+        EXPECT_EQ(0, BulkItem::instances);
+        EXPECT_EQ(0, BulkItemPrivate::instances);
+    }
+
+    static void slab_construct_test()
+    {
+        {
+            auto items = qe::constructBulk<BulkItem>(100, [](BulkItem &item, std::size_t i) {
+                item.privatePointer()->value = static_cast<int>(i);
+            }, 2);
+            EXPECT_EQ(100u, items.size());
+            EXPECT_TRUE(items.isPublicInSlab());
+            EXPECT_EQ(100, BulkItem::instances);
+            EXPECT_EQ(100, BulkItemPrivate::instances);
+
+            for (std::size_t i = 0; i < items.size(); ++i) {
+                EXPECT_EQ(static_cast<int>(i) * 2, items[i].value());
+                //the q-ptr is bound to the public object and the privates are contiguous
+                EXPECT_EQ(&items[i], items.privateAt(i).publicPointer());
+                EXPECT_EQ(items.privateData() + i, items[i].privatePointer());
+            }
+        }
+        EXPECT_EQ(0, BulkItem::instances);
+        EXPECT_EQ(0, BulkItemPrivate::instances);
+    }
+
+    static void private_only_test()
+    {
+        {
+            auto items = qe::constructBulk<BulkItem, qe::BulkLayout::PrivateOnly>(10,
+                [](BulkItem &item, std::size_t i) {
+                    item.privatePointer()->value = static_cast<int>(i);
+                });
+            EXPECT_FALSE(items.isPublicInSlab());
+            EXPECT_EQ(10, BulkItem::instances);
+            EXPECT_EQ(9, items[9].value());
+            EXPECT_EQ(&items[3], items.privateAt(3).publicPointer());
+        }
+        EXPECT_EQ(0, BulkItem::instances);
+        EXPECT_EQ(0, BulkItemPrivate::instances);
+    }
+
+    static void move_test()
+    {
+        auto items = qe::constructBulk<BulkItem>(4, [](BulkItem &, std::size_t) {});
+        BulkItem *first = &items[0];
+
+        qe::BulkStorage<BulkItem> other(std::move(items));
+        EXPECT_TRUE(items.isEmpty());
+        EXPECT_EQ(4u, other.size());
+        EXPECT_EQ(first, &other[0]);
+
+        other.clear();
+        EXPECT_TRUE(other.isEmpty());
+        EXPECT_EQ(0, BulkItem::instances);
+        EXPECT_EQ(0, BulkItemPrivate::instances);
+    }
+
+    //! Moving a public object out of the slab leaves its private class in place, owned by the object
+    //! moved to, which is destroyed before the storage. A heap private class moved into the slab
+    //! is still deleted.
+    static void slab_move_test()
+    {
+        {
+            auto items = qe::constructBulk<BulkItem>(3, [](BulkItem &item, std::size_t i) {
+                item.privatePointer()->value = static_cast<int>(i) + 1;
+            });
+            {
+                BulkItem moved(std::move(items[1]));
+                EXPECT_EQ(2, moved.value());
+                EXPECT_EQ(&items.privateAt(1), moved.privatePointer());
+                EXPECT_EQ(&moved, items.privateAt(1).publicPointer());
+                EXPECT_TRUE(items[1].privatePointer() == nullptr);
+
+                items[2] = BulkItem(7);
+                EXPECT_EQ(7, items[2].value());
+                EXPECT_EQ(&items[2], items[2].privatePointer()->publicPointer());
+                EXPECT_EQ(3, BulkItemPrivate::instances);
+            }
+            EXPECT_EQ(2, BulkItemPrivate::instances);
+            EXPECT_EQ(3, BulkItem::instances);
+        }
+        EXPECT_EQ(0, BulkItem::instances);
+        EXPECT_EQ(0, BulkItemPrivate::instances);
+    }
+
+    //! Each private class is destroyed exactly once when a public constructor throws, whether or
+    //! not qe::PublicBase had taken ownership of it.
+    template <qe::BulkLayout Layout>
+    static void throwing_case(bool early)
+    {
+        ThrowingItem::constructed = 0;
+        ThrowingItemPrivate::created = 0;
+        ThrowingItemPrivate::destroyed = 0;
+        bool thrown = false;
+        try {
+            qe::constructBulk<ThrowingItem, Layout>(8, [](ThrowingItem &, std::size_t) {}, 5, early);
+        } catch (const std::runtime_error &) {
+            thrown = true;
+        }
+        EXPECT_TRUE(thrown);
+        EXPECT_EQ(6, ThrowingItemPrivate::created);
+        EXPECT_EQ(6, ThrowingItemPrivate::destroyed);
+    }
+
+    static void throwing_test()
+    {
+        throwing_case<qe::BulkLayout::PublicAndPrivate>(false);
+        throwing_case<qe::BulkLayout::PublicAndPrivate>(true);
+        throwing_case<qe::BulkLayout::PrivateOnly>(false);
+        throwing_case<qe::BulkLayout::PrivateOnly>(true);
+    }
+};
+
+#endif // QE_TEST_BULKCONSTRUCT_H
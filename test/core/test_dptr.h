@@ -0,0 +1,174 @@
+/*  QExt: Extensions to Qt
+ *  Copyright (C) 2016  Jonathan Harper
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QE_TEST_DPTR_H
+#define QE_TEST_DPTR_H
+
+#include <algorithm>
+#include <type_traits>
+#include <vector>
+#include <qecore/dptr.h>
+#include "test.h"
+
+class MovableValuePrivate;
+class MovableValue : public qe::PublicBase
+{
+public:
+    explicit MovableValue(int value);
+    ~MovableValue();
+    QE_DECLARE_MOVABLE(MovableValue)
+
+    int value() const;
+    bool isBound() const;
+    bool isNull() const { return !qed_ptr; }
+
+private:
+    QE_DECLARE_PRIVATE(MovableValue)
+};
+
+class MovableValuePrivate : public qe::PrivateBase
+{
+    QE_DECLARE_PUBLIC(MovableValue)
+public:
+    MovableValuePrivate(qe::PublicBase *qq) : qe::PrivateBase(qq) { ++instances; }
+    ~MovableValuePrivate() { --instances; }
+
+    const MovableValue *publicPointer() const { return qe_cq_func(); }
+
+    int value = 0;
+    static int instances;
+};
+
+int MovableValuePrivate::instances = 0;
+
+MovableValue::MovableValue(int value)
+    : qe::PublicBase(*new MovableValuePrivate(this))
+{
+    QE_D;
+    d->value = value;
+}
+
+MovableValue::~MovableValue()
+{
+}
+
+int MovableValue::value() const
+{
+    QE_CD;
+    return d->value;
+}
+
+bool MovableValue::isBound() const
+{
+    QE_CD;
+    return d->publicPointer() == this;
+}
+
+struct dptr_test
+{
+    static void run()
+    {
+        move_construct_test();
+        move_assign_test();
+        container_test();
+        reallocation_test();
+    }
+
+    static void move_construct_test()
+    {
+        static_assert(std::is_nothrow_move_constructible<MovableValue>::value, "");
+        static_assert(std::is_nothrow_move_assignable<MovableValue>::value, "");
+        static_assert(!std::is_copy_constructible<MovableValue>::value, "");
+        {
+            MovableValue a(1);
+            EXPECT_TRUE(a.isBound());
+
+            MovableValue b(std::move(a));
+            EXPECT_TRUE(a.isNull());
+            EXPECT_TRUE(b.isBound());
+            EXPECT_EQ(1, b.value());
+            EXPECT_EQ(1, MovableValuePrivate::instances);
+        }
+        EXPECT_EQ(0, MovableValuePrivate::instances);
+    }
+
+    static void move_assign_test()
+    {
+        {
+            MovableValue a(1);
+            MovableValue b(2);
+            EXPECT_EQ(2, MovableValuePrivate::instances);
+
+            b = std::move(a);
+            //the private class previously owned by b is destroyed
+            EXPECT_EQ(1, MovableValuePrivate::instances);
+            EXPECT_TRUE(a.isNull());
+            EXPECT_TRUE(b.isBound());
+            EXPECT_EQ(1, b.value());
+        }
+        EXPECT_EQ(0, MovableValuePrivate::instances);
+    }
+
+    static void container_test()
+    {
+        {
+            std::vector<MovableValue> values;
+            for (int i = 0; i < 64; ++i)
+                values.emplace_back(63 - i);
+            EXPECT_EQ(64, MovableValuePrivate::instances);
+
+            std::sort(values.begin(), values.end(), [](const MovableValue &lhs, const MovableValue &rhs) {
+                return lhs.value() < rhs.value();
+            });
+            for (int i = 0; i < 64; ++i) {
+                EXPECT_EQ(i, values[i].value());
+                EXPECT_TRUE(values[i].isBound());
+            }
+            EXPECT_EQ(64, MovableValuePrivate::instances);
+        }
+        EXPECT_EQ(0, MovableValuePrivate::instances);
+    }
+
+    //! std::vector moves, rather than copies, QE_DECLARE_MOVABLE classes when it grows, and each
+    //! private class follows its public object to the new storage.
+    static void reallocation_test()
+    {
+        {
+            std::vector<MovableValue> values;
+            values.reserve(4);
+            int reallocations = 0;
+            for (int i = 0; i < 100; ++i) {
+                const MovableValue *data = values.data();
+                const std::size_t capacity = values.capacity();
+                values.emplace_back(i);
+                if (values.capacity() != capacity) {
+                    EXPECT_TRUE(values.data() != data);
+                    ++reallocations;
+                }
+                EXPECT_EQ(i + 1, MovableValuePrivate::instances);
+            }
+            EXPECT_GT(reallocations, 0);
+            for (int i = 0; i < 100; ++i) {
+                EXPECT_EQ(i, values[std::size_t(i)].value());
+                EXPECT_TRUE(values[std::size_t(i)].isBound());
+            }
+        }
+        EXPECT_EQ(0, MovableValuePrivate::instances);
+    }
+};
+
+#endif // QE_TEST_DPTR_H
@@ -0,0 +1,97 @@
+/*  QExt: Extensions to Qt
+ *  Copyright (C) 2016  Jonathan Harper
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QE_TEST_HEXENCODE_H
+#define QE_TEST_HEXENCODE_H
+
+#include <cstring>
+#include <string>
+#include <vector>
+#include "../../src/core/debugutil_p.h"
+#include "test.h"
+
+struct hex_encode_test
+{
+    static void run()
+    {
+        known_value_test();
+        level_agreement_test();
+        printable_test();
+    }
+
+    static std::string encode(const std::vector<unsigned char> &in, bool upper, qe::detail::SimdLevel level)
+    {
+        std::string out(in.size() * 2, '\0');
+        qe::detail::hexEncode(in.data(), in.size(), &out[0], upper, level);
+        return out;
+    }
+
+    static std::vector<qe::detail::SimdLevel> supportedLevels()
+    {
+        std::vector<qe::detail::SimdLevel> levels{qe::detail::SimdLevel::Scalar};
+#ifdef QE_SIMD_X86
+        levels.push_back(qe::detail::SimdLevel::SSE2);
+        if (qe::detail::simdLevel() == qe::detail::SimdLevel::AVX2)
+            levels.push_back(qe::detail::SimdLevel::AVX2);
+#endif
+        return levels;
+    }
+
+    static void known_value_test()
+    {
+        const std::vector<unsigned char> in{0x00, 0x09, 0x0a, 0x7f, 0x80, 0xab, 0xff};
+        for (auto level : supportedLevels()) {
+            EXPECT_TRUE(encode(in, false, level) == "00090a7f80abff");
+            EXPECT_TRUE(encode(in, true, level) == "00090A7F80ABFF");
+        }
+    }
+
+    //! Every vector path must match the scalar path, including the scalar tails.
+    static void level_agreement_test()
+    {
+        std::vector<unsigned char> in;
+        unsigned seed = 1;
+        for (std::size_t n = 0; n <= 200; ++n) {
+            const std::string lower = encode(in, false, qe::detail::SimdLevel::Scalar);
+            const std::string upper = encode(in, true, qe::detail::SimdLevel::Scalar);
+            for (auto level : supportedLevels()) {
+                EXPECT_TRUE(encode(in, false, level) == lower);
+                EXPECT_TRUE(encode(in, true, level) == upper);
+            }
+            seed = seed * 1103515245u + 12345u;
+            in.push_back(static_cast<unsigned char>(seed >> 16));
+        }
+    }
+
+    static void printable_test()
+    {
+        std::vector<unsigned char> in(256);
+        for (int i = 0; i < 256; ++i)
+            in[i] = static_cast<unsigned char>(i);
+        std::string expected(256, '.');
+        for (int i = 0x20; i < 0x7F; ++i)
+            expected[i] = static_cast<char>(i);
+
+        for (auto level : supportedLevels()) {
+            std::string out(256, '\0');
+            qe::detail::printable(in.data(), in.size(), &out[0], level);
+            EXPECT_TRUE(out == expected);
+        }
+    }
+};
+
+#endif // QE_TEST_HEXENCODE_H
@@ -0,0 +1,154 @@
+/*  QExt: Extensions to Qt
+ *  Copyright (C) 2016  Jonathan Harper
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QE_TEST_LOGRING_H
+#define QE_TEST_LOGRING_H
+
+#include <cstring>
+#include <thread>
+#include "../../src/core/debugwriter_p.h"
+#include "test.h"
+
+struct log_ring_test
+{
+    static void run()
+    {
+        round_trip_test();
+        wrap_test();
+        drop_test();
+        concurrent_test();
+    }
+
+    static void round_trip_test()
+    {
+        qe::detail::LogRing ring(4096);
+        const char16_t utf16[] = u"wide";
+        const qe::detail::LogArg args[] = {
+            qe::detail::makeLogArg(-42),
+            qe::detail::makeLogArg(42u),
+            qe::detail::makeLogArg(0.5),
+            qe::detail::makeLogArg(true),
+            qe::detail::makeLogArg("narrow"),
+            qe::detail::makeLogArg(utf16, 4)
+        };
+        EXPECT_TRUE(qe::detail::writeLogRecord(ring, 7, 123, args, 6));
+
+        int records = 0;
+        ring.consume([&](const qe::detail::LogRecordHeader &header, const char *payload) {
+            ++records;
+            EXPECT_EQ(7, header.formatId);
+            EXPECT_EQ(6, header.argCount);
+            EXPECT_EQ(123, header.timestamp);
+            qe::detail::LogArg arg;
+            payload = qe::detail::decodeArg(payload, arg);
+            EXPECT_EQ(-42, arg.i);
+            payload = qe::detail::decodeArg(payload, arg);
+            EXPECT_EQ(42u, arg.u);
+            payload = qe::detail::decodeArg(payload, arg);
+            EXPECT_EQ(0.5, arg.d);
+            payload = qe::detail::decodeArg(payload, arg);
+            EXPECT_EQ(qe::detail::LogArg::Bool, arg.type);
+            payload = qe::detail::decodeArg(payload, arg);
+            EXPECT_EQ(6u, arg.length);
+            EXPECT_EQ(0, std::memcmp(arg.data, "narrow", 6));
+            payload = qe::detail::decodeArg(payload, arg);
+            EXPECT_EQ(qe::detail::LogArg::Utf16, arg.type);
+            EXPECT_EQ(0, std::memcmp(arg.data, utf16, 8));
+        });
+        EXPECT_EQ(1, records);
+        EXPECT_TRUE(ring.isEmpty());
+    }
+
+    //! Records must never straddle the end of the ring.
+    static void wrap_test()
+    {
+        qe::detail::LogRing ring(4096);
+        std::int64_t next = 0;
+        std::int64_t expected = 0;
+        for (int round = 0; round < 100; ++round) {
+            for (int i = 0; i < 7; ++i) {
+                const qe::detail::LogArg arg = qe::detail::makeLogArg(next);
+                EXPECT_TRUE(qe::detail::writeLogRecord(ring, 1, next, &arg, 1));
+                ++next;
+            }
+            ring.consume([&](const qe::detail::LogRecordHeader &header, const char *payload) {
+                qe::detail::LogArg arg;
+                qe::detail::decodeArg(payload, arg);
+                EXPECT_EQ(expected, header.timestamp);
+                EXPECT_EQ(expected, arg.i);
+                ++expected;
+            });
+        }
+        EXPECT_EQ(next, expected);
+        EXPECT_EQ(0u, ring.dropped());
+    }
+
+    static void drop_test()
+    {
+        qe::detail::LogRing ring(4096);
+        const qe::detail::LogArg arg = qe::detail::makeLogArg(1);
+        int written = 0;
+        while (qe::detail::writeLogRecord(ring, 1, 0, &arg, 1))
+            ++written;
+        EXPECT_EQ(4096 / 32, written);
+        EXPECT_EQ(1u, ring.dropped());
+
+        //oversized records are dropped rather than written
+        char big[2048] = {};
+        big[sizeof(big) - 1] = '\0';
+        std::memset(big, 'x', sizeof(big) - 1);
+        qe::detail::LogRing other(4096);
+        const qe::detail::LogArg text = qe::detail::makeLogArg(static_cast<const char *>(big));
+        EXPECT_FALSE(qe::detail::writeLogRecord(other, 1, 0, &text, 1));
+        EXPECT_EQ(1u, other.dropped());
+    }
+
+    //! One producer and one consumer; every record is seen once and in order, or counted as dropped.
+    static void concurrent_test()
+    {
+        qe::detail::LogRing ring(4096);
+        const std::int64_t total = 200000;
+        std::atomic<bool> done{false};
+        std::int64_t seen = 0;
+        std::int64_t last = -1;
+        bool ordered = true;
+
+        std::thread consumer([&] {
+            auto take = [&] {
+                ring.consume([&](const qe::detail::LogRecordHeader &header, const char *) {
+                    ordered = ordered && header.timestamp > last;
+                    last = header.timestamp;
+                    ++seen;
+                });
+            };
+            while (!done.load(std::memory_order_acquire))
+                take();
+            take();
+        });
+        for (std::int64_t i = 0; i < total; ++i) {
+            const qe::detail::LogArg arg = qe::detail::makeLogArg(i);
+            qe::detail::writeLogRecord(ring, 1, i, &arg, 1);
+        }
+        done.store(true, std::memory_order_release);
+        consumer.join();
+
+        EXPECT_TRUE(ordered);
+        EXPECT_EQ(total, seen + std::int64_t(ring.dropped()));
+    }
+};
+
+#endif // QE_TEST_LOGRING_H
@@ -91,6 +91,7 @@ struct managed_pointer_test
     {
         empty_pointer_test();
         basic_pointer_test();
+        allocation_test();
     }
 
     //! Basic `nullptr` tests
@@ -183,6 +184,37 @@ struct managed_pointer_test
 
         EXPECT_EQ(0, Dummy::instances);
     }
+
+    //! Moves and swaps must not allocate; a copy allocates exactly once, through the manager.
+    static void allocation_test()
+    {
+        {
+            using pointer = ManagedPointer<Dummy2, DefaultManager<Dummy2>>;
+            pointer xPtr(new Dummy2(123));
+            pointer yPtr(new Dummy2(234));
+
+            QE_EXPECT_NO_ALLOC {
+                pointer zPtr(std::move(xPtr));
+                xPtr = std::move(zPtr);
+                xPtr.swap(yPtr);
+                std::swap(xPtr, yPtr);
+            }
+            EXPECT_EQ(123, xPtr->value);
+            EXPECT_EQ(234, yPtr->value);
+
+            QE_EXPECT_ALLOCS(1) {
+                pointer zPtr(xPtr);
+                qe_test::keep(zPtr);
+            }
+            QE_EXPECT_ALLOCS(1) {
+                yPtr = xPtr;
+                qe_test::keep(yPtr);
+            }
+            EXPECT_EQ(123, yPtr->value);
+            EXPECT_EQ(2, Dummy::instances);
+        }
+        EXPECT_EQ(0, Dummy::instances);
+    }
 };
 
 #endif // QE_TEST_MANAGEDPOINTER_H
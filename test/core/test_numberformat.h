@@ -0,0 +1,123 @@
+/*  QExt: Extensions to Qt
+ *  Copyright (C) 2016  Jonathan Harper
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QE_TEST_NUMBERFORMAT_H
+#define QE_TEST_NUMBERFORMAT_H
+
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <qecore/type_util.h>
+#include "../../src/core/debugutil_p.h"
+#include "test.h"
+
+//! Checks the char kernels behind qe::formatInto against the output of QString::number.
+struct number_format_test
+{
+    static void run()
+    {
+        integer_test();
+#ifdef QE_HAS_FLOAT_TO_CHARS
+        shortest_test();
+        precision_test();
+#endif
+    }
+
+    template <class T>
+    static std::string integer(T value, int base = 10)
+    {
+        char buffer[qe::detail::NumberChars];
+        return std::string(buffer, qe::detail::formatInteger(buffer, buffer + sizeof(buffer), value, base));
+    }
+
+    static void integer_test()
+    {
+        EXPECT_TRUE(integer(0) == "0");
+        EXPECT_TRUE(integer(-42) == "-42");
+        EXPECT_TRUE(integer(std::numeric_limits<std::int64_t>::min()) == "-9223372036854775808");
+        EXPECT_TRUE(integer(std::numeric_limits<std::uint64_t>::max()) == "18446744073709551615");
+        EXPECT_TRUE(integer(255, 16) == "ff");
+        EXPECT_TRUE(integer(-255, 16) == "-ff");
+        EXPECT_TRUE(integer(5u, 2) == "101");
+        EXPECT_TRUE(integer(35, 36) == "z");
+        //bases outside 2-36 fall back to 10
+        EXPECT_TRUE(integer(35, 37) == "35");
+        EXPECT_TRUE(integer(-35, 1) == "-35");
+        EXPECT_TRUE(integer(35u, 0) == "35");
+        EXPECT_TRUE(integer(35, -16) == "35");
+        static_assert(qe::detail::isValidBase(2) && qe::detail::isValidBase(36), "");
+        static_assert(!qe::detail::isValidBase(1) && !qe::detail::isValidBase(37), "");
+        static_assert(qe::detail::is_formattable_integer<short>::value, "");
+        static_assert(!qe::detail::is_formattable_integer<char>::value, "");
+        static_assert(!qe::detail::is_formattable_integer<bool>::value, "");
+    }
+
+#ifdef QE_HAS_FLOAT_TO_CHARS
+    static std::string shortest(double value)
+    {
+        char buffer[qe::detail::NumberChars];
+        return std::string(buffer, qe::detail::formatShortest(buffer, buffer + sizeof(buffer), value));
+    }
+
+    static std::string number(double value, char format, int precision)
+    {
+        char buffer[qe::detail::NumberChars];
+        char *end = qe::detail::formatDouble(buffer, buffer + sizeof(buffer), value, format, precision);
+        return end ? std::string(buffer, end) : std::string("<null>");
+    }
+
+    static void shortest_test()
+    {
+        EXPECT_TRUE(shortest(0.0) == "0");
+        EXPECT_TRUE(shortest(0.5) == "0.5");
+        EXPECT_TRUE(shortest(-1.5) == "-1.5");
+        EXPECT_TRUE(shortest(0.1 + 0.2) == "0.30000000000000004");
+        EXPECT_TRUE(shortest(12345.0) == "12345");
+        EXPECT_TRUE(shortest(1234567.0) == "1234567");
+        EXPECT_TRUE(shortest(1200000.0) == "1200000");
+        EXPECT_TRUE(shortest(100000.0) == "1e+05");
+        EXPECT_TRUE(shortest(1e21) == "1e+21");
+        EXPECT_TRUE(shortest(0.001) == "0.001");
+        EXPECT_TRUE(shortest(0.0001) == "1e-04");
+        EXPECT_TRUE(shortest(0.00012) == "0.00012");
+        EXPECT_TRUE(shortest(1.7976931348623157e308) == "1.7976931348623157e+308");
+        EXPECT_TRUE(shortest(std::numeric_limits<double>::infinity()) == "inf");
+        EXPECT_TRUE(shortest(-std::numeric_limits<double>::infinity()) == "-inf");
+        EXPECT_TRUE(shortest(std::numeric_limits<double>::quiet_NaN()) == "nan");
+
+        char small[8];
+        EXPECT_TRUE(qe::detail::formatShortest(small, small + sizeof(small), 1.0) == nullptr);
+    }
+
+    static void precision_test()
+    {
+        EXPECT_TRUE(number(0.5, 'g', 2) == "0.5");
+        EXPECT_TRUE(number(1.0, 'g', 2) == "1");
+        EXPECT_TRUE(number(0.333333, 'g', 2) == "0.33");
+        EXPECT_TRUE(number(123.0, 'g', 2) == "1.2e+02");
+        EXPECT_TRUE(number(123.0, 'G', 2) == "1.2E+02");
+        EXPECT_TRUE(number(3.14159, 'f', 2) == "3.14");
+        EXPECT_TRUE(number(2.0, 'f', 0) == "2");
+        EXPECT_TRUE(number(1234.5, 'e', 3) == "1.234e+03");
+        EXPECT_TRUE(number(std::numeric_limits<double>::infinity(), 'G', 6) == "INF");
+        EXPECT_TRUE(number(1.0, 'x', 2) == "<null>");
+        EXPECT_TRUE(number(1e300, 'f', 2) == "<null>");
+    }
+#endif
+};
+
+#endif // QE_TEST_NUMBERFORMAT_H
@@ -0,0 +1,130 @@
+/*  QExt: Extensions to Qt
+ *  Copyright (C) 2016  Jonathan Harper
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QE_TEST_SEQLOCK_H
+#define QE_TEST_SEQLOCK_H
+
+#include <atomic>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <qecore/seqlock.h>
+#include "test.h"
+
+class SharedPairPrivate;
+class SharedPair : public qe::PublicBase
+{
+public:
+    SharedPair();
+
+    //! Returns both fields in one consistent read.
+    std::pair<int, int> values() const;
+    int first() const;
+    void set(int value);
+
+private:
+    QE_DECLARE_PRIVATE(SharedPair)
+};
+
+class SharedPairPrivate : public qe::SeqLockedPrivate
+{
+    QE_DECLARE_PUBLIC(SharedPair)
+public:
+    SharedPairPrivate(qe::PublicBase *qq) : qe::SeqLockedPrivate(qq) {}
+
+    int first = 0;
+    int second = 0; //always -first
+};
+
+SharedPair::SharedPair()
+    : qe::PublicBase(*new SharedPairPrivate(this))
+{
+}
+
+std::pair<int, int> SharedPair::values() const
+{
+    return QE_CD_READ(std::make_pair(d->first, d->second));
+}
+
+int SharedPair::first() const
+{
+    return QE_CD_READ(d->first);
+}
+
+void SharedPair::set(int value)
+{
+    QE_D;
+    qe::SeqWriteLocker lock(d);
+    d->first = value;
+    d->second = -value;
+}
+
+struct seqlock_test
+{
+    static void run()
+    {
+        single_thread_test();
+        concurrent_test();
+    }
+
+    static void single_thread_test()
+    {
+        SharedPair pair;
+        EXPECT_EQ(0, pair.first());
+        pair.set(5);
+        EXPECT_EQ(5, pair.values().first);
+        EXPECT_EQ(-5, pair.values().second);
+    }
+
+    //! Readers must never observe a half-written pair.
+    static void concurrent_test()
+    {
+        SharedPair pair;
+        std::atomic<bool> done{false};
+        std::atomic<int> torn{0};
+
+        std::vector<std::thread> readers;
+        for (int i = 0; i < 3; ++i) {
+            readers.emplace_back([&] {
+                while (!done.load(std::memory_order_relaxed)) {
+                    auto v = pair.values();
+                    if (v.first != -v.second)
+                        ++torn;
+                }
+            });
+        }
+        std::thread writer([&] {
+            for (int i = 0; i < 100000; ++i)
+                pair.set(i);
+        });
+        std::thread writer2([&] {
+            for (int i = 0; i < 100000; ++i)
+                pair.set(-i);
+        });
+        writer.join();
+        writer2.join();
+        done = true;
+        for (auto &t : readers)
+            t.join();
+
+        EXPECT_EQ(0, torn.load());
+        auto v = pair.values();
+        EXPECT_EQ(v.first, -v.second);
+    }
+};
+
+#endif // QE_TEST_SEQLOCK_H
@@ -0,0 +1,79 @@
+/*  QExt: Extensions to Qt
+ *  Copyright (C) 2016  Jonathan Harper
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QE_TEST_TYPEUTIL_H
+#define QE_TEST_TYPEUTIL_H
+
+#include <qecore/type_util.h>
+#include "test.h"
+
+namespace type_util_test_ns {
+struct Widget {};
+template <class T> struct Box {};
+}
+
+struct type_util_test
+{
+    static void run()
+    {
+        name_test();
+        id_test();
+        switch_test();
+    }
+
+    static void name_test()
+    {
+        static_assert(qe::type_name<int>() == "int", "");
+        static_assert(qe::type_name<void>() == "void", "");
+#if defined(__clang__) || defined(__GNUC__)
+        static_assert(qe::type_name<type_util_test_ns::Widget>() == "type_util_test_ns::Widget", "");
+        static_assert(qe::type_name<const int *>() == "const int *" || qe::type_name<const int *>() == "const int*", "");
+        EXPECT_TRUE(qe::type_name<type_util_test_ns::Box<int>>() == "type_util_test_ns::Box<int>");
+#endif
+        EXPECT_FALSE(qe::type_name<type_util_test_ns::Widget>().empty());
+    }
+
+    static void id_test()
+    {
+        static_assert(qe::type_id<int>() == qe::type_id<int>(), "");
+        static_assert(qe::type_id<int>() != qe::type_id<unsigned>(), "");
+        static_assert(qe::type_id<int>() != qe::type_id<const int>(), "");
+        static_assert(qe::type_id<int>() != qe::type_id<int &>(), "");
+        static_assert(qe::type_id<type_util_test_ns::Box<int>>() != qe::type_id<type_util_test_ns::Box<long>>(), "");
+        EXPECT_TRUE(qe::type_id<type_util_test_ns::Widget>() == qe::detail::fnv1a(qe::type_name<type_util_test_ns::Widget>()));
+    }
+
+    static int classify(qe::type_id_t id)
+    {
+        switch (id) {
+        case qe::type_id<int>():                       return 1;
+        case qe::type_id<double>():                    return 2;
+        case qe::type_id<type_util_test_ns::Widget>(): return 3;
+        default:                                       return 0;
+        }
+    }
+
+    static void switch_test()
+    {
+        EXPECT_EQ(1, classify(qe::type_id<int>()));
+        EXPECT_EQ(2, classify(qe::type_id<double>()));
+        EXPECT_EQ(3, classify(qe::type_id<type_util_test_ns::Widget>()));
+        EXPECT_EQ(0, classify(qe::type_id<float>()));
+    }
+};
+
+#endif // QE_TEST_TYPEUTIL_H
@@ -99,6 +99,7 @@ struct unique_pointer_test
         compare_pointer_test();
         swap_pointer_test();
         std_container_test();
+        allocation_test();
     }
 
     static void empty_pointer_test()
@@ -296,5 +297,28 @@ struct unique_pointer_test
         EXPECT_EQ(0, Struct1::instances);
     }
 
+    //! Moving and swapping only transfer ownership and must never allocate.
+    static void allocation_test()
+    {
+        using namespace qe;
+        UniquePointer<Struct2> xPtr(new Struct2(123));
+        UniquePointer<Struct2> yPtr(new Struct2(234));
+
+        QE_EXPECT_NO_ALLOC {
+            UniquePointer<Struct2> zPtr(std::move(xPtr));
+            xPtr = std::move(zPtr);
+            xPtr.swap(yPtr);
+            std::swap(xPtr, yPtr);
+        }
+        EXPECT_EQ(123, xPtr->value);
+        EXPECT_EQ(234, yPtr->value);
+
+        QE_EXPECT_ALLOCS(1) {
+            xPtr.reset(new Struct2(345));
+            qe_test::keep(xPtr);
+        }
+        EXPECT_EQ(2, Struct1::instances);
+    }
+
 };
 #endif // QE_TEST_UNIQUEPOINTER_H
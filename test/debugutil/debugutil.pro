@@ -0,0 +1,18 @@
+#The public qe::hexInto, qe::hexDump and qe::formatInto against the Qt functions they match.
+#test/core checks the Qt-free kernels behind them.
+QT += core gui
+
+TARGET = debugutil_test
+TEMPLATE = app
+CONFIG += console c++1z
+
+INCLUDEPATH += ../../Include
+
+include(../../src/core/core.pri)
+
+SOURCES += \
+    $$PWD/main.cpp
+
+HEADERS += \
+    $$PWD/../core/test.h \
+    $$PWD/test_publicformat.h
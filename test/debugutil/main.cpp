@@ -0,0 +1,10 @@
+#include "test_publicformat.h"
+
+int main(int argc, char **argv)
+{
+    qe_test::add_test("hex_into", &public_format_test::hex_test);
+    qe_test::add_test("hex_dump", &public_format_test::dump_test);
+    qe_test::add_test("format_into", &public_format_test::format_test);
+    qe_test::add_test("format_color", &public_format_test::color_test);
+    return qe_test::run(argc, argv);
+}
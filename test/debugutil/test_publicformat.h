@@ -0,0 +1,248 @@
+/*  QExt: Extensions to Qt
+ *  Copyright (C) 2016  Jonathan Harper
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QE_TEST_PUBLICFORMAT_H
+#define QE_TEST_PUBLICFORMAT_H
+
+#include <limits>
+#include <QtCore/QByteArray>
+#include <QtCore/QLocale>
+#include <QtCore/QString>
+#include <QtCore/QVector>
+#include <QtGui/QColor>
+#include <qecore/debugutil.h>
+#include "../core/test.h"
+
+//! Checks the public qe::hexInto, qe::hexDump and qe::formatInto against the Qt functions whose
+//! output they promise to match.
+struct public_format_test
+{
+    //! Bytes covering printable and non-printable values.
+    static QByteArray pattern(int size)
+    {
+        QByteArray ret(size, Qt::Uninitialized);
+        for (int i = 0; i < size; ++i)
+            ret[i] = char((i * 37 + 11) & 0xFF);
+        return ret;
+    }
+
+    //! Sizes around a line (16 bytes) and around the 1 KiB chunks the encoders work in.
+    static QVector<int> sizes()
+    {
+        return {0, 1, 7, 8, 9, 15, 16, 17, 31, 32, 33, 1008, 1015, 1023, 1024, 1025, 1040, 2047, 2048, 2049, 3000};
+    }
+
+    template <class T>
+    static QString hex(T value)
+    {
+        QString ret;
+        qe::hexInto(ret, value);
+        return ret;
+    }
+
+    static void hex_test()
+    {
+        for (int size : sizes()) {
+            const QByteArray bytes = pattern(size);
+            QString out = QStringLiteral("x");
+            qe::hexInto(out, bytes);
+            EXPECT_EQ(out, QStringLiteral("x") + QString::fromLatin1(bytes.toHex()));
+
+            out.clear();
+            qe::hexInto(out, bytes.constData(), bytes.size(), true);
+            EXPECT_EQ(out, QString::fromLatin1(bytes.toHex().toUpper()));
+        }
+
+        EXPECT_EQ(hex(0), QString::number(0, 16));
+        EXPECT_EQ(hex(255), QString::number(255, 16));
+        EXPECT_EQ(hex(-255), QString::number(-255, 16));
+        EXPECT_EQ(hex(std::numeric_limits<int>::min()), QString::number(std::numeric_limits<int>::min(), 16));
+        EXPECT_EQ(hex(std::numeric_limits<uint>::max()), QString::number(std::numeric_limits<uint>::max(), 16));
+        EXPECT_EQ(hex(std::numeric_limits<qint64>::min()), QString::number(std::numeric_limits<qint64>::min(), 16));
+        EXPECT_EQ(hex(std::numeric_limits<quint64>::max()), QString::number(std::numeric_limits<quint64>::max(), 16));
+        EXPECT_EQ(hex(qint8(-128)), QString::number(-128, 16));
+        EXPECT_EQ(hex(quint16(0xBEEF)), QString::number(0xBEEF, 16));
+        EXPECT_EQ(qe::toHexString(qint32(-1)), QString::number(qint32(-1), 16));
+    }
+
+    //! Builds the `hexdump -C` layout that qe::hexDumpInto documents, one line at a time.
+    static QString referenceDump(const QByteArray &bytes, qe::HexDumpOptions options)
+    {
+        const bool upper = options.testFlag(qe::HexDumpOption::UpperCase);
+        auto hexDigits = [upper](uint value, int width) {
+            const QString ret = QString::number(value, 16).rightJustified(width, QLatin1Char('0'));
+            return upper ? ret.toUpper() : ret;
+        };
+        QString ret;
+        for (int line = 0; line < bytes.size(); line += 16) {
+            QString text;
+            if (options.testFlag(qe::HexDumpOption::ShowOffset))
+                text += hexDigits(uint(line), 8) + QLatin1String("  ");
+            for (int i = 0; i < 16; ++i) {
+                if (i == 8)
+                    text += QLatin1Char(' ');
+                if (line + i < bytes.size())
+                    text += hexDigits(uchar(bytes.at(line + i)), 2);
+                else
+                    text += QLatin1String("  ");
+                text += QLatin1Char(' ');
+            }
+            if (options.testFlag(qe::HexDumpOption::ShowAscii)) {
+                text += QLatin1String(" |");
+                for (int i = line; i < qMin(line + 16, bytes.size()); ++i) {
+                    const uchar c = uchar(bytes.at(i));
+                    text += QLatin1Char(c >= 0x20 && c < 0x7F ? char(c) : '.');
+                }
+                text += QLatin1Char('|');
+            } else {
+                while (text.endsWith(QLatin1Char(' ')))
+                    text.chop(1);
+            }
+            text += QLatin1Char('\n');
+            ret += text;
+        }
+        return ret;
+    }
+
+    static void dump_test()
+    {
+        using Option = qe::HexDumpOption;
+        const QVector<qe::HexDumpOptions> optionSets = {
+            Option::NoOptions,
+            Option::ShowOffset,
+            Option::ShowAscii,
+            Option::DefaultOptions,
+            Option::DefaultOptions | Option::UpperCase,
+            Option::UpperCase
+        };
+        for (const auto options : optionSets) {
+            for (int size : sizes()) {
+                const QByteArray bytes = pattern(size);
+                EXPECT_EQ(qe::hexDump(bytes, options), referenceDump(bytes, options));
+            }
+        }
+
+        //the documented example
+        const QByteArray hello("Hello, world!\n\0\xff", 16);
+        EXPECT_EQ(qe::hexDump(hello),
+                  QStringLiteral("00000000  48 65 6c 6c 6f 2c 20 77  6f 72 6c 64 21 0a 00 ff  |Hello, world!...|\n"));
+
+        //hexDumpInto appends; offsets keep counting across chunks
+        const QByteArray bytes = pattern(1040);
+        QString out = QStringLiteral("dump:\n");
+        qe::hexDumpInto(out, bytes.constData(), bytes.size());
+        EXPECT_EQ(out, QStringLiteral("dump:\n") + referenceDump(bytes, Option::DefaultOptions));
+        EXPECT_TRUE(out.contains(QLatin1String("\n00000400  ")));
+        EXPECT_TRUE(out.endsWith(QLatin1String("|\n")));
+    }
+
+    template <class T>
+    static void integer_case(T value)
+    {
+        for (int base : {2, 8, 10, 16, 36}) {
+            QString out;
+            qe::formatInto(out, value, base);
+            EXPECT_EQ(out, QString::number(value, base));
+        }
+    }
+
+    static void double_case(double value)
+    {
+        QString out;
+#if QT_VERSION >= QT_VERSION_CHECK(5, 15, 0)
+        qe::formatInto(out, value);
+        EXPECT_EQ(out, QString::number(value, 'g', QLocale::FloatingPointShortest));
+#endif
+        for (char format : {'e', 'E', 'f', 'g', 'G'}) {
+            for (int precision = 1; precision <= 8; ++precision) {
+                out.clear();
+                qe::formatInto(out, value, format, precision);
+                EXPECT_EQ(out, QString::number(value, format, precision));
+            }
+        }
+    }
+
+    static void format_test()
+    {
+        integer_case(0);
+        integer_case(-1);
+        integer_case(123456789);
+        integer_case(std::numeric_limits<int>::min());
+        integer_case(std::numeric_limits<uint>::max());
+        integer_case(std::numeric_limits<qint64>::min());
+        integer_case(std::numeric_limits<qint64>::max());
+        integer_case(std::numeric_limits<quint64>::max());
+        integer_case(short(-300));
+        integer_case(ushort(65535));
+
+        //an invalid base warns and writes decimal
+        QString out;
+        qe::formatInto(out, 35, 37);
+        EXPECT_EQ(out, QString::number(35));
+
+        for (double value : {0.0, 0.5, -1.5, 1.0 / 3.0, 0.1 + 0.2, 123.456, 99.995, 1e-5, 0.00012,
+                             100000.0, 1234567.0, 1e21, 6.02214076e23, 1e300,
+                             std::numeric_limits<double>::infinity(),
+                             -std::numeric_limits<double>::infinity(),
+                             std::numeric_limits<double>::quiet_NaN()})
+            double_case(value);
+    }
+
+    static void color_test()
+    {
+        const QVector<QColor> colors = {
+            QColor(0, 0, 0), QColor(255, 255, 255), QColor(255, 128, 0), QColor(12, 34, 56, 78),
+            QColor::fromHsv(200, 100, 50), QColor::fromHsl(300, 20, 240), QColor::fromRgbF(0.1, 0.2, 0.3)
+        };
+        for (const QColor &color : colors) {
+            const struct {
+                char component;
+                QString expected;
+            } cases[] = {
+                {'r', QString::number(color.red())},
+                {'g', QString::number(color.green())},
+                {'b', QString::number(color.blue())},
+                {'h', QString::number(color.hue())},
+                {'s', QString::number(color.saturation())},
+                {'v', QString::number(color.value())},
+                {'l', QString::number(color.lightness())},
+                {'R', QString::number(color.redF(), 'g', 2)},
+                {'G', QString::number(color.greenF(), 'g', 2)},
+                {'B', QString::number(color.blueF(), 'g', 2)},
+                {'H', QString::number(color.hueF(), 'g', 2)},
+                {'S', QString::number(color.saturationF(), 'g', 2)},
+                {'V', QString::number(color.valueF(), 'g', 2)},
+                {'L', QString::number(color.lightnessF(), 'g', 2)}
+            };
+            for (const auto &c : cases) {
+                QString out;
+                EXPECT_TRUE(qe::formatInto(out, color, c.component));
+                EXPECT_EQ(out, c.expected);
+            }
+
+            QString precise;
+            EXPECT_TRUE(qe::formatInto(precise, color, 'R', 6));
+            EXPECT_EQ(precise, QString::number(color.redF(), 'g', 6));
+        }
+
+        QString out = QStringLiteral("kept");
+        EXPECT_FALSE(qe::formatInto(out, QColor(1, 2, 3), 'x'));
+        EXPECT_EQ(out, QStringLiteral("kept"));
+    }
+};
+
+#endif // QE_TEST_PUBLICFORMAT_H
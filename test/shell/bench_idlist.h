@@ -0,0 +1,209 @@
+/*  QExt: Extensions to Qt
+ *  Copyright (C) 2016  Jonathan Harper
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QE_TEST_BENCH_IDLIST_H
+#define QE_TEST_BENCH_IDLIST_H
+
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+#include <qewindows/idlist.h>
+#include "pidlcorpus.h"
+#include "test_idlist.h"
+
+/*!
+    Benchmarks for IdList over a generated corpus. Run with `shell_test --bench`.
+
+    Each operation works on the next list of the corpus, so the times are averages over its mix of
+    depths and types. `QE_PIDL_CORPUS` names a file written by pidl_corpus::save() to use in place
+    of the generated corpus, and `QE_PIDL_SEED` changes the seed.
+*/
+struct idlist_bench
+{
+    using IdList = qe::windows::shell::IdList;
+
+    //! The lists being measured; the size is a power of two so the index can wrap with a mask.
+    static std::vector<IdList> &corpus()
+    {
+        static std::vector<IdList> ret = [] {
+            std::vector<pidl_corpus::Bytes> bytes;
+            if (const char *path = std::getenv("QE_PIDL_CORPUS"))
+                bytes = pidl_corpus::load(path);
+            if (bytes.empty()) {
+                pidl_corpus::Options options;
+                if (const char *seed = std::getenv("QE_PIDL_SEED"))
+                    options.seed = std::strtoull(seed, nullptr, 10);
+                bytes = pidl_corpus::generate(options);
+            }
+            std::size_t size = 1;
+            while (size * 2 <= bytes.size())
+                size *= 2;
+            std::vector<IdList> lists;
+            lists.reserve(size);
+            for (std::size_t i = 0; i < size; ++i)
+                lists.push_back(idlist_test::make(bytes[i]));
+            return lists;
+        }();
+        return ret;
+    }
+
+    //! Runs \a fn on each list of the corpus in turn.
+    template <class Fn>
+    static void over_corpus(qe_test::Bench &bench, Fn fn)
+    {
+        const auto &lists = corpus();
+        const std::size_t mask = lists.size() - 1;
+        std::size_t i = 0;
+        bench.run([&] {
+            fn(lists[i]);
+            i = (i + 1) & mask;
+        });
+    }
+
+    static void iterate(qe_test::Bench &bench)
+    {
+        over_corpus(bench, [](const IdList &id) {
+            unsigned bytes = 0;
+            for (const auto &item : id)
+                bytes += item.mkid.cb;
+            qe_test::keep(bytes);
+        });
+    }
+
+    static void byte_count(qe_test::Bench &bench)
+    {
+        over_corpus(bench, [](const IdList &id) { qe_test::keep(id.byteCount()); });
+    }
+
+    static void element_count(qe_test::Bench &bench)
+    {
+        over_corpus(bench, [](const IdList &id) { qe_test::keep(id.elementCount()); });
+    }
+
+    static void raw_type(qe_test::Bench &bench)
+    {
+        over_corpus(bench, [](const IdList &id) { qe_test::keep(id.rawType()); });
+    }
+
+    static void inferred_type(qe_test::Bench &bench)
+    {
+        over_corpus(bench, [](const IdList &id) { qe_test::keep(id.inferredType()); });
+    }
+
+    static void last_id(qe_test::Bench &bench)
+    {
+        over_corpus(bench, [](const IdList &id) { qe_test::keep(id.lastId()); });
+    }
+
+    static void parent(qe_test::Bench &bench)
+    {
+        over_corpus(bench, [](const IdList &id) {
+            IdList p = id.parent();
+            qe_test::keep(p);
+        });
+    }
+
+    //! Hashes each list without the cache in IdList.
+    static void hash(qe_test::Bench &bench)
+    {
+        over_corpus(bench, [](const IdList &id) {
+            qe_test::keep(qe::pidl::hashIdList(qe::windows::shell::toPidl(id.data())));
+        });
+    }
+
+    //! Compares each list with the next, which shares its parent in most of the generated corpus.
+    static void compare_neighbour(qe_test::Bench &bench)
+    {
+        const auto &lists = corpus();
+        const std::size_t mask = lists.size() - 1;
+        std::size_t i = 0;
+        bench.run([&] {
+            qe_test::keep(qe::windows::shell::compareIdList(lists[i].data(), lists[(i + 1) & mask].data()));
+            i = (i + 1) & mask;
+        });
+    }
+
+    //! Compares each list with an identical copy, the worst case for a byte-wise comparison.
+    static void compare_equal(qe_test::Bench &bench)
+    {
+        static const std::vector<IdList> copies(corpus().begin(), corpus().end());
+        const auto &lists = corpus();
+        const std::size_t mask = lists.size() - 1;
+        std::size_t i = 0;
+        bench.run([&] {
+            qe_test::keep(qe::windows::shell::compareIdList(lists[i].data(), copies[i].data()));
+            i = (i + 1) & mask;
+        });
+    }
+
+    //! compare_equal at a fixed qe::pidl::SimdLevel, to compare the kernels behind compareIdList.
+    template <qe::pidl::SimdLevel Level>
+    static void compare_equal_level(qe_test::Bench &bench)
+    {
+        static const std::vector<IdList> copies(corpus().begin(), corpus().end());
+        const auto &lists = corpus();
+        const std::size_t mask = lists.size() - 1;
+        std::size_t i = 0;
+        bench.run([&] {
+            qe_test::keep(qe::pidl::compareIdList(qe::windows::shell::toPidl(lists[i].data()),
+                                                  qe::windows::shell::toPidl(copies[i].data()), Level));
+            i = (i + 1) & mask;
+        });
+    }
+
+    //! Sorts a shuffled copy of the corpus by compareIdList. One operation is one full sort.
+    static void sort(qe_test::Bench &bench)
+    {
+        std::vector<const ITEMIDLIST *> order;
+        for (const auto &id : corpus())
+            order.push_back(id.data());
+        pidl_corpus::Random random(3);
+        std::vector<const ITEMIDLIST *> shuffled(order);
+        for (std::size_t i = shuffled.size(); i > 1; --i)
+            std::swap(shuffled[i - 1], shuffled[random.next() % i]);
+        bench.run([&] {
+            order = shuffled;
+            std::sort(order.begin(), order.end(), [](const ITEMIDLIST *a, const ITEMIDLIST *b) {
+                return qe::windows::shell::compareIdList(a, b) < 0;
+            });
+            qe_test::keep(order.front());
+        });
+    }
+
+    static void add()
+    {
+        qe_test::add_benchmark("idlist_iterate", &iterate);
+        qe_test::add_benchmark("idlist_byte_count", &byte_count);
+        qe_test::add_benchmark("idlist_element_count", &element_count);
+        qe_test::add_benchmark("idlist_raw_type", &raw_type);
+        qe_test::add_benchmark("idlist_inferred_type", &inferred_type);
+        qe_test::add_benchmark("idlist_last_id", &last_id);
+        qe_test::add_benchmark("idlist_parent", &parent);
+        qe_test::add_benchmark("idlist_hash", &hash);
+        qe_test::add_benchmark("idlist_compare_neighbour", &compare_neighbour);
+        qe_test::add_benchmark("idlist_compare_equal", &compare_equal);
+        qe_test::add_benchmark("idlist_sort", &sort);
+        qe_test::add_benchmark("pidl_compare_equal_scalar", &compare_equal_level<qe::pidl::SimdLevel::Scalar>);
+#ifdef QE_SIMD_X86
+        qe_test::add_benchmark("pidl_compare_equal_sse2", &compare_equal_level<qe::pidl::SimdLevel::SSE2>);
+        if (qe::detail::simdLevel() == qe::pidl::SimdLevel::AVX2)
+            qe_test::add_benchmark("pidl_compare_equal_avx2", &compare_equal_level<qe::pidl::SimdLevel::AVX2>);
+#endif
+    }
+};
+
+#endif // QE_TEST_BENCH_IDLIST_H
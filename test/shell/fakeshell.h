@@ -0,0 +1,857 @@
+/*  QExt: Extensions to Qt
+ *  Copyright (C) 2016  Jonathan Harper
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QE_TEST_FAKESHELL_H
+#define QE_TEST_FAKESHELL_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <ShlObj.h>
+#include <propkey.h>
+#include "pidlcorpus.h"
+
+/*!
+    An in-memory shell namespace for testing and benchmarking the node model off Windows.
+
+    A Namespace generates a tree of folders and files from Options and installs itself as the
+    SDK shim's shell provider, so that `SHGetDesktopFolder`, `SHCreateItemFromIDList` and the rest
+    resolve against the tree. Items are synthetic `IShellItem2` objects that enumerate with
+    `IEnumShellItems`, report attributes and `PKEY_FindData`, and expose an `IPropertyStore`.
+
+    Every call that the real shell may satisfy from disk or the network first waits for the
+    configured latency, so that tests can model slow and remote folders. The namespace counts the
+    calls and the live objects; a test that releases everything it acquired leaves live() at zero.
+
+    The objects are not thread safe, matching the apartment rules of the real shell interfaces.
+*/
+namespace fake_shell {
+
+using Bytes = pidl_corpus::Bytes;
+using Nanoseconds = std::chrono::nanoseconds;
+
+//! Parameters of the generated tree.
+struct Options
+{
+    //! Levels of folders below the desktop.
+    unsigned depth = 3;
+    unsigned foldersPerFolder = 4;
+    unsigned filesPerFolder = 16;
+    std::uint64_t seed = 1;
+    //! Delay added to each call that the real shell may have to satisfy from storage.
+    Nanoseconds latency{0};
+    //! Delay added on top of latency for items below a remote folder.
+    Nanoseconds remoteLatency{0};
+    //! Number of folders directly below the desktop that are marked remote (`SFGAO_ISSLOW`).
+    unsigned remoteFolders = 0;
+    //! Number of files directly below the desktop that are virtual. Like the items of many shell
+    //! extensions, they lack `SFGAO_FILESYSTEM` and get a different ID list each time one is asked
+    //! for, so only `IShellItem::Compare` recognizes them.
+    unsigned virtualFiles = 0;
+};
+
+//! An item in the generated tree.
+struct Node
+{
+    Node *parent = nullptr;
+    std::vector<std::unique_ptr<Node>> children;
+    std::wstring name;
+    std::wstring path;
+    //! The absolute ID list of the item, including the terminator.
+    Bytes id;
+    SFGAOF attributes = 0;
+    DWORD fileAttributes = 0;
+    ULONGLONG size = 0;
+    bool remote = false;
+    //! The ID lists handed out for the node differ from id in the pad byte of the last item.
+    bool unstableId = false;
+
+    bool isFolder() const           { return attributes & SFGAO_FOLDER; }
+};
+
+//! Per-method call counts.
+struct Calls
+{
+    std::size_t bindToHandler = 0;
+    std::size_t getParent = 0;
+    std::size_t getDisplayName = 0;
+    std::size_t getAttributes = 0;
+    std::size_t compare = 0;
+    std::size_t update = 0;
+    std::size_t getProperty = 0;
+    std::size_t next = 0;
+    std::size_t itemFromIdList = 0;
+    std::size_t idListFromObject = 0;
+};
+
+class Namespace;
+
+//! Implements `IUnknown` reference counting for the fake objects and tracks them in a Namespace.
+template <class Interface>
+class Object : public Interface
+{
+public:
+    explicit Object(Namespace *ns);
+    virtual ~Object();
+
+    ULONG STDMETHODCALLTYPE AddRef() override   { return ++m_refs; }
+    ULONG STDMETHODCALLTYPE Release() override
+    {
+        const ULONG ret = --m_refs;
+        if (!ret)
+            delete this;
+        return ret;
+    }
+
+protected:
+    Namespace *m_ns;
+
+private:
+    ULONG m_refs = 1;
+};
+
+//! Returns \a object through \a ppv if \a riid is one of \a iids.
+template <class... Iids>
+inline HRESULT queryAny(IUnknown *object, REFIID riid, void **ppv, const Iids &... iids)
+{
+    if (!ppv)
+        return E_POINTER;
+    const bool match = riid == IUnknown::qe_iid || ((riid == iids) || ...);
+    *ppv = match ? object : nullptr;
+    if (!match)
+        return E_NOINTERFACE;
+    object->AddRef();
+    return S_OK;
+}
+
+//! A synthetic `IShellItem2` for a Node.
+class Item final : public Object<IShellItem2>
+{
+public:
+    //! Recovers an Item from any of its interfaces.
+    static constexpr IID qe_iid = QE_SHIM_GUID(0x400);
+
+    Item(Namespace *ns, const Node *node) : Object(ns), m_node(node) {}
+    const Node *node() const        { return m_node; }
+
+    HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void **ppv) override
+    {
+        return queryAny(this, riid, ppv, IShellItem::qe_iid, IShellItem2::qe_iid, qe_iid);
+    }
+
+    HRESULT STDMETHODCALLTYPE BindToHandler(IBindCtx *pbc, REFGUID bhid, REFIID riid, void **ppv) override;
+    HRESULT STDMETHODCALLTYPE GetParent(IShellItem **ppsi) override;
+    HRESULT STDMETHODCALLTYPE GetDisplayName(SIGDN sigdnName, LPWSTR *ppszName) override;
+    HRESULT STDMETHODCALLTYPE GetAttributes(SFGAOF sfgaoMask, SFGAOF *psfgaoAttribs) override;
+    HRESULT STDMETHODCALLTYPE Compare(IShellItem *psi, SICHINTF hint, int *piOrder) override;
+
+    HRESULT STDMETHODCALLTYPE GetPropertyStore(GETPROPERTYSTOREFLAGS flags, REFIID riid, void **ppv) override;
+    HRESULT STDMETHODCALLTYPE Update(IBindCtx *pbc) override;
+    HRESULT STDMETHODCALLTYPE GetProperty(REFPROPERTYKEY key, PROPVARIANT *ppropvar) override;
+    HRESULT STDMETHODCALLTYPE GetString(REFPROPERTYKEY key, LPWSTR *ppsz) override;
+    HRESULT STDMETHODCALLTYPE GetUInt32(REFPROPERTYKEY key, ULONG *pui) override;
+    HRESULT STDMETHODCALLTYPE GetUInt64(REFPROPERTYKEY key, ULONGLONG *pull) override;
+    HRESULT STDMETHODCALLTYPE GetBool(REFPROPERTYKEY key, BOOL *pf) override;
+
+private:
+    const Node *m_node;
+};
+
+//! Enumerates the children of a folder Node.
+class Enum final : public Object<IEnumShellItems>
+{
+public:
+    Enum(Namespace *ns, const Node *node, std::size_t index = 0) : Object(ns), m_node(node), m_index(index) {}
+
+    HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void **ppv) override
+    {
+        return queryAny(this, riid, ppv, IEnumShellItems::qe_iid);
+    }
+
+    HRESULT STDMETHODCALLTYPE Next(ULONG celt, IShellItem **rgelt, ULONG *pceltFetched) override;
+    HRESULT STDMETHODCALLTYPE Skip(ULONG celt) override;
+    HRESULT STDMETHODCALLTYPE Reset() override                      { m_index = 0; return S_OK; }
+    HRESULT STDMETHODCALLTYPE Clone(IEnumShellItems **ppenum) override;
+
+private:
+    const Node *m_node;
+    std::size_t m_index;
+};
+
+//! A read-only property store over the properties of a Node.
+class PropertyStore final : public Object<IPropertyStore>
+{
+public:
+    PropertyStore(Namespace *ns, const Node *node) : Object(ns), m_node(node) {}
+
+    HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void **ppv) override
+    {
+        return queryAny(this, riid, ppv, IPropertyStore::qe_iid);
+    }
+
+    HRESULT STDMETHODCALLTYPE GetCount(DWORD *cProps) override;
+    HRESULT STDMETHODCALLTYPE GetAt(DWORD iProp, PROPERTYKEY *pkey) override;
+    HRESULT STDMETHODCALLTYPE GetValue(REFPROPERTYKEY key, PROPVARIANT *pv) override;
+    HRESULT STDMETHODCALLTYPE SetValue(REFPROPERTYKEY, REFPROPVARIANT) override     { return E_NOTIMPL; }
+    HRESULT STDMETHODCALLTYPE Commit() override                                     { return E_NOTIMPL; }
+
+private:
+    const Node *m_node;
+};
+
+//! The `IShellFolder2` returned by `SHGetDesktopFolder`. It only identifies its Node.
+class Folder final : public Object<IShellFolder2>
+{
+public:
+    static constexpr IID qe_iid = QE_SHIM_GUID(0x401);
+
+    Folder(Namespace *ns, const Node *node) : Object(ns), m_node(node) {}
+    const Node *node() const        { return m_node; }
+
+    HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void **ppv) override
+    {
+        return queryAny(this, riid, ppv, IShellFolder::qe_iid, IShellFolder2::qe_iid, qe_iid);
+    }
+
+private:
+    const Node *m_node;
+};
+
+class BindCtx final : public Object<IBindCtx>
+{
+public:
+    explicit BindCtx(Namespace *ns) : Object(ns) {}
+
+    HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void **ppv) override
+    {
+        return queryAny(this, riid, ppv, IBindCtx::qe_iid);
+    }
+};
+
+/*!
+    \brief Owns a generated tree and serves it through the SDK shim.
+
+    Constructing a Namespace installs it as the shell provider; destroying it restores the previous
+    one. Every object handed out must be released before the Namespace is destroyed.
+*/
+class Namespace : public qe_shim::ShellProvider
+{
+public:
+    explicit Namespace(const Options &options = Options());
+    ~Namespace() override                       { qe_shim::setShellProvider(m_previous); }
+
+    Namespace(const Namespace &) = delete;
+    Namespace &operator=(const Namespace &) = delete;
+
+    const Options &options() const              { return m_options; }
+    const Node *root() const                    { return m_root.get(); }
+    //! Returns the number of items in the tree, including the desktop.
+    std::size_t size() const                    { return m_byId.size(); }
+    const Node *find(PCUIDLIST_ABSOLUTE id) const;
+
+    //! Returns a new item for \a node, with one reference owned by the caller.
+    IShellItem2 *item(const Node *node)         { return new Item(this, node); }
+
+    Calls &calls()                              { return m_calls; }
+    void resetCalls()                           { m_calls = Calls(); }
+    //! Returns the number of fake objects that have not been released.
+    long live() const                           { return m_live; }
+
+    //! Waits for the latency of a call on \a node.
+    void delay(const Node *node) const;
+    HRESULT property(const Node *node, REFPROPERTYKEY key, PROPVARIANT *pv) const;
+    std::vector<PROPERTYKEY> propertyKeys(const Node *node) const;
+
+    HRESULT desktopFolder(IShellFolder **folder) override;
+    HRESULT itemFromObject(IUnknown *object, REFIID riid, void **ppv) override;
+    HRESULT itemFromIdList(PCIDLIST_ABSOLUTE id, REFIID riid, void **ppv) override;
+    HRESULT itemFromParsingName(PCWSTR path, IBindCtx *ctx, REFIID riid, void **ppv) override;
+    HRESULT idListFromObject(IUnknown *object, PIDLIST_ABSOLUTE *id) override;
+    HRESULT knownFolderIdList(REFKNOWNFOLDERID folder, PIDLIST_ABSOLUTE *id) override;
+    HRESULT pathFromIdList(PCIDLIST_ABSOLUTE id, PWSTR path, DWORD chars) override;
+    HRESULT createBindContext(IBindCtx **ctx) override;
+
+private:
+    template <class> friend class Object;
+
+    void populate(Node *node, unsigned level, pidl_corpus::Random &random);
+    Node *addChild(Node *parent, bool folder, unsigned index, pidl_corpus::Random &random);
+    const Node *nodeOf(IUnknown *object) const;
+    static std::size_t lastItemOffset(const Bytes &id);
+    HRESULT answer(const Node *node, REFIID riid, void **ppv);
+
+    Options m_options;
+    std::unique_ptr<Node> m_root;
+    std::map<Bytes, const Node *> m_byId;
+    std::map<std::wstring, const Node *> m_byPath;
+    std::uint64_t m_serial = 0;
+    //! Counts the ID lists handed out for nodes with an unstable id.
+    unsigned m_idGeneration = 0;
+    Calls m_calls;
+    long m_live = 0;
+    qe_shim::ShellProvider *m_previous = nullptr;
+};
+
+////////
+// Implementation below
+
+template <class Interface>
+Object<Interface>::Object(Namespace *ns)
+    : m_ns(ns)
+{
+    ++m_ns->m_live;
+}
+
+template <class Interface>
+Object<Interface>::~Object()
+{
+    --m_ns->m_live;
+}
+
+//! Returns a CoTaskMem copy of \a text.
+inline LPWSTR duplicate(const std::wstring &text)
+{
+    auto ret = static_cast<LPWSTR>(CoTaskMemAlloc((text.size() + 1) * sizeof(wchar_t)));
+    std::wmemcpy(ret, text.c_str(), text.size() + 1);
+    return ret;
+}
+
+//! Returns the size of the ID list at \a id, including the terminator.
+inline std::size_t idListSize(PCUIDLIST_RELATIVE id)
+{
+    return id ? ILGetSize(id) : 0;
+}
+
+inline Namespace::Namespace(const Options &options)
+    : m_options(options), m_root(new Node)
+{
+    m_root->name = L"Desktop";
+    m_root->path = L"X:";
+    m_root->id = {0, 0};
+    m_root->attributes = SFGAO_FOLDER | SFGAO_FILESYSTEM | SFGAO_STORAGE | SFGAO_HASSUBFOLDER;
+    m_root->fileAttributes = FILE_ATTRIBUTE_DIRECTORY;
+    m_byId[m_root->id] = m_root.get();
+    m_byPath[m_root->path] = m_root.get();
+
+    pidl_corpus::Random random(options.seed);
+    populate(m_root.get(), 0, random);
+    m_previous = qe_shim::setShellProvider(this);
+}
+
+//! \internal
+inline void Namespace::populate(Node *node, unsigned level, pidl_corpus::Random &random)
+{
+    for (unsigned i = 0; level < m_options.depth && i < m_options.foldersPerFolder; ++i) {
+        Node *child = addChild(node, true, i, random);
+        if (!level && i < m_options.remoteFolders) {
+            child->remote = true;
+            child->attributes |= SFGAO_ISSLOW;
+        }
+        populate(child, level + 1, random);
+    }
+    for (unsigned i = 0; level < m_options.depth && i < m_options.filesPerFolder; ++i) {
+        Node *child = addChild(node, false, i, random);
+        if (!level && i < m_options.virtualFiles) {
+            child->attributes &= ~SFGAO_FILESYSTEM;
+            child->unstableId = true;
+        }
+    }
+    if (node->children.empty())
+        node->attributes &= ~SFGAO_HASSUBFOLDER;
+}
+
+//! \internal
+//! Appends a child to \a parent. The item is laid out like a file system item: `cb`, a type byte,
+//! a pad byte, a unique serial and the name in UTF-16, so sizes vary with the name.
+inline Node *Namespace::addChild(Node *parent, bool folder, unsigned index, pidl_corpus::Random &random)
+{
+    std::unique_ptr<Node> node(new Node);
+    node->parent = parent;
+    node->remote = parent->remote;
+
+    static const wchar_t letters[] = L"abcdefghijklmnopqrstuvwxyz";
+    const unsigned length = random.range(3, 24);
+    for (unsigned i = 0; i < length; ++i)
+        node->name += letters[random.range(0, 25)];
+    node->name += L'_' + std::to_wstring(index);
+    if (!folder)
+        node->name += L".dat";
+    node->path = parent->path + L'\\' + node->name;
+
+    if (folder) {
+        node->attributes = SFGAO_FOLDER | SFGAO_FILESYSTEM | SFGAO_STORAGE | SFGAO_HASSUBFOLDER;
+        node->fileAttributes = FILE_ATTRIBUTE_DIRECTORY;
+    } else {
+        node->attributes = SFGAO_STREAM | SFGAO_FILESYSTEM;
+        node->fileAttributes = FILE_ATTRIBUTE_ARCHIVE;
+        node->size = random.next() % (ULONGLONG(1) << 24);
+    }
+    node->attributes |= SFGAO_CANCOPY | SFGAO_CANMOVE | SFGAO_CANRENAME | SFGAO_CANDELETE;
+    if (node->remote)
+        node->attributes |= SFGAO_ISSLOW;
+    if (random.range(0, 15) == 0) {
+        node->attributes |= SFGAO_HIDDEN;
+        node->fileAttributes |= FILE_ATTRIBUTE_HIDDEN;
+    }
+
+    const std::uint64_t serial = ++m_serial;
+    Bytes item;
+    const std::size_t cb = 2 + 2 + sizeof(serial) + node->name.size() * 2;
+    item.push_back(std::uint8_t(cb));
+    item.push_back(std::uint8_t(cb >> 8));
+    item.push_back(folder ? pidl_corpus::type::FolderW : pidl_corpus::type::ValueW);
+    item.push_back(0);
+    for (unsigned i = 0; i < sizeof(serial); ++i)
+        item.push_back(std::uint8_t(serial >> (8 * i)));
+    for (wchar_t c : node->name) {
+        item.push_back(std::uint8_t(c));
+        item.push_back(std::uint8_t(unsigned(c) >> 8));
+    }
+    node->id.assign(parent->id.begin(), parent->id.end() - 2);
+    node->id.insert(node->id.end(), item.begin(), item.end());
+    node->id.push_back(0);
+    node->id.push_back(0);
+
+    Node *ret = node.get();
+    m_byId[ret->id] = ret;
+    m_byPath[ret->path] = ret;
+    parent->children.push_back(std::move(node));
+    return ret;
+}
+
+//! Returns the node identified by \a id, or nullptr. Any ID list handed out for a node with an
+//! unstable id identifies it.
+inline const Node *Namespace::find(PCUIDLIST_ABSOLUTE id) const
+{
+    if (!id)
+        return nullptr;
+    auto p = reinterpret_cast<const std::uint8_t *>(id);
+    Bytes bytes(p, p + idListSize(id));
+    auto iter = m_byId.find(bytes);
+    if (iter != m_byId.end())
+        return iter->second;
+    const std::size_t last = lastItemOffset(bytes);
+    if (bytes.size() < last + 6)
+        return nullptr;
+    bytes[last + 3] = 0;
+    iter = m_byId.find(bytes);
+    return iter != m_byId.end() && iter->second->unstableId ? iter->second : nullptr;
+}
+
+//! Returns the offset of the last item in the ID list \a id, or of the terminator if it is empty.
+inline std::size_t Namespace::lastItemOffset(const Bytes &id)
+{
+    std::size_t ret = 0;
+    for (std::size_t pos = 0; pos + 2 <= id.size();) {
+        const std::size_t cb = id[pos] | std::size_t(id[pos + 1]) << 8;
+        if (!cb)
+            break;
+        ret = pos;
+        pos += cb;
+    }
+    return ret;
+}
+
+inline void Namespace::delay(const Node *node) const
+{
+    Nanoseconds wait = m_options.latency;
+    if (node && node->remote)
+        wait += m_options.remoteLatency;
+    if (wait <= Nanoseconds::zero())
+        return;
+    //sleeping is far too coarse for sub-millisecond delays
+    if (wait >= std::chrono::milliseconds(1)) {
+        std::this_thread::sleep_for(wait);
+        return;
+    }
+    const auto end = std::chrono::steady_clock::now() + wait;
+    while (std::chrono::steady_clock::now() < end) {}
+}
+
+//! Returns the keys that property() answers for \a node.
+inline std::vector<PROPERTYKEY> Namespace::propertyKeys(const Node *node) const
+{
+    std::vector<PROPERTYKEY> ret{PKEY_ItemNameDisplay};
+    if (node->attributes & SFGAO_FILESYSTEM)
+        ret.push_back(PKEY_FindData);
+    if (!node->isFolder())
+        ret.push_back(PKEY_Size);
+    return ret;
+}
+
+//! Fills \a pv with the value of \a key. Unknown keys yield `VT_EMPTY`, as in the real shell.
+inline HRESULT Namespace::property(const Node *node, REFPROPERTYKEY key, PROPVARIANT *pv) const
+{
+    if (!pv)
+        return E_POINTER;
+    PropVariantInit(pv);
+    if (key == PKEY_ItemNameDisplay) {
+        pv->vt = VT_LPWSTR;
+        pv->pwszVal = duplicate(node->name);
+    } else if (key == PKEY_Size && !node->isFolder()) {
+        pv->vt = VT_UI8;
+        pv->uhVal.QuadPart = node->size;
+    } else if (key == PKEY_FindData && (node->attributes & SFGAO_FILESYSTEM)) {
+        WIN32_FIND_DATA data;
+        std::memset(&data, 0, sizeof(data));
+        data.dwFileAttributes = node->fileAttributes;
+        data.nFileSizeHigh = DWORD(node->size >> 32);
+        data.nFileSizeLow = DWORD(node->size);
+        StringCchCopyW(data.cFileName, MAX_PATH, node->name.c_str());
+        pv->vt = VT_VECTOR | VT_UI1;
+        pv->caub.cElems = ULONG(sizeof(data));
+        pv->caub.pElems = static_cast<UCHAR *>(CoTaskMemAlloc(sizeof(data)));
+        std::memcpy(pv->caub.pElems, &data, sizeof(data));
+    }
+    return S_OK;
+}
+
+//! \internal
+//! Returns the node of an Item or Folder, or nullptr for other objects.
+inline const Node *Namespace::nodeOf(IUnknown *object) const
+{
+    if (!object)
+        return nullptr;
+    void *ptr = nullptr;
+    if (SUCCEEDED(object->QueryInterface(Item::qe_iid, &ptr))) {
+        auto item = static_cast<Item *>(static_cast<IShellItem2 *>(static_cast<IUnknown *>(ptr)));
+        const Node *ret = item->node();
+        item->Release();
+        return ret;
+    }
+    if (SUCCEEDED(object->QueryInterface(Folder::qe_iid, &ptr))) {
+        auto folder = static_cast<Folder *>(static_cast<IShellFolder2 *>(static_cast<IUnknown *>(ptr)));
+        const Node *ret = folder->node();
+        folder->Release();
+        return ret;
+    }
+    return nullptr;
+}
+
+//! \internal
+//! Creates an item for \a node and returns its \a riid interface through \a ppv.
+inline HRESULT Namespace::answer(const Node *node, REFIID riid, void **ppv)
+{
+    if (!ppv)
+        return E_POINTER;
+    *ppv = nullptr;
+    if (!node)
+        return HRESULT_FILE_NOT_FOUND;
+    IShellItem2 *created = item(node);
+    const HRESULT hr = created->QueryInterface(riid, ppv);
+    created->Release();
+    return hr;
+}
+
+inline HRESULT Namespace::desktopFolder(IShellFolder **folder)
+{
+    if (!folder)
+        return E_POINTER;
+    *folder = new Folder(this, root());
+    return S_OK;
+}
+
+inline HRESULT Namespace::itemFromObject(IUnknown *object, REFIID riid, void **ppv)
+{
+    const Node *node = nodeOf(object);
+    return node ? answer(node, riid, ppv) : E_NOINTERFACE;
+}
+
+inline HRESULT Namespace::itemFromIdList(PCIDLIST_ABSOLUTE id, REFIID riid, void **ppv)
+{
+    ++m_calls.itemFromIdList;
+    if (!id)
+        return E_INVALIDARG;
+    const Node *node = find(id);
+    delay(node);
+    return answer(node, riid, ppv);
+}
+
+inline HRESULT Namespace::itemFromParsingName(PCWSTR path, IBindCtx *, REFIID riid, void **ppv)
+{
+    if (!path)
+        return E_INVALIDARG;
+    auto iter = m_byPath.find(path);
+    const Node *node = iter == m_byPath.end() ? nullptr : iter->second;
+    delay(node);
+    return answer(node, riid, ppv);
+}
+
+inline HRESULT Namespace::idListFromObject(IUnknown *object, PIDLIST_ABSOLUTE *id)
+{
+    ++m_calls.idListFromObject;
+    if (!id)
+        return E_POINTER;
+    *id = nullptr;
+    const Node *node = nodeOf(object);
+    if (!node)
+        return E_NOINTERFACE;
+    auto copy = static_cast<std::uint8_t *>(CoTaskMemAlloc(node->id.size()));
+    std::memcpy(copy, node->id.data(), node->id.size());
+    if (node->unstableId)
+        copy[lastItemOffset(node->id) + 3] = std::uint8_t(++m_idGeneration % 255 + 1);
+    *id = reinterpret_cast<PIDLIST_ABSOLUTE>(copy);
+    return S_OK;
+}
+
+inline HRESULT Namespace::knownFolderIdList(REFKNOWNFOLDERID folder, PIDLIST_ABSOLUTE *id)
+{
+    if (!id)
+        return E_POINTER;
+    *id = nullptr;
+    if (folder != FOLDERID_Desktop)
+        return HRESULT_FILE_NOT_FOUND;
+    *id = ILCloneFull(reinterpret_cast<PCUIDLIST_ABSOLUTE>(root()->id.data()));
+    return S_OK;
+}
+
+inline HRESULT Namespace::pathFromIdList(PCIDLIST_ABSOLUTE id, PWSTR path, DWORD chars)
+{
+    const Node *node = find(id);
+    if (!node)
+        return HRESULT_FILE_NOT_FOUND;
+    if (!path)
+        return E_POINTER;
+    return StringCchCopyW(path, chars, node->path.c_str());
+}
+
+inline HRESULT Namespace::createBindContext(IBindCtx **ctx)
+{
+    if (!ctx)
+        return E_POINTER;
+    *ctx = new BindCtx(this);
+    return S_OK;
+}
+
+inline HRESULT Item::BindToHandler(IBindCtx *, REFGUID bhid, REFIID riid, void **ppv)
+{
+    ++m_ns->calls().bindToHandler;
+    if (!ppv)
+        return E_POINTER;
+    *ppv = nullptr;
+    m_ns->delay(m_node);
+    IUnknown *handler = nullptr;
+    if (bhid == BHID_EnumItems && m_node->isFolder())
+        handler = new Enum(m_ns, m_node);
+    else if (bhid == BHID_PropertyStore)
+        handler = new PropertyStore(m_ns, m_node);
+    else if (bhid == BHID_SFObject && m_node->isFolder())
+        handler = new Folder(m_ns, m_node);
+    if (!handler)
+        return E_NOINTERFACE;
+    const HRESULT hr = handler->QueryInterface(riid, ppv);
+    handler->Release();
+    return hr;
+}
+
+inline HRESULT Item::GetParent(IShellItem **ppsi)
+{
+    ++m_ns->calls().getParent;
+    if (!ppsi)
+        return E_POINTER;
+    *ppsi = nullptr;
+    if (!m_node->parent)
+        return E_FAIL;
+    *ppsi = m_ns->item(m_node->parent);
+    return S_OK;
+}
+
+inline HRESULT Item::GetDisplayName(SIGDN sigdnName, LPWSTR *ppszName)
+{
+    ++m_ns->calls().getDisplayName;
+    if (!ppszName)
+        return E_POINTER;
+    *ppszName = nullptr;
+    m_ns->delay(m_node);
+    switch (sigdnName) {
+    case SIGDN_DESKTOPABSOLUTEPARSING:
+    case SIGDN_DESKTOPABSOLUTEEDITING:
+    case SIGDN_FILESYSPATH:
+        *ppszName = duplicate(m_node->path);
+        return S_OK;
+    case SIGDN_URL:
+        return E_NOTIMPL;
+    default:
+        *ppszName = duplicate(m_node->name);
+        return S_OK;
+    }
+}
+
+inline HRESULT Item::GetAttributes(SFGAOF sfgaoMask, SFGAOF *psfgaoAttribs)
+{
+    ++m_ns->calls().getAttributes;
+    if (!psfgaoAttribs)
+        return E_POINTER;
+    m_ns->delay(m_node);
+    *psfgaoAttribs = m_node->attributes & sfgaoMask;
+    return *psfgaoAttribs == sfgaoMask ? S_OK : S_FALSE;
+}
+
+//! Orders items by their ID bytes; equal items compare as 0 and return `S_OK`.
+inline HRESULT Item::Compare(IShellItem *psi, SICHINTF, int *piOrder)
+{
+    ++m_ns->calls().compare;
+    if (!psi || !piOrder)
+        return E_POINTER;
+    void *ptr = nullptr;
+    if (FAILED(psi->QueryInterface(Item::qe_iid, &ptr)))
+        return E_INVALIDARG;
+    auto other = static_cast<Item *>(static_cast<IShellItem2 *>(static_cast<IUnknown *>(ptr)));
+    const Bytes &a = m_node->id;
+    const Bytes &b = other->node()->id;
+    other->Release();
+    *piOrder = a < b ? -1 : (b < a ? 1 : 0);
+    return *piOrder ? S_FALSE : S_OK;
+}
+
+inline HRESULT Item::GetPropertyStore(GETPROPERTYSTOREFLAGS, REFIID riid, void **ppv)
+{
+    if (!ppv)
+        return E_POINTER;
+    *ppv = nullptr;
+    m_ns->delay(m_node);
+    auto store = new PropertyStore(m_ns, m_node);
+    const HRESULT hr = store->QueryInterface(riid, ppv);
+    store->Release();
+    return hr;
+}
+
+inline HRESULT Item::Update(IBindCtx *)
+{
+    ++m_ns->calls().update;
+    m_ns->delay(m_node);
+    return S_OK;
+}
+
+inline HRESULT Item::GetProperty(REFPROPERTYKEY key, PROPVARIANT *ppropvar)
+{
+    ++m_ns->calls().getProperty;
+    m_ns->delay(m_node);
+    return m_ns->property(m_node, key, ppropvar);
+}
+
+inline HRESULT Item::GetString(REFPROPERTYKEY key, LPWSTR *ppsz)
+{
+    if (!ppsz)
+        return E_POINTER;
+    *ppsz = nullptr;
+    PROPVARIANT var;
+    HRESULT hr = GetProperty(key, &var);
+    if (SUCCEEDED(hr) && var.vt == VT_LPWSTR)
+        *ppsz = std::exchange(var.pwszVal, nullptr);
+    else if (SUCCEEDED(hr))
+        hr = E_INVALIDARG;
+    PropVariantClear(&var);
+    return hr;
+}
+
+inline HRESULT Item::GetUInt32(REFPROPERTYKEY key, ULONG *pui)
+{
+    ULONGLONG value = 0;
+    const HRESULT hr = GetUInt64(key, &value);
+    if (SUCCEEDED(hr) && pui)
+        *pui = ULONG(value);
+    return hr;
+}
+
+inline HRESULT Item::GetUInt64(REFPROPERTYKEY key, ULONGLONG *pull)
+{
+    if (!pull)
+        return E_POINTER;
+    PROPVARIANT var;
+    HRESULT hr = GetProperty(key, &var);
+    if (SUCCEEDED(hr) && var.vt == VT_UI8)
+        *pull = var.uhVal.QuadPart;
+    else if (SUCCEEDED(hr))
+        hr = E_INVALIDARG;
+    PropVariantClear(&var);
+    return hr;
+}
+
+inline HRESULT Item::GetBool(REFPROPERTYKEY, BOOL *pf)
+{
+    if (pf)
+        *pf = FALSE;
+    return E_INVALIDARG;
+}
+
+//! Returns up to \a celt items. `S_FALSE` means that fewer than \a celt remained.
+inline HRESULT Enum::Next(ULONG celt, IShellItem **rgelt, ULONG *pceltFetched)
+{
+    ++m_ns->calls().next;
+    if (!rgelt)
+        return E_POINTER;
+    if (celt != 1 && !pceltFetched)
+        return E_INVALIDARG;
+    m_ns->delay(m_node);
+    ULONG fetched = 0;
+    for (; fetched < celt && m_index < m_node->children.size(); ++fetched, ++m_index)
+        rgelt[fetched] = m_ns->item(m_node->children[m_index].get());
+    if (pceltFetched)
+        *pceltFetched = fetched;
+    return fetched == celt ? S_OK : S_FALSE;
+}
+
+inline HRESULT Enum::Skip(ULONG celt)
+{
+    const std::size_t left = m_node->children.size() - m_index;
+    m_index += std::min<std::size_t>(celt, left);
+    return celt <= left ? S_OK : S_FALSE;
+}
+
+inline HRESULT Enum::Clone(IEnumShellItems **ppenum)
+{
+    if (!ppenum)
+        return E_POINTER;
+    *ppenum = new Enum(m_ns, m_node, m_index);
+    return S_OK;
+}
+
+inline HRESULT PropertyStore::GetCount(DWORD *cProps)
+{
+    if (!cProps)
+        return E_POINTER;
+    *cProps = DWORD(m_ns->propertyKeys(m_node).size());
+    return S_OK;
+}
+
+inline HRESULT PropertyStore::GetAt(DWORD iProp, PROPERTYKEY *pkey)
+{
+    if (!pkey)
+        return E_POINTER;
+    const auto keys = m_ns->propertyKeys(m_node);
+    if (iProp >= keys.size())
+        return E_INVALIDARG;
+    *pkey = keys[iProp];
+    return S_OK;
+}
+
+inline HRESULT PropertyStore::GetValue(REFPROPERTYKEY key, PROPVARIANT *pv)
+{
+    return m_ns->property(m_node, key, pv);
+}
+
+} // namespace fake_shell
+
+#endif // QE_TEST_FAKESHELL_H
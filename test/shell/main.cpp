@@ -0,0 +1,16 @@
+#include "test_nodeflags.h"
+#include "test_pidl.h"
+#include "test_idlist.h"
+#include "bench_idlist.h"
+#include "test_fakeshell.h"
+
+int main(int argc, char *argv[])
+{
+    qe_test::add_test("nodeflags", &nodeflags_test::run);
+    qe_test::add_test("pidl", &pidl_test::run);
+    qe_test::add_test("idlist", &idlist_test::run);
+    idlist_bench::add();
+    qe_test::add_test("fakeshell", &fakeshell_test::run);
+
+    return qe_test::run(argc, argv);
+}
@@ -0,0 +1,380 @@
+/*  QExt: Extensions to Qt
+ *  Copyright (C) 2016  Jonathan Harper
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QE_TEST_PIDLCORPUS_H
+#define QE_TEST_PIDLCORPUS_H
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+/*!
+    Builds shell ID lists as raw byte streams so that the ID list code can be tested and
+    benchmarked without a live desktop.
+
+    Each stream is a sequence of `SHITEMID` items (a little-endian `cb` followed by `cb - 2` bytes,
+    the first of which is the `abID[0]` type) terminated by two zero bytes. generate() produces a
+    reproducible corpus from a seed; builtin() returns a small set of well-known lists assembled
+    from the documented item layouts; load() and save() read and write corpora captured elsewhere,
+    for example by writing `ILGetSize` bytes of each PIDL on a Windows machine back to back.
+*/
+namespace pidl_corpus {
+
+using Bytes = std::vector<std::uint8_t>;
+
+//! The `abID[0]` values of qe::pidl::abIDType.
+namespace type {
+enum : std::uint8_t {
+    CplApplet   = 0x00,
+    GUID        = 0x1F,
+    Drive       = 0x23,
+    Drive2      = 0x25,
+    Drive3      = 0x29,
+    ShellExt    = 0x2E,
+    Drive1      = 0x2F,
+    Folder1     = 0x30,
+    FolderA     = 0x31,
+    ValueA      = 0x32,
+    ValueW      = 0x34,
+    FolderW     = 0x35,
+    Workgroup   = 0x41,
+    Computer    = 0x42,
+    NetProvider = 0x46,
+    Network     = 0x47,
+    IESPECIAL1  = 0x61,
+    Printer     = 0x70,
+    IESPECIAL2  = 0xb1,
+    Share       = 0xc3
+};
+}
+
+//! A type byte and its relative weight in a distribution.
+struct TypeWeight
+{
+    std::uint8_t type;
+    unsigned weight;
+};
+
+//! Parameters for generate(). The defaults resemble a filesystem-heavy desktop.
+struct Options
+{
+    unsigned count = 4096;
+    std::uint64_t seed = 1;
+    //! Number of items per list, including the root item.
+    unsigned minDepth = 1;
+    unsigned maxDepth = 10;
+    //! Size range of variable-sized items (file system entries and unknown types), including `cb`.
+    unsigned minItemSize = 40;
+    unsigned maxItemSize = 160;
+    //! Percentage of lists that are a sibling of the previous list, sharing all but its last item.
+    unsigned siblingPercent = 60;
+    //! Distribution of the first item's type. Empty selects the default.
+    std::vector<TypeWeight> rootTypes;
+    //! Distribution of the last item's type, for lists with more than one item. Empty selects the default.
+    std::vector<TypeWeight> leafTypes;
+};
+
+//! A small, portable generator (splitmix64) so that a seed produces the same corpus everywhere.
+class Random
+{
+public:
+    explicit Random(std::uint64_t seed) : m_state(seed) {}
+
+    std::uint64_t next()
+    {
+        std::uint64_t z = (m_state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    //! Returns a value in [lo, hi].
+    unsigned range(unsigned lo, unsigned hi)
+    {
+        if (hi <= lo)
+            return lo;
+        return lo + unsigned(next() % (std::uint64_t(hi) - lo + 1));
+    }
+
+    std::uint8_t pick(const std::vector<TypeWeight> &weights)
+    {
+        unsigned total = 0;
+        for (const auto &w : weights)
+            total += w.weight;
+        if (!total)
+            return weights.empty() ? std::uint8_t(type::FolderW) : weights.front().type;
+        unsigned n = unsigned(next() % total);
+        for (const auto &w : weights) {
+            if (n < w.weight)
+                return w.type;
+            n -= w.weight;
+        }
+        return weights.back().type;
+    }
+
+private:
+    std::uint64_t m_state;
+};
+
+inline std::vector<TypeWeight> defaultRootTypes()
+{
+    return {{type::GUID, 90}, {type::CplApplet, 2}, {type::ShellExt, 3}, {type::Network, 3},
+            {type::Printer, 2}};
+}
+
+inline std::vector<TypeWeight> defaultLeafTypes()
+{
+    return {{type::FolderW, 20}, {type::FolderA, 10}, {type::Folder1, 2}, {type::ValueW, 30},
+            {type::ValueA, 15}, {type::Drive1, 4}, {type::Drive, 1}, {type::Drive2, 1},
+            {type::Drive3, 1}, {type::GUID, 4}, {type::ShellExt, 2}, {type::Computer, 2},
+            {type::Workgroup, 1}, {type::NetProvider, 1}, {type::Network, 1}, {type::Share, 2},
+            {type::Printer, 1}, {type::IESPECIAL1, 1}, {type::IESPECIAL2, 1}};
+}
+
+inline bool isFileEntry(std::uint8_t t)
+{
+    return t >= type::Folder1 && t <= type::FolderW;
+}
+
+inline bool isFolder(std::uint8_t t)
+{
+    return t == type::Folder1 || t == type::FolderA || t == type::FolderW;
+}
+
+//! Appends an item of type \a t to \a out.
+inline void appendItem(Bytes &out, std::uint8_t t, const Options &options, Random &random)
+{
+    unsigned cb;
+    switch (t) {
+    case type::GUID:
+    case type::ShellExt:
+    case type::Printer:
+        cb = 20; //cb, type, sort order, CLSID
+        break;
+    case type::Drive:
+    case type::Drive1:
+    case type::Drive2:
+    case type::Drive3:
+        cb = 25; //cb, type, "X:\", padding
+        break;
+    default:
+        cb = random.range(options.minItemSize < 3 ? 3 : options.minItemSize,
+                          options.maxItemSize > 0xFFF0 ? 0xFFF0 : options.maxItemSize);
+        break;
+    }
+
+    const std::size_t start = out.size();
+    out.resize(start + cb, 0);
+    std::uint8_t *item = out.data() + start;
+    item[0] = std::uint8_t(cb & 0xFF);
+    item[1] = std::uint8_t(cb >> 8);
+    item[2] = t;
+    for (unsigned i = 3; i < cb; ++i)
+        item[i] = std::uint8_t(random.next());
+
+    if (t == type::Drive || t == type::Drive1 || t == type::Drive2 || t == type::Drive3) {
+        item[3] = std::uint8_t('C' + random.range(0, 5));
+        item[4] = ':';
+        item[5] = '\\';
+        for (unsigned i = 6; i < cb; ++i)
+            item[i] = 0;
+    } else if (isFileEntry(t) && cb >= 14) {
+        //type, unknown, file size, DOS date/time, attributes, then an 8.3 name
+        item[3] = 0;
+        if (isFolder(t)) {
+            for (unsigned i = 4; i < 8; ++i)
+                item[i] = 0;
+            item[12] = 0x10; //FILE_ATTRIBUTE_DIRECTORY
+        } else {
+            item[12] = 0x20; //FILE_ATTRIBUTE_ARCHIVE
+        }
+        item[13] = 0;
+        const unsigned nameEnd = cb < 27 ? cb - 1 : 26;
+        for (unsigned i = 14; i < nameEnd; ++i)
+            item[i] = std::uint8_t('A' + random.range(0, 25));
+        if (nameEnd < cb)
+            item[nameEnd] = 0;
+    }
+}
+
+//! Returns a corpus of \a options.count lists.
+inline std::vector<Bytes> generate(Options options = Options())
+{
+    if (options.rootTypes.empty())
+        options.rootTypes = defaultRootTypes();
+    if (options.leafTypes.empty())
+        options.leafTypes = defaultLeafTypes();
+    if (options.minDepth < 1)
+        options.minDepth = 1;
+    if (options.maxDepth < options.minDepth)
+        options.maxDepth = options.minDepth;
+
+    Random random(options.seed);
+    std::vector<Bytes> ret;
+    ret.reserve(options.count);
+    Bytes parent; //the items of the previous list that a sibling shares
+    for (unsigned n = 0; n < options.count; ++n) {
+        Bytes list;
+        if (!parent.empty() && random.range(1, 100) <= options.siblingPercent) {
+            list = parent;
+        } else {
+            const unsigned depth = random.range(options.minDepth, options.maxDepth);
+            appendItem(list, random.pick(options.rootTypes), options, random);
+            //the second item is usually a drive, followed by folders
+            for (unsigned i = 2; i < depth; ++i) {
+                const std::uint8_t t = i == 2 ? std::uint8_t(type::Drive1)
+                                              : random.pick({{type::FolderW, 3}, {type::FolderA, 1}});
+                appendItem(list, t, options, random);
+            }
+            parent = depth > 1 ? list : Bytes();
+        }
+        if (!parent.empty())
+            appendItem(list, random.pick(options.leafTypes), options, random);
+        list.push_back(0);
+        list.push_back(0);
+        ret.push_back(std::move(list));
+    }
+    return ret;
+}
+
+//! Returns a handful of common ID lists, assembled from the documented item layouts.
+inline std::vector<Bytes> builtin()
+{
+    //{20D04FE0-3AEA-1069-A2D8-08002B30309D}, This PC
+    const Bytes thisPc = {0x14, 0x00, 0x1F, 0x50, 0xE0, 0x4F, 0xD0, 0x20, 0xEA, 0x3A, 0x69, 0x10,
+                          0xA2, 0xD8, 0x08, 0x00, 0x2B, 0x30, 0x30, 0x9D};
+    //{26EE0668-A00A-44D7-9371-BEB064C98683}, Control Panel
+    const Bytes controlPanel = {0x14, 0x00, 0x1F, 0x80, 0x68, 0x06, 0xEE, 0x26, 0x0A, 0xA0, 0xD7,
+                                0x44, 0x93, 0x71, 0xBE, 0xB0, 0x64, 0xC9, 0x86, 0x83};
+    //{F02C1A0D-BE21-4350-88B0-7367FC96EF3C}, Network
+    const Bytes network = {0x14, 0x00, 0x1F, 0x58, 0x0D, 0x1A, 0x2C, 0xF0, 0x21, 0xBE, 0x50, 0x43,
+                           0x88, 0xB0, 0x73, 0x67, 0xFC, 0x96, 0xEF, 0x3C};
+    Bytes driveC(25, 0);
+    driveC[0] = 25;
+    driveC[2] = type::Drive1;
+    driveC[3] = 'C';
+    driveC[4] = ':';
+    driveC[5] = '\\';
+
+    auto fileEntry = [](std::uint8_t t, const char *shortName, std::uint32_t size) {
+        Bytes item = {0, 0, t, 0,
+                      std::uint8_t(size), std::uint8_t(size >> 8), std::uint8_t(size >> 16), std::uint8_t(size >> 24),
+                      0x21, 0x4B, 0x6E, 0x80, //DOS date and time
+                      std::uint8_t(isFolder(t) ? 0x10 : 0x20), 0x00};
+        for (const char *c = shortName; *c; ++c)
+            item.push_back(std::uint8_t(*c));
+        item.push_back(0);
+        if (item.size() & 1)
+            item.push_back(0);
+        item.resize(item.size() + 36, 0); //extension block, zeroed
+        item[0] = std::uint8_t(item.size());
+        item[1] = std::uint8_t(item.size() >> 8);
+        return item;
+    };
+    auto computer = [](const char *name) {
+        Bytes item = {0, 0, type::Computer, 0x01, 0x82};
+        for (const char *c = name; *c; ++c)
+            item.push_back(std::uint8_t(*c));
+        item.push_back(0);
+        item.push_back(0);
+        item[0] = std::uint8_t(item.size());
+        return item;
+    };
+    auto share = [](const char *path) {
+        Bytes item = {0, 0, type::Share, 0x01, 0x81};
+        for (const char *c = path; *c; ++c)
+            item.push_back(std::uint8_t(*c));
+        item.push_back(0);
+        item.push_back(0);
+        item[0] = std::uint8_t(item.size());
+        return item;
+    };
+    auto join = [](std::initializer_list<Bytes> items) {
+        Bytes ret;
+        for (const auto &item : items)
+            ret.insert(ret.end(), item.begin(), item.end());
+        ret.push_back(0);
+        ret.push_back(0);
+        return ret;
+    };
+
+    const Bytes windows = fileEntry(type::FolderW, "Windows", 0);
+    const Bytes system32 = fileEntry(type::FolderW, "System32", 0);
+    return {
+        join({}),                                                           //Desktop
+        join({thisPc}),
+        join({controlPanel}),
+        join({network}),
+        join({thisPc, driveC}),
+        join({thisPc, driveC, windows}),
+        join({thisPc, driveC, windows, system32}),
+        join({thisPc, driveC, windows, system32, fileEntry(type::ValueW, "notepad.exe", 201216)}),
+        join({thisPc, driveC, fileEntry(type::FolderW, "PROGRA~1", 0), fileEntry(type::FolderW, "COMMON~1", 0)}),
+        join({network, computer("\\\\SERVER")}),
+        join({network, computer("\\\\SERVER"), share("\\\\SERVER\\public")}),
+    };
+}
+
+//! Reads a corpus of back-to-back ID lists from \a path. Returns an empty corpus on error.
+inline std::vector<Bytes> load(const std::string &path)
+{
+    std::vector<Bytes> ret;
+    std::FILE *file = std::fopen(path.c_str(), "rb");
+    if (!file)
+        return ret;
+    Bytes data;
+    std::uint8_t buffer[4096];
+    std::size_t read;
+    while ((read = std::fread(buffer, 1, sizeof(buffer), file)) > 0)
+        data.insert(data.end(), buffer, buffer + read);
+    std::fclose(file);
+
+    std::size_t pos = 0;
+    while (pos + 2 <= data.size()) {
+        const std::size_t start = pos;
+        for (;;) {
+            if (pos + 2 > data.size())
+                return ret; //truncated
+            const unsigned cb = unsigned(data[pos]) | unsigned(data[pos + 1]) << 8;
+            if (!cb)
+                break;
+            if (cb < 2)
+                return ret; //malformed
+            pos += cb;
+        }
+        pos += 2;
+        ret.emplace_back(data.begin() + std::ptrdiff_t(start), data.begin() + std::ptrdiff_t(pos));
+    }
+    return ret;
+}
+
+//! Writes \a corpus to \a path in the format read by load().
+inline bool save(const std::string &path, const std::vector<Bytes> &corpus)
+{
+    std::FILE *file = std::fopen(path.c_str(), "wb");
+    if (!file)
+        return false;
+    bool ok = true;
+    for (const auto &list : corpus)
+        ok = ok && std::fwrite(list.data(), 1, list.size(), file) == list.size();
+    return std::fclose(file) == 0 && ok;
+}
+
+} // namespace pidl_corpus
+
+#endif // QE_TEST_PIDLCORPUS_H
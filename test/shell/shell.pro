@@ -0,0 +1,35 @@
+TARGET = shell_test
+TEMPLATE = app
+CONFIG += console c++1z thread
+CONFIG -= qt
+
+INCLUDEPATH += ../../Include
+
+#stand-ins for the SDK headers used by the platform-neutral parts of qewindows
+!win32: INCLUDEPATH += $$PWD/shim
+win32: LIBS += -lShell32
+
+SOURCES += \
+    $$PWD/main.cpp
+
+HEADERS += \
+    $$PWD/../core/test.h \
+    $$PWD/../core/perfcounters.h \
+    $$PWD/../core/baseline.h \
+    $$PWD/test_nodeflags.h \
+    $$PWD/pidlcorpus.h \
+    $$PWD/test_pidl.h \
+    $$PWD/test_idlist.h \
+    $$PWD/bench_idlist.h \
+    $$PWD/fakeshell.h \
+    $$PWD/test_fakeshell.h
+
+!win32: HEADERS += \
+    $$PWD/shim/windows_shim.h \
+    $$PWD/shim/ShlObj.h \
+    $$PWD/shim/ShlObj_core.h \
+    $$PWD/shim/combaseapi.h \
+    $$PWD/shim/propkey.h \
+    $$PWD/shim/shtypes.h \
+    $$PWD/shim/strsafe.h \
+    $$PWD/shim/wtypes.h
@@ -0,0 +1,24 @@
+/*  QExt: Extensions to Qt
+ *  Copyright (C) 2016  Jonathan Harper
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+//stand-in for the Windows SDK header of the same name; see windows_shim.h
+#ifndef QE_TEST_SHIM_SHLOBJ_H
+#define QE_TEST_SHIM_SHLOBJ_H
+
+#include "windows_shim.h"
+
+#endif // QE_TEST_SHIM_SHLOBJ_H
@@ -0,0 +1,698 @@
+/*  QExt: Extensions to Qt
+ *  Copyright (C) 2016  Jonathan Harper
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+    A minimal stand-in for the parts of the Windows SDK that qewindows' shell code uses, so that
+    the ID list and node model can be built and exercised on other platforms. The SDK-named
+    headers in this directory (ShlObj.h, combaseapi.h and so on) all include this file.
+
+    Types, constants and flag values follow the SDK. Interfaces declare only the methods that
+    qewindows calls, in their SDK order; IIDs and BHIDs are distinct placeholders rather than the
+    SDK values. Memory from CoTaskMemAlloc, SysAllocString and the IL* functions comes from malloc.
+
+    Functions that need a shell namespace (SHGetDesktopFolder, SHCreateItemFromIDList and so on)
+    forward to qe_shim::ShellProvider, which tests install; see test/shell/fakeshell.h. Without a
+    provider they fail with E_NOTIMPL.
+*/
+
+#ifndef QE_TEST_SHIM_WINDOWS_SHIM_H
+#define QE_TEST_SHIM_WINDOWS_SHIM_H
+
+#ifdef _WIN32
+#  error "The Windows SDK shim must not be used on Windows."
+#endif
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <cwchar>
+#include <type_traits>
+
+#ifndef __unaligned
+#  define __unaligned
+#endif
+#define STDMETHODCALLTYPE
+#define WINAPI
+
+using BYTE = std::uint8_t;
+using UCHAR = std::uint8_t;
+using CHAR = char;
+using SHORT = std::int16_t;
+using USHORT = std::uint16_t;
+using WORD = std::uint16_t;
+using INT = int;
+using UINT = unsigned int;
+using LONG = std::int32_t;
+using ULONG = std::uint32_t;
+using DWORD = std::uint32_t;
+using LONGLONG = std::int64_t;
+using ULONGLONG = std::uint64_t;
+using FLOAT = float;
+using DOUBLE = double;
+using BOOL = int;
+using HRESULT = std::int32_t;
+using SCODE = std::int32_t;
+using HANDLE = void *;
+using WCHAR = wchar_t;
+using OLECHAR = wchar_t;
+using LPSTR = char *;
+using LPWSTR = wchar_t *;
+using PWSTR = wchar_t *;
+using LPCWSTR = const wchar_t *;
+using PCWSTR = const wchar_t *;
+using BSTR = wchar_t *;
+using VARTYPE = std::uint16_t;
+using VARIANT_BOOL = std::int16_t;
+using SFGAOF = ULONG;
+using SICHINTF = DWORD;
+
+#ifndef TRUE
+#  define TRUE 1
+#  define FALSE 0
+#endif
+#define MAX_PATH 260
+
+constexpr HRESULT S_OK = 0;
+constexpr HRESULT S_FALSE = 1;
+constexpr HRESULT E_NOTIMPL = HRESULT(0x80004001u);
+constexpr HRESULT E_NOINTERFACE = HRESULT(0x80004002u);
+constexpr HRESULT E_POINTER = HRESULT(0x80004003u);
+constexpr HRESULT E_FAIL = HRESULT(0x80004005u);
+constexpr HRESULT E_OUTOFMEMORY = HRESULT(0x8007000Eu);
+constexpr HRESULT E_INVALIDARG = HRESULT(0x80070057u);
+constexpr HRESULT HRESULT_FILE_NOT_FOUND = HRESULT(0x80070002u);
+#define SUCCEEDED(hr) (HRESULT(hr) >= 0)
+#define FAILED(hr) (HRESULT(hr) < 0)
+
+struct GUID
+{
+    std::uint32_t Data1;
+    std::uint16_t Data2;
+    std::uint16_t Data3;
+    std::uint8_t Data4[8];
+};
+using IID = GUID;
+using CLSID = GUID;
+using KNOWNFOLDERID = GUID;
+using REFGUID = const GUID &;
+using REFIID = const IID &;
+using REFCLSID = const CLSID &;
+using REFKNOWNFOLDERID = const KNOWNFOLDERID &;
+
+inline bool operator==(const GUID &a, const GUID &b)
+{
+    return std::memcmp(&a, &b, sizeof(GUID)) == 0;
+}
+
+inline bool operator!=(const GUID &a, const GUID &b)
+{
+    return !(a == b);
+}
+
+//! Placeholder GUIDs; only their distinctness matters here.
+#define QE_SHIM_GUID(n) GUID{0x51E00000u + (n), 0x51E0, 0x51E0, {0x51, 0xE0, 0, 0, 0, 0, 0, 0}}
+
+struct FILETIME
+{
+    DWORD dwLowDateTime;
+    DWORD dwHighDateTime;
+};
+
+union LARGE_INTEGER { LONGLONG QuadPart; };
+union ULARGE_INTEGER { ULONGLONG QuadPart; };
+
+struct PROPERTYKEY
+{
+    GUID fmtid;
+    DWORD pid;
+};
+using REFPROPERTYKEY = const PROPERTYKEY &;
+
+inline bool operator==(const PROPERTYKEY &a, const PROPERTYKEY &b)
+{
+    return a.fmtid == b.fmtid && a.pid == b.pid;
+}
+
+struct CAUB { ULONG cElems; UCHAR *pElems; };
+struct CAUI { ULONG cElems; USHORT *pElems; };
+
+enum VARENUM : VARTYPE {
+    VT_EMPTY = 0, VT_NULL = 1, VT_I2 = 2, VT_I4 = 3, VT_R4 = 4, VT_R8 = 5, VT_CY = 6, VT_DATE = 7,
+    VT_BSTR = 8, VT_ERROR = 10, VT_BOOL = 11, VT_DECIMAL = 14, VT_I1 = 16, VT_UI1 = 17, VT_UI2 = 18,
+    VT_UI4 = 19, VT_I8 = 20, VT_UI8 = 21, VT_INT = 22, VT_UINT = 23, VT_LPSTR = 30, VT_LPWSTR = 31,
+    VT_FILETIME = 64, VT_BLOB = 65, VT_CF = 71, VT_CLSID = 72, VT_BLOB_OBJECT = 70,
+    VT_VECTOR = 0x1000
+};
+
+struct PROPVARIANT
+{
+    VARTYPE vt;
+    WORD wReserved1;
+    WORD wReserved2;
+    WORD wReserved3;
+    union {
+        CHAR cVal;
+        UCHAR bVal;
+        SHORT iVal;
+        USHORT uiVal;
+        LONG lVal;
+        ULONG ulVal;
+        INT intVal;
+        UINT uintVal;
+        LARGE_INTEGER hVal;
+        ULARGE_INTEGER uhVal;
+        FLOAT fltVal;
+        DOUBLE dblVal;
+        VARIANT_BOOL boolVal;
+        SCODE scode;
+        FILETIME filetime;
+        BSTR bstrVal;
+        LPSTR pszVal;
+        LPWSTR pwszVal;
+        CAUB caub;
+        CAUI caui;
+    };
+};
+using REFPROPVARIANT = const PROPVARIANT &;
+
+//! Declared for winutil.h; nothing in the shim produces them.
+struct RECT
+{
+    LONG left;
+    LONG top;
+    LONG right;
+    LONG bottom;
+};
+using COLORREF = DWORD;
+
+struct VARIANT
+{
+    VARTYPE vt;
+    WORD wReserved1;
+    WORD wReserved2;
+    WORD wReserved3;
+    union {
+        LONG lVal;
+        ULONG ulVal;
+        DOUBLE dblVal;
+        VARIANT_BOOL boolVal;
+        BSTR bstrVal;
+    };
+};
+
+namespace qe_shim {
+//! The number of CoTaskMemAlloc calls that fail before allocations succeed again, for tests of
+//! allocation failure.
+inline int &failingAllocations()
+{
+    static int count = 0;
+    return count;
+}
+
+//! The number of blocks from CoTaskMemAlloc that have not been freed, for leak checks.
+inline long &taskAllocations()
+{
+    static long count = 0;
+    return count;
+}
+} // namespace qe_shim
+
+inline void *CoTaskMemAlloc(std::size_t size)
+{
+    if (qe_shim::failingAllocations() > 0) {
+        --qe_shim::failingAllocations();
+        return nullptr;
+    }
+    void *ret = std::malloc(size ? size : 1);
+    if (ret)
+        ++qe_shim::taskAllocations();
+    return ret;
+}
+
+inline void CoTaskMemFree(void *ptr)
+{
+    if (ptr)
+        --qe_shim::taskAllocations();
+    std::free(ptr);
+}
+
+inline HRESULT CoInitialize(void *)             { return S_OK; }
+inline void CoUninitialize()                    {}
+
+inline void PropVariantInit(PROPVARIANT *pv)
+{
+    std::memset(pv, 0, sizeof(PROPVARIANT));
+}
+
+inline HRESULT PropVariantClear(PROPVARIANT *pv)
+{
+    if (!pv)
+        return S_OK;
+    switch (pv->vt) {
+    case VT_LPWSTR:
+    case VT_LPSTR:
+    case VT_BSTR:
+        CoTaskMemFree(pv->pwszVal);
+        break;
+    case VT_VECTOR | VT_UI1:
+    case VT_VECTOR | VT_UI2:
+        CoTaskMemFree(pv->caub.pElems);
+        break;
+    default:
+        break;
+    }
+    PropVariantInit(pv);
+    return S_OK;
+}
+
+inline BSTR SysAllocString(const OLECHAR *text)
+{
+    if (!text)
+        return nullptr;
+    const std::size_t length = std::wcslen(text) + 1;
+    auto ret = static_cast<BSTR>(CoTaskMemAlloc(length * sizeof(OLECHAR)));
+    std::wmemcpy(ret, text, length);
+    return ret;
+}
+
+inline void SysFreeString(BSTR text)            { CoTaskMemFree(text); }
+
+#define STRSAFE_MAX_CCH 2147483647
+
+inline HRESULT StringCbLengthW(const wchar_t *text, std::size_t maxBytes, std::size_t *bytes)
+{
+    if (!text)
+        return E_INVALIDARG;
+    const std::size_t length = std::wcslen(text) * sizeof(wchar_t);
+    if (bytes)
+        *bytes = length;
+    return length < maxBytes ? S_OK : E_INVALIDARG;
+}
+
+inline HRESULT StringCchCopyW(wchar_t *dest, std::size_t destChars, const wchar_t *src)
+{
+    if (!dest || !destChars)
+        return E_INVALIDARG;
+    std::size_t i = 0;
+    for (; i + 1 < destChars && src[i]; ++i)
+        dest[i] = src[i];
+    dest[i] = 0;
+    return src[i] ? E_INVALIDARG : S_OK;
+}
+
+////////
+// Item ids
+
+#pragma pack(push, 1)
+typedef struct _SHITEMID
+{
+    USHORT cb;
+    BYTE abID[1];
+} SHITEMID;
+
+typedef struct _ITEMIDLIST
+{
+    SHITEMID mkid;
+} ITEMIDLIST;
+#pragma pack(pop)
+
+static_assert(sizeof(SHITEMID) == 3, "SHITEMID must be packed");
+
+typedef struct _ITEMIDLIST_RELATIVE : ITEMIDLIST {} ITEMIDLIST_RELATIVE;
+typedef struct _ITEMID_CHILD : ITEMIDLIST_RELATIVE {} ITEMID_CHILD;
+typedef struct _ITEMIDLIST_ABSOLUTE : ITEMIDLIST_RELATIVE {} ITEMIDLIST_ABSOLUTE;
+
+typedef ITEMIDLIST_ABSOLUTE *PIDLIST_ABSOLUTE;
+typedef const ITEMIDLIST_ABSOLUTE *PCIDLIST_ABSOLUTE;
+typedef __unaligned ITEMIDLIST_ABSOLUTE *PUIDLIST_ABSOLUTE;
+typedef const __unaligned ITEMIDLIST_ABSOLUTE *PCUIDLIST_ABSOLUTE;
+
+typedef ITEMIDLIST_RELATIVE *PIDLIST_RELATIVE;
+typedef const ITEMIDLIST_RELATIVE *PCIDLIST_RELATIVE;
+typedef __unaligned ITEMIDLIST_RELATIVE *PUIDLIST_RELATIVE;
+typedef const __unaligned ITEMIDLIST_RELATIVE *PCUIDLIST_RELATIVE;
+
+typedef ITEMID_CHILD *PITEMID_CHILD;
+typedef const ITEMID_CHILD *PCITEMID_CHILD;
+typedef __unaligned ITEMID_CHILD *PUITEMID_CHILD;
+typedef const __unaligned ITEMID_CHILD *PCUITEMID_CHILD;
+
+//! Returns the size of \a pidl in bytes, including the terminator.
+inline UINT ILGetSize(PCUIDLIST_RELATIVE pidl)
+{
+    if (!pidl)
+        return 0;
+    auto p = reinterpret_cast<const unsigned char *>(pidl);
+    UINT size = 0;
+    USHORT cb;
+    while (std::memcpy(&cb, p + size, sizeof(cb)), cb)
+        size += cb;
+    return size + sizeof(USHORT);
+}
+
+//! Returns a copy of \a pidl allocated with CoTaskMemAlloc.
+inline PIDLIST_ABSOLUTE ILCloneFull(PCUIDLIST_ABSOLUTE pidl)
+{
+    if (!pidl)
+        return nullptr;
+    const UINT size = ILGetSize(pidl);
+    void *ret = CoTaskMemAlloc(size);
+    if (!ret)
+        return nullptr;
+    std::memcpy(ret, pidl, size);
+    return static_cast<PIDLIST_ABSOLUTE>(ret);
+}
+
+inline void ILFree(PIDLIST_RELATIVE pidl)       { CoTaskMemFree(pidl); }
+
+//! Removes the last item of \a pidl in place. Returns FALSE if \a pidl is empty.
+inline BOOL ILRemoveLastID(PUIDLIST_RELATIVE pidl)
+{
+    if (!pidl || !pidl->mkid.cb)
+        return FALSE;
+    auto p = reinterpret_cast<unsigned char *>(pidl);
+    UINT last = 0;
+    UINT pos = 0;
+    USHORT cb;
+    while (std::memcpy(&cb, p + pos, sizeof(cb)), cb) {
+        last = pos;
+        pos += cb;
+    }
+    std::memset(p + last, 0, sizeof(USHORT));
+    return TRUE;
+}
+
+////////
+// Shell constants
+
+constexpr SFGAOF SFGAO_CANCOPY      = 0x00000001;
+constexpr SFGAOF SFGAO_CANMOVE      = 0x00000002;
+constexpr SFGAOF SFGAO_CANLINK      = 0x00000004;
+constexpr SFGAOF SFGAO_STORAGE      = 0x00000008;
+constexpr SFGAOF SFGAO_CANRENAME    = 0x00000010;
+constexpr SFGAOF SFGAO_CANDELETE    = 0x00000020;
+constexpr SFGAOF SFGAO_SYSTEM       = 0x00001000;
+constexpr SFGAOF SFGAO_ENCRYPTED    = 0x00002000;
+constexpr SFGAOF SFGAO_ISSLOW       = 0x00004000;
+constexpr SFGAOF SFGAO_GHOSTED      = 0x00008000;
+constexpr SFGAOF SFGAO_LINK         = 0x00010000;
+constexpr SFGAOF SFGAO_READONLY     = 0x00040000;
+constexpr SFGAOF SFGAO_HIDDEN       = 0x00080000;
+constexpr SFGAOF SFGAO_STREAM       = 0x00400000;
+constexpr SFGAOF SFGAO_REMOVABLE    = 0x02000000;
+constexpr SFGAOF SFGAO_COMPRESSED   = 0x04000000;
+constexpr SFGAOF SFGAO_FOLDER       = 0x20000000;
+constexpr SFGAOF SFGAO_FILESYSTEM   = 0x40000000;
+constexpr SFGAOF SFGAO_HASSUBFOLDER = 0x80000000;
+
+constexpr DWORD FILE_ATTRIBUTE_READONLY      = 0x00000001;
+constexpr DWORD FILE_ATTRIBUTE_HIDDEN        = 0x00000002;
+constexpr DWORD FILE_ATTRIBUTE_SYSTEM        = 0x00000004;
+constexpr DWORD FILE_ATTRIBUTE_DIRECTORY     = 0x00000010;
+constexpr DWORD FILE_ATTRIBUTE_ARCHIVE       = 0x00000020;
+constexpr DWORD FILE_ATTRIBUTE_NORMAL        = 0x00000080;
+constexpr DWORD FILE_ATTRIBUTE_REPARSE_POINT = 0x00000400;
+constexpr DWORD FILE_ATTRIBUTE_COMPRESSED    = 0x00000800;
+constexpr DWORD FILE_ATTRIBUTE_ENCRYPTED     = 0x00004000;
+constexpr DWORD IO_REPARSE_TAG_MOUNT_POINT   = 0xA0000003;
+constexpr DWORD IO_REPARSE_TAG_SYMLINK       = 0xA000000C;
+
+struct WIN32_FIND_DATAW
+{
+    DWORD dwFileAttributes;
+    FILETIME ftCreationTime;
+    FILETIME ftLastAccessTime;
+    FILETIME ftLastWriteTime;
+    DWORD nFileSizeHigh;
+    DWORD nFileSizeLow;
+    DWORD dwReserved0;
+    DWORD dwReserved1;
+    WCHAR cFileName[MAX_PATH];
+    WCHAR cAlternateFileName[14];
+};
+using WIN32_FIND_DATA = WIN32_FIND_DATAW;
+
+enum SIGDN : int {
+    SIGDN_NORMALDISPLAY                 = 0x00000000,
+    SIGDN_PARENTRELATIVEPARSING         = int(0x80018001),
+    SIGDN_DESKTOPABSOLUTEPARSING        = int(0x80028000),
+    SIGDN_PARENTRELATIVEEDITING         = int(0x80031001),
+    SIGDN_DESKTOPABSOLUTEEDITING        = int(0x8004c000),
+    SIGDN_FILESYSPATH                   = int(0x80058000),
+    SIGDN_URL                           = int(0x80068000),
+    SIGDN_PARENTRELATIVEFORADDRESSBAR   = int(0x8007c001),
+    SIGDN_PARENTRELATIVE                = int(0x80080001),
+    SIGDN_PARENTRELATIVEFORUI           = int(0x80094001)
+};
+
+enum _SICHINTF : DWORD {
+    SICHINT_DISPLAY                         = 0,
+    SICHINT_ALLFIELDS                       = 0x80000000,
+    SICHINT_CANONICAL                       = 0x10000000,
+    SICHINT_TEST_FILESYSPATH_IF_NOT_EQUAL   = 0x20000000
+};
+
+enum KNOWN_FOLDER_FLAG : DWORD {
+    KF_FLAG_DEFAULT     = 0x00000000,
+    KF_FLAG_NO_ALIAS    = 0x00001000
+};
+
+enum GPFIDL_FLAGS : int {
+    GPFIDL_DEFAULT  = 0,
+    GPFIDL_ALTNAME  = 1,
+    GPFIDL_UNCPRINTER = 2
+};
+
+enum GETPROPERTYSTOREFLAGS : int {
+    GPS_DEFAULT = 0
+};
+
+enum CLSCTX : DWORD {
+    CLSCTX_INPROC_SERVER = 0x1,
+    CLSCTX_INPROC_HANDLER = 0x2,
+    CLSCTX_INPROC = CLSCTX_INPROC_SERVER | CLSCTX_INPROC_HANDLER
+};
+
+constexpr GUID BHID_SFObject            = QE_SHIM_GUID(0x100);
+constexpr GUID BHID_Stream              = QE_SHIM_GUID(0x101);
+constexpr GUID BHID_Storage             = QE_SHIM_GUID(0x102);
+constexpr GUID BHID_EnumItems           = QE_SHIM_GUID(0x103);
+constexpr GUID BHID_Transfer            = QE_SHIM_GUID(0x104);
+constexpr GUID BHID_PropertyStore       = QE_SHIM_GUID(0x105);
+constexpr GUID BHID_ThumbnailHandler    = QE_SHIM_GUID(0x106);
+constexpr GUID BHID_DataObject          = QE_SHIM_GUID(0x107);
+constexpr GUID BHID_AssociationArray    = QE_SHIM_GUID(0x108);
+constexpr GUID BHID_EnumAssocHandlers   = QE_SHIM_GUID(0x109);
+constexpr GUID BHID_Filter              = QE_SHIM_GUID(0x10A);
+
+constexpr KNOWNFOLDERID FOLDERID_Desktop = QE_SHIM_GUID(0x200);
+
+//! The WIN32_FIND_DATA of a file system item, as a VT_VECTOR | VT_UI1.
+constexpr PROPERTYKEY PKEY_FindData     = {QE_SHIM_GUID(0x300), 0};
+constexpr PROPERTYKEY PKEY_ItemNameDisplay = {QE_SHIM_GUID(0x301), 10};
+constexpr PROPERTYKEY PKEY_Size         = {QE_SHIM_GUID(0x302), 12};
+constexpr PROPERTYKEY PKEY_DateModified = {QE_SHIM_GUID(0x302), 14};
+
+////////
+// Interfaces
+
+//! Declares the IID of an interface, used by IID_PPV_ARGS in place of `__uuidof`.
+#define QE_SHIM_IID(n) static constexpr IID qe_iid = QE_SHIM_GUID(n);
+
+struct IUnknown
+{
+    QE_SHIM_IID(0)
+    virtual HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void **ppv) = 0;
+    virtual ULONG STDMETHODCALLTYPE AddRef() = 0;
+    virtual ULONG STDMETHODCALLTYPE Release() = 0;
+
+protected:
+    ~IUnknown() = default;
+};
+
+struct IDispatch : IUnknown             { QE_SHIM_IID(1) };
+struct IBindCtx : IUnknown              { QE_SHIM_IID(2) };
+struct IStream : IUnknown               { QE_SHIM_IID(3) };
+struct IStorage : IUnknown              { QE_SHIM_IID(4) };
+struct ITransferSource : IUnknown       { QE_SHIM_IID(5) };
+struct ITransferDestination : IUnknown  { QE_SHIM_IID(6) };
+struct IPropertyStoreFactory : IUnknown { QE_SHIM_IID(7) };
+struct IExtractImage : IUnknown         { QE_SHIM_IID(8) };
+struct IThumbnailProvider : IUnknown    { QE_SHIM_IID(9) };
+struct IDataObject : IUnknown           { QE_SHIM_IID(10) };
+struct IQueryAssociation : IUnknown     { QE_SHIM_IID(11) };
+struct IEnumAssocHandlers : IUnknown    { QE_SHIM_IID(12) };
+struct IFilter : IUnknown               { QE_SHIM_IID(13) };
+struct IShellFolder : IUnknown          { QE_SHIM_IID(14) };
+struct IShellFolder2 : IShellFolder     { QE_SHIM_IID(15) };
+
+struct IShellItem : IUnknown
+{
+    QE_SHIM_IID(16)
+    virtual HRESULT STDMETHODCALLTYPE BindToHandler(IBindCtx *pbc, REFGUID bhid, REFIID riid, void **ppv) = 0;
+    virtual HRESULT STDMETHODCALLTYPE GetParent(IShellItem **ppsi) = 0;
+    virtual HRESULT STDMETHODCALLTYPE GetDisplayName(SIGDN sigdnName, LPWSTR *ppszName) = 0;
+    virtual HRESULT STDMETHODCALLTYPE GetAttributes(SFGAOF sfgaoMask, SFGAOF *psfgaoAttribs) = 0;
+    virtual HRESULT STDMETHODCALLTYPE Compare(IShellItem *psi, SICHINTF hint, int *piOrder) = 0;
+};
+
+struct IShellItem2 : IShellItem
+{
+    QE_SHIM_IID(17)
+    virtual HRESULT STDMETHODCALLTYPE GetPropertyStore(GETPROPERTYSTOREFLAGS flags, REFIID riid, void **ppv) = 0;
+    virtual HRESULT STDMETHODCALLTYPE Update(IBindCtx *pbc) = 0;
+    virtual HRESULT STDMETHODCALLTYPE GetProperty(REFPROPERTYKEY key, PROPVARIANT *ppropvar) = 0;
+    virtual HRESULT STDMETHODCALLTYPE GetString(REFPROPERTYKEY key, LPWSTR *ppsz) = 0;
+    virtual HRESULT STDMETHODCALLTYPE GetUInt32(REFPROPERTYKEY key, ULONG *pui) = 0;
+    virtual HRESULT STDMETHODCALLTYPE GetUInt64(REFPROPERTYKEY key, ULONGLONG *pull) = 0;
+    virtual HRESULT STDMETHODCALLTYPE GetBool(REFPROPERTYKEY key, BOOL *pf) = 0;
+};
+
+struct IEnumShellItems : IUnknown
+{
+    QE_SHIM_IID(18)
+    virtual HRESULT STDMETHODCALLTYPE Next(ULONG celt, IShellItem **rgelt, ULONG *pceltFetched) = 0;
+    virtual HRESULT STDMETHODCALLTYPE Skip(ULONG celt) = 0;
+    virtual HRESULT STDMETHODCALLTYPE Reset() = 0;
+    virtual HRESULT STDMETHODCALLTYPE Clone(IEnumShellItems **ppenum) = 0;
+};
+
+struct IPropertyStore : IUnknown
+{
+    QE_SHIM_IID(19)
+    virtual HRESULT STDMETHODCALLTYPE GetCount(DWORD *cProps) = 0;
+    virtual HRESULT STDMETHODCALLTYPE GetAt(DWORD iProp, PROPERTYKEY *pkey) = 0;
+    virtual HRESULT STDMETHODCALLTYPE GetValue(REFPROPERTYKEY key, PROPVARIANT *pv) = 0;
+    virtual HRESULT STDMETHODCALLTYPE SetValue(REFPROPERTYKEY key, REFPROPVARIANT propvar) = 0;
+    virtual HRESULT STDMETHODCALLTYPE Commit() = 0;
+};
+
+namespace qe_shim {
+
+template <class T>
+inline REFIID iid_of(T **)                      { return T::qe_iid; }
+
+template <class T>
+inline void **ppv_of(T **pp)                    { return reinterpret_cast<void **>(pp); }
+
+/*!
+    \brief Implements the SDK functions that need a shell namespace.
+
+    Install an instance with setShellProvider(); the shim's SH* functions forward to it.
+*/
+class ShellProvider
+{
+public:
+    virtual ~ShellProvider() = default;
+
+    virtual HRESULT desktopFolder(IShellFolder **folder) = 0;
+    virtual HRESULT itemFromObject(IUnknown *object, REFIID riid, void **ppv) = 0;
+    virtual HRESULT itemFromIdList(PCIDLIST_ABSOLUTE id, REFIID riid, void **ppv) = 0;
+    virtual HRESULT itemFromParsingName(PCWSTR path, IBindCtx *ctx, REFIID riid, void **ppv) = 0;
+    virtual HRESULT idListFromObject(IUnknown *object, PIDLIST_ABSOLUTE *id) = 0;
+    virtual HRESULT knownFolderIdList(REFKNOWNFOLDERID folder, PIDLIST_ABSOLUTE *id) = 0;
+    virtual HRESULT pathFromIdList(PCIDLIST_ABSOLUTE id, PWSTR path, DWORD chars) = 0;
+    virtual HRESULT createBindContext(IBindCtx **ctx) = 0;
+};
+
+inline ShellProvider *&shellProvider()
+{
+    static ShellProvider *provider = nullptr;
+    return provider;
+}
+
+//! Makes \a provider handle the SH* functions and returns the previous provider.
+inline ShellProvider *setShellProvider(ShellProvider *provider)
+{
+    ShellProvider *old = shellProvider();
+    shellProvider() = provider;
+    return old;
+}
+
+} // namespace qe_shim
+
+#define IID_PPV_ARGS(pp) ::qe_shim::iid_of(pp), ::qe_shim::ppv_of(pp)
+
+inline HRESULT CoCreateInstance(REFCLSID, IUnknown *, DWORD, REFIID, void **ppv)
+{
+    if (ppv)
+        *ppv = nullptr;
+    return E_NOTIMPL;
+}
+
+inline HRESULT SHGetDesktopFolder(IShellFolder **ppshf)
+{
+    auto p = qe_shim::shellProvider();
+    return p ? p->desktopFolder(ppshf) : E_NOTIMPL;
+}
+
+inline HRESULT SHGetItemFromObject(IUnknown *punk, REFIID riid, void **ppv)
+{
+    auto p = qe_shim::shellProvider();
+    return p ? p->itemFromObject(punk, riid, ppv) : E_NOTIMPL;
+}
+
+inline HRESULT SHCreateItemFromIDList(PCIDLIST_ABSOLUTE pidl, REFIID riid, void **ppv)
+{
+    auto p = qe_shim::shellProvider();
+    return p ? p->itemFromIdList(pidl, riid, ppv) : E_NOTIMPL;
+}
+
+inline HRESULT SHCreateItemFromParsingName(PCWSTR pszPath, IBindCtx *pbc, REFIID riid, void **ppv)
+{
+    auto p = qe_shim::shellProvider();
+    return p ? p->itemFromParsingName(pszPath, pbc, riid, ppv) : E_NOTIMPL;
+}
+
+inline HRESULT SHGetIDListFromObject(IUnknown *punk, PIDLIST_ABSOLUTE *ppidl)
+{
+    auto p = qe_shim::shellProvider();
+    return p ? p->idListFromObject(punk, ppidl) : E_NOTIMPL;
+}
+
+inline HRESULT SHGetKnownFolderIDList(REFKNOWNFOLDERID rfid, DWORD, HANDLE, PIDLIST_ABSOLUTE *ppidl)
+{
+    auto p = qe_shim::shellProvider();
+    return p ? p->knownFolderIdList(rfid, ppidl) : E_NOTIMPL;
+}
+
+inline HRESULT SHGetKnownFolderItem(REFKNOWNFOLDERID rfid, KNOWN_FOLDER_FLAG flags, HANDLE token,
+                                    REFIID riid, void **ppv)
+{
+    PIDLIST_ABSOLUTE pidl = nullptr;
+    HRESULT hr = SHGetKnownFolderIDList(rfid, flags, token, &pidl);
+    if (FAILED(hr))
+        return hr;
+    hr = SHCreateItemFromIDList(pidl, riid, ppv);
+    ILFree(pidl);
+    return hr;
+}
+
+inline BOOL SHGetPathFromIDListEx(PCIDLIST_ABSOLUTE pidl, PWSTR pszPath, DWORD cchPath, GPFIDL_FLAGS)
+{
+    auto p = qe_shim::shellProvider();
+    return p && SUCCEEDED(p->pathFromIdList(pidl, pszPath, cchPath)) ? TRUE : FALSE;
+}
+
+inline HRESULT CreateBindCtx(DWORD, IBindCtx **ppbc)
+{
+    auto p = qe_shim::shellProvider();
+    return p ? p->createBindContext(ppbc) : E_NOTIMPL;
+}
+
+#endif // QE_TEST_SHIM_WINDOWS_SHIM_H
@@ -0,0 +1,286 @@
+/*  QExt: Extensions to Qt
+ *  Copyright (C) 2016  Jonathan Harper
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QE_TEST_FAKESHELL_TEST_H
+#define QE_TEST_FAKESHELL_TEST_H
+
+#include <chrono>
+#include <cwchar>
+#include "fakeshell.h"
+#include "../core/test.h"
+
+//! Checks the fake shell namespace through the SDK entry points that qewindows uses.
+struct fakeshell_test
+{
+    static void run()
+    {
+        tree_test();
+        sdk_test();
+        enum_test();
+        property_test();
+        latency_test();
+        provider_test();
+    }
+
+    //! Returns the desktop item, as `shell::desktopItem` obtains it.
+    static IShellItem2 *desktop()
+    {
+        IShellFolder *folder = nullptr;
+        IShellItem2 *ret = nullptr;
+        EXPECT_EQ(SHGetDesktopFolder(&folder), S_OK);
+        EXPECT_EQ(SHGetItemFromObject(folder, IID_PPV_ARGS(&ret)), S_OK);
+        folder->Release();
+        return ret;
+    }
+
+    static void tree_test()
+    {
+        fake_shell::Options options;
+        options.depth = 2;
+        options.foldersPerFolder = 3;
+        options.filesPerFolder = 4;
+        std::vector<pidl_corpus::Bytes> ids;
+        {
+            fake_shell::Namespace ns(options);
+            //the desktop, 3 + 4 children, and 3 + 4 below each of the 3 folders
+            EXPECT_EQ(ns.size(), 29u);
+            EXPECT_EQ(ns.root()->children.size(), 7u);
+            for (const auto &child : ns.root()->children) {
+                ids.push_back(child->id);
+                EXPECT_TRUE(child->parent == ns.root());
+                EXPECT_TRUE(ns.find(reinterpret_cast<PCUIDLIST_ABSOLUTE>(child->id.data())) == child.get());
+            }
+            EXPECT_TRUE(ns.root()->children.front()->isFolder());
+            EXPECT_FALSE(ns.root()->children.back()->isFolder());
+        }
+        fake_shell::Namespace same(options);
+        for (std::size_t i = 0; i < ids.size(); ++i)
+            EXPECT_TRUE(same.root()->children[i]->id == ids[i]);
+    }
+
+    static void sdk_test()
+    {
+        fake_shell::Namespace ns;
+        IShellItem2 *root = desktop();
+        EXPECT_TRUE(root != nullptr);
+
+        PIDLIST_ABSOLUTE id = nullptr;
+        EXPECT_EQ(SHGetIDListFromObject(root, &id), S_OK);
+        EXPECT_EQ(ILGetSize(id), 2u);
+        ILFree(id);
+
+        LPWSTR name = nullptr;
+        EXPECT_EQ(root->GetDisplayName(SIGDN_NORMALDISPLAY, &name), S_OK);
+        EXPECT_EQ(std::wcscmp(name, L"Desktop"), 0);
+        CoTaskMemFree(name);
+
+        //an item recreated from its ID list compares equal to the original
+        const fake_shell::Node *node = ns.root()->children.front()->children.back().get();
+        IShellItem2 *item = nullptr;
+        EXPECT_EQ(SHCreateItemFromIDList(reinterpret_cast<PCIDLIST_ABSOLUTE>(node->id.data()),
+                                         IID_PPV_ARGS(&item)), S_OK);
+        EXPECT_EQ(SHGetIDListFromObject(item, &id), S_OK);
+        IShellItem2 *copy = nullptr;
+        EXPECT_EQ(SHCreateItemFromIDList(id, IID_PPV_ARGS(&copy)), S_OK);
+        ILFree(id);
+        int order = 1;
+        EXPECT_EQ(item->Compare(copy, SICHINT_CANONICAL, &order), S_OK);
+        EXPECT_EQ(order, 0);
+        EXPECT_EQ(item->Compare(root, SICHINT_CANONICAL, &order), S_FALSE);
+        EXPECT_GT(order, 0);
+
+        EXPECT_EQ(item->GetDisplayName(SIGDN_FILESYSPATH, &name), S_OK);
+        EXPECT_TRUE(node->path == name);
+        IShellItem2 *byName = nullptr;
+        EXPECT_EQ(SHCreateItemFromParsingName(name, nullptr, IID_PPV_ARGS(&byName)), S_OK);
+        EXPECT_EQ(byName->Compare(item, SICHINT_CANONICAL, &order), S_OK);
+        CoTaskMemFree(name);
+
+        IShellItem *parent = nullptr;
+        EXPECT_EQ(item->GetParent(&parent), S_OK);
+        PIDLIST_ABSOLUTE parentId = nullptr;
+        EXPECT_EQ(SHGetIDListFromObject(parent, &parentId), S_OK);
+        EXPECT_TRUE(ns.find(parentId) == node->parent);
+        ILFree(parentId);
+        IShellItem *none = nullptr;
+        EXPECT_EQ(root->GetParent(&none), E_FAIL);
+        EXPECT_TRUE(none == nullptr);
+
+        SFGAOF attributes = 0;
+        EXPECT_EQ(item->GetAttributes(SFGAO_FOLDER | SFGAO_STREAM, &attributes), S_FALSE);
+        EXPECT_EQ(attributes, SFGAO_STREAM);
+
+        IBindCtx *ctx = nullptr;
+        EXPECT_EQ(CreateBindCtx(0, &ctx), S_OK);
+        IEnumShellItems *items = nullptr;
+        EXPECT_EQ(item->BindToHandler(ctx, BHID_EnumItems, IID_PPV_ARGS(&items)), E_NOINTERFACE);
+        EXPECT_TRUE(items == nullptr);
+
+        for (IUnknown *object : {static_cast<IUnknown *>(root), static_cast<IUnknown *>(item),
+                                 static_cast<IUnknown *>(copy), static_cast<IUnknown *>(byName),
+                                 static_cast<IUnknown *>(parent), static_cast<IUnknown *>(ctx)})
+            object->Release();
+        EXPECT_EQ(ns.live(), 0);
+    }
+
+    static void enum_test()
+    {
+        fake_shell::Options options;
+        options.depth = 1;
+        options.foldersPerFolder = 2;
+        options.filesPerFolder = 5;
+        fake_shell::Namespace ns(options);
+        IShellItem2 *root = desktop();
+
+        IEnumShellItems *items = nullptr;
+        EXPECT_EQ(root->BindToHandler(nullptr, BHID_EnumItems, IID_PPV_ARGS(&items)), S_OK);
+        IShellItem *batch[4] = {};
+        ULONG fetched = 0;
+        EXPECT_EQ(items->Next(4, batch, nullptr), E_INVALIDARG);
+        EXPECT_EQ(items->Next(4, batch, &fetched), S_OK);
+        EXPECT_EQ(fetched, 4u);
+        for (ULONG i = 0; i < fetched; ++i)
+            batch[i]->Release();
+        EXPECT_EQ(items->Skip(2), S_OK);
+
+        IEnumShellItems *clone = nullptr;
+        EXPECT_EQ(items->Clone(&clone), S_OK);
+        EXPECT_EQ(items->Next(4, batch, &fetched), S_FALSE);
+        EXPECT_EQ(fetched, 1u);
+        batch[0]->Release();
+        EXPECT_EQ(clone->Next(1, batch, nullptr), S_OK);
+        batch[0]->Release();
+        EXPECT_EQ(clone->Next(1, batch, nullptr), S_FALSE);
+
+        EXPECT_EQ(items->Reset(), S_OK);
+        std::size_t count = 0;
+        IShellItem *item = nullptr;
+        while (items->Next(1, &item, nullptr) == S_OK) {
+            ++count;
+            item->Release();
+        }
+        EXPECT_EQ(count, 7u);
+        //five calls above, including the clone's, then seven items and the end
+        EXPECT_EQ(ns.calls().next, 13u);
+
+        clone->Release();
+        items->Release();
+        root->Release();
+        EXPECT_EQ(ns.live(), 0);
+    }
+
+    static void property_test()
+    {
+        fake_shell::Namespace ns;
+        const fake_shell::Node *folder = ns.root()->children.front().get();
+        const fake_shell::Node *file = ns.root()->children.back().get();
+        IShellItem2 *item = ns.item(file);
+
+        PROPVARIANT var;
+        EXPECT_EQ(item->GetProperty(PKEY_FindData, &var), S_OK);
+        EXPECT_EQ(var.vt, VT_VECTOR | VT_UI1);
+        EXPECT_EQ(var.caub.cElems, sizeof(WIN32_FIND_DATA));
+        WIN32_FIND_DATA data;
+        std::memcpy(&data, var.caub.pElems, sizeof(data));
+        EXPECT_EQ(data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY, 0u);
+        EXPECT_EQ((ULONGLONG(data.nFileSizeHigh) << 32) | data.nFileSizeLow, file->size);
+        EXPECT_TRUE(file->name == data.cFileName);
+        PropVariantClear(&var);
+        EXPECT_EQ(var.vt, VT_EMPTY);
+
+        ULONGLONG size = 0;
+        EXPECT_EQ(item->GetUInt64(PKEY_Size, &size), S_OK);
+        EXPECT_EQ(size, file->size);
+        LPWSTR name = nullptr;
+        EXPECT_EQ(item->GetString(PKEY_ItemNameDisplay, &name), S_OK);
+        EXPECT_TRUE(file->name == name);
+        CoTaskMemFree(name);
+
+        IPropertyStore *store = nullptr;
+        EXPECT_EQ(item->GetPropertyStore(GPS_DEFAULT, IID_PPV_ARGS(&store)), S_OK);
+        DWORD count = 0;
+        EXPECT_EQ(store->GetCount(&count), S_OK);
+        EXPECT_EQ(count, 3u);
+        PROPERTYKEY key;
+        for (DWORD i = 0; i < count; ++i) {
+            EXPECT_EQ(store->GetAt(i, &key), S_OK);
+            EXPECT_EQ(store->GetValue(key, &var), S_OK);
+            EXPECT_NE(var.vt, VT_EMPTY);
+            PropVariantClear(&var);
+        }
+        EXPECT_EQ(store->GetAt(count, &key), E_INVALIDARG);
+        store->Release();
+        item->Release();
+
+        //folders have no size; unknown keys are empty rather than errors
+        item = ns.item(folder);
+        EXPECT_EQ(item->GetUInt64(PKEY_Size, &size), E_INVALIDARG);
+        EXPECT_EQ(item->GetProperty(PKEY_DateModified, &var), S_OK);
+        EXPECT_EQ(var.vt, VT_EMPTY);
+        item->Release();
+        EXPECT_EQ(ns.live(), 0);
+    }
+
+    static void latency_test()
+    {
+        using Clock = std::chrono::steady_clock;
+        fake_shell::Options options;
+        options.depth = 1;
+        options.latency = std::chrono::microseconds(200);
+        options.remoteLatency = std::chrono::milliseconds(2);
+        options.remoteFolders = 1;
+        fake_shell::Namespace ns(options);
+        const fake_shell::Node *remote = ns.root()->children.front().get();
+        const fake_shell::Node *local = ns.root()->children.back().get();
+        EXPECT_TRUE(remote->remote);
+        EXPECT_FALSE(local->remote);
+
+        SFGAOF attributes = 0;
+        IShellItem2 *item = ns.item(local);
+        auto start = Clock::now();
+        for (int i = 0; i < 10; ++i)
+            item->GetAttributes(SFGAO_ISSLOW, &attributes);
+        EXPECT_GE(Clock::now() - start, std::chrono::milliseconds(2));
+        EXPECT_EQ(attributes, 0u);
+        item->Release();
+
+        item = ns.item(remote);
+        start = Clock::now();
+        item->GetAttributes(SFGAO_ISSLOW, &attributes);
+        EXPECT_GE(Clock::now() - start, std::chrono::microseconds(2200));
+        EXPECT_EQ(attributes, SFGAO_ISSLOW);
+        item->Release();
+        EXPECT_EQ(ns.calls().getAttributes, 11u);
+    }
+
+    static void provider_test()
+    {
+        IShellFolder *folder = nullptr;
+        EXPECT_EQ(SHGetDesktopFolder(&folder), E_NOTIMPL);
+        {
+            fake_shell::Namespace outer;
+            {
+                fake_shell::Namespace inner;
+                EXPECT_TRUE(qe_shim::shellProvider() == &inner);
+            }
+            EXPECT_TRUE(qe_shim::shellProvider() == &outer);
+        }
+        EXPECT_TRUE(qe_shim::shellProvider() == nullptr);
+    }
+};
+
+#endif // QE_TEST_FAKESHELL_TEST_H
@@ -0,0 +1,390 @@
+/*  QExt: Extensions to Qt
+ *  Copyright (C) 2016  Jonathan Harper
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QE_TEST_IDLIST_H
+#define QE_TEST_IDLIST_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <stdexcept>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+#include <qewindows/idlist.h>
+#include "pidlcorpus.h"
+#include "../core/test.h"
+
+//! Checks IdList against generated and built-in corpora.
+struct idlist_test
+{
+    using IdList = qe::windows::shell::IdList;
+
+    static void run()
+    {
+        corpus_test();
+        builtin_test();
+        accessor_test();
+        compare_test();
+        parent_test();
+        hash_test();
+        index_test();
+        concurrent_test();
+    }
+
+    //! Returns a copy of \a bytes allocated like a pidl from the shell.
+    static ITEMIDLIST *clone(const pidl_corpus::Bytes &bytes)
+    {
+        using qe::windows::aligned_cast;
+        return aligned_cast<ITEMIDLIST *>(ILCloneFull(reinterpret_cast<PCUIDLIST_ABSOLUTE>(bytes.data())));
+    }
+
+    //! Returns a copy of \a bytes owned by an IdList.
+    static IdList make(const pidl_corpus::Bytes &bytes)
+    {
+        return IdList(clone(bytes));
+    }
+
+    //! Returns the offsets of the items in \a bytes.
+    static std::vector<std::size_t> offsets(const pidl_corpus::Bytes &bytes)
+    {
+        std::vector<std::size_t> ret;
+        std::size_t pos = 0;
+        for (;;) {
+            const unsigned cb = unsigned(bytes[pos]) | unsigned(bytes[pos + 1]) << 8;
+            if (!cb)
+                return ret;
+            ret.push_back(pos);
+            pos += cb;
+        }
+    }
+
+    static void corpus_test()
+    {
+        pidl_corpus::Options options;
+        options.count = 500;
+        options.seed = 7;
+        const auto a = pidl_corpus::generate(options);
+        const auto b = pidl_corpus::generate(options);
+        EXPECT_EQ(a.size(), 500u);
+        EXPECT_TRUE(a == b);
+
+        options.seed = 8;
+        EXPECT_FALSE(a == pidl_corpus::generate(options));
+
+        for (const auto &list : a) {
+            const auto items = offsets(list);
+            EXPECT_GE(items.size(), options.minDepth);
+            EXPECT_LE(items.size(), options.maxDepth);
+            EXPECT_EQ(list[list.size() - 1], 0);
+            EXPECT_EQ(list[list.size() - 2], 0);
+        }
+
+        options.minDepth = 3;
+        options.maxDepth = 3;
+        options.siblingPercent = 0;
+        options.leafTypes = {{pidl_corpus::type::Share, 1}};
+        for (const auto &list : pidl_corpus::generate(options)) {
+            const auto items = offsets(list);
+            EXPECT_EQ(items.size(), 3u);
+            EXPECT_EQ(list[items.back() + 2], pidl_corpus::type::Share);
+        }
+    }
+
+    static void builtin_test()
+    {
+        const auto corpus = pidl_corpus::builtin();
+        EXPECT_GT(corpus.size(), 5u);
+
+        //round trip through a file
+        const std::string path = "idlist_test_corpus.bin";
+        EXPECT_TRUE(pidl_corpus::save(path, corpus));
+        EXPECT_TRUE(pidl_corpus::load(path) == corpus);
+        std::remove(path.c_str());
+    }
+
+    static void accessor_test()
+    {
+        using qe::windows::shell::InferredType;
+
+        auto corpus = pidl_corpus::builtin();
+        const auto generated = pidl_corpus::generate();
+        corpus.insert(corpus.end(), generated.begin(), generated.end());
+
+        for (const auto &bytes : corpus) {
+            const IdList id = make(bytes);
+            const auto items = offsets(bytes);
+            EXPECT_TRUE(id);
+            EXPECT_EQ(id.byteCount(), bytes.size());
+            EXPECT_EQ(id.elementCount(), items.size());
+            EXPECT_EQ(id.isRoot(), items.empty());
+
+            if (items.empty()) {
+                EXPECT_EQ(id.rawType(), 0xFE);
+                EXPECT_TRUE(id.inferredType() == InferredType::LocalVirtual);
+                continue;
+            }
+            const auto last = reinterpret_cast<const std::uint8_t *>(id.lastId());
+            EXPECT_TRUE(last == reinterpret_cast<const std::uint8_t *>(id.data()) + items.back());
+            //rawType only looks past the first item
+            if (items.size() > 1)
+                EXPECT_EQ(id.rawType(), bytes[items.back() + 2]);
+
+            std::size_t count = 0;
+            for (const auto &item : id) {
+                //items are packed and may be unaligned, so copy cb out before comparing it
+                const unsigned cb = item.mkid.cb;
+                EXPECT_EQ(cb, unsigned(bytes[items[count]] | bytes[items[count] + 1] << 8));
+                ++count;
+            }
+            EXPECT_EQ(count, items.size());
+        }
+
+        EXPECT_EQ(IdList().rawType(), 0xFF);
+    }
+
+    static void compare_test()
+    {
+        using qe::windows::shell::compareIdList;
+
+        const auto corpus = pidl_corpus::generate();
+        for (std::size_t i = 0; i < corpus.size(); ++i) {
+            const IdList a = make(corpus[i]);
+            const IdList copy = a;
+            EXPECT_TRUE(a == copy);
+            EXPECT_EQ(compareIdList(a.data(), copy.data()), 0);
+
+            if (i + 1 < corpus.size()) {
+                const IdList b = make(corpus[i + 1]);
+                const int ab = compareIdList(a.data(), b.data());
+                const int ba = compareIdList(b.data(), a.data());
+                EXPECT_EQ(ab, -ba);
+                EXPECT_EQ(ab == 0, corpus[i] == corpus[i + 1]);
+            }
+        }
+
+        //a list sorts after each of its prefixes
+        const IdList full = make(pidl_corpus::builtin()[7]);
+        for (IdList p = full.parent(); p; p = p.parent())
+            EXPECT_EQ(compareIdList(p.data(), full.data()), -1);
+    }
+
+    static void parent_test()
+    {
+        for (const auto &bytes : pidl_corpus::generate()) {
+            const IdList id = make(bytes);
+            const auto items = offsets(bytes);
+            const IdList parent = id.parent();
+            if (items.empty()) {
+                EXPECT_FALSE(parent);
+                continue;
+            }
+            EXPECT_TRUE(parent);
+            EXPECT_EQ(parent.elementCount(), items.size() - 1);
+            EXPECT_EQ(parent.byteCount(), items.back() + 2);
+            EXPECT_TRUE(std::equal(bytes.begin(), bytes.begin() + std::ptrdiff_t(items.back()),
+                                   reinterpret_cast<const std::uint8_t *>(parent.data())));
+        }
+    }
+
+    static void hash_test()
+    {
+        using qe::windows::aligned_cast;
+        using qe::windows::shell::toPidl;
+
+        const auto corpus = pidl_corpus::generate();
+        std::unordered_set<IdList> set;
+        std::unordered_set<std::uint64_t> hashes;
+        std::size_t distinct = 0;
+        for (std::size_t i = 0; i < corpus.size(); ++i) {
+            const IdList id = make(corpus[i]);
+            const IdList copy = make(corpus[i]);
+            EXPECT_NE(id.hash(), 0u);
+            EXPECT_EQ(id.hash(), copy.hash());
+            EXPECT_EQ(qHash(id), qHash(copy));
+            EXPECT_EQ(qHash(id, 1), qHash(id) ^ 1u);
+
+            //the hash of a parent is the hash of the list before its last item
+            const IdList parent = id.parent();
+            if (parent)
+                EXPECT_EQ(parent.hash(), qe::pidl::hashPrefix(toPidl(id.data()), id.elementCount() - 1));
+
+            const bool isNew = std::find(corpus.begin(), corpus.begin() + std::ptrdiff_t(i), corpus[i])
+                    == corpus.begin() + std::ptrdiff_t(i);
+            distinct += isNew;
+            EXPECT_EQ(set.insert(id).second, isNew);
+            hashes.insert(id.hash());
+        }
+        //no collisions among the distinct lists
+        EXPECT_EQ(hashes.size(), distinct);
+        EXPECT_EQ(set.size(), distinct);
+
+        //the cached hash follows the stored pointer
+        IdList id = make(corpus[0]);
+        IdList other = make(corpus[1]);
+        const auto first = id.hash();
+        const auto second = other.hash();
+        id.swap(other);
+        EXPECT_EQ(id.hash(), second);
+        EXPECT_EQ(other.hash(), first);
+        id.reset(clone(corpus[3]));
+        EXPECT_EQ(id.hash(), make(corpus[3]).hash());
+        ITEMIDLIST **slot = id.address();
+        ILFree(aligned_cast<PIDLIST_RELATIVE>(*slot));
+        *slot = clone(corpus[4]);
+        EXPECT_EQ(id.hash(), make(corpus[4]).hash());
+        id.reset();
+        EXPECT_EQ(id.hash(), 0u);
+        EXPECT_EQ(IdList().hash(), 0u);
+
+#ifndef _WIN32
+        //a copy that cannot allocate is null and keeps none of the original's caches
+        const IdList original = make(corpus[2]);
+        EXPECT_NE(original.hash(), 0u);
+        EXPECT_NE(original.elementCount(), 0u);
+        qe_shim::failingAllocations() = 1;
+        const IdList failed = original;
+        qe_shim::failingAllocations() = 0;
+        EXPECT_FALSE(failed);
+        EXPECT_EQ(failed.hash(), 0u);
+        EXPECT_EQ(failed.elementCount(), 0u);
+        EXPECT_EQ(IdList(original).hash(), original.hash());
+#endif
+    }
+
+    //! The accessors served by the offset index agree with the bytes, for lists indexed in place
+    //! and for those too deep or too large to be.
+    static void index_test()
+    {
+        using qe::windows::aligned_cast;
+
+        pidl_corpus::Options deep;
+        deep.count = 200;
+        deep.maxDepth = 24;
+        pidl_corpus::Options large;
+        large.count = 20;
+        large.minDepth = 10;
+        large.maxDepth = 12;
+        large.minItemSize = 6000;
+        large.maxItemSize = 9000;
+        auto corpus = pidl_corpus::builtin();
+        for (const auto &options : {deep, large}) {
+            const auto generated = pidl_corpus::generate(options);
+            corpus.insert(corpus.end(), generated.begin(), generated.end());
+        }
+
+        for (const auto &bytes : corpus) {
+            const IdList id = make(bytes);
+            const auto items = offsets(bytes);
+            const auto base = reinterpret_cast<const std::uint8_t *>(id.data());
+            for (int pass = 0; pass < 2; ++pass) { //building the index, then using it
+                EXPECT_EQ(id.elementCount(), items.size());
+                EXPECT_EQ(id.byteCount(), bytes.size());
+                EXPECT_EQ(id.rawType(), qe::pidl::rawType(qe::windows::shell::toPidl(id.data())));
+                for (std::size_t i = 0; i < items.size(); ++i)
+                    EXPECT_TRUE(reinterpret_cast<const std::uint8_t *>(id.at(unsigned(i))) == base + items[i]);
+                bool thrown = false;
+                try {
+                    id.at(unsigned(items.size()));
+                } catch (const std::out_of_range &) {
+                    thrown = true;
+                }
+                EXPECT_TRUE(thrown);
+                if (items.empty()) {
+                    EXPECT_TRUE(id.lastId() == id.data());
+                    EXPECT_EQ(id.parentByteCount(), 0u);
+                } else {
+                    EXPECT_TRUE(reinterpret_cast<const std::uint8_t *>(id.lastId()) == base + items.back());
+                    EXPECT_EQ(id.parentByteCount(), items.back() + 2);
+                }
+            }
+
+            const IdList copy = id;
+            EXPECT_EQ(copy.elementCount(), items.size());
+            if (!items.empty())
+                EXPECT_TRUE(reinterpret_cast<const std::uint8_t *>(copy.lastId())
+                            == reinterpret_cast<const std::uint8_t *>(copy.data()) + items.back());
+        }
+
+        //an item too small to hold abID[0] makes the list invalid
+        const pidl_corpus::Bytes runt = {0x04, 0x00, 0x31, 0x00, 0x02, 0x00, 0x00, 0x00};
+        EXPECT_EQ(make(runt).rawType(), 0xFF);
+
+        //the index follows the stored pointer
+        IdList id = make(corpus[0]);
+        IdList other = make(corpus.back());
+        const unsigned first = id.elementCount();
+        const unsigned last = other.elementCount();
+        id.swap(other);
+        EXPECT_EQ(id.elementCount(), last);
+        EXPECT_EQ(other.elementCount(), first);
+        ITEMIDLIST **slot = id.address();
+        ILFree(aligned_cast<PIDLIST_RELATIVE>(*slot));
+        *slot = clone(corpus[0]);
+        EXPECT_EQ(id.elementCount(), first);
+        id.reset();
+        EXPECT_EQ(id.elementCount(), 0u);
+        EXPECT_EQ(id.byteCount(), 0u);
+        EXPECT_TRUE(id.lastId() == nullptr);
+        EXPECT_FALSE(id.parent());
+    }
+
+    //! Threads that read the same lists fill the caches once and agree on them.
+    static void concurrent_test()
+    {
+        pidl_corpus::Options options;
+        options.count = 64;
+        options.maxDepth = 16;
+        const auto corpus = pidl_corpus::generate(options);
+
+        struct Seen
+        {
+            std::uint64_t hash;
+            unsigned count;
+            unsigned bytes;
+            const ITEMIDLIST *last;
+        };
+        constexpr int Threads = 4;
+        std::vector<IdList> lists;
+        for (const auto &bytes : corpus)
+            lists.push_back(make(bytes));
+        std::vector<std::vector<Seen>> seen(Threads, std::vector<Seen>(lists.size()));
+        std::vector<std::thread> threads;
+        for (int t = 0; t < Threads; ++t) {
+            threads.emplace_back([&lists, &seen, t] {
+                for (std::size_t i = 0; i < lists.size(); ++i) {
+                    const IdList &id = lists[i];
+                    seen[t][i] = {id.hash(), id.elementCount(), id.byteCount(), id.lastId()};
+                }
+            });
+        }
+        for (auto &thread : threads)
+            thread.join();
+
+        for (std::size_t i = 0; i < lists.size(); ++i) {
+            const IdList fresh = make(corpus[i]);
+            for (int t = 0; t < Threads; ++t) {
+                EXPECT_EQ(seen[t][i].hash, fresh.hash());
+                EXPECT_EQ(seen[t][i].count, fresh.elementCount());
+                EXPECT_EQ(seen[t][i].bytes, corpus[i].size());
+                EXPECT_TRUE(seen[t][i].last == lists[i].lastId());
+            }
+        }
+    }
+};
+
+#endif // QE_TEST_IDLIST_H
@@ -0,0 +1,157 @@
+/*  QExt: Extensions to Qt
+ *  Copyright (C) 2016  Jonathan Harper
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QE_TEST_NODEFLAGS_H
+#define QE_TEST_NODEFLAGS_H
+
+#include <cstdint>
+#include <vector>
+#include "../../src/windows/shellflags_p.h"
+#include "../core/test.h"
+
+//! Checks the table-driven flag translation against the bit-by-bit version it replaced.
+struct nodeflags_test
+{
+    static void run()
+    {
+        single_bit_test();
+        combination_test();
+        batch_test();
+    }
+
+    //! The previous nodeFlagsToSfgao, with the SDK macros replaced by their values.
+    static std::uint32_t legacyNodeToSfgao(std::uint32_t flags)
+    {
+        using namespace qe::windows::shell::detail;
+        std::uint32_t ret = 0x0;
+        if (flags & node::Folder)           ret |= sfgao::Folder;
+        if (flags & node::FileSystem)       ret |= sfgao::FileSystem;
+        if (flags & node::StorageObject)    ret |= sfgao::Storage;
+        if (flags & node::Stream)           ret |= sfgao::Stream;
+
+        if (flags & node::CanCopy)          ret |= sfgao::CanCopy;
+        if (flags & node::CanMove)          ret |= sfgao::CanMove;
+        if (flags & node::CanRename)        ret |= sfgao::CanRename;
+        if (flags & node::CanDelete)        ret |= sfgao::CanDelete;
+
+        if (flags & node::ReadOnly)         ret |= sfgao::ReadOnly;
+        if (flags & node::Hidden)           ret |= sfgao::Hidden;
+        if (flags & node::System)           ret |= sfgao::System;
+        if (flags & node::Ghosted)          ret |= sfgao::Ghosted;
+        if (flags & node::ShellLink)        ret |= sfgao::Link;
+        if (flags & node::Remote)           ret |= sfgao::IsSlow;
+        if (flags & node::Removable)        ret |= sfgao::Removable;
+        if (flags & node::Compressed)       ret |= sfgao::Compressed;
+        if (flags & node::Encrypted)        ret |= sfgao::Encrypted;
+        if (flags & node::MayHaveChildren)  ret |= sfgao::HasSubfolder;
+        return ret;
+    }
+
+    //! The previous sfgaoFlagsToNodeFlags.
+    static std::uint32_t legacySfgaoToNode(std::uint32_t flags)
+    {
+        using namespace qe::windows::shell::detail;
+        std::uint32_t ret = 0x0;
+        if (flags & sfgao::Folder)          ret |= node::Folder;
+        if (flags & sfgao::FileSystem)      ret |= node::FileSystem;
+        if (flags & sfgao::Storage)         ret |= node::StorageObject;
+        if (flags & sfgao::Stream)          ret |= node::Stream;
+
+        if (flags & sfgao::CanCopy)         ret |= node::CanCopy;
+        if (flags & sfgao::CanMove)         ret |= node::CanMove;
+        if (flags & sfgao::CanRename)       ret |= node::CanRename;
+        if (flags & sfgao::CanDelete)       ret |= node::CanDelete;
+
+        if (flags & sfgao::ReadOnly)        ret |= node::ReadOnly;
+        if (flags & sfgao::Hidden)          ret |= node::Hidden;
+        if (flags & sfgao::System)          ret |= node::System;
+        if (flags & sfgao::Ghosted)         ret |= node::Ghosted;
+        if (flags & sfgao::Link)            ret |= node::ShellLink;
+        if (flags & sfgao::IsSlow)          ret |= node::Remote;
+        if (flags & sfgao::Removable)       ret |= node::Removable;
+        if (flags & sfgao::Compressed)      ret |= node::Compressed;
+        if (flags & sfgao::Encrypted)       ret |= node::Encrypted;
+        if (flags & sfgao::HasSubfolder)    ret |= node::MayHaveChildren;
+        return ret;
+    }
+
+    //! The previous fileAttributeToNodeFlags.
+    static std::uint32_t legacyAttributeToNode(std::uint32_t flags)
+    {
+        using namespace qe::windows::shell::detail;
+        std::uint32_t ret = 0x0;
+        if (flags & attribute::ReadOnly)    ret |= node::ReadOnly;
+        if (flags & attribute::Hidden)      ret |= node::Hidden;
+        if (flags & attribute::System)      ret |= node::System;
+        if (flags & attribute::Directory)   ret |= node::Folder;
+        if (flags & attribute::Compressed)  ret |= node::Compressed;
+        if (flags & attribute::Encrypted)   ret |= node::Encrypted;
+        return ret;
+    }
+
+    static void check(std::uint32_t value)
+    {
+        using namespace qe::windows::shell::detail;
+        EXPECT_EQ(legacyNodeToSfgao(value), nodeToSfgao(value));
+        EXPECT_EQ(legacySfgaoToNode(value), sfgaoToNode(value));
+        EXPECT_EQ(legacyAttributeToNode(value), attributeToNode(value));
+    }
+
+    static void single_bit_test()
+    {
+        check(0);
+        check(0xFFFFFFFFu);
+        for (int bit = 0; bit < 32; ++bit)
+            check(1u << bit);
+    }
+
+    //! Every combination within each half-word, and pseudo-random words spanning both.
+    static void combination_test()
+    {
+        for (std::uint32_t value = 0; value < 0x10000; ++value) {
+            check(value);
+            check(value << 16);
+        }
+        std::uint32_t seed = 1;
+        for (int i = 0; i < 1000000; ++i) {
+            seed = seed * 1664525u + 1013904223u;
+            check(seed);
+        }
+    }
+
+    static void batch_test()
+    {
+        using namespace qe::windows::shell::detail;
+        std::vector<std::uint32_t> in(1000);
+        std::uint32_t seed = 7;
+        for (auto &value : in) {
+            seed = seed * 1664525u + 1013904223u;
+            value = seed;
+        }
+        std::vector<std::uint32_t> out(in.size());
+        sfgaoToNode(in.data(), out.data(), in.size());
+        for (std::size_t i = 0; i < in.size(); ++i)
+            EXPECT_EQ(legacySfgaoToNode(in[i]), out[i]);
+
+        //in place
+        nodeToSfgao(out.data(), out.data(), out.size());
+        for (std::size_t i = 0; i < in.size(); ++i)
+            EXPECT_EQ(legacyNodeToSfgao(legacySfgaoToNode(in[i])), out[i]);
+    }
+};
+
+#endif // QE_TEST_NODEFLAGS_H
@@ -0,0 +1,349 @@
+/*  QExt: Extensions to Qt
+ *  Copyright (C) 2016  Jonathan Harper
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QE_TEST_PIDL_H
+#define QE_TEST_PIDL_H
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include <qewindows/pidl.h>
+#include "pidlcorpus.h"
+#include "../core/test.h"
+
+//! Checks the qe::pidl byte routines directly on corpus bytes, without the SDK.
+struct pidl_test
+{
+    using Bytes = pidl_corpus::Bytes;
+
+    static void run()
+    {
+        accessor_test();
+        unaligned_test();
+        compare_test();
+        level_test();
+        bounds_test();
+        hash_test();
+        offsets_test();
+        checked_test();
+    }
+
+    static std::vector<qe::pidl::SimdLevel> supportedLevels()
+    {
+        std::vector<qe::pidl::SimdLevel> levels{qe::pidl::SimdLevel::Scalar};
+#ifdef QE_SIMD_X86
+        levels.push_back(qe::pidl::SimdLevel::SSE2);
+        if (qe::detail::simdLevel() == qe::pidl::SimdLevel::AVX2)
+            levels.push_back(qe::pidl::SimdLevel::AVX2);
+#endif
+        return levels;
+    }
+
+    static const qe::pidl::ItemIdList *list(const Bytes &bytes)
+    {
+        return qe::pidl::fromBytes(bytes.data());
+    }
+
+    //! Returns the items of \a bytes without their `cb`.
+    static std::vector<Bytes> items(const Bytes &bytes)
+    {
+        std::vector<Bytes> ret;
+        std::size_t pos = 0;
+        for (;;) {
+            const unsigned cb = unsigned(bytes[pos]) | unsigned(bytes[pos + 1]) << 8;
+            if (!cb)
+                return ret;
+            ret.emplace_back(bytes.begin() + std::ptrdiff_t(pos + 2), bytes.begin() + std::ptrdiff_t(pos + cb));
+            pos += cb;
+        }
+    }
+
+    static std::vector<Bytes> corpus()
+    {
+        auto ret = pidl_corpus::builtin();
+        const auto generated = pidl_corpus::generate();
+        ret.insert(ret.end(), generated.begin(), generated.end());
+        return ret;
+    }
+
+    static void check(const Bytes &bytes, const qe::pidl::ItemIdList *id)
+    {
+        const auto parts = items(bytes);
+        EXPECT_EQ(qe::pidl::byteCount(id), bytes.size());
+        EXPECT_EQ(qe::pidl::elementCount(id), parts.size());
+        EXPECT_EQ(qe::pidl::isTerminator(id), parts.empty());
+        if (parts.empty()) {
+            EXPECT_EQ(qe::pidl::rawType(id), 0xFE);
+            EXPECT_TRUE(qe::pidl::lastId(id) == id);
+            return;
+        }
+        const auto last = qe::pidl::lastId(id);
+        EXPECT_EQ(qe::pidl::itemSize(last), parts.back().size() + 2);
+        EXPECT_TRUE(qe::pidl::isTerminator(qe::pidl::nextId(last)));
+        //rawType only looks past the first item
+        EXPECT_EQ(qe::pidl::rawType(id), parts.size() > 1 ? parts.back()[0] : 0);
+    }
+
+    static void accessor_test()
+    {
+        for (const auto &bytes : corpus())
+            check(bytes, list(bytes));
+
+        EXPECT_EQ(qe::pidl::byteCount(&qe::pidl::terminator), 2u);
+        EXPECT_EQ(qe::pidl::byteCount(nullptr), 0u);
+        EXPECT_EQ(qe::pidl::elementCount(nullptr), 0u);
+        EXPECT_EQ(qe::pidl::rawType(nullptr), 0xFF);
+        EXPECT_TRUE(qe::pidl::lastId(nullptr) == nullptr);
+        EXPECT_FALSE(qe::pidl::hasNext(nullptr));
+
+        //an item too small to hold abID[0]
+        const Bytes runt = {0x04, 0x00, 0x31, 0x00, 0x02, 0x00, 0x00, 0x00};
+        EXPECT_EQ(qe::pidl::rawType(list(runt)), 0xFF);
+    }
+
+    //! The routines read cb a byte at a time, so lists at odd addresses behave the same.
+    static void unaligned_test()
+    {
+        for (const auto &bytes : corpus()) {
+            Bytes shifted(1, 0xCC);
+            shifted.insert(shifted.end(), bytes.begin(), bytes.end());
+            check(bytes, qe::pidl::fromBytes(shifted.data() + 1));
+            EXPECT_EQ(qe::pidl::compareIdList(list(bytes), qe::pidl::fromBytes(shifted.data() + 1)), 0);
+        }
+    }
+
+    //! compareIdList orders lists as sequences of items, and items as sequences of bytes.
+    static void compare_test()
+    {
+        const auto all = corpus();
+        for (std::size_t i = 0; i < all.size(); ++i) {
+            const auto &a = all[i];
+            const auto &b = all[(i * 7 + 3) % all.size()];
+            const auto ia = items(a);
+            const auto ib = items(b);
+            const int expected = ia < ib ? -1 : (ib < ia ? 1 : 0);
+            EXPECT_EQ(qe::pidl::compareIdList(list(a), list(b)), expected);
+            EXPECT_EQ(qe::pidl::compareIdList(list(b), list(a)), -expected);
+            if (!ia.empty() && !ib.empty()) {
+                const int first = ia[0] < ib[0] ? -1 : (ib[0] < ia[0] ? 1 : 0);
+                EXPECT_EQ(qe::pidl::compareId(list(a), list(b)), first);
+            }
+        }
+        EXPECT_EQ(qe::pidl::compareIdList(&qe::pidl::terminator, &qe::pidl::terminator), 0);
+        const Bytes drive = {0x05, 0x00, 0x2F, 0x43, 0x3A, 0x00, 0x00};
+        EXPECT_EQ(qe::pidl::compareIdList(&qe::pidl::terminator, list(drive)), -1);
+        EXPECT_EQ(qe::pidl::compareIdList(list(drive), &qe::pidl::terminator), 1);
+    }
+
+    //! Every level finds the same first difference, wherever it falls relative to the vector width.
+    static void level_test()
+    {
+        pidl_corpus::Random random(11);
+        for (std::size_t n = 0; n <= 100; ++n) {
+            Bytes a(n), b;
+            for (auto &byte : a)
+                byte = std::uint8_t(random.next());
+            for (std::size_t at = 0; at <= n; ++at) {
+                b = a;
+                if (at < n)
+                    b[at] ^= std::uint8_t(1 + random.next() % 255);
+                for (auto level : supportedLevels())
+                    EXPECT_EQ(qe::pidl::mismatch(a.data(), b.data(), n, level), at);
+            }
+        }
+
+        const auto all = corpus();
+        for (std::size_t i = 0; i < all.size(); ++i) {
+            const auto &a = all[i];
+            const auto &b = all[(i + 1) % all.size()];
+            const int expected = qe::pidl::compareIdList(list(a), list(b), qe::pidl::SimdLevel::Scalar);
+            for (auto level : supportedLevels()) {
+                EXPECT_EQ(qe::pidl::compareIdList(list(a), list(b), level), expected);
+                EXPECT_EQ(qe::pidl::compareIdList(list(a), list(a), level), 0);
+            }
+        }
+    }
+
+    //! Items are only read up to their `cb`; each list here ends its allocation, so a sanitizer
+    //! build catches an over-read.
+    static void bounds_test()
+    {
+        for (unsigned payload : {1u, 15u, 16u, 17u, 31u, 32u, 33u, 64u, 200u}) {
+            const unsigned cb = payload + 2;
+            Bytes item(cb + 2, 0x5A);
+            item[0] = std::uint8_t(cb);
+            item[1] = std::uint8_t(cb >> 8);
+            item[cb] = item[cb + 1] = 0;
+            //copies are allocated at exactly their size
+            const Bytes left(item);
+            Bytes right(item);
+            const auto a = list(left);
+            const auto b = list(right);
+            for (auto level : supportedLevels()) {
+                EXPECT_EQ(qe::pidl::compareId(a, b, level), 0);
+                EXPECT_EQ(qe::pidl::compareIdList(a, b, level), 0);
+                right[cb - 1] = 0x5B;
+                EXPECT_EQ(qe::pidl::compareId(a, b, level), -1);
+                EXPECT_EQ(qe::pidl::compareIdList(b, a, level), 1);
+                right[cb - 1] = 0x5A;
+            }
+        }
+    }
+
+    static void hash_test()
+    {
+        //every byte, including those in the zero-padded tail, reaches the hash
+        pidl_corpus::Random random(5);
+        for (std::size_t n = 1; n <= 70; ++n) {
+            Bytes a(n);
+            for (auto &byte : a)
+                byte = std::uint8_t(random.next());
+            const auto h = qe::pidl::hashBytes(a.data(), n);
+            EXPECT_EQ(qe::pidl::hashBytes(Bytes(a).data(), n), h);
+            EXPECT_NE(qe::pidl::hashBytes(a.data(), n, 1), h);
+            for (std::size_t at = 0; at < n; ++at) {
+                Bytes b = a;
+                b[at] ^= 0x01;
+                EXPECT_NE(qe::pidl::hashBytes(b.data(), n), h);
+            }
+            //a trailing zero byte is not the same as padding
+            Bytes longer = a;
+            longer.push_back(0);
+            EXPECT_NE(qe::pidl::hashBytes(longer.data(), n + 1), h);
+        }
+
+        for (const auto &bytes : corpus()) {
+            const auto id = list(bytes);
+            std::uint64_t rolling = qe::pidl::emptyListHash;
+            unsigned count = 0;
+            EXPECT_EQ(qe::pidl::hashPrefix(id, 0), rolling);
+            for (auto item = id; !qe::pidl::isTerminator(item); item = qe::pidl::nextId(item)) {
+                rolling = qe::pidl::hashAppend(rolling, qe::pidl::hashItem(item));
+                EXPECT_EQ(qe::pidl::hashPrefix(id, ++count), rolling);
+            }
+            EXPECT_EQ(qe::pidl::hashIdList(id), rolling);
+        }
+        EXPECT_EQ(qe::pidl::hashIdList(&qe::pidl::terminator), qe::pidl::emptyListHash);
+        EXPECT_EQ(qe::pidl::hashIdList(nullptr), 0u);
+
+        //item order matters
+        const Bytes ab = {0x03, 0x00, 0x31, 0x03, 0x00, 0x32, 0x00, 0x00};
+        const Bytes ba = {0x03, 0x00, 0x32, 0x03, 0x00, 0x31, 0x00, 0x00};
+        EXPECT_NE(qe::pidl::hashIdList(list(ab)), qe::pidl::hashIdList(list(ba)));
+    }
+
+    static void offsets_test()
+    {
+        using qe::pidl::ItemOffsets;
+
+        pidl_corpus::Options deep;
+        deep.count = 200;
+        deep.maxDepth = 24;
+        auto all = corpus();
+        const auto generated = pidl_corpus::generate(deep);
+        all.insert(all.end(), generated.begin(), generated.end());
+
+        std::size_t inlined = 0;
+        for (const auto &bytes : all) {
+            ItemOffsets index;
+            index.build(list(bytes));
+            EXPECT_TRUE(index.isBuilt());
+            EXPECT_EQ(index.byteCount(), bytes.size());
+            EXPECT_EQ(index.isInline(), index.count() <= ItemOffsets::InlineItems);
+            inlined += index.isInline();
+
+            std::size_t pos = 0;
+            const auto parts = items(bytes);
+            EXPECT_EQ(index.count(), parts.size());
+            for (unsigned i = 0; i < parts.size(); ++i) {
+                EXPECT_EQ(index.offset(i), pos);
+                pos += parts[i].size() + 2;
+            }
+            EXPECT_EQ(index.offset(index.count()), pos);
+            EXPECT_FALSE(index.hasShortItem());
+
+            //copies and moves keep the offsets; moved-from indexes are empty
+            ItemOffsets copy(index);
+            ItemOffsets moved(std::move(index));
+            EXPECT_FALSE(index.isBuilt());
+            EXPECT_EQ(copy.byteCount(), bytes.size());
+            EXPECT_EQ(moved.byteCount(), bytes.size());
+            copy = moved;
+            moved.clear();
+            EXPECT_FALSE(moved.isBuilt());
+            EXPECT_EQ(copy.offset(copy.count()), pos);
+        }
+        //both representations were covered
+        EXPECT_GT(inlined, 0u);
+        EXPECT_LT(inlined, all.size());
+
+        ItemOffsets index;
+        index.build(nullptr);
+        EXPECT_FALSE(index.isBuilt());
+        index.build(&qe::pidl::terminator);
+        EXPECT_TRUE(index.isBuilt());
+        EXPECT_EQ(index.count(), 0u);
+        EXPECT_EQ(index.byteCount(), 2u);
+
+        const Bytes runt = {0x04, 0x00, 0x31, 0x00, 0x02, 0x00, 0x00, 0x00};
+        index.build(list(runt));
+        EXPECT_TRUE(index.hasShortItem());
+        EXPECT_EQ(index.count(), 2u);
+
+        //a list of 64 KiB or more does not fit 16-bit offsets
+        Bytes large;
+        for (int i = 0; i < 3; ++i) {
+            Bytes item(30000, 0x41);
+            item[0] = std::uint8_t(30000 & 0xFF);
+            item[1] = std::uint8_t(30000 >> 8);
+            large.insert(large.end(), item.begin(), item.end());
+        }
+        large.push_back(0);
+        large.push_back(0);
+        index.build(list(large));
+        EXPECT_FALSE(index.isInline());
+        EXPECT_EQ(index.count(), 3u);
+        EXPECT_EQ(index.offset(2), 60000u);
+        EXPECT_EQ(index.byteCount(), large.size());
+    }
+
+    static void checked_test()
+    {
+        for (const auto &bytes : corpus()) {
+            EXPECT_EQ(qe::pidl::checkedByteCount(bytes.data(), bytes.size()), bytes.size());
+
+            //trailing data is ignored
+            Bytes padded = bytes;
+            padded.insert(padded.end(), 5, 0xAB);
+            EXPECT_EQ(qe::pidl::checkedByteCount(padded.data(), padded.size()), bytes.size());
+
+            //any truncation loses the terminator or cuts an item short
+            for (std::size_t size = 0; size < bytes.size(); ++size)
+                EXPECT_EQ(qe::pidl::checkedByteCount(bytes.data(), size), 0u);
+        }
+
+        EXPECT_EQ(qe::pidl::checkedByteCount(nullptr, 16), 0u);
+        const Bytes one = {0x01, 0x00, 0x00, 0x00};
+        EXPECT_EQ(qe::pidl::checkedByteCount(one.data(), one.size()), 0u);
+        const Bytes overrun = {0xFF, 0xFF, 0x31, 0x00, 0x00};
+        EXPECT_EQ(qe::pidl::checkedByteCount(overrun.data(), overrun.size()), 0u);
+        const Bytes minimal = {0x02, 0x00, 0x00, 0x00};
+        EXPECT_EQ(qe::pidl::checkedByteCount(minimal.data(), minimal.size()), 4u);
+    }
+};
+
+#endif // QE_TEST_PIDL_H
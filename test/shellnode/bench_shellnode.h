@@ -0,0 +1,84 @@
+/*  QExt: Extensions to Qt
+ *  Copyright (C) 2016  Jonathan Harper
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QE_TEST_BENCH_SHELLNODE_H
+#define QE_TEST_BENCH_SHELLNODE_H
+
+#include <chrono>
+#include "test_fakenode.h"
+
+/*!
+    Benchmarks for building ShellNode trees over the fake namespace. Run with
+    `shellnode_test --bench`. One operation builds a tree from a fresh root node.
+*/
+struct shellnode_bench
+{
+    //! Enumerates \a node and everything below it.
+    static int enumerateAll(const fakenode_test::ShellNodePointer &node)
+    {
+        int ret = 1;
+        for (const auto &child : node->children())
+            ret += enumerateAll(child);
+        return ret;
+    }
+
+    static void build(qe_test::Bench &bench, const fake_shell::Options &options)
+    {
+        fake_shell::Namespace ns(options);
+        bench.run([&] {
+            auto root = fakenode_test::rootNode(ns);
+            qe_test::keep(enumerateAll(root));
+        });
+    }
+
+    //! 4 folders and 16 files per folder, 3 levels deep: 421 nodes with no latency.
+    static void build_tree(qe_test::Bench &bench)
+    {
+        build(bench, fake_shell::Options());
+    }
+
+    //! The same tree with 2 µs per call, and 50 µs more below the first folder, which is remote.
+    static void build_tree_remote(qe_test::Bench &bench)
+    {
+        fake_shell::Options options;
+        options.latency = std::chrono::microseconds(2);
+        options.remoteLatency = std::chrono::microseconds(50);
+        options.remoteFolders = 1;
+        bench.setSamples(5);
+        build(bench, options);
+    }
+
+    //! One folder of 2,000 files, where the duplicate scan of ShellNode::enumerate dominates.
+    static void enumerate_wide(qe_test::Bench &bench)
+    {
+        fake_shell::Options options;
+        options.depth = 1;
+        options.foldersPerFolder = 0;
+        options.filesPerFolder = 2000;
+        bench.setSamples(5);
+        build(bench, options);
+    }
+
+    static void add()
+    {
+        qe_test::add_benchmark("shellnode_build_tree", &build_tree);
+        qe_test::add_benchmark("shellnode_build_tree_remote", &build_tree_remote);
+        qe_test::add_benchmark("shellnode_enumerate_wide", &enumerate_wide);
+    }
+};
+
+#endif // QE_TEST_BENCH_SHELLNODE_H
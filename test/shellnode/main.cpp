@@ -0,0 +1,17 @@
+#include "test_fakenode.h"
+#include "test_formatters.h"
+#include "test_compointer.h"
+#include "bench_shellnode.h"
+
+#include <QCoreApplication>
+
+int main(int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);
+    qe_test::add_test("fake_node", &fakenode_test::run);
+    qe_test::add_test("fake_node_info", &fakenode_test::info_test);
+    qe_test::add_test("formatters", &formatters_test::run);
+    qe_test::add_test("compointer", &compointer_test::run);
+    shellnode_bench::add();
+    return qe_test::run(argc, argv);
+}
@@ -0,0 +1,43 @@
+#ShellNode and ShellNodeInfo over the in-memory namespace of ../shell/fakeshell.h, for platforms
+#without the Windows SDK. The shim directory stands in for the SDK headers.
+!win32 {
+QT += core gui
+
+TARGET = shellnode_test
+TEMPLATE = app
+CONFIG += console c++1z
+
+#release, so that Q_ASSERT is compiled out as in shipped builds
+CONFIG -= debug debug_and_release
+CONFIG += release
+
+DEFINES += QEXT_NO_EXPORT
+
+INCLUDEPATH += \
+    ../../Include \
+    ../shell/shim \
+    ../shell
+
+include(../../src/core/core.pri)
+
+SOURCES += \
+    $$PWD/main.cpp \
+    $$PWD/winutil_stub.cpp \
+    $$PWD/../../src/windows/shell.cpp \
+    $$PWD/../../src/windows/shellnode.cpp \
+    $$PWD/../../src/windows/shellnodedata.cpp \
+    $$PWD/../../src/windows/shellnodeinfo.cpp
+
+HEADERS += \
+    $$PWD/../core/test.h \
+    $$PWD/../shell/fakeshell.h \
+    $$PWD/../shell/shim/windows_shim.h \
+    $$PWD/../../src/windows/shell.h \
+    $$PWD/../../src/windows/shellnode.h \
+    $$PWD/../../src/windows/shellnodedata.h \
+    $$PWD/../../src/windows/shellnodeinfo.h \
+    $$PWD/test_fakenode.h \
+    $$PWD/test_formatters.h \
+    $$PWD/test_compointer.h \
+    $$PWD/bench_shellnode.h
+} #!win32
@@ -0,0 +1,54 @@
+/*  QExt: Extensions to Qt
+ *  Copyright (C) 2016  Jonathan Harper
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QE_TEST_COMPOINTER_H
+#define QE_TEST_COMPOINTER_H
+
+#include <cwchar>
+#include <qewindows/compointer.h>
+#include "../core/test.h"
+
+//! Copies strings through WCharManager, which allocates with CoTaskMemAlloc. Run under
+//! AddressSanitizer to catch copies that write past their allocation.
+struct compointer_test
+{
+    static void run()
+    {
+        using qe::windows::WCharManager;
+        using qe::windows::WCharPointer;
+        wchar_t path[] = L"C:\\Users\\Public\\Documents";
+        wchar_t empty[] = L"";
+        const long allocations = qe_shim::taskAllocations();
+        {
+            WCharPointer original(WCharManager::copy(path));
+            EXPECT_TRUE(original.data() != path);
+            EXPECT_EQ(std::wcscmp(original.data(), path), 0);
+
+            WCharPointer copy(original);
+            EXPECT_TRUE(copy.data() != original.data());
+            EXPECT_EQ(std::wcscmp(copy.data(), path), 0);
+
+            WCharPointer none(WCharManager::copy(empty));
+            EXPECT_TRUE(none.data());
+            EXPECT_EQ(none.data()[0], L'\0');
+        }
+        EXPECT_EQ(qe_shim::taskAllocations(), allocations);
+        EXPECT_FALSE(WCharManager::copy(nullptr));
+    }
+};
+
+#endif // QE_TEST_COMPOINTER_H
@@ -0,0 +1,260 @@
+/*  QExt: Extensions to Qt
+ *  Copyright (C) 2016  Jonathan Harper
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QE_TEST_FAKENODE_H
+#define QE_TEST_FAKENODE_H
+
+#include <cstring>
+#include <qewindows/shellnode.h>
+#include <qewindows/shellnodeinfo.h>
+#include "fakeshell.h"
+#include "../core/test.h"
+
+//! Runs ShellNode and ShellNodeInfo over a fake_shell::Namespace.
+struct fakenode_test
+{
+    using ShellNode = qe::windows::ShellNode;
+    using ShellNodePointer = qe::windows::ShellNodePointer;
+
+    //! A root node for the fake desktop. ShellNode::rootNode() caches its node per thread, which
+    //! would outlive the namespace.
+    class RootNode : public ShellNode
+    {
+    public:
+        explicit RootNode(qe::windows::ShellItem2Pointer item)
+            : ShellNode(qe::windows::ShellNodeData::create(item), nullptr) {}
+    };
+
+    static ShellNodePointer rootNode(fake_shell::Namespace &ns)
+    {
+        return ShellNodePointer(new RootNode(ns.item(ns.root())));
+    }
+
+    static QString toQString(const std::wstring &text)
+    {
+        return QString::fromStdWString(text);
+    }
+
+    static fake_shell::Options smallTree()
+    {
+        fake_shell::Options options;
+        options.depth = 2;
+        options.foldersPerFolder = 3;
+        options.filesPerFolder = 4;
+        options.remoteFolders = 1;
+        return options;
+    }
+
+    static void run()
+    {
+        tree_test();
+        flags_test();
+        enumerate_test();
+        virtual_test();
+        release_test();
+        data_test();
+    }
+
+    static void tree_test()
+    {
+        fake_shell::Namespace ns(smallTree());
+        auto root = rootNode(ns);
+        EXPECT_TRUE(root->isValid());
+        EXPECT_TRUE(root->isRoot());
+        EXPECT_FALSE(root->isEnumerated());
+        EXPECT_TRUE(root->hasChildren());
+        EXPECT_EQ(root->displayName(), QStringLiteral("Desktop"));
+
+        root->enumerate();
+        EXPECT_TRUE(root->isEnumerated());
+        EXPECT_EQ(root->childCount(), 7);
+        for (int i = 0; i < root->childCount(); ++i) {
+            const fake_shell::Node *expected = ns.root()->children[std::size_t(i)].get();
+            auto child = root->childAt(i);
+            EXPECT_FALSE(child->isRoot());
+            EXPECT_TRUE(child->parent() == root);
+            EXPECT_EQ(child->displayName(), toQString(expected->name));
+            EXPECT_EQ(child->parsingName(), toQString(expected->name));
+            const auto id = child->idList();
+            EXPECT_EQ(std::size_t(id.byteCount()), expected->id.size());
+            EXPECT_EQ(std::memcmp(id.data(), expected->id.data(), expected->id.size()), 0);
+            EXPECT_EQ(child->hasChildren(), expected->isFolder());
+        }
+
+        //enumerating again finds the same items and adds no duplicates, by id rather than by
+        //comparing every item with every child
+        ns.resetCalls();
+        root->enumerate();
+        EXPECT_EQ(root->childCount(), 7);
+        EXPECT_EQ(ns.calls().compare, 0u);
+        EXPECT_EQ(ns.calls().idListFromObject, 7u);
+
+        //nodes order like their items
+        auto first = root->childAt(0);
+        auto second = root->childAt(1);
+        EXPECT_TRUE(*first == *root->children().first());
+        EXPECT_TRUE(*first != *second);
+
+        auto leaf = first->children().first();
+        EXPECT_TRUE(leaf);
+        EXPECT_TRUE(leaf->parent() == first);
+        EXPECT_FALSE(leaf->hasChildren());
+        EXPECT_EQ(first->childCount(), 7);
+
+        EXPECT_TRUE(root->bindTo<IEnumShellItems>());
+        EXPECT_FALSE(root->childAt(6)->bindTo<IEnumShellItems>());
+    }
+
+    static void flags_test()
+    {
+        using qe::windows::shell::NodeFlag;
+        fake_shell::Namespace ns(smallTree());
+        auto root = rootNode(ns);
+        for (const auto &child : root->children()) {
+            const auto flags = child->data()->flags;
+            EXPECT_TRUE(flags & NodeFlag::FileSystem);
+            EXPECT_TRUE(flags & NodeFlag::CanRename);
+            if (flags & NodeFlag::Folder) {
+                EXPECT_TRUE(flags & NodeFlag::MayHaveChildren);
+                EXPECT_FALSE(flags & NodeFlag::Stream);
+            } else {
+                EXPECT_TRUE(flags & NodeFlag::Stream);
+            }
+        }
+        //the first folder below the desktop is remote, and so is everything in it
+        auto remote = root->childAt(0);
+        EXPECT_TRUE(remote->data()->flags & NodeFlag::Remote);
+        EXPECT_TRUE(remote->children().first()->data()->flags & NodeFlag::Remote);
+        EXPECT_FALSE(root->childAt(1)->data()->flags & NodeFlag::Remote);
+
+        //hidden files carry the flag from both SFGAO_HIDDEN and FILE_ATTRIBUTE_HIDDEN
+        std::size_t hidden = 0;
+        for (std::size_t i = 0; i < ns.root()->children.size(); ++i) {
+            const bool expected = ns.root()->children[i]->attributes & SFGAO_HIDDEN;
+            EXPECT_EQ(bool(root->childAt(int(i))->data()->flags & NodeFlag::Hidden), expected);
+            hidden += expected;
+        }
+        qe_test::keep(hidden);
+    }
+
+    //! Enumerating releases every item it is given and stops when `Next` returns `S_FALSE`.
+    static void enumerate_test()
+    {
+        fake_shell::Namespace ns(smallTree());
+        auto root = rootNode(ns);
+        root->enumerate();
+        const int live = ns.live();
+        ns.resetCalls();
+        root->enumerate();
+        root->enumerate();
+        EXPECT_EQ(ns.live(), live);
+        EXPECT_EQ(ns.calls().next, 16u);
+        EXPECT_EQ(ns.calls().idListFromObject, 14u);
+        EXPECT_EQ(root->childCount(), 7);
+    }
+
+    //! Items that are not on the file system may get a new id list each time; enumerating again
+    //! recognizes them by asking the shell, comparing them only with the other virtual children.
+    static void virtual_test()
+    {
+        using qe::windows::shell::NodeFlag;
+        fake_shell::Options options = smallTree();
+        options.virtualFiles = 2;
+        fake_shell::Namespace ns(options);
+        auto root = rootNode(ns);
+        root->enumerate();
+        EXPECT_EQ(root->childCount(), 7);
+        int virtualChildren = 0;
+        for (const auto &child : root->children())
+            virtualChildren += !(child->data()->flags & NodeFlag::FileSystem);
+        EXPECT_EQ(virtualChildren, 2);
+
+        ns.resetCalls();
+        root->enumerate();
+        EXPECT_EQ(root->childCount(), 7);
+        EXPECT_GT(ns.calls().compare, 0u);
+        EXPECT_TRUE(ns.calls().compare <= 4u);
+    }
+
+    //! Every item, enumerator and bind context the nodes acquire is released with them. A node
+    //! holds its parent weakly, and stays a non-root node after the parent is gone.
+    static void release_test()
+    {
+        fake_shell::Namespace ns(smallTree());
+        qe::windows::ShellNodePointer leaf;
+        {
+            auto root = rootNode(ns);
+            for (const auto &child : root->children())
+                child->enumerate();
+            EXPECT_GT(ns.live(), 0);
+            leaf = root->childAt(0)->childAt(0);
+            EXPECT_TRUE(leaf->parent() == root->childAt(0));
+        }
+        EXPECT_FALSE(leaf->parent());
+        EXPECT_FALSE(leaf->isRoot());
+        EXPECT_TRUE(leaf->isValid());
+        leaf.reset();
+        EXPECT_EQ(ns.live(), 0);
+    }
+
+    //! Refreshing node data frees the property values it reads.
+    static void data_test()
+    {
+        fake_shell::Namespace ns(smallTree());
+        const long allocations = qe_shim::taskAllocations();
+        {
+            auto root = rootNode(ns);
+            const auto data = root->children().at(1)->data();
+            EXPECT_TRUE(data->flags & qe::windows::shell::NodeFlag::FileSystem);
+            const long held = qe_shim::taskAllocations();
+            for (int i = 0; i < 4; ++i)
+                qe::windows::ShellNodeData::create(data->item);
+            EXPECT_EQ(qe_shim::taskAllocations(), held);
+        }
+        EXPECT_EQ(qe_shim::taskAllocations(), allocations);
+    }
+
+    static void info_test()
+    {
+        fake_shell::Namespace ns(smallTree());
+        const fake_shell::Node *file = ns.root()->children.front()->children.back().get();
+        {
+            qe::windows::ShellNodeInfo info(toQString(file->path));
+            EXPECT_TRUE(info.exists());
+            EXPECT_FALSE(info.isFolder());
+            EXPECT_FALSE(info.isVirtual());
+            EXPECT_EQ(info.displayName(), toQString(file->name));
+            EXPECT_EQ(info.filesystemPathName(), toQString(file->path));
+            EXPECT_EQ(info.propertyValue(PKEY_Size).toULongLong(), quint64(file->size));
+            EXPECT_EQ(info.propertyValue(PKEY_ItemNameDisplay).toString(), toQString(file->name));
+            EXPECT_FALSE(info.propertyValue(PKEY_DateModified).isValid());
+
+            const auto id = info.idList();
+            EXPECT_EQ(std::size_t(id.byteCount()), file->id.size());
+
+            qe::windows::ShellNodeInfo missing(QStringLiteral("X:\\missing"));
+            EXPECT_FALSE(missing.exists());
+            //the project builds in release, where the path must still be converted
+            EXPECT_TRUE(missing.setNode(toQString(file->path)));
+            EXPECT_TRUE(missing.exists());
+            EXPECT_EQ(missing.displayName(), toQString(file->name));
+        }
+        EXPECT_EQ(ns.live(), 0);
+    }
+};
+
+#endif // QE_TEST_FAKENODE_H
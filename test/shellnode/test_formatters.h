@@ -0,0 +1,46 @@
+/*  QExt: Extensions to Qt
+ *  Copyright (C) 2016  Jonathan Harper
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QE_TEST_FORMATTERS_H
+#define QE_TEST_FORMATTERS_H
+
+#include <QtCore/QVariant>
+#include <qecore/debugutil.h>
+#include <qewindows/shell.h>
+#include "../core/test.h"
+
+//! Formats shell types through the qe::toString registry. Needs a QCoreApplication, which
+//! registers the shell formatters; the test never calls registerFormatters() itself.
+struct formatters_test
+{
+    static void run()
+    {
+        using qe::windows::shell::NodeFlag;
+        using qe::windows::shell::NodeFlags;
+
+        EXPECT_EQ(qe::toString(QVariant::fromValue(NodeFlags())), QStringLiteral("NoFlags"));
+        EXPECT_EQ(qe::toString(QVariant::fromValue(NodeFlags(NodeFlag::Hidden))), QStringLiteral("Hidden"));
+        const NodeFlags folder = NodeFlags(NodeFlag::Folder) | NodeFlag::FileSystem | NodeFlag::MayHaveChildren;
+        EXPECT_EQ(qe::toString(QVariant::fromValue(folder)), QStringLiteral("Folder|FileSystem|MayHaveChildren"));
+
+        QString out = QStringLiteral("flags: ");
+        EXPECT_TRUE(qe::formatInto(out, QVariant::fromValue(NodeFlags(NodeFlag::ReadOnly) | NodeFlag::System)));
+        EXPECT_EQ(out, QStringLiteral("flags: ReadOnly|System"));
+    }
+};
+
+#endif // QE_TEST_FORMATTERS_H
@@ -0,0 +1,45 @@
+#include <qewindows/winutil.h>
+#include <QtCore/QByteArray>
+
+//winutil.cpp needs QtWinExtras; these cover the values that the fake namespace produces.
+
+namespace qe {
+namespace windows {
+namespace util {
+
+QDateTime fromFILETIME(const FILETIME &ft)
+{
+    QDateTime ret(QDate(1601, 1, 1), QTime(0,0,0,0), Qt::UTC);
+    qint64 time = (static_cast<qint64>(ft.dwHighDateTime) << 32) | ft.dwLowDateTime;
+    time /= 10000;
+    return ret.addMSecs(time);
+}
+
+QVariant fromPROPVARIANT(PROPVARIANT &v)
+{
+    QVariant ret;
+    switch(v.vt)
+    {
+    case VT_EMPTY:
+    case VT_NULL:
+        break;
+    case VT_I4:         ret.setValue<qint32>(v.lVal);                   break;
+    case VT_UI4:        ret.setValue<quint32>(v.ulVal);                 break;
+    case VT_I8:         ret.setValue<qint64>(v.hVal.QuadPart);          break;
+    case VT_UI8:        ret.setValue<quint64>(v.uhVal.QuadPart);        break;
+    case VT_BOOL:       ret.setValue<bool>(v.boolVal ? true:false);     break;
+    case VT_LPWSTR:     ret.setValue(QString::fromWCharArray(v.pwszVal)); break;
+    case VT_FILETIME:   ret.setValue(fromFILETIME(v.filetime));         break;
+    case VT_VECTOR | VT_UI1:
+        ret.setValue(QByteArray(reinterpret_cast<const char *>(v.caub.pElems), int(v.caub.cElems)));
+        break;
+    default:
+        Q_UNIMPLEMENTED();
+        break;
+    }
+    return ret;
+}
+
+} // namespace util
+} // namespace windows
+} // namespace qe
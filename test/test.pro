@@ -3,4 +3,9 @@ TEMPLATE = subdirs
 
 SUBDIRS += \
     core \
+    debugutil \
+    shell \
 	windows
+
+#ShellNode over the fake shell namespace, for platforms without the Windows SDK
+!win32: SUBDIRS += shellnode
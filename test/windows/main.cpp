@@ -11,16 +11,12 @@ int main(int argc, char **argv)
 {
     QCoreApplication(argc, argv);
     CoInitialize(nullptr);
-    qDebug() << "Testing unaligned.h";
-    test_unaligned::run();
-    qDebug() << "Testing shell::idList";
-    test_shellidlist::run();
-    qDebug() << "Testing UnknownPointer";
-    test_unknownpointer::run();
-    qDebug() << "Testing ShellNodeInfo";
-    test_shellnodeinfo::run();
-    qDebug() << "Testing ShellNode";
-    test_shellnode::run();
+    qe_test::add_test("unaligned", &test_unaligned::run);
+    qe_test::add_test("shell_idlist", &test_shellidlist::run);
+    qe_test::add_test("unknown_pointer", &test_unknownpointer::run);
+    qe_test::add_test("shell_node_info", &test_shellnodeinfo::run);
+    qe_test::add_test("shell_node", &test_shellnode::run);
+    const int ret = qe_test::run(argc, argv);
     CoUninitialize();
-    return 0;
+    return ret;
 }